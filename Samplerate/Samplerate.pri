@@ -2,7 +2,6 @@
 HEADERS += \
     $$PWD/fastest_coeffs.h \
     $$PWD/float_cast.h \
-    $$PWD/high_qual_coeffs.h \
     $$PWD/mid_qual_coeffs.h \
     $$PWD/samplerate.h \
     $$PWD/samplerate_common.h \
@@ -49,7 +49,8 @@ typedef float	coeff_t ;
 
 #include "fastest_coeffs.h"
 #include "mid_qual_coeffs.h"
-#include "high_qual_coeffs.h"
+
+/* SpikeGLX: high_qual_coeffs.h (SRC_SINC_BEST_QUALITY) not bundled. */
 
 typedef struct
 {	int		sinc_magic_marker ;
@@ -116,10 +117,7 @@ const char*
 sinc_get_name (int src_enum)
 {
 	switch (src_enum)
-	{	case SRC_SINC_BEST_QUALITY :
-			return "Best Sinc Interpolator" ;
-
-		case SRC_SINC_MEDIUM_QUALITY :
+	{	case SRC_SINC_MEDIUM_QUALITY :
 			return "Medium Sinc Interpolator" ;
 
 		case SRC_SINC_FASTEST :
@@ -141,9 +139,6 @@ sinc_get_description (int src_enum)
 		case SRC_SINC_MEDIUM_QUALITY :
 			return "Band limited sinc interpolation, medium quality, 121dB SNR, 90% BW." ;
 
-		case SRC_SINC_BEST_QUALITY :
-			return "Band limited sinc interpolation, best quality, 145dB SNR, 96% BW." ;
-
 		default :
 			break ;
 		} ;
@@ -211,12 +206,6 @@ sinc_set_converter (SRC_PRIVATE *psrc, int src_enum)
 				temp_filter.index_inc = slow_mid_qual_coeffs.increment ;
 				break ;
 
-		case SRC_SINC_BEST_QUALITY :
-				temp_filter.coeffs = slow_high_qual_coeffs.coeffs ;
-				temp_filter.coeff_half_len = ARRAY_LEN (slow_high_qual_coeffs.coeffs) - 1 ;
-				temp_filter.index_inc = slow_high_qual_coeffs.increment ;
-				break ;
-
 		default :
 				return SRC_ERR_BAD_CONVERTER ;
 		} ;
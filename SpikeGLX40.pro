@@ -82,17 +82,11 @@ for(dir, SRC_SGLX) {
     include($$dir/$$dir".pri")
 }
 
-# 3rd party - deprecate Samplerate
+# 3rd party
 win32 {
-    xx_win32-g++ {
-        SRC_ALIEN = \
-            RtAudio \
-            Samplerate
-    }
-    else {
-        SRC_ALIEN = \
-            RtAudio
-    }
+    SRC_ALIEN = \
+        RtAudio \
+        Samplerate
     for(dir, SRC_ALIEN) {
         INCLUDEPATH += $$PWD/$$dir
         include($$dir/$$dir".pri")
@@ -175,6 +169,9 @@ win32 {
 unix {
     DEFINES         += OPENGL54
     CONFIG          += debug warn_on
+    !macx {
+        LIBS        += -lrt
+    }
 #   QMAKE_CXXFLAGS  += -fsanitize=address -fno-omit-frame-pointer -g
 #   QMAKE_LFLAGS    += -fsanitize=address
 #   QMAKE_CFLAGS    += -Wall -Wno-return-type
@@ -26,6 +26,7 @@ class AOCtl : public QWidget
     Q_OBJECT
 
     friend class AODevRtAudio;
+    friend class AOFeedWorker;
 
 private:
     struct EachStream {
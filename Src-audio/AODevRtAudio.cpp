@@ -4,23 +4,24 @@
 
 #include "AOCtl.h"
 #include "AODevRtAudio.h"
+#include "AOFeed.h"
 #include "Util.h"
 #include "DAQ.h"
 
 #include <QThread>
 
-/* ---------------------------------------------------------------- */
-/* Statics -------------------------------------------------------- */
-/* ---------------------------------------------------------------- */
+#include <string.h>
 
-static AODevRtAudio *ME;
+
+#define AO_DEVRATE      48000   // if device states no preference
+#define AO_RINGFRAMES   (32*1024)
 
 /* ---------------------------------------------------------------- */
 /* AODevRtAudio --------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
 AODevRtAudio::AODevRtAudio( AOCtl *aoC, const DAQ::Params &p )
-    :   AODevBase(aoC, p), rta(0), ready(false)
+    :   AODevBase(aoC, p), rta(0), feedShr(0), feedT(0), ready(false)
 {
 }
 
@@ -401,11 +402,6 @@ bool AODevRtAudio::devStart(
 
     drv.usr2drv( aoC );
 
-    ME          = this;
-    fromCt      = 0;
-    latSum      = 0.0;
-    latCt       = 0;
-
     switch( drv.streamjs ) {
         case jsNI: this->aiQ = niQ; break;
         case jsOB: this->aiQ = obQ[drv.streamip]; break;
@@ -428,15 +424,46 @@ bool AODevRtAudio::devStart(
     prm.nChannels       = aoC->nDevChans;
     prm.firstChannel    = 0;
 
-    uint sampPerCall    = 256;
+    uint sampPerCall    = 256,
+         devRate        = AO_DEVRATE;
+
+// Device runs at its own rate; feeder resamples
+
+    try {
+        RtAudio::DeviceInfo info = rta->getDeviceInfo( prm.deviceId );
+
+        if( info.preferredSampleRate )
+            devRate = info.preferredSampleRate;
+    }
+    catch( RtAudioError &e ) {
+        Warning() << "Audio error: " << e.what();
+        return false;
+    }
+
+    if( devRate / drv.srate > 256 || drv.srate / devRate > 256 ) {
+        Warning() <<
+            QString("Audio error: Can't resample %1 Hz to %2 Hz.")
+            .arg( drv.srate ).arg( devRate );
+        return false;
+    }
+
+    feedShr = new AOFeedShared( prm.nChannels, AO_RINGFRAMES );
 
 // Start audio stream
 
     try {
         rta->openStream(
-                &prm, NULL, RTAUDIO_SINT16, drv.srate, &sampPerCall,
-                (prm.nChannels == 2 ? callbackStereo : callbackMono) );
+                &prm, NULL, RTAUDIO_SINT16, devRate, &sampPerCall,
+                callback, feedShr );
+    }
+    catch( RtAudioError &e ) {
+        Warning() << "Audio error: " << e.what();
+        return false;
+    }
 
+    feedT = new AOFeedThread( aoC, aiQ, *feedShr, devRate );
+
+    try {
         rta->startStream();
     }
     catch( RtAudioError &e ) {
@@ -470,70 +497,32 @@ void AODevRtAudio::devStop()
             Warning() << "Audio error: " << e.what();
         }
 
+        if( feedT ) {
+            feedShr->kill();
+            delete feedT;
+            feedT = 0;
+        }
+
         if( aoC->usr.useQf && aoC->drv.streamjs == jsIM )
             this->aiQ->qf_audioClient( false );
 
         delete rta;
         rta = 0;
     }
+
+    delete feedShr;
+    feedShr = 0;
 }
 
 /* ---------------------------------------------------------------- */
 /* Private -------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
-// nChan is either {1,2}.
-// iChan is either {0,1}.
+// Runs on the audio driver's thread: copy out what the
+// feeder has ready, zero-pad any shortfall, and leave all
+// reporting to the feeder.
 //
-void AODevRtAudio::filter(
-    qint16  *data,
-    int     ntpts,
-    int     nChan,
-    int     ichan )
-{
-    AOCtl::Derived  &drv = aoC->drv;
-
-    if( drv.loCut > -1 || drv.hiCut > -1 ) {
-
-        if( drv.loCut > -1 ) {
-            drv.hipass.apply1BlockwiseMem1(
-                data, drv.maxInt, ntpts, nChan, ichan );
-        }
-
-        if( drv.hiCut > -1 ) {
-            drv.lopass.apply1BlockwiseMem1(
-                data, drv.maxInt, ntpts, nChan, ichan );
-        }
-    }
-}
-
-
-void AODevRtAudio::latency()
-{
-    const AOCtl::Derived    &drv = aoC->drv;
-
-    double L = qMax( 0.0, 1000 * (aiQ->endCount() - fromCt) / drv.srate );
-
-    latSum += L;
-    ++latCt;
-
-// Average about 2 sec worth: 2 sec = N*256/30000; N ~ 200
-
-    if( latCt < 200 )
-        return;
-
-    L       = latSum / latCt;
-    latSum  = 0.0;
-    latCt   = 0;
-
-    if( L >= drv.maxLatency )
-        aoC->restart();
-
-//    Log() << L;
-}
-
-
-int AODevRtAudio::callbackMono(
+int AODevRtAudio::callback(
     void                *outputBuffer,
     void                *inputBuffer,
     uint                nBufferFrames,
@@ -543,165 +532,18 @@ int AODevRtAudio::callbackMono(
 {
     Q_UNUSED( inputBuffer )
     Q_UNUSED( streamTime )
-    Q_UNUSED( userData )
-
-    QMutexLocker    ml( &ME->aoC->aoMtx );
-
-    const AOCtl::Derived    &drv = ME->aoC->drv;
-    qint16                  *dst = (qint16*)outputBuffer;
-    qint64                  headCt;
-
-    if( status ) {
-        Debug() << QString("Audio stream(js,ip=%1,%2) underflow detected.")
-                    .arg( drv.streamjs ).arg( drv.streamip );
-    }
-
-// Fetch data from stream
-
-    for( int tries = 0; tries < 100; ++tries ) {
-
-        // Fetch
-
-        if( !ME->fromCt ) {
-            headCt = ME->aiQ->getNewestNSampsMono(
-                        dst, nBufferFrames, drv.lChan );
-        }
-        else {
-            headCt = ME->aiQ->getNSampsFromCtMono(
-                        dst, ME->fromCt, nBufferFrames, drv.lChan );
-        }
-
-        if( headCt >= 0 )
-            goto fetched;
-
-        QThread::usleep( 1000 );    // wait ~30 samples
-    }
-
-// Fetch failed
-
-    Warning() << QString("Audio stream(js,ip=%1,%2) getting no samples.")
-                    .arg( drv.streamjs ).arg( drv.streamip );
-
-#if 0
-    // Stopping from within callback crashes sometimes...
-    return 1;
-#else
-    // Stop from outside instead.
-    memset( dst, 0, nBufferFrames*sizeof(qint16) );
-    ME->aoC->restart();
-#endif
-
-// Mark next fetch point
-
-fetched:
-    ME->fromCt = headCt + nBufferFrames;
-
-// Latency
-
-    ME->latency();
-
-// Filter channels
-
-    if( drv.lChan < drv.nNeural )
-        ME->filter( dst, nBufferFrames, 1, 0 );
-
-// Apply volume
-
-    for( uint t = 0; t < nBufferFrames; ++t ) {
-
-        dst[t] = drv.vol( dst[t], drv.lVol );
-    }
-
-    return 0;
-}
-
-
-int AODevRtAudio::callbackStereo(
-    void                *outputBuffer,
-    void                *inputBuffer,
-    uint                nBufferFrames,
-    double              streamTime,
-    RtAudioStreamStatus status,
-    void                *userData )
-{
-    Q_UNUSED( inputBuffer )
-    Q_UNUSED( streamTime )
-    Q_UNUSED( userData )
-
-    QMutexLocker    ml( &ME->aoC->aoMtx );
-
-    const AOCtl::Derived    &drv = ME->aoC->drv;
-    qint16                  *dst = (qint16*)outputBuffer;
-    qint64                  headCt;
-
-    if( status ) {
-        Debug() << QString("Audio stream(js,ip=%1,%2) underflow detected.")
-                    .arg( drv.streamjs ).arg( drv.streamip );
-    }
-
-// Fetch data from stream
-
-    for( int tries = 0; tries < 100; ++tries ) {
-
-        // Fetch
-
-        if( !ME->fromCt ) {
-            headCt = ME->aiQ->getNewestNSampsStereo(
-                        dst, nBufferFrames,
-                        drv.lChan, drv.rChan );
-        }
-        else {
-            headCt = ME->aiQ->getNSampsFromCtStereo(
-                        dst, ME->fromCt, nBufferFrames,
-                        drv.lChan, drv.rChan );
-        }
-
-        if( headCt >= 0 )
-            goto fetched;
-
-        QThread::usleep( 1000 );    // wait ~30 samples
-    }
-
-// Fetch failed
-
-    Warning() << QString("Audio stream(js,ip=%1,%2) getting no samples.")
-                    .arg( drv.streamjs ).arg( drv.streamip );
-
-#if 0
-    // Stopping from within callback crashes sometimes...
-    return 1;
-#else
-    // Stop from outside instead.
-    memset( dst, 0, 2*nBufferFrames*sizeof(qint16) );
-    ME->aoC->restart();
-#endif
-
-// Mark next fetch point
-
-fetched:
-    ME->fromCt = headCt + nBufferFrames;
-
-// Latency
-
-    ME->latency();
-
-// Filter channels
-
-    if( drv.lChan < drv.nNeural )
-        ME->filter( dst, nBufferFrames, 2, 0 );
-
-    if( drv.rChan < drv.nNeural )
-        ME->filter( dst, nBufferFrames, 2, 1 );
-
-// Apply volume
-
-    for( uint t = 0; t < nBufferFrames; ++t ) {
 
-        int j = 2*t;
+    AOFeedShared    *shr    = (AOFeedShared*)userData;
+    qint16          *dst    = (qint16*)outputBuffer;
+    int             nCh     = shr->ring.nChans(),
+                    n       = shr->ring.read( dst, nBufferFrames );
 
-        dst[j]      = drv.vol( dst[j], drv.lVol );
-        dst[j+1]    = drv.vol( dst[j+1], drv.rVol );
+    if( n < int(nBufferFrames) ) {
+        memset( dst + n * nCh, 0, (nBufferFrames - n) * nCh * sizeof(qint16) );
+        ++shr->underflows;
     }
+    else if( status )
+        ++shr->underflows;
 
     return 0;
 }
@@ -8,20 +8,25 @@
 #include "RtAudio.h"
 #include "AIQ.h"
 
+struct AOFeedShared;
+class AOFeedThread;
+
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
-// RtAudio-based audio output
+// RtAudio-based audio output.
+// A feeder thread prepares device-rate frames into a ring;
+// the callback only copies them out, never locking or
+// waiting on the stream.
 //
 class AODevRtAudio : public AODevBase
 {
 private:
-    RtAudio     *rta;
-    quint64     fromCt;
-    double      latSum;
-    int         latCt;
-    bool        ready;
+    RtAudio         *rta;
+    AOFeedShared    *feedShr;
+    AOFeedThread    *feedT;
+    bool            ready;
 
 public:
     AODevRtAudio( AOCtl *aoC, const DAQ::Params &p );
@@ -44,23 +49,7 @@ public:
     virtual void devStop();
 
 private:
-    void filter(
-        qint16  *data,
-        int     ntpts,
-        int     nChan,
-        int     ichan );
-
-    void latency();
-
-    static int callbackMono(
-        void                *outputBuffer,
-        void                *inputBuffer,
-        uint                nBufferFrames,
-        double              streamTime,
-        RtAudioStreamStatus status,
-        void                *userData );
-
-    static int callbackStereo(
+    static int callback(
         void                *outputBuffer,
         void                *inputBuffer,
         uint                nBufferFrames,
@@ -0,0 +1,412 @@
+
+#include <qglobal.h>
+#ifdef Q_OS_WIN
+
+#include "AOFeed.h"
+#include "AOCtl.h"
+#include "Util.h"
+#include "AIQ.h"
+#include "ThreadPlace.h"
+#include "samplerate.h"
+
+#include <QThread>
+
+#include <string.h>
+
+
+#define AOFEED_MAXTPTS      4096    // stream tpts per pass
+#define AOFEED_TARGETMS     30      // ring fill to hold
+#define AOFEED_MAXTRIM      0.002   // max fractional ratio trim
+#define AOFEED_TRIMGAIN     0.1     // trim per sec of fill error
+#define AOFEED_NODATASECS   1.0
+#define AOFEED_REPORTSECS   2.0
+
+/* ---------------------------------------------------------------- */
+/* AOFeedRing ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+AOFeedRing::AOFeedRing( int nCh, int minFrames )
+    :   wrCt(0), rdCt(0), nCh(nCh), cap(1)
+{
+    while( cap < minFrames )
+        cap *= 2;
+
+    buf.resize( cap * nCh );
+}
+
+
+int AOFeedRing::fill() const
+{
+    return int(wrCt.load( std::memory_order_acquire )
+                - rdCt.load( std::memory_order_acquire ));
+}
+
+
+// Producer side.
+//
+int AOFeedRing::write( const qint16 *src, int nFrames )
+{
+    quint64 w = wrCt.load( std::memory_order_relaxed ),
+            r = rdCt.load( std::memory_order_acquire );
+
+    nFrames = qMin( nFrames, cap - int(w - r) );
+
+    if( nFrames <= 0 )
+        return 0;
+
+    int i0  = int(w & (cap - 1)),
+        n0  = qMin( nFrames, cap - i0 );
+
+    memcpy( &buf[i0 * nCh], src, n0 * nCh * sizeof(qint16) );
+
+    if( n0 < nFrames ) {
+        memcpy( &buf[0], src + n0 * nCh,
+            (nFrames - n0) * nCh * sizeof(qint16) );
+    }
+
+    wrCt.store( w + nFrames, std::memory_order_release );
+
+    return nFrames;
+}
+
+
+// Consumer side.
+//
+int AOFeedRing::read( qint16 *dst, int nFrames )
+{
+    quint64 r = rdCt.load( std::memory_order_relaxed ),
+            w = wrCt.load( std::memory_order_acquire );
+
+    nFrames = qMin( nFrames, int(w - r) );
+
+    if( nFrames <= 0 )
+        return 0;
+
+    int i0  = int(r & (cap - 1)),
+        n0  = qMin( nFrames, cap - i0 );
+
+    memcpy( dst, &buf[i0 * nCh], n0 * nCh * sizeof(qint16) );
+
+    if( n0 < nFrames ) {
+        memcpy( dst + n0 * nCh, &buf[0],
+            (nFrames - n0) * nCh * sizeof(qint16) );
+    }
+
+    rdCt.store( r + nFrames, std::memory_order_release );
+
+    return nFrames;
+}
+
+/* ---------------------------------------------------------------- */
+/* AOFeedWorker --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+AOFeedWorker::AOFeedWorker(
+    AOCtl           *aoC,
+    const AIQ       *Q,
+    AOFeedShared    &shr,
+    double          devRate )
+    :   QObject(0), aoC(aoC), Q(Q), shr(shr), src(0), devRate(devRate)
+{
+    const AOCtl::Derived    &drv = aoC->drv;
+    int                     err;
+
+    ratio0  = devRate / drv.srate;
+    target  = int(AOFEED_TARGETMS * 1e-3 * devRate);
+    fillAve = target;
+
+    src = src_new( SRC_SINC_FASTEST, shr.ring.nChans(), &err );
+
+    if( !src ) {
+        Warning() <<
+            QString("Audio resampler error <%1>.").arg( src_strerror( err ) );
+    }
+
+// Start a little behind newest so the ring fills at once
+
+    quint64 pre = quint64(AOFEED_TARGETMS * 1e-3 * drv.srate);
+
+    fromCt = Q->endCount();
+
+    if( fromCt >= Q->qHeadCt() + pre )
+        fromCt -= pre;
+}
+
+
+AOFeedWorker::~AOFeedWorker()
+{
+    if( src )
+        src_delete( src );
+}
+
+
+void AOFeedWorker::run()
+{
+    const AOCtl::Derived    &drv = aoC->drv;
+
+    double  tData   = getTime(),
+            tReport = tData,
+            latSum  = 0.0;
+    int     latCt   = 0;
+
+    ThreadPlace::pin( ThreadPlace::tpAux, "audio" );
+
+    while( src && !shr.isStopped() ) {
+
+        double  tNow;
+
+        if( feedSome() )
+            tData = getTime();
+
+        tNow = getTime();
+
+        if( tNow - tData > AOFEED_NODATASECS ) {
+
+            Warning() <<
+                QString("Audio stream(js,ip=%1,%2) getting no samples.")
+                .arg( drv.streamjs ).arg( drv.streamip );
+
+            aoC->restart();
+            tData = tNow;
+        }
+
+        // Latency: stream data not yet fed, plus ring
+
+        latSum += 1000 * ((Q->endCount() - fromCt) / drv.srate
+                            + shr.ring.fill() / devRate);
+        ++latCt;
+
+        if( tNow - tReport < AOFEED_REPORTSECS )
+            continue;
+
+        if( latSum / latCt >= drv.maxLatency ) {
+
+            Debug() <<
+                QString("Audio stream(js,ip=%1,%2) skipped ahead at %3 ms.")
+                .arg( drv.streamjs ).arg( drv.streamip )
+                .arg( int(latSum / latCt) );
+
+            skipAhead();
+        }
+
+        int nu = shr.underflows.exchange( 0 );
+
+        if( nu ) {
+            Debug() <<
+                QString("Audio stream(js,ip=%1,%2) underflow detected (%3).")
+                .arg( drv.streamjs ).arg( drv.streamip ).arg( nu );
+        }
+
+        latSum  = 0.0;
+        latCt   = 0;
+        tReport = tNow;
+    }
+
+    emit finished();
+}
+
+
+// Move the next run of stream data into the ring.
+// Return true unless waiting for data timed out.
+//
+bool AOFeedWorker::feedSome()
+{
+    const AOCtl::Derived    &drv = aoC->drv;
+
+// Ring well ahead: let callback drain
+
+    if( shr.ring.fill() >= 2 * target ) {
+        QThread::msleep( 1 );
+        return true;
+    }
+
+// Fetch
+
+    if( !Q->waitForData( fromCt, 20 ) )
+        return false;
+
+    AIQ::View   V;
+
+    if( Q->getViewFromCt( V, fromCt, AOFEED_MAXTPTS ) < 0 ) {
+        skipAhead();
+        return true;
+    }
+
+    int ntpts = V.nTpts();
+
+    if( !ntpts )
+        return true;
+
+    int     nD  = shr.ring.nChans(),
+            nS  = ntpts * nD;
+    qint16  *d;
+
+    in.resize( nS );
+    d = &in[0];
+
+    for( int it = 0; it < ntpts; ++it, d += nD ) {
+
+        const qint16    *t = V.tpt( it );
+
+        d[0] = t[drv.lChan];
+
+        if( nD > 1 )
+            d[1] = t[drv.rChan];
+    }
+
+    if( !V.intact() ) {
+        skipAhead();
+        return true;
+    }
+
+    fromCt += ntpts;
+
+// Filter channels
+
+    if( drv.lChan < drv.nNeural )
+        filter( &in[0], ntpts, nD, 0 );
+
+    if( nD > 1 && drv.rChan < drv.nNeural )
+        filter( &in[0], ntpts, nD, 1 );
+
+// Apply volume
+
+    d = &in[0];
+
+    for( int it = 0; it < ntpts; ++it, d += nD ) {
+
+        d[0] = drv.vol( d[0], drv.lVol );
+
+        if( nD > 1 )
+            d[1] = drv.vol( d[1], drv.rVol );
+    }
+
+// Resample
+
+    SRC_DATA    D;
+    double      r       = ratio();
+    int         nOut    = int(ntpts * r) + 64,
+                err;
+
+    fin.resize( nS );
+    fout.resize( nOut * nD );
+
+    src_short_to_float_array( &in[0], &fin[0], nS );
+
+    D.data_in       = &fin[0];
+    D.input_frames  = ntpts;
+    D.data_out      = &fout[0];
+    D.output_frames = nOut;
+    D.end_of_input  = 0;
+    D.src_ratio     = r;
+
+    if( (err = src_process( src, &D )) ) {
+
+        Warning() <<
+            QString("Audio resampler error <%1>.").arg( src_strerror( err ) );
+
+        skipAhead();
+        return true;
+    }
+
+    if( (nOut = D.output_frames_gen) ) {
+
+        out.resize( nOut * nD );
+        src_float_to_short_array( &fout[0], &out[0], nOut * nD );
+
+        // Full ring drops the excess; skipAhead restores latency.
+
+        shr.ring.write( &out[0], nOut );
+    }
+
+    return true;
+}
+
+
+// nChan is either {1,2}.
+// iChan is either {0,1}.
+//
+void AOFeedWorker::filter(
+    qint16  *data,
+    int     ntpts,
+    int     nChan,
+    int     ichan )
+{
+    AOCtl::Derived  &drv = aoC->drv;
+
+    if( drv.loCut > -1 || drv.hiCut > -1 ) {
+
+        if( drv.loCut > -1 ) {
+            drv.hipass.apply1BlockwiseMem1(
+                data, drv.maxInt, ntpts, nChan, ichan );
+        }
+
+        if( drv.hiCut > -1 ) {
+            drv.lopass.apply1BlockwiseMem1(
+                data, drv.maxInt, ntpts, nChan, ichan );
+        }
+    }
+}
+
+
+// Nominal device/stream ratio, trimmed to steer smoothed
+// ring fill toward target.
+//
+double AOFeedWorker::ratio()
+{
+    fillAve += 0.05 * (shr.ring.fill() - fillAve);
+
+    double  e = (fillAve - target) / devRate;  // secs
+
+    return ratio0 * (1.0 -
+            qBound( -AOFEED_MAXTRIM, AOFEED_TRIMGAIN * e, AOFEED_MAXTRIM ));
+}
+
+
+void AOFeedWorker::skipAhead()
+{
+    fromCt = Q->endCount();
+    src_reset( src );
+}
+
+/* ---------------------------------------------------------------- */
+/* AOFeedThread --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+AOFeedThread::AOFeedThread(
+    AOCtl           *aoC,
+    const AIQ       *Q,
+    AOFeedShared    &shr,
+    double          devRate )
+{
+    thread  = new QThread;
+    worker  = new AOFeedWorker( aoC, Q, shr, devRate );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+
+// Keep ahead of the audio callback.
+
+    thread->setPriority( QThread::HighPriority );
+}
+
+
+AOFeedThread::~AOFeedThread()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() )
+        thread->wait();
+
+    delete thread;
+}
+
+#endif  // Q_OS_WIN
+
+
@@ -0,0 +1,133 @@
+#ifndef AOFEED_H
+#define AOFEED_H
+
+#include <qglobal.h>
+#ifdef Q_OS_WIN
+
+#include <QMutex>
+#include <QObject>
+
+#include <atomic>
+#include <vector>
+
+class AOCtl;
+class AIQ;
+
+class QThread;
+
+struct SRC_STATE_tag;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Single producer (feeder), single consumer (audio callback)
+// ring of interleaved device frames. Neither side locks or
+// blocks; the read/write counters are the only shared state.
+//
+class AOFeedRing
+{
+private:
+    std::vector<qint16>     buf;
+    std::atomic<quint64>    wrCt,   // frames ever written
+                            rdCt;   // frames ever read
+    int                     nCh,
+                            cap;    // frames, power of 2
+
+public:
+    AOFeedRing( int nCh, int minFrames );
+
+    int nChans() const      {return nCh;}
+    int capacity() const    {return cap;}
+    int fill() const;
+
+    // Return frames moved.
+    int write( const qint16 *src, int nFrames );
+    int read( qint16 *dst, int nFrames );
+};
+
+
+struct AOFeedShared {
+    AOFeedRing          ring;
+    std::atomic<int>    underflows; // callback tallies
+    QMutex              runMtx;
+    bool                stop;
+
+    AOFeedShared( int nCh, int minFrames )
+    :   ring(nCh, minFrames), underflows(0), stop(false)    {}
+
+    bool isStopped()
+        {QMutexLocker ml( &runMtx ); return stop;}
+    void kill()
+        {QMutexLocker ml( &runMtx ); stop = true;}
+};
+
+
+// Follows the monitored stream: extracts the L/R channels,
+// filters, applies volume, resamples from stream rate to the
+// device rate (libsamplerate), and tops up the ring. The
+// resampling ratio is trimmed slightly to hold the ring near
+// its target fill, absorbing clock drift between acquisition
+// hardware and sound card.
+//
+class AOFeedWorker : public QObject
+{
+    Q_OBJECT
+
+private:
+    AOCtl                   *aoC;
+    const AIQ               *Q;
+    AOFeedShared            &shr;
+    SRC_STATE_tag           *src;
+    std::vector<qint16>     in,
+                            out;
+    std::vector<float>      fin,
+                            fout;
+    quint64                 fromCt;
+    double                  ratio0,
+                            fillAve,
+                            devRate;
+    int                     target;     // ring frames
+
+public:
+    AOFeedWorker(
+        AOCtl           *aoC,
+        const AIQ       *Q,
+        AOFeedShared    &shr,
+        double          devRate );
+    virtual ~AOFeedWorker();
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+
+private:
+    bool feedSome();
+    void filter( qint16 *data, int ntpts, int nChan, int ichan );
+    double ratio();
+    void skipAhead();
+};
+
+
+class AOFeedThread
+{
+public:
+    QThread         *thread;
+    AOFeedWorker    *worker;
+
+public:
+    AOFeedThread(
+        AOCtl           *aoC,
+        const AIQ       *Q,
+        AOFeedShared    &shr,
+        double          devRate );
+    virtual ~AOFeedThread();
+};
+
+#endif  // Q_OS_WIN
+
+#endif  // AOFEED_H
+
+
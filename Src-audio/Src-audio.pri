@@ -3,10 +3,12 @@ HEADERS += \
     $$PWD/AOCtl.h \
     $$PWD/AODevBase.h \
     $$PWD/AODevRtAudio.h \
-    $$PWD/AODevSim.h
+    $$PWD/AODevSim.h \
+    $$PWD/AOFeed.h
 
 SOURCES += \
     $$PWD/AOCtl.cpp \
-    $$PWD/AODevRtAudio.cpp
+    $$PWD/AODevRtAudio.cpp \
+    $$PWD/AOFeed.cpp
 
 
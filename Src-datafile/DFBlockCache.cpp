@@ -0,0 +1,335 @@
+#include "DFBlockCache.h"
+#include "ThreadPlace.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include <string.h>
+
+
+/* ---------------------------------------------------------------- */
+/* FileID --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool DFBlockCache::FileID::operator<( const FileID &rhs ) const
+{
+    if( path != rhs.path )
+        return path < rhs.path;
+
+    if( size != rhs.size )
+        return size < rhs.size;
+
+    return mtime < rhs.mtime;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* DFBlockCache --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+DFBlockCache::DFBlockCache( qint64 budget )
+    :   budget(budget), pleaseStop(false)
+{
+    memset( &S, 0, sizeof(Stats) );
+}
+
+
+DFBlockCache::~DFBlockCache()
+{
+    cacheMtx.lock();
+        pleaseStop = true;
+        jobs.clear();
+        condJobs.wakeAll();
+    cacheMtx.unlock();
+
+    for( int i = 0, n = int(vT.size()); i < n; ++i )
+        vT[i].join();
+}
+
+
+// Shared by all file viewers.
+//
+DFBlockCache &DFBlockCache::global()
+{
+    static DFBlockCache cache( 512LL * 1024 * 1024 );
+    return cache;
+}
+
+
+// Identify file as it is now; call when a viewer opens it.
+//
+DFBlockCache::FileID DFBlockCache::fileID( const QString &path )
+{
+    QFileInfo   fi( path );
+    FileID      id;
+
+    id.path     = path;
+    id.size     = fi.size();
+    id.mtime    = fi.lastModified().toMSecsSinceEpoch();
+
+    return id;
+}
+
+
+DFBlockCache::Blk DFBlockCache::get(
+    const FileID    &file,
+    int             nC,
+    int             blkTp,
+    qint64          iblk )
+{
+    Key     key( file, iblk );
+    bool    waited = false;
+
+    cacheMtx.lock();
+
+    ++S.nGet;
+
+    for(;;) {
+
+        std::map<Key,Entry>::iterator   it = cache.find( key );
+
+        if( it != cache.end() ) {
+
+            lru.splice( lru.begin(), lru, it->second.lru );
+
+            if( !waited )
+                ++S.nHit;
+
+            Blk blk = it->second.blk;
+            cacheMtx.unlock();
+            return blk;
+        }
+
+        if( !loading.count( key ) )
+            break;
+
+        if( !waited ) {
+            ++S.nWait;
+            waited = true;
+        }
+
+        condLoaded.wait( &cacheMtx );
+    }
+
+    loading.insert( key );
+    ++S.nLoad;
+
+    cacheMtx.unlock();
+
+    Blk blk;
+
+    syncMtx.lock();
+        blk = load( syncFile, key, nC, blkTp );
+    syncMtx.unlock();
+
+    cacheMtx.lock();
+        loading.erase( key );
+        if( blk )
+            insert( key, blk );
+        condLoaded.wakeAll();
+    cacheMtx.unlock();
+
+    return blk;
+}
+
+
+void DFBlockCache::prefetch(
+    const void                  *owner,
+    const FileID                &file,
+    int                         nC,
+    int                         blkTp,
+    const std::vector<qint64>   &vblk )
+{
+    QMutexLocker    ml( &cacheMtx );
+
+    if( pleaseStop )
+        return;
+
+    for( std::deque<Job>::iterator it = jobs.begin(); it != jobs.end(); ) {
+
+        if( it->owner == owner )
+            it = jobs.erase( it );
+        else
+            ++it;
+    }
+
+    for( int i = 0, n = int(vblk.size()); i < n; ++i ) {
+
+        Job J;
+
+        J.owner = owner;
+        J.key   = Key( file, vblk[i] );
+        J.nC    = nC;
+        J.blkTp = blkTp;
+
+        if( !cache.count( J.key ) && !loading.count( J.key ) )
+            jobs.push_back( J );
+    }
+
+    if( vT.empty() ) {
+
+        for( int i = 0; i < NTHD; ++i )
+            vT.push_back( std::thread( &DFBlockCache::run, this ) );
+    }
+
+    condJobs.wakeAll();
+}
+
+
+void DFBlockCache::cancel( const void *owner )
+{
+    QMutexLocker    ml( &cacheMtx );
+
+    for( std::deque<Job>::iterator it = jobs.begin(); it != jobs.end(); ) {
+
+        if( it->owner == owner )
+            it = jobs.erase( it );
+        else
+            ++it;
+    }
+}
+
+
+void DFBlockCache::setBudget( qint64 bytes )
+{
+    QMutexLocker    ml( &cacheMtx );
+
+    budget = bytes;
+    evict();
+}
+
+
+QString DFBlockCache::statsString() const
+{
+    Stats   s = stats();
+
+    return QString(
+        "Viewer block cache: gets %1, hits %2 (%3%), waits %4,"
+        " reads %5, prefetched %6, evicted %7, held %8 MB.")
+        .arg( s.nGet )
+        .arg( s.nHit )
+        .arg( s.nGet ? 100.0 * s.nHit / s.nGet : 0.0, 0, 'f', 1 )
+        .arg( s.nWait )
+        .arg( s.nLoad )
+        .arg( s.nPre )
+        .arg( s.nEvict )
+        .arg( s.heldBytes / (1024.0 * 1024.0), 0, 'f', 1 );
+}
+
+
+// Read block, reusing (f) if it is already open on that file.
+// Short blocks at end of file are trimmed to whole timepoints.
+// Return null on error.
+//
+DFBlockCache::Blk DFBlockCache::load(
+    QFile       &f,
+    const Key   &key,
+    int         nC,
+    int         blkTp )
+{
+    if( !f.isOpen() || f.fileName() != key.first.path ) {
+
+        f.close();
+        f.setFileName( key.first.path );
+
+        if( !f.open( QIODevice::ReadOnly ) )
+            return Blk();
+    }
+
+    qint64  tpBytes = nC * sizeof(qint16);
+
+    if( !f.seek( key.second * blkTp * tpBytes ) )
+        return Blk();
+
+    std::shared_ptr<vec_i16>    v =
+        std::make_shared<vec_i16>( qint64(blkTp) * nC );
+
+    qint64  n = f.read( (char*)&(*v)[0], qint64(blkTp) * tpBytes );
+
+    if( n < 0 )
+        return Blk();
+
+    v->resize( n / tpBytes * nC );
+
+    return v;
+}
+
+
+// Call with cacheMtx held.
+//
+void DFBlockCache::insert( const Key &key, const Blk &blk )
+{
+    Entry   &E = cache[key];
+
+    lru.push_front( key );
+
+    E.blk   = blk;
+    E.lru   = lru.begin();
+
+    S.heldBytes += blk->size() * sizeof(qint16);
+
+    evict();
+}
+
+
+// Call with cacheMtx held. Newest block always stays.
+//
+void DFBlockCache::evict()
+{
+    while( S.heldBytes > budget && lru.size() > 1 ) {
+
+        std::map<Key,Entry>::iterator   it = cache.find( lru.back() );
+
+        S.heldBytes -= it->second.blk->size() * sizeof(qint16);
+        cache.erase( it );
+        lru.pop_back();
+        ++S.nEvict;
+    }
+}
+
+
+// Read-ahead thread: take queued jobs in order, skipping
+// blocks that got cached or claimed since they were queued.
+//
+void DFBlockCache::run()
+{
+    QFile   f;
+
+    cacheMtx.lock();
+
+    for(;;) {
+
+        while( !pleaseStop && jobs.empty() )
+            condJobs.wait( &cacheMtx );
+
+        if( pleaseStop )
+            break;
+
+        Job J = jobs.front();
+        jobs.pop_front();
+
+        if( cache.count( J.key ) || loading.count( J.key ) )
+            continue;
+
+        loading.insert( J.key );
+
+        cacheMtx.unlock();
+
+        ThreadPlace::follow( ThreadPlace::tpAux );
+
+        Blk blk = load( f, J.key, J.nC, J.blkTp );
+
+        cacheMtx.lock();
+
+        loading.erase( J.key );
+
+        if( blk ) {
+            insert( J.key, blk );
+            ++S.nPre;
+        }
+
+        condLoaded.wakeAll();
+    }
+
+    cacheMtx.unlock();
+}
@@ -0,0 +1,134 @@
+#ifndef DFBLOCKCACHE_H
+#define DFBLOCKCACHE_H
+
+#include "SGLTypes.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <thread>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Process-wide LRU cache of raw bin file blocks for the file
+// viewers, with a small pool of read-ahead threads.
+//
+// A block is blkTp whole timepoints of all nC saved channels,
+// block (iblk) starting at timepoint iblk*blkTp. Blocks are keyed
+// by FileID (path, size, mtime as of opening), so viewers of the
+// same file (and all linked viewers) share blocks, while a file
+// rewritten or grown since gets fresh ones. All files share one
+// byte budget; the least recently used blocks are evicted beyond
+// it, which is also how blocks of outdated FileIDs leave.
+//
+// get() returns a block, reading it on the calling thread on a
+// miss, or waiting for a pool thread already reading it.
+//
+// prefetch() replaces (owner's) still-queued requests with a new
+// list, taken in order, so stale read-ahead never delays what the
+// viewer wants next. Block reads overlap, which matters most for
+// network file systems.
+//
+class DFBlockCache
+{
+public:
+    typedef std::shared_ptr<const vec_i16>  Blk;
+
+    enum {
+        BLKBYTES    = 1024*1024,    // nominal block size
+        NTHD        = 3             // read-ahead threads
+    };
+
+    struct FileID {
+        QString path;
+        qint64  size,
+                mtime;  // msecs since epoch
+        FileID() : size(0), mtime(0)    {}
+        bool operator<( const FileID &rhs ) const;
+    };
+
+    struct Stats {
+        quint64 nGet,
+                nHit,
+                nWait,      // was in flight
+                nLoad,      // read by get()
+                nPre,       // read by pool
+                nEvict;
+        qint64  heldBytes;
+    };
+
+private:
+    typedef std::pair<FileID,qint64>    Key;
+
+    struct Entry {
+        Blk                         blk;
+        std::list<Key>::iterator    lru;
+    };
+
+    struct Job {
+        const void  *owner;
+        Key         key;
+        int         nC,
+                    blkTp;
+    };
+
+    std::map<Key,Entry>         cache;
+    std::list<Key>              lru;        // front = newest
+    std::set<Key>               loading;
+    std::deque<Job>             jobs;
+    std::vector<std::thread>    vT;
+    mutable QMutex              cacheMtx;
+    QWaitCondition              condLoaded,
+                                condJobs;
+    QFile                       syncFile;   // for get()
+    QMutex                      syncMtx;
+    Stats                       S;
+    qint64                      budget;
+    bool                        pleaseStop;
+
+public:
+    DFBlockCache( qint64 budget );
+    virtual ~DFBlockCache();
+
+    static DFBlockCache &global();
+    static int blockTpts( int nC )
+        {return qMax( 1, int(BLKBYTES / (nC * sizeof(qint16))) );}
+    static FileID fileID( const QString &path );
+
+    Blk get( const FileID &file, int nC, int blkTp, qint64 iblk );
+
+    void prefetch(
+        const void                  *owner,
+        const FileID                &file,
+        int                         nC,
+        int                         blkTp,
+        const std::vector<qint64>   &vblk );
+    void cancel( const void *owner );
+
+    void setBudget( qint64 bytes );
+    qint64 getBudget() const    {QMutexLocker ml( &cacheMtx ); return budget;}
+
+    Stats stats() const         {QMutexLocker ml( &cacheMtx ); return S;}
+    QString statsString() const;
+
+private:
+    static Blk load(
+        QFile       &f,
+        const Key   &key,
+        int         nC,
+        int         blkTp );
+    void insert( const Key &key, const Blk &blk );
+    void evict();
+    void run();
+};
+
+#endif  // DFBLOCKCACHE_H
@@ -0,0 +1,247 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "DFDirectWriter.h"
+
+#include <QMutex>
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+
+
+// O_DIRECT wants buffer address, file offset and length to be
+// multiples of the device block size; 4096 covers all current
+// disks. Chunks are large so each pwrite is one big request.
+//
+#define DIO_ALIGN       4096
+#define DIO_CHUNK       (4 * 1024 * 1024)
+#define DIO_POOL_MAX    16
+
+/* ---------------------------------------------------------------- */
+/* Chunk pool ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Files open and close at every trigger, so aligned chunks are
+// recycled rather than freed.
+
+static QMutex               poolMtx;
+static std::vector<char*>   pool;
+
+
+static char *chunkGet()
+{
+    {
+        QMutexLocker    ml( &poolMtx );
+
+        if( pool.size() ) {
+            char    *c = pool.back();
+            pool.pop_back();
+            return c;
+        }
+    }
+
+#ifdef Q_OS_LINUX
+    void    *c = 0;
+
+    if( posix_memalign( &c, DIO_ALIGN, DIO_CHUNK ) == 0 )
+        return (char*)c;
+#endif
+
+    return 0;
+}
+
+
+static void chunkPut( char *c )
+{
+    if( !c )
+        return;
+
+    {
+        QMutexLocker    ml( &poolMtx );
+
+        if( pool.size() < DIO_POOL_MAX ) {
+            pool.push_back( c );
+            return;
+        }
+    }
+
+    free( c );
+}
+
+/* ---------------------------------------------------------------- */
+/* DFDirectWriter ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool DFDirectWriter::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+bool DFDirectWriter::open( const QString &path )
+{
+    close();
+
+    this->path  = path;
+    err.clear();
+    fill        = 0;
+    off         = 0;
+
+#ifdef Q_OS_LINUX
+    fd = ::open(
+            path.toLocal8Bit().constData(),
+            O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644 );
+
+    if( fd < 0 ) {
+        setErr( "open" );
+        return false;
+    }
+
+    if( !(buf = chunkGet()) ) {
+        err = "no memory for aligned buffer";
+        ::close( fd );
+        fd = -1;
+        return false;
+    }
+
+    return true;
+#else
+    err = "O_DIRECT not supported on this OS";
+    return false;
+#endif
+}
+
+
+bool DFDirectWriter::write( const void *src, qint64 bytes )
+{
+    if( fd < 0 )
+        return false;
+
+    const char  *s = (const char*)src;
+
+    while( bytes > 0 ) {
+
+        qint64  n = qMin( bytes, qint64(DIO_CHUNK) - fill );
+
+        memcpy( buf + fill, s, n );
+        fill    += n;
+        s       += n;
+        bytes   -= n;
+
+        if( fill == DIO_CHUNK && !flushChunk( DIO_CHUNK ) )
+            return false;
+    }
+
+    return true;
+}
+
+
+// Write the aligned part of the staging chunk directly,
+// then drop O_DIRECT and append the remainder.
+//
+bool DFDirectWriter::close()
+{
+    if( fd < 0 )
+        return true;
+
+    bool    ok = true;
+
+#ifdef Q_OS_LINUX
+    qint64  aligned = fill & ~qint64(DIO_ALIGN - 1),
+            tail    = fill - aligned;
+
+    if( aligned && !flushChunk( aligned ) )
+        ok = false;
+
+    if( ok && tail ) {
+
+        int flags = fcntl( fd, F_GETFL );
+
+        if( flags == -1 || fcntl( fd, F_SETFL, flags & ~O_DIRECT ) == -1 ) {
+            setErr( "fcntl" );
+            ok = false;
+        }
+        else if( pwrite( fd, buf, tail, off ) != tail ) {
+            setErr( "pwrite" );
+            ok = false;
+        }
+        else {
+            off += tail;
+            fill = 0;
+        }
+    }
+
+    if( ::close( fd ) != 0 && ok ) {
+        setErr( "close" );
+        ok = false;
+    }
+#endif
+
+    fd = -1;
+    chunkPut( buf );
+    buf = 0;
+
+    return ok;
+}
+
+
+// Write (bytes) from head of buf at file offset (off).
+// Any unwritten remainder shifts to head of buf.
+//
+bool DFDirectWriter::flushChunk( qint64 bytes )
+{
+#ifdef Q_OS_LINUX
+    qint64  done = 0;
+
+    while( done < bytes ) {
+
+        ssize_t n = pwrite( fd, buf + done, bytes - done, off + done );
+
+        if( n < 0 ) {
+            if( errno == EINTR )
+                continue;
+            setErr( "pwrite" );
+            return false;
+        }
+        else if( !n || (n & (DIO_ALIGN - 1)) ) {
+            err = "short direct write";
+            return false;
+        }
+
+        done += n;
+    }
+
+    off     += bytes;
+    fill    -= bytes;
+
+    if( fill )
+        memmove( buf, buf + bytes, fill );
+
+    return true;
+#else
+    Q_UNUSED( bytes )
+    return false;
+#endif
+}
+
+
+void DFDirectWriter::setErr( const char *op )
+{
+#ifdef Q_OS_LINUX
+    err = QString("%1: %2").arg( op ).arg( strerror( errno ) );
+#else
+    err = op;
+#endif
+}
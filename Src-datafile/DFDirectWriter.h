@@ -0,0 +1,52 @@
+#ifndef DFDIRECTWRITER_H
+#define DFDIRECTWRITER_H
+
+#include <QString>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Unbuffered (O_DIRECT) bin file writer, Linux only.
+//
+// Multi-probe recording at hundreds of MB/s through the page cache
+// leaves the kernel a large dirty backlog; when writeback kicks in,
+// write() can stall long enough to back up the DFWriter queues.
+// Here, samples are packed into a page-aligned staging chunk taken
+// from a process-wide pool, and each full chunk goes to disk in one
+// aligned pwrite that bypasses the cache.
+//
+// The unaligned tail is written in buffered mode at close().
+// open() fails if the OS or filesystem refuses O_DIRECT, in which
+// case the caller should fall back to QFile.
+//
+class DFDirectWriter
+{
+private:
+    QString     path,
+                err;
+    char        *buf;
+    qint64      fill,
+                off;
+    int         fd;
+
+public:
+    DFDirectWriter() : buf(0), fill(0), off(0), fd(-1)    {}
+    virtual ~DFDirectWriter()                           {close();}
+
+    static bool isSupported();
+
+    bool open( const QString &path );
+    bool write( const void *src, qint64 bytes );
+    bool close();
+
+    bool isOpen() const             {return fd >= 0;}
+    qint64 size() const             {return off + fill;}
+    const QString &errorString() const  {return err;}
+
+private:
+    bool flushChunk( qint64 bytes );
+    void setErr( const char *op );
+};
+
+#endif  // DFDIRECTWRITER_H
@@ -0,0 +1,569 @@
+#include "DFPyramid.h"
+#include "Util.h"
+
+#include <QFileInfo>
+#include <QThread>
+
+#include <limits.h>
+#include <string.h>
+
+
+#define PYR_VERSION     1
+#define PYR_RDBYTES     (8*1024*1024)   // worker read size
+
+static const char pyrMagic[8] = {'S','G','L','X','P','Y','R','1'};
+
+/* ---------------------------------------------------------------- */
+/* DFPyramid ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+QString DFPyramid::sidecarName( const QString &binName )
+{
+    if( binName.endsWith( ".bin", Qt::CaseInsensitive ) )
+        return binName.left( binName.size() - 4 ) + ".pyr";
+
+    return binName + ".pyr";
+}
+
+
+bool DFPyramid::open(
+    QString         &error,
+    const QString   &binName,
+    qint64          srcBytes,
+    int             nC )
+{
+    close();
+    error.clear();
+
+    QString name = sidecarName( binName );
+
+    f.setFileName( name );
+
+    if( !f.exists() ) {
+        error = QString("No pyramid file '%1'.").arg( name );
+        return false;
+    }
+
+    if( !f.open( QIODevice::ReadOnly ) ) {
+        error = QString("Pyramid error <%1> opening(read) '%2'.")
+                .arg( f.errorString() ).arg( name );
+        return false;
+    }
+
+// ------
+// Header
+// ------
+
+    DFPyrHdr    H;
+
+    if( f.read( (char*)&H, sizeof(H) ) != sizeof(H)
+        || memcmp( H.magic, pyrMagic, 8 )
+        || H.version != PYR_VERSION
+        || H.nC != quint32(nC)
+        || H.base != BASE
+        || H.step != STEP
+        || H.pageBins != PAGEBINS
+        || H.nLevels < 1 || H.nLevels > MAXLEVELS
+        || H.srcBytes != srcBytes ) {
+
+        error = QString("Pyramid file stale or invalid '%1'.").arg( name );
+        close();
+        return false;
+    }
+
+// -----
+// Index
+// -----
+
+    L.resize( H.nLevels );
+
+    bool    ok = f.seek( H.indexOff );
+
+    for( int il = 0; ok && il < int(H.nLevels); ++il ) {
+
+        Level   &V = L[il];
+
+        ok = f.read( (char*)&V.nBins, sizeof(qint64) ) == sizeof(qint64)
+                && V.nBins >= 0;
+
+        if( ok ) {
+
+            V.pageOff.resize( (V.nBins + PAGEBINS - 1) / PAGEBINS );
+
+            qint64  bytes = V.pageOff.size() * sizeof(qint64);
+
+            ok = !bytes || f.read( (char*)&V.pageOff[0], bytes ) == bytes;
+        }
+    }
+
+    if( !ok ) {
+        error = QString("Pyramid index corrupt '%1'.").arg( name );
+        close();
+        return false;
+    }
+
+    nSamps      = H.nSamps;
+    this->nC    = nC;
+
+    return true;
+}
+
+
+void DFPyramid::close()
+{
+    f.close();
+    L.clear();
+    nSamps  = 0;
+    nC      = 0;
+}
+
+
+// Return coarsest level with factor <= dwnSmp, or -1 if none.
+//
+int DFPyramid::levelFor( int dwnSmp ) const
+{
+    int level = -1;
+
+    for( int il = 0, nl = nLevels(); il < nl; ++il ) {
+
+        if( factor( il ) > dwnSmp )
+            break;
+
+        level = il;
+    }
+
+    return level;
+}
+
+
+// Fill dst with bins [bin0, bin0+nbin) of level, clipped to
+// level extent, as [bin][chan][min,max,mean].
+// Return count of bins read, or zero on error.
+//
+int DFPyramid::read( vec_i16 &dst, int level, qint64 bin0, int nbin ) const
+{
+    if( level < 0 || level >= nLevels() || bin0 < 0 )
+        return 0;
+
+    const Level &V = L[level];
+
+    if( bin0 + nbin > V.nBins )
+        nbin = int(V.nBins - bin0);
+
+    if( nbin <= 0 )
+        return 0;
+
+    qint64  binBytes = 3 * nC * sizeof(qint16);
+
+    dst.resize( qint64(nbin) * 3 * nC );
+
+    char    *d = (char*)&dst[0];
+
+    for( qint64 b = bin0, lim = bin0 + nbin; b < lim; ) {
+
+        qint64  ipg     = b / PAGEBINS,
+                inPg    = b - ipg * PAGEBINS,
+                n       = qMin( lim - b, PAGEBINS - inPg ),
+                bytes   = n * binBytes;
+
+        if( !f.seek( V.pageOff[ipg] + inPg * binBytes )
+            || f.read( d, bytes ) != bytes ) {
+
+            return 0;
+        }
+
+        d += bytes;
+        b += n;
+    }
+
+    return nbin;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFPyramidBuilder ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool DFPyramidBuilder::begin( const QString &binName, int nC )
+{
+    abort();
+    err.clear();
+
+    this->nC    = nC;
+    nSamps      = 0;
+
+    if( nC <= 0 ) {
+        err = "no channels";
+        return false;
+    }
+
+    f.setFileName( DFPyramid::sidecarName( binName ) );
+
+    if( !f.open( QIODevice::WriteOnly ) ) {
+        err = QString("<%1> opening(write) '%2'")
+                .arg( f.errorString() ).arg( f.fileName() );
+        return false;
+    }
+
+// Placeholder header, sealed by finish()
+
+    DFPyrHdr    H;
+    memset( &H, 0, sizeof(H) );
+
+    if( f.write( (char*)&H, sizeof(H) ) != sizeof(H) ) {
+        err = QString("<%1> writing '%2'")
+                .arg( f.errorString() ).arg( f.fileName() );
+        abort();
+        return false;
+    }
+
+    addLevel();
+
+    return true;
+}
+
+
+bool DFPyramidBuilder::update( const qint16 *src, int ntpts )
+{
+    if( !f.isOpen() )
+        return false;
+
+// Level 0 takes raw timepoints, a bin boundary at a time
+
+    while( ntpts > 0 ) {
+
+        Acc     &a  = A[0];
+        int     n   = qMin( ntpts, DFPyramid::BASE - a.nIn );
+        qint16  *mn = &a.vmin[0],
+                *mx = &a.vmax[0];
+        qint64  *sm = &a.sum[0];
+
+        for( int it = 0; it < n; ++it, src += nC ) {
+
+            for( int ic = 0; ic < nC; ++ic ) {
+
+                qint16  v = src[ic];
+
+                if( v < mn[ic] )
+                    mn[ic] = v;
+                if( v > mx[ic] )
+                    mx[ic] = v;
+
+                sm[ic] += v;
+            }
+        }
+
+        a.nIn   += n;
+        a.cnt   += n;
+        nSamps  += n;
+        ntpts   -= n;
+
+        if( a.nIn == DFPyramid::BASE )
+            emitBin( 0 );
+    }
+
+    return err.isEmpty();
+}
+
+
+// Flush partial bins upward, drop levels coarser than needed,
+// then write last pages, index, and the real header.
+//
+bool DFPyramidBuilder::finish( qint64 srcBytes )
+{
+    if( !f.isOpen() )
+        return false;
+
+    if( !nSamps ) {
+        abort();
+        return true;
+    }
+
+    for( int il = 0; il < int(A.size()); ++il ) {
+
+        if( A[il].nIn )
+            emitBin( il, false );
+    }
+
+    while( A.size() > 1 && A[A.size() - 2].nBins <= 1 )
+        A.pop_back();
+
+    for( int il = 0, nl = int(A.size()); il < nl; ++il )
+        writePage( il );
+
+    DFPyrHdr    H;
+
+    memcpy( H.magic, pyrMagic, 8 );
+    H.version   = PYR_VERSION;
+    H.nC        = nC;
+    H.base      = DFPyramid::BASE;
+    H.step      = DFPyramid::STEP;
+    H.nLevels   = quint32(A.size());
+    H.pageBins  = DFPyramid::PAGEBINS;
+    H.srcBytes  = srcBytes;
+    H.nSamps    = nSamps;
+    H.indexOff  = f.pos();
+
+    for( int il = 0, nl = int(A.size()); err.isEmpty() && il < nl; ++il ) {
+
+        const Acc   &a      = A[il];
+        qint64      bytes   = a.pageOff.size() * sizeof(qint64);
+
+        if( f.write( (char*)&a.nBins, sizeof(qint64) ) != sizeof(qint64)
+            || (bytes && f.write( (char*)&a.pageOff[0], bytes ) != bytes) ) {
+
+            err = QString("<%1> writing '%2'")
+                    .arg( f.errorString() ).arg( f.fileName() );
+        }
+    }
+
+    if( err.isEmpty()
+        && (!f.seek( 0 ) || f.write( (char*)&H, sizeof(H) ) != sizeof(H)) ) {
+
+        err = QString("<%1> writing '%2'")
+                .arg( f.errorString() ).arg( f.fileName() );
+    }
+
+    if( !err.isEmpty() ) {
+        abort();
+        return false;
+    }
+
+    f.close();
+    A.clear();
+
+    return true;
+}
+
+
+// Discard partial output.
+//
+void DFPyramidBuilder::abort()
+{
+    if( f.isOpen() ) {
+        f.close();
+        f.remove();
+    }
+
+    A.clear();
+}
+
+
+void DFPyramidBuilder::addLevel()
+{
+    A.push_back( Acc() );
+
+    Acc &a = A.back();
+
+    a.vmin.assign( nC, SHRT_MAX );
+    a.vmax.assign( nC, SHRT_MIN );
+    a.sum.assign( nC, 0 );
+    a.nBins     = 0;
+    a.cnt       = 0;
+    a.nIn       = 0;
+    a.pageFill  = 0;
+}
+
+
+// Store current bin of (level) in its page and merge it into the
+// next level up, adding that level if needed (and grow allowed).
+// Pages grow on demand: coarse levels, which emit few bins,
+// never hold a full page.
+//
+void DFPyramidBuilder::emitBin( int level, bool grow )
+{
+    {
+        Acc     &a      = A[level];
+        size_t  need    = size_t(a.pageFill + 1) * 3 * nC;
+
+        if( a.page.size() < need )
+            a.page.resize( need );
+
+        qint16  *p = &a.page[a.pageFill * 3 * nC];
+
+        for( int ic = 0; ic < nC; ++ic, p += 3 ) {
+            p[0] = a.vmin[ic];
+            p[1] = a.vmax[ic];
+            p[2] = qint16(a.sum[ic] / a.cnt);
+        }
+
+        ++a.nBins;
+
+        if( ++a.pageFill == DFPyramid::PAGEBINS )
+            writePage( level );
+    }
+
+    if( level + 1 >= int(A.size()) && grow && level + 1 < DFPyramid::MAXLEVELS )
+        addLevel();
+
+    Acc &a = A[level];
+
+    if( level + 1 < int(A.size()) ) {
+
+        Acc &u = A[level + 1];
+
+        for( int ic = 0; ic < nC; ++ic ) {
+
+            if( a.vmin[ic] < u.vmin[ic] )
+                u.vmin[ic] = a.vmin[ic];
+            if( a.vmax[ic] > u.vmax[ic] )
+                u.vmax[ic] = a.vmax[ic];
+
+            u.sum[ic] += a.sum[ic];
+        }
+
+        u.cnt += a.cnt;
+        ++u.nIn;
+    }
+
+    a.vmin.assign( nC, SHRT_MAX );
+    a.vmax.assign( nC, SHRT_MIN );
+    a.sum.assign( nC, 0 );
+    a.cnt   = 0;
+    a.nIn   = 0;
+
+    if( level + 1 < int(A.size()) && A[level + 1].nIn == DFPyramid::STEP )
+        emitBin( level + 1, grow );
+}
+
+
+bool DFPyramidBuilder::writePage( int level )
+{
+    Acc &a = A[level];
+
+    if( !a.pageFill )
+        return true;
+
+    qint64  bytes = qint64(a.pageFill) * 3 * nC * sizeof(qint16);
+
+    a.pageOff.push_back( f.pos() );
+    a.pageFill = 0;
+
+    if( f.write( (char*)&a.page[0], bytes ) != bytes ) {
+
+        if( err.isEmpty() ) {
+            err = QString("<%1> writing '%2'")
+                    .arg( f.errorString() ).arg( f.fileName() );
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFPyramidWorker ------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+void DFPyramidWorker::run()
+{
+    QFile   bf( binName );
+
+    if( !bf.open( QIODevice::ReadOnly ) ) {
+        Warning() <<
+        QString("Pyramid build error <%1> opening(read) '%2'.")
+        .arg( bf.errorString() ).arg( binName );
+        emit finished();
+        return;
+    }
+
+    DFPyramidBuilder    B;
+    qint64              size    = bf.size(),
+                        done    = 0;
+    int                 tpBytes = nC * sizeof(qint16),
+                        nTp     = qMax( 1, PYR_RDBYTES / tpBytes ),
+                        lastPct = 0;
+    vec_i16             buf( qint64(nTp) * nC );
+
+    if( !B.begin( binName, nC ) ) {
+        Warning() <<
+        QString("Pyramid build error %1.").arg( B.errorString() );
+        emit finished();
+        return;
+    }
+
+    for(;;) {
+
+        if( isStopped() ) {
+            B.abort();
+            emit finished();
+            return;
+        }
+
+        qint64  n = bf.read( (char*)&buf[0], qint64(nTp) * tpBytes );
+
+        if( n < 0 ) {
+            Warning() <<
+            QString("Pyramid build error <%1> reading '%2'.")
+            .arg( bf.errorString() ).arg( binName );
+            B.abort();
+            emit finished();
+            return;
+        }
+
+        if( n < tpBytes )
+            break;
+
+        if( !B.update( &buf[0], int(n / tpBytes) ) )
+            break;
+
+        done += n;
+
+        int pct = int(100 * done / size);
+
+        if( pct >= lastPct + 5 ) {
+            lastPct = pct;
+            emit progress( pct );
+        }
+    }
+
+    if( !B.finish( size ) ) {
+        Warning() <<
+        QString("Pyramid build error %1.").arg( B.errorString() );
+    }
+    else
+        Debug() << "Built pyramid for " << binName;
+
+    emit finished();
+}
+
+/* ---------------------------------------------------------------- */
+/* DFPyramidThread ------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+DFPyramidThread::DFPyramidThread( const QString &binName, int nC )
+{
+    thread  = new QThread;
+    worker  = new DFPyramidWorker( binName, nC );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+}
+
+
+DFPyramidThread::~DFPyramidThread()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() ) {
+        worker->stop();
+        thread->wait();
+    }
+    else if( !thread->isFinished() )
+        delete worker;
+
+    delete thread;
+}
+
+
+// Low priority: the viewer stays responsive, using raw
+// reads until the build is done.
+//
+void DFPyramidThread::start()
+{
+    thread->start( QThread::LowPriority );
+}
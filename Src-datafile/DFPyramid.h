@@ -0,0 +1,187 @@
+#ifndef DFPYRAMID_H
+#define DFPYRAMID_H
+
+#include "SGLTypes.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QObject>
+
+class QThread;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Multi-resolution summary of a bin file, kept in a sidecar file
+// next to it: "name.bin" -> "name.pyr".
+//
+// Level L bins the file in runs of BASE*STEP^L timepoints; each bin
+// holds, for every saved channel, {min, max, mean} as int16, stored
+// [bin][chan][3]. A viewer drawing (dwnSmp) timepoints per point
+// reads a level instead of the raw samples, so wide spans cost
+// O(pixels) rather than O(samples). Total size is about 1% of the
+// bin file.
+//
+// File layout (little-endian):
+// - Header, magic written last, so partial files are rejected.
+// - Pages: runs of up to PAGEBINS bins of one level, in the order
+//   they were produced.
+// - Index at Header.indexOff: per level {nBins, page offsets}.
+//
+// Header.srcBytes must equal the bin file size or the sidecar is
+// stale and should be rebuilt.
+//
+struct DFPyrHdr {
+    char    magic[8];
+    quint32 version,
+            nC,
+            base,
+            step,
+            nLevels,
+            pageBins;
+    qint64  srcBytes,
+            nSamps,
+            indexOff;
+};
+
+
+class DFPyramid
+{
+public:
+    enum {
+        BASE        = 256,
+        STEP        = 4,
+        PAGEBINS    = 4096,
+        MAXLEVELS   = 12
+    };
+
+private:
+    struct Level {
+        qint64              nBins;
+        std::vector<qint64> pageOff;
+    };
+
+    mutable QFile       f;
+    std::vector<Level>  L;
+    qint64              nSamps;
+    int                 nC;
+
+public:
+    DFPyramid() : nSamps(0), nC(0) {}
+
+    static QString sidecarName( const QString &binName );
+    static qint64 factor( int level )   {return qint64(BASE) << (2*level);}
+
+    bool open(
+        QString         &error,
+        const QString   &binName,
+        qint64          srcBytes,
+        int             nC );
+    void close();
+
+    bool isOpen() const         {return L.size() > 0;}
+    int nLevels() const         {return int(L.size());}
+    qint64 nBins( int level ) const {return L[level].nBins;}
+    int levelFor( int dwnSmp ) const;
+
+    int read( vec_i16 &dst, int level, qint64 bin0, int nbin ) const;
+};
+
+
+// Streaming writer of a pyramid sidecar. Feed interleaved
+// timepoints in file order with update(); finish() flushes and
+// seals the file. Memory is O(nC * levels) for accumulators, plus
+// page buffers sized to the bins each level actually emits (at
+// most PAGEBINS, so only the finest levels fill whole pages).
+//
+// Used by DataFile while recording, and by DFPyramidWorker
+// to index existing files.
+//
+class DFPyramidBuilder
+{
+private:
+    struct Acc {
+        std::vector<qint16> vmin,
+                            vmax,
+                            page;
+        std::vector<qint64> sum,
+                            pageOff;
+        qint64              nBins,
+                            cnt;    // timepoints in current bin
+        int                 nIn,    // units in current bin
+                            pageFill;
+    };
+
+    QFile               f;
+    QString             err;
+    std::vector<Acc>    A;
+    qint64              nSamps;
+    int                 nC;
+
+public:
+    DFPyramidBuilder() : nSamps(0), nC(0)   {}
+    virtual ~DFPyramidBuilder()             {abort();}
+
+    bool begin( const QString &binName, int nC );
+    bool update( const qint16 *src, int ntpts );
+    bool finish( qint64 srcBytes );
+    void abort();
+
+    const QString &errorString() const  {return err;}
+
+private:
+    void addLevel();
+    void emitBin( int level, bool grow = true );
+    bool writePage( int level );
+};
+
+/* ---------------------------------------------------------------- */
+/* DFPyramidWorker ------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// Builds the sidecar for an existing bin file.
+//
+class DFPyramidWorker : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString         binName;
+    mutable QMutex  runMtx;
+    int             nC;
+    volatile bool   pleaseStop;
+
+public:
+    DFPyramidWorker( const QString &binName, int nC )
+    :   QObject(0), binName(binName), nC(nC), pleaseStop(false)  {}
+
+    void stop()             {QMutexLocker ml( &runMtx ); pleaseStop = true;}
+    bool isStopped() const  {QMutexLocker ml( &runMtx ); return pleaseStop;}
+
+signals:
+    void progress( int );
+    void finished();
+
+public slots:
+    void run();
+};
+
+
+// Caller connects to worker signals, then calls start().
+// Deleting the object cancels an unfinished build.
+//
+class DFPyramidThread
+{
+public:
+    QThread         *thread;
+    DFPyramidWorker *worker;
+
+public:
+    DFPyramidThread( const QString &binName, int nC );
+    virtual ~DFPyramidThread();
+
+    void start();
+};
+
+#endif  // DFPYRAMID_H
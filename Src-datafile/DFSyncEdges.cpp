@@ -0,0 +1,386 @@
+
+#include "DFSyncEdges.h"
+
+#include <QFileInfo>
+
+#include <string.h>
+
+#ifndef Q_OS_WIN
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+#define EDG_VERSION     1
+#define EDG_MAPBYTES    (64*1024*1024)  // reader map window
+#define EDG_RDBYTES     (8*1024*1024)   // reader fallback block
+
+static const char edgMagic[8] = {'S','G','L','X','E','D','G','1'};
+
+/* ---------------------------------------------------------------- */
+/* DFSyncEdgeScan ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void DFSyncEdgeScan::init( int nC, int ic, int bit, qint16 thresh )
+{
+    this->nC        = nC;
+    this->ic        = ic;
+    this->mask      = (bit >= 0 ? 1 << (bit % 16) : 0);
+    this->thresh    = thresh;
+    isHi            = false;
+    started         = false;
+}
+
+
+void DFSyncEdgeScan::scan(
+    std::vector<qint64> &edges,
+    const qint16        *src,
+    int                 ntpts,
+    qint64              pos0 )
+{
+    if( ntpts <= 0 )
+        return;
+
+    src += ic;
+
+    if( !started ) {
+        isHi    = high( *src );
+        started = true;
+    }
+
+    for( int i = 0; i < ntpts; ++i, src += nC ) {
+
+        if( isHi ) {
+
+            if( !high( *src ) )
+                isHi = false;
+        }
+        else if( high( *src ) ) {
+
+            edges.push_back( pos0 + i );
+            isHi = true;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* DFChanReader --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool DFChanReader::open(
+    QString         &error,
+    const QString   &binName,
+    int             nC,
+    int             ic )
+{
+    close();
+    error.clear();
+
+    if( nC <= 0 || ic < 0 || ic >= nC ) {
+        error = QString("Bad channel %1 of %2 for '%3'.")
+                .arg( ic ).arg( nC ).arg( binName );
+        return false;
+    }
+
+    f.setFileName( binName );
+
+    if( !f.open( QIODevice::ReadOnly ) ) {
+        error = QString("File error <%1> opening(read) '%2'.")
+                .arg( f.errorString() ).arg( binName );
+        return false;
+    }
+
+    this->nC    = nC;
+    this->ic    = ic;
+    nSamps      = f.size() / (nC * sizeof(qint16));
+
+    return true;
+}
+
+
+// Fill dst with num2read values of our channel from samp0,
+// clipped to file extent. Return count read, or -1 on error.
+//
+qint64 DFChanReader::read( vec_i16 &dst, qint64 samp0, qint64 num2read )
+{
+    dst.clear();
+
+    if( samp0 < 0 || samp0 >= nSamps )
+        return 0;
+
+    num2read = qMin( num2read, nSamps - samp0 );
+
+    if( num2read <= 0 )
+        return 0;
+
+    dst.resize( num2read );
+
+    qint64  tpBytes = nC * sizeof(qint16),
+            maxTp   = qMax( qint64(1), EDG_MAPBYTES / tpBytes ),
+            done    = 0;
+
+// ------------------
+// Mapped, by windows
+// ------------------
+
+    while( done < num2read ) {
+
+        qint64  ntp     = qMin( maxTp, num2read - done ),
+                len     = ntp * tpBytes;
+        uchar   *p      = f.map( (samp0 + done) * tpBytes, len );
+
+        if( !p )
+            break;
+
+#ifndef Q_OS_WIN
+        // Advice needs a page-aligned start
+        quintptr    pg  = sysconf( _SC_PAGESIZE ),
+                    a   = quintptr(p) & ~(pg - 1);
+        madvise( (void*)a, len + (quintptr(p) - a), MADV_SEQUENTIAL );
+#endif
+
+        const qint16    *s = (const qint16*)p + ic;
+        qint16          *d = &dst[done];
+
+        for( qint64 i = 0; i < ntp; ++i, s += nC )
+            *d++ = *s;
+
+        f.unmap( p );
+        done += ntp;
+    }
+
+    if( done == num2read )
+        return num2read;
+
+// -----------------------------
+// Fallback: block reads/extract
+// -----------------------------
+
+    maxTp = qMax( qint64(1), EDG_RDBYTES / tpBytes );
+
+    vec_i16 buf( qMin( maxTp, num2read - done ) * nC );
+
+    if( !f.seek( (samp0 + done) * tpBytes ) )
+        return -1;
+
+    while( done < num2read ) {
+
+        qint64  ntp     = qMin( maxTp, num2read - done ),
+                bytes   = ntp * tpBytes;
+
+        if( f.read( (char*)&buf[0], bytes ) != bytes )
+            return -1;
+
+        const qint16    *s = &buf[ic];
+        qint16          *d = &dst[done];
+
+        for( qint64 i = 0; i < ntp; ++i, s += nC )
+            *d++ = *s;
+
+        done += ntp;
+    }
+
+    return num2read;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFSyncEdges ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+QString DFSyncEdges::sidecarName( const QString &binName )
+{
+    if( binName.endsWith( ".bin", Qt::CaseInsensitive ) )
+        return binName.left( binName.size() - 4 ) + ".edges";
+
+    return binName + ".edges";
+}
+
+
+// Load all edges if sidecar exists, matches {nC, ic, bit}
+// and describes the current bin file.
+//
+bool DFSyncEdges::read(
+    QString             &error,
+    std::vector<qint64> &edges,
+    const QString       &binName,
+    int                 nC,
+    int                 ic,
+    int                 bit )
+{
+    edges.clear();
+    error.clear();
+
+    QFile   f( sidecarName( binName ) );
+
+    if( !f.exists() ) {
+        error = QString("No sync edge file '%1'.").arg( f.fileName() );
+        return false;
+    }
+
+    if( !f.open( QIODevice::ReadOnly ) ) {
+        error = QString("Sync edge error <%1> opening(read) '%2'.")
+                .arg( f.errorString() ).arg( f.fileName() );
+        return false;
+    }
+
+    DFEdgeHdr   H;
+
+    if( f.read( (char*)&H, sizeof(H) ) != sizeof(H)
+        || memcmp( H.magic, edgMagic, 8 )
+        || H.version != EDG_VERSION
+        || H.nC != quint32(nC)
+        || H.ic != quint32(ic)
+        || H.bit != bit
+        || H.srcBytes != QFileInfo( binName ).size()
+        || H.nEdges < 0
+        || f.size() != qint64(sizeof(H)) + H.nEdges * qint64(sizeof(qint64)) ) {
+
+        error = QString("Sync edge file stale or invalid '%1'.")
+                .arg( f.fileName() );
+        return false;
+    }
+
+    if( H.nEdges ) {
+
+        qint64  bytes = H.nEdges * sizeof(qint64);
+
+        edges.resize( H.nEdges );
+
+        if( f.read( (char*)&edges[0], bytes ) != bytes ) {
+            error = QString("Sync edge error <%1> reading '%2'.")
+                    .arg( f.errorString() ).arg( f.fileName() );
+            edges.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFSyncEdgeBuilder ---------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool DFSyncEdgeBuilder::begin(
+    const QString       &binName,
+    int                 nC,
+    int                 ic,
+    const DFSyncSpec    &S )
+{
+    abort();
+    err.clear();
+
+    this->nC    = nC;
+    this->ic    = ic;
+    bit         = S.bit;
+    thresh      = S.thresh;
+    nSamps      = 0;
+    nEdges      = 0;
+
+    if( ic < 0 || ic >= nC ) {
+        err = "sync channel not saved";
+        return false;
+    }
+
+    E.init( nC, ic, bit, S.thresh );
+
+    f.setFileName( DFSyncEdges::sidecarName( binName ) );
+
+    if( !f.open( QIODevice::WriteOnly ) ) {
+        err = QString("<%1> opening(write) '%2'")
+                .arg( f.errorString() ).arg( f.fileName() );
+        return false;
+    }
+
+// Placeholder header, sealed by finish()
+
+    DFEdgeHdr   H;
+    memset( &H, 0, sizeof(H) );
+
+    if( f.write( (char*)&H, sizeof(H) ) != sizeof(H) ) {
+        err = QString("<%1> writing '%2'")
+                .arg( f.errorString() ).arg( f.fileName() );
+        abort();
+        return false;
+    }
+
+    return true;
+}
+
+
+bool DFSyncEdgeBuilder::update( const qint16 *src, int ntpts )
+{
+    if( !f.isOpen() )
+        return false;
+
+    E.scan( edges, src, ntpts, nSamps );
+    nSamps += ntpts;
+
+    if( edges.size() ) {
+
+        qint64  bytes = edges.size() * sizeof(qint64);
+
+        if( f.write( (char*)&edges[0], bytes ) != bytes ) {
+            err = QString("<%1> writing '%2'")
+                    .arg( f.errorString() ).arg( f.fileName() );
+            abort();
+            return false;
+        }
+
+        nEdges += edges.size();
+        edges.clear();
+    }
+
+    return true;
+}
+
+
+bool DFSyncEdgeBuilder::finish( qint64 srcBytes )
+{
+    if( !f.isOpen() )
+        return false;
+
+    if( !nSamps ) {
+        abort();
+        return true;
+    }
+
+    DFEdgeHdr   H;
+    memset( &H, 0, sizeof(H) );
+
+    memcpy( H.magic, edgMagic, 8 );
+    H.version   = EDG_VERSION;
+    H.nC        = nC;
+    H.ic        = ic;
+    H.bit       = bit;
+    H.thresh    = thresh;
+    H.srcBytes  = srcBytes;
+    H.nSamps    = nSamps;
+    H.nEdges    = nEdges;
+
+    if( !f.seek( 0 ) || f.write( (char*)&H, sizeof(H) ) != sizeof(H) ) {
+        err = QString("<%1> writing '%2'")
+                .arg( f.errorString() ).arg( f.fileName() );
+        abort();
+        return false;
+    }
+
+    f.close();
+
+    return true;
+}
+
+
+// Discard partial output.
+//
+void DFSyncEdgeBuilder::abort()
+{
+    if( f.isOpen() ) {
+        f.close();
+        f.remove();
+    }
+
+    edges.clear();
+}
+
+
@@ -0,0 +1,159 @@
+#ifndef DFSYNCEDGES_H
+#define DFSYNCEDGES_H
+
+#include "SGLTypes.h"
+
+#include <QFile>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Where a stream carries the sync pulser: a bit of a digital word,
+// or (bit < 0) an analog channel crossing thresh (int16 units).
+//
+struct DFSyncSpec {
+    int     acqChan,    // orig (acq) id
+            bit;
+    qint16  thresh;
+
+    DFSyncSpec() : acqChan(-1), bit(-1), thresh(0)  {}
+};
+
+
+// Rising edge detector for one channel of interleaved timepoints.
+// State carries across calls, so blocks can be fed in file order.
+// The level of the very first sample only initializes the state;
+// it never counts as an edge.
+//
+class DFSyncEdgeScan
+{
+private:
+    int     nC,
+            ic,
+            mask;
+    qint16  thresh;
+    bool    isHi,
+            started;
+
+public:
+    DFSyncEdgeScan()
+    :   nC(1), ic(0), mask(0), thresh(0), isHi(false), started(false)  {}
+
+    void init( int nC, int ic, int bit, qint16 thresh );
+
+    // Append to edges the timepoints (pos0 + i) of rising edges.
+    void scan(
+        std::vector<qint64> &edges,
+        const qint16        *src,
+        int                 ntpts,
+        qint64              pos0 );
+
+private:
+    bool high( qint16 v ) const
+        {return (mask ? (v & mask) != 0 : v > thresh);}
+};
+
+
+// Reads a single channel of a bin file without building
+// full timepoints. The file is mapped a window at a time,
+// with sequential access advised where the OS supports it,
+// so only one int16 per timepoint is copied out. If mapping
+// fails, falls back to large block reads.
+//
+class DFChanReader
+{
+private:
+    QFile   f;
+    qint64  nSamps;
+    int     nC,
+            ic;
+
+public:
+    DFChanReader() : nSamps(0), nC(0), ic(0)    {}
+
+    bool open( QString &error, const QString &binName, int nC, int ic );
+    void close()                {f.close(); nSamps = 0;}
+    qint64 sampCount() const    {return nSamps;}
+
+    qint64 read( vec_i16 &dst, qint64 samp0, qint64 num2read );
+};
+
+
+// Sync edge sidecar, written while recording so sample rate
+// calibration needs no rescan: "name.bin" -> "name.edges".
+//
+// Layout (little-endian): header, magic written last so partial
+// files are rejected; then nEdges qint64 timepoints of rising
+// edges, relative to the first sample of the bin file. About
+// 30 KB per hour for a 1 Hz pulser.
+//
+// Header.srcBytes must equal the bin file size or the sidecar
+// is stale.
+//
+struct DFEdgeHdr {
+    char    magic[8];
+    quint32 version,
+            nC,
+            ic;
+    qint32  bit,
+            thresh;
+    quint32 pad;
+    qint64  srcBytes,
+            nSamps,
+            nEdges;
+};
+
+
+class DFSyncEdges
+{
+public:
+    static QString sidecarName( const QString &binName );
+
+    static bool read(
+        QString             &error,
+        std::vector<qint64> &edges,
+        const QString       &binName,
+        int                 nC,
+        int                 ic,
+        int                 bit );
+};
+
+
+// Streaming writer of a sync edge sidecar. Feed interleaved
+// timepoints in file order with update(); finish() seals it.
+//
+class DFSyncEdgeBuilder
+{
+private:
+    QFile               f;
+    QString             err;
+    DFSyncEdgeScan      E;
+    std::vector<qint64> edges;
+    qint64              nSamps,
+                        nEdges;
+    int                 nC,
+                        ic,
+                        bit,
+                        thresh;
+
+public:
+    DFSyncEdgeBuilder()
+    :   nSamps(0), nEdges(0), nC(0), ic(0), bit(0), thresh(0)   {}
+    virtual ~DFSyncEdgeBuilder()    {abort();}
+
+    bool begin(
+        const QString       &binName,
+        int                 nC,
+        int                 ic,
+        const DFSyncSpec    &S );
+    bool update( const qint16 *src, int ntpts );
+    bool finish( qint64 srcBytes );
+    void abort();
+
+    const QString &errorString() const  {return err;}
+};
+
+#endif  // DFSYNCEDGES_H
+
+
@@ -1,7 +1,12 @@
 
 #include "DataFile.h"
 #include "DataFile_Helpers.h"
+#include "DFDirectWriter.h"
+#include "DFPyramid.h"
+#include "DFSyncEdges.h"
+#include "FileChecksum.h"
 #include "DFName.h"
+#include "SampleBufPool.h"
 #include "Util.h"
 #include "MainApp.h"
 #include "Subset.h"
@@ -19,6 +24,21 @@ DataFile::ORec::~ORec()
 {
     if( dfw )
         delete dfw;
+
+    if( dfh )
+        delete dfh;
+
+    if( dio )
+        delete dio;
+
+    if( tcrc )
+        delete tcrc;
+
+    if( pyr )
+        delete pyr;
+
+    if( edg )
+        delete edg;
 }
 
 /* ---------------------------------------------------------------- */
@@ -28,7 +48,8 @@ DataFile::ORec::~ORec()
 DataFile::DataFile( int ip )
     :   sampCt(0), mode(Undefined),
         i_trgStream(DAQ::Params::jsip2stream( jsNI, 0 )),
-        i_trgChan(-1), o_wrAsync(true),
+        i_trgChan(-1), o_wrAsync(true), o_wrDirect(false),
+        o_wrTreeCRC(false), o_wrPyramid(false), o_wrSyncEdges(false),
         sRate(0), ip(ip), nSavedChans(0)
 {
 }
@@ -543,14 +564,8 @@ bool DataFile::openForWrite(
             QString bName = o_baseName +
                                 QString("imec%1.ap.bin").arg( 1000 + 10*ip + is );
 
-            R.binFile.setFileName( bName );
-
-            if( !R.binFile.open( QIODevice::WriteOnly ) ) {
-                Error() <<
-                QString("File error <%1> opening(write) '%2'.")
-                .arg( R.binFile.errorString() ).arg( bName );
+            if( !openBinFile( R, bName ) )
                 return false;
-            }
 
             R.iKeep     = shk[is];
             R.kvp       = kvp;
@@ -592,14 +607,8 @@ bool DataFile::openForWrite(
 
         QString bName = o_baseName + fileLblFromObj() + ".bin";
 
-        R.binFile.setFileName( bName );
-
-        if( !R.binFile.open( QIODevice::WriteOnly ) ) {
-            Error() <<
-            QString("File error <%1> opening(write) '%2'.")
-            .arg( R.binFile.errorString() ).arg( bName );
+        if( !openBinFile( R, bName ) )
             return false;
-        }
 
         if( nSavedChans < o_nAcqChans )
             R.iKeep = snsFileChans;
@@ -616,6 +625,70 @@ bool DataFile::openForWrite(
         Debug() << "Outfile: " << bName;
     }
 
+// ---------------
+// Pyramid sidecar
+// ---------------
+
+    if( o_wrPyramid ) {
+
+        for( int j = 0, n = int(o_rec.size()); j < n; ++j ) {
+
+            ORec    &R = *o_rec[j];
+
+            R.pyr = new DFPyramidBuilder;
+
+            if( !R.pyr->begin(
+                    R.binFile.fileName(),
+                    R.iKeep.size() ? R.iKeep.size() : o_nAcqChans ) ) {
+
+                Warning() <<
+                QString("Pyramid file error %1; not indexing '%2'.")
+                .arg( R.pyr->errorString() ).arg( R.binFile.fileName() );
+
+                delete R.pyr;
+                R.pyr = 0;
+            }
+        }
+    }
+
+// -----------------
+// Sync edge sidecar
+// -----------------
+
+    DFSyncSpec  sy;
+
+    if( o_wrSyncEdges
+        && p.sync.sourceIdx != DAQ::eSyncSourceNone
+        && subclassSyncSpec( sy, p ) ) {
+
+        for( int j = 0, n = int(o_rec.size()); j < n; ++j ) {
+
+            ORec    &R  = *o_rec[j];
+            int     ic  = (R.iKeep.size() ?
+                            R.iKeep.indexOf( (uint)sy.acqChan ) : sy.acqChan);
+
+            // Split files lacking sync word get none
+
+            if( ic < 0 )
+                continue;
+
+            R.edg = new DFSyncEdgeBuilder;
+
+            if( !R.edg->begin(
+                    R.binFile.fileName(),
+                    R.iKeep.size() ? R.iKeep.size() : o_nAcqChans,
+                    ic, sy ) ) {
+
+                Warning() <<
+                QString("Sync edge file error %1; not indexing '%2'.")
+                .arg( R.edg->errorString() ).arg( R.binFile.fileName() );
+
+                delete R.edg;
+                R.edg = 0;
+            }
+        }
+    }
+
 // ----------
 // State data
 // ----------
@@ -746,23 +819,72 @@ bool DataFile::closeAndFinalize()
 
             ORec    &R = *o_rec[j];
 
+            // Drain writer then hasher queues and flush
+            // file tail before taking size and sums.
+
+            if( R.dfw ) {
+                delete R.dfw;
+                R.dfw = 0;
+            }
+
+            if( R.dfh ) {
+                delete R.dfh;
+                R.dfh = 0;
+            }
+
+            if( R.dio && !R.dio->close() ) {
+                Error() <<
+                QString("File error <%1> closing(direct) '%2'.")
+                .arg( R.dio->errorString() ).arg( R.binFile.fileName() );
+                ok = false;
+            }
+
+            qint64  binBytes = (R.dio ? R.dio->size() : R.binFile.size());
+
+            if( R.pyr ) {
+
+                if( !R.pyr->finish( binBytes ) ) {
+                    Warning() <<
+                    QString("Pyramid file error %1 for '%2'.")
+                    .arg( R.pyr->errorString() ).arg( R.binFile.fileName() );
+                }
+
+                delete R.pyr;
+                R.pyr = 0;
+            }
+
+            if( R.edg ) {
+
+                if( !R.edg->finish( binBytes ) ) {
+                    Warning() <<
+                    QString("Sync edge file error %1 for '%2'.")
+                    .arg( R.edg->errorString() ).arg( R.binFile.fileName() );
+                }
+
+                delete R.edg;
+                R.edg = 0;
+            }
+
             R.sha.Final();
             std::basic_string<char> hStr;
             R.sha.ReportHashStl( hStr, CSHA1::REPORT_HEX_SHORT );
 
             R.kvp["fileSHA1"]         = hStr.c_str();
+
+            if( R.tcrc ) {
+                R.kvp["fileTreeCRC32C"]      = TreeCRC::toString( R.tcrc->final() );
+                R.kvp["fileTreeCRCBlkBytes"] = R.tcrc->blockBytes();
+            }
+
             R.kvp["fileTimeSecs"]     = fileTimeSecs();
-            R.kvp["fileSizeBytes"]    = R.binFile.size();
+            R.kvp["fileSizeBytes"]    = binBytes;
             R.kvp["appVersion"]       = QString("%1").arg( VERS_SGLX, 0, 16 );
 
-            ok = R.kvp.toMetaFile( R.metaName );
+            if( !R.kvp.toMetaFile( R.metaName ) )
+                ok = false;
 
             Log() << ">> Completed " << R.binFile.fileName();
 
-            if( R.dfw ) {
-                delete R.dfw;
-                R.dfw = 0;
-            }
             R.binFile.close();
         }
     }
@@ -853,18 +975,23 @@ bool DataFile::writeAndInvalSamps( vec_i16 &samps )
 
             ORec    &R = *o_rec[j];
 
-            if( !R.dfw )
+            if( !R.dfw ) {
+                R.dfh = new DFHasher( this, j, 4000 );
                 R.dfw = new DFWriter( this, j, 4000 );
+            }
 
             if( R.iKeep.size() ) {
                 vec_i16 rsamps;
+                SampleBufPool::global().get(
+                    rsamps, samps.size() / o_nAcqChans * R.iKeep.size() );
                 Subset::subset( rsamps, samps, R.iKeep, o_nAcqChans );
                 R.dfw->worker->enqueue( rsamps );
             }
             else
                 R.dfw->worker->enqueue( samps );
 
-            if( R.dfw->worker->percentFull() >= 95.0 ) {
+            if( qMax( R.dfw->worker->percentFull(),
+                      R.dfh->worker->percentFull() ) >= 95.0 ) {
                 Error() << "Datafile queue overflow; stopping run.";
                 return false;
             }
@@ -873,7 +1000,129 @@ bool DataFile::writeAndInvalSamps( vec_i16 &samps )
         return true;
     }
 
-    return doFileWrite( samps, 0 );
+    if( !doFileWrite( samps, 0 ) )
+        return false;
+
+    doFileHash( samps, 0 );
+    return true;
+}
+
+/* ---------------------------------------------------------------- */
+/* writeAndInvalView ---------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Zero-copy variant of writeAndInvalSamps: each output record
+// copies or subsets its channels straight out of the AIQ ring,
+// so the full-width block is never duplicated. Nothing is
+// queued unless the view is still intact after the copy.
+//
+// Blocks come from SampleBufPool and go back to it once hashed.
+//
+bool DataFile::writeAndInvalView( const AIQ::View &V )
+{
+// -------------------
+// Check stupid errors
+// -------------------
+
+    if( mode != Output )
+        return false;
+
+    int ntpts = V.nTpts();
+
+    if( !ntpts )
+        return true;
+
+    if( V.nchans != o_nAcqChans ) {
+        Error()
+            << "writeAndInval: View chan count ("
+            << V.nchans
+            << ") not acquired count ("
+            << o_nAcqChans
+            << ") [stream: "
+            << fileLblFromObj()
+            << "].";
+        return false;
+    }
+
+// --------------------
+// Copy out of the ring
+// --------------------
+
+    int                     nrec = int(o_rec.size());
+    std::vector<vec_i16>    &vS  = o_vS;
+
+    vS.resize( nrec );
+
+    for( int j = 0; j < nrec; ++j ) {
+
+        const ORec  &R = *o_rec[j];
+
+        SampleBufPool::global().get(
+            vS[j], ntpts * (R.iKeep.size() ? R.iKeep.size() : o_nAcqChans) );
+
+        for( int k = 0; k < 2; ++k ) {
+
+            if( V.ntpts[k] ) {
+
+                if( R.iKeep.size() ) {
+                    Subset::appendSubset(
+                        vS[j], V.src[k], V.ntpts[k], R.iKeep, o_nAcqChans );
+                }
+                else {
+                    vS[j].insert(
+                        vS[j].end(),
+                        V.src[k], V.src[k] + V.ntpts[k] * o_nAcqChans );
+                }
+            }
+        }
+    }
+
+    if( !V.intact() ) {
+        Error()
+            << "writeAndInval: Samples overwritten during copy [stream: "
+            << fileLblFromObj()
+            << "].";
+        return false;
+    }
+
+// --------------
+// Update counter
+// --------------
+
+    sampCt += ntpts;
+
+// -----
+// Write
+// -----
+
+    if( o_wrAsync ) {
+
+        for( int j = 0; j < nrec; ++j ) {
+
+            ORec    &R = *o_rec[j];
+
+            if( !R.dfw ) {
+                R.dfh = new DFHasher( this, j, 4000 );
+                R.dfw = new DFWriter( this, j, 4000 );
+            }
+
+            R.dfw->worker->enqueue( vS[j] );
+
+            if( qMax( R.dfw->worker->percentFull(),
+                      R.dfh->worker->percentFull() ) >= 95.0 ) {
+                Error() << "Datafile queue overflow; stopping run.";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if( !doFileWrite( vS[0], 0 ) )
+        return false;
+
+    doFileHash( vS[0], 0 );
+    return true;
 }
 
 /* ---------------------------------------------------------------- */
@@ -1153,9 +1402,10 @@ const QVariant DataFile::getParam( const QString &name ) const
 /* verifySHA1 ----------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
+// Checks tree CRC if metadata has one (all cores), else SHA1.
+//
 bool DataFile::verifySHA1( const QString &filename )
 {
-    CSHA1       sha1;
     KVParams    kvp;
 
     if( !kvp.fromMetaFile( DFName::forceMetaSuffix( filename ) ) ) {
@@ -1167,33 +1417,22 @@ bool DataFile::verifySHA1( const QString &filename )
         return false;
     }
 
-    if( !sha1.HashFile( STR2CHR( filename ) ) ) {
+    QString err, how;
 
-        Error()
-            << "verifySHA1 could not read file '"
-            << filename
-            << "'.";
-        return false;
-    }
-
-    std::basic_string<char> hStr;
-    sha1.ReportHashStl( hStr, CSHA1::REPORT_HEX_SHORT );
-
-    QString hash        = hStr.c_str();
-    QString hashSaved   = kvp["fileSHA1"].toString().trimmed();
-
-    if( hashSaved.length() != 40 ) {
+    if( FileChecksum::Success != FileChecksum::verify(
+                                    err, how,
+                                    DFName::forceBinSuffix( filename ),
+                                    kvp ) ) {
 
         Error()
-            << "verifySHA1: Bad metadata hash: ["
-            << hashSaved
-            << "].";
+            << "verifySHA1 ("
+            << how
+            << "): "
+            << err;
         return false;
     }
 
-    hash = hash.trimmed();
-
-    return 0 == hash.compare( hashSaved, Qt::CaseInsensitive );
+    return true;
 }
 
 /* ---------------------------------------------------------------- */
@@ -1206,8 +1445,11 @@ double DataFile::percentFull() const
 
     for( int j = 0, n = int(o_rec.size()); j < n; ++j ) {
         DFWriter    *dfw = o_rec[j]->dfw;
+        DFHasher    *dfh = o_rec[j]->dfh;
         if( dfw )
             pct = qMax( pct, dfw->worker->percentFull() );
+        if( dfh )
+            pct = qMax( pct, dfh->worker->percentFull() );
     }
 
     return pct;
@@ -1238,6 +1480,48 @@ double DataFile::writtenBytes() const
     return sum;
 }
 
+/* ---------------------------------------------------------------- */
+/* openBinFile ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// With setDirectIO(true), try the unbuffered writer first,
+// falling back to a regular (page cached) QFile if refused.
+// binFile always carries the name.
+//
+// With setTreeCRC(true), the tree checksum is tallied too.
+//
+bool DataFile::openBinFile( ORec &R, const QString &bName )
+{
+    R.binFile.setFileName( bName );
+
+    if( o_wrTreeCRC )
+        R.tcrc = new TreeCRC;
+
+    if( o_wrDirect && DFDirectWriter::isSupported() ) {
+
+        R.dio = new DFDirectWriter;
+
+        if( R.dio->open( bName ) )
+            return true;
+
+        Warning() <<
+        QString("Direct I/O unavailable <%1> for '%2'; using buffered writes.")
+        .arg( R.dio->errorString() ).arg( bName );
+
+        delete R.dio;
+        R.dio = 0;
+    }
+
+    if( !R.binFile.open( QIODevice::WriteOnly ) ) {
+        Error() <<
+        QString("File error <%1> opening(write) '%2'.")
+        .arg( R.binFile.errorString() ).arg( bName );
+        return false;
+    }
+
+    return true;
+}
+
 /* ---------------------------------------------------------------- */
 /* doFileWrite ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -1248,8 +1532,14 @@ bool DataFile::doFileWrite( const vec_i16 &samps, int j )
 
     int n2Write = int(samps.size()) * sizeof(qint16);
 
-//    int nWrit = writeChunky( R->binFile, &samps[0], n2Write );
-    int nWrit = R.binFile.write( (char*)&samps[0], n2Write );
+    int nWrit;
+
+    if( R.dio )
+        nWrit = (R.dio->write( &samps[0], n2Write ) ? n2Write : 0);
+    else {
+//        nWrit = writeChunky( R->binFile, &samps[0], n2Write );
+        nWrit = R.binFile.write( (char*)&samps[0], n2Write );
+    }
 
     R.statsMtx.lock();
         R.statsBytes.push_back( nWrit );
@@ -1258,13 +1548,59 @@ bool DataFile::doFileWrite( const vec_i16 &samps, int j )
     if( nWrit != n2Write ) {
         Error() <<
         QString("File error <%1> writing(bin) '%2'.")
-        .arg( R.binFile.errorString() ).arg( R.binFile.fileName() );
+        .arg( R.dio ? R.dio->errorString() : R.binFile.errorString() )
+        .arg( R.binFile.fileName() );
         return false;
     }
 
-    R.sha.Update( (const UINT_8*)&samps[0], n2Write );
-
     return true;
 }
 
+/* ---------------------------------------------------------------- */
+/* doFileHash ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Sums, plus the viewer's pyramid and sync edge sidecars
+// if enabled; all want the bytes exactly as written.
+//
+void DataFile::doFileHash( const vec_i16 &samps, int j )
+{
+    ORec    &R = *o_rec[j];
+
+    int n2Hash = int(samps.size()) * sizeof(qint16);
+
+    R.sha.Update( (const UINT_8*)&samps[0], n2Hash );
+
+    if( R.tcrc )
+        R.tcrc->update( &samps[0], n2Hash );
+
+    int nC = (R.iKeep.size() ? R.iKeep.size() : o_nAcqChans);
+
+    if( R.pyr ) {
+
+        if( !R.pyr->update( &samps[0], int(samps.size()) / nC ) ) {
+
+            Warning() <<
+            QString("Pyramid file error %1; not indexing '%2'.")
+            .arg( R.pyr->errorString() ).arg( R.binFile.fileName() );
+
+            delete R.pyr;
+            R.pyr = 0;
+        }
+    }
+
+    if( R.edg ) {
+
+        if( !R.edg->update( &samps[0], int(samps.size()) / nC ) ) {
+
+            Warning() <<
+            QString("Sync edge file error %1; not indexing '%2'.")
+            .arg( R.edg->errorString() ).arg( R.binFile.fileName() );
+
+            delete R.edg;
+            R.edg = 0;
+        }
+    }
+}
+
 
@@ -1,6 +1,7 @@
 #ifndef DATAFILE_H
 #define DATAFILE_H
 
+#include "AIQ.h"
 #include "DAQ.h"
 #include "GeomMap.h"
 #include "KVParams.h"
@@ -12,6 +13,12 @@
 #include <QMutex>
 
 class DFWriter;
+class DFHasher;
+class DFDirectWriter;
+class DFPyramidBuilder;
+class DFSyncEdgeBuilder;
+struct DFSyncSpec;
+class TreeCRC;
 
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
@@ -22,6 +29,7 @@ class DFWriter;
 class DataFile
 {
     friend class DFWriterWorker;
+    friend class DFHasherWorker;
     friend class DFCloseAsyncWorker;
 
 private:
@@ -33,14 +41,19 @@ private:
 
     struct ORec {
         DFWriter                *dfw;
+        DFHasher                *dfh;
+        DFDirectWriter          *dio;       // else binFile
         QFile                   binFile;
         QVector<uint>           iKeep;
         CSHA1                   sha;
+        TreeCRC                 *tcrc;      // optional
+        DFPyramidBuilder        *pyr;       // optional
+        DFSyncEdgeBuilder       *edg;       // optional
         mutable QMutex          statsMtx;
         mutable QVector<uint>   statsBytes;
         KVParams                kvp;
         QString                 metaName;
-        ORec() : dfw(0) {}
+        ORec() : dfw(0), dfh(0), dio(0), tcrc(0), pyr(0), edg(0) {}
         virtual ~ORec();
     };
 
@@ -57,8 +70,13 @@ private:
 
     // Output mode only
     std::vector<std::unique_ptr<ORec>> o_rec;
+    std::vector<vec_i16>    o_vS;           // per-ORec block staging
     int                     o_nAcqChans;
-    bool                    o_wrAsync;
+    bool                    o_wrAsync,
+                            o_wrDirect,
+                            o_wrTreeCRC,
+                            o_wrPyramid,
+                            o_wrSyncEdges;
 
 protected:
     // Input and Output mode
@@ -119,7 +137,12 @@ public:
     // ------
 
     void setAsyncWriting( bool async )  {o_wrAsync = async;}
+    void setDirectIO( bool direct )     {o_wrDirect = direct;}
+    void setTreeCRC( bool tree )        {o_wrTreeCRC = tree;}
+    void setPyramid( bool pyr )         {o_wrPyramid = pyr;}
+    void setSyncEdges( bool edg )       {o_wrSyncEdges = edg;}
     bool writeAndInvalSamps( vec_i16 &samps );
+    bool writeAndInvalView( const AIQ::View &V );
 
     // -----
     // Input
@@ -192,6 +215,10 @@ protected:
 
     virtual GeomMap* geomMap( bool forExport ) const = 0;
 
+    virtual bool subclassSyncSpec(
+        DFSyncSpec          &,
+        const DAQ::Params   & ) const   {return false;}
+
     virtual void subclassUpdateGeomMap(
         const DataFile      &dfSrc,
         const QVector<uint> &indicesOfSrcChans ) = 0;
@@ -205,7 +232,9 @@ protected:
         const QVector<uint> &indicesOfSrcChans ) = 0;
 
 private:
+    bool openBinFile( ORec &R, const QString &bName );
     bool doFileWrite( const vec_i16 &samps, int j = 0 );
+    void doFileHash( const vec_i16 &samps, int j = 0 );
 };
 
 #endif  // DATAFILE_H
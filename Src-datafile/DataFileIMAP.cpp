@@ -3,6 +3,7 @@
 #include "MainApp.h"
 #include "ConfigCtl.h"
 #include "DataFileIMAP.h"
+#include "DFSyncEdges.h"
 #include "Subset.h"
 
 #include <QRegularExpression>
@@ -360,6 +361,19 @@ void DataFileIMAP::subclassSetSNSChanCounts(
 }
 
 
+// Sync signal always at bit 6 of first SY word.
+//
+bool DataFileIMAP::subclassSyncSpec(
+    DFSyncSpec          &sy,
+    const DAQ::Params   &p ) const
+{
+    sy.acqChan  = p.im.prbj[ip].imCumTypCnt[CimCfg::imSumNeural];
+    sy.bit      = 6;
+
+    return true;
+}
+
+
 // Note: For FVW, map entries must match the saved chans.
 //
 // GeomMap is not used within SpikeGLX. We get it for only
@@ -50,6 +50,10 @@ protected:
 
     virtual GeomMap* geomMap( bool forExport ) const;
 
+    virtual bool subclassSyncSpec(
+        DFSyncSpec          &sy,
+        const DAQ::Params   &p ) const;
+
     virtual void subclassUpdateGeomMap(
         const DataFile      &dfSrc,
         const QVector<uint> &indicesOfSrcChans );
@@ -1,5 +1,6 @@
 
 #include "DataFileNI.h"
+#include "DFSyncEdges.h"
 #include "Subset.h"
 
 #include <QRegularExpression>
@@ -258,6 +259,30 @@ void DataFileNI::subclassSetSNSChanCounts(
 }
 
 
+// Sync input is a digital line or a thresholded analog channel.
+//
+bool DataFileNI::subclassSyncSpec(
+    DFSyncSpec          &sy,
+    const DAQ::Params   &p ) const
+{
+    if( p.sync.niChanType == 0 ) {
+        sy.acqChan  = p.ni.niCumTypCnt[CniCfg::niSumAnalog]
+                        + p.sync.niChan/16;
+        sy.bit      = p.sync.niChan % 16;
+    }
+    else {
+        sy.acqChan  = p.sync.niChan;
+        sy.bit      = -1;
+        sy.thresh   = qBound(
+                        -32768.0,
+                        p.sync.niThresh / p.ni.range.rmax * 32768,
+                        32767.0 );
+    }
+
+    return true;
+}
+
+
 // Note: For FVW, map entries must match the saved chans.
 //
 void DataFileNI::subclassUpdateShankMap(
@@ -3,6 +3,7 @@
 #include "MainApp.h"
 #include "ConfigCtl.h"
 #include "DataFileOB.h"
+#include "DFSyncEdges.h"
 #include "Subset.h"
 
 #include <QRegularExpression>
@@ -177,6 +178,19 @@ void DataFileOB::subclassSetSNSChanCounts(
 }
 
 
+// Sync signal always at bit 6 of SY word.
+//
+bool DataFileOB::subclassSyncSpec(
+    DFSyncSpec          &sy,
+    const DAQ::Params   &p ) const
+{
+    sy.acqChan  = p.im.get_iStrOneBox( ip ).obCumTypCnt[CimCfg::obSumData];
+    sy.bit      = 6;
+
+    return true;
+}
+
+
 // Note: For FVW, map entries must match the saved chans.
 //
 void DataFileOB::subclassUpdateChanMap(
@@ -48,6 +48,10 @@ protected:
 
     virtual GeomMap* geomMap( bool ) const  {return 0;}
 
+    virtual bool subclassSyncSpec(
+        DFSyncSpec          &sy,
+        const DAQ::Params   &p ) const;
+
     virtual void subclassUpdateGeomMap(
         const DataFile      &,
         const QVector<uint> & ) {}
@@ -1,7 +1,10 @@
 
 #include "DataFile_Helpers.h"
 #include "DataFile.h"
+#include "BenchRun.h"
+#include "SampleBufPool.h"
 #include "Util.h"
+#include "ThreadPlace.h"
 
 #include <QThread>
 
@@ -14,6 +17,10 @@ void DFWriterWorker::run()
 {
     Debug() << "DFWriter started for " << d->outBinFileName( j );
 
+    ThreadPlace::pin(
+        ThreadPlace::tpWriter,
+        QString("wr-%1.%2").arg( d->streamFromObj() ).arg( j ) );
+
     for(;;) {
 
         vec_i16 buf;
@@ -28,16 +35,22 @@ void DFWriterWorker::run()
 
     Debug() << "DFWriter stopped for " << d->outBinFileName( j );
 
+    BenchCPU::add( BenchCPU::write );
+
     emit finished();
 }
 
 
-bool DFWriterWorker::write( const vec_i16 &samps )
+// Written blocks pass to the hasher.
+//
+bool DFWriterWorker::write( vec_i16 &samps )
 {
-    if( !d )
+    if( !d || !d->doFileWrite( samps, j ) )
         return false;
 
-    return d->doFileWrite( samps, j );
+    d->o_rec[j]->dfh->worker->enqueue( samps );
+
+    return true;
 }
 
 /* ---------------------------------------------------------------- */
@@ -75,6 +88,68 @@ DFWriter::~DFWriter()
     delete thread;
 }
 
+/* ---------------------------------------------------------------- */
+/* DFHasherWorker ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void DFHasherWorker::run()
+{
+    ThreadPlace::pin(
+        ThreadPlace::tpWriter,
+        QString("hash-%1.%2").arg( d->streamFromObj() ).arg( j ) );
+
+    for(;;) {
+
+        vec_i16 buf;
+
+        if( dequeue( buf, waitData() ) ) {
+            d->doFileHash( buf, j );
+            SampleBufPool::global().put( buf );
+        }
+        else if( isStopped() )
+            break;
+    }
+
+    BenchCPU::add( BenchCPU::hash );
+
+    emit finished();
+}
+
+/* ---------------------------------------------------------------- */
+/* DFHasher ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+DFHasher::DFHasher( DataFile *df, int j, int maxQSize )
+{
+    thread  = new QThread;
+    worker  = new DFHasherWorker( df, j, maxQSize );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+}
+
+
+DFHasher::~DFHasher()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() ) {
+
+        worker->stayAwake();
+        worker->wake();
+        worker->stop();
+        thread->wait();
+    }
+
+    delete thread;
+}
+
 /* ---------------------------------------------------------------- */
 /* DFCloseAsyncWorker --------------------------------------------- */
 /* ---------------------------------------------------------------- */
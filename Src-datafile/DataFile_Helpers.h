@@ -44,7 +44,7 @@ public slots:
     void run();
 
 private:
-    bool write( const vec_i16 &samps );
+    bool write( vec_i16 &samps );
 };
 
 
@@ -59,6 +59,54 @@ public:
     virtual ~DFWriter();
 };
 
+/* ---------------------------------------------------------------- */
+/* DFHasher ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Checksum stage fed by DFWriterWorker: each block is handed over
+// (swapped, not copied) once written, so hashing and disk writes
+// run concurrently rather than back to back on one thread.
+//
+class DFHasherWorker : public QObject, public SampleBufQ
+{
+    Q_OBJECT
+
+private:
+    DataFile        *d;
+    mutable QMutex  runMtx;
+    int             j;
+    volatile bool   _waitData,
+                    pleaseStop;
+
+public:
+    DFHasherWorker( DataFile *df, int j, int maxQSize )
+    :   QObject(0), SampleBufQ(maxQSize), d(df), j(j),
+        _waitData(true), pleaseStop(false)  {}
+
+    void stayAwake()        {QMutexLocker ml( &runMtx ); _waitData = false;}
+    bool waitData() const   {QMutexLocker ml( &runMtx ); return _waitData;}
+    void stop()             {QMutexLocker ml( &runMtx ); pleaseStop = true;}
+    bool isStopped() const  {QMutexLocker ml( &runMtx ); return pleaseStop;}
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+};
+
+
+class DFHasher
+{
+public:
+    QThread         *thread;
+    DFHasherWorker  *worker;
+
+public:
+    DFHasher( DataFile *df, int j, int maxQSize );
+    virtual ~DFHasher();
+};
+
 /* ---------------------------------------------------------------- */
 /* DFCloseAsync --------------------------------------------------- */
 /* ---------------------------------------------------------------- */
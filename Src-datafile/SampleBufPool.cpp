@@ -0,0 +1,171 @@
+#include "SampleBufPool.h"
+
+#include <string.h>
+
+
+/* ---------------------------------------------------------------- */
+/* SampleBufPool -------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+SampleBufPool::SampleBufPool( int maxBufs, qint64 maxBytes )
+    :   maxBufs(maxBufs), maxBytes(maxBytes)
+{
+    memset( &S, 0, sizeof(Stats) );
+    freeBufs.reserve( maxBufs );
+}
+
+
+// Shared by all DataFiles. Queue depth is typically tens of
+// blocks per file; 1024 blocks or 512 MB covers many probes.
+//
+SampleBufPool &SampleBufPool::global()
+{
+    static SampleBufPool    pool( 1024, 512LL * 1024 * 1024 );
+    return pool;
+}
+
+
+// Return dst empty, with capacity >= minCap, allocating only
+// if no pooled buffer is big enough.
+//
+void SampleBufPool::get( vec_i16 &dst, size_t minCap )
+{
+    dst.clear();
+
+    QMutexLocker    ml( &poolMtx );
+
+    ++S.nGet;
+
+    if( dst.capacity() >= minCap ) {
+        ++S.nHit;
+        return;
+    }
+
+    int nf = int(freeBufs.size());
+
+    if( !nf ) {
+        ++S.nNew;
+        ml.unlock();
+        dst.reserve( minCap );
+        return;
+    }
+
+    // Best fit: smallest that suffices, else largest (to grow)
+
+    int ib = -1, il = 0;
+
+    for( int i = 0; i < nf; ++i ) {
+
+        size_t  cap = freeBufs[i].capacity();
+
+        if( cap >= minCap ) {
+            if( ib < 0 || cap < freeBufs[ib].capacity() )
+                ib = i;
+        }
+        else if( cap > freeBufs[il].capacity() )
+            il = i;
+    }
+
+    if( ib < 0 )
+        ib = il;
+
+    vec_i16 &B = freeBufs[ib];
+
+    S.heldBytes -= B.capacity() * sizeof(qint16);
+
+    if( B.capacity() >= minCap )
+        ++S.nHit;
+    else
+        ++S.nGrow;
+
+    if( dst.capacity() ) {
+        // Caller already had storage; trade it in.
+        S.heldBytes += dst.capacity() * sizeof(qint16);
+        dst.swap( B );
+    }
+    else {
+        dst.swap( B );
+        B.swap( freeBufs.back() );
+        freeBufs.pop_back();
+    }
+
+    ml.unlock();
+
+    dst.reserve( minCap );
+}
+
+
+void SampleBufPool::put( vec_i16 &src )
+{
+    qint64  bytes = src.capacity() * sizeof(qint16);
+
+    if( !bytes )
+        return;
+
+    src.clear();
+
+    vec_i16 drop;
+
+    {
+        QMutexLocker    ml( &poolMtx );
+
+        ++S.nPut;
+
+        if( int(freeBufs.size()) < maxBufs
+            && S.heldBytes + bytes <= maxBytes ) {
+
+            freeBufs.push_back( vec_i16() );
+            freeBufs.back().swap( src );
+
+            S.heldBytes += bytes;
+
+            if( S.heldBytes > S.peakBytes )
+                S.peakBytes = S.heldBytes;
+
+            return;
+        }
+
+        ++S.nDrop;
+    }
+
+// Free outside the lock
+
+    drop.swap( src );
+}
+
+
+void SampleBufPool::trim()
+{
+    std::vector<vec_i16>    old;
+
+    {
+        QMutexLocker    ml( &poolMtx );
+        old.swap( freeBufs );
+        freeBufs.reserve( maxBufs );
+        S.heldBytes = 0;
+    }
+}
+
+
+SampleBufPool::Stats SampleBufPool::stats() const
+{
+    QMutexLocker    ml( &poolMtx );
+    return S;
+}
+
+
+QString SampleBufPool::statsString() const
+{
+    Stats   s = stats();
+
+    return QString(
+        "Buffer pool: %1 gets (%2 reused, %3 grown, %4 new),"
+        " %5 returns (%6 freed), peak held %7 MB.")
+        .arg( s.nGet )
+        .arg( s.nHit )
+        .arg( s.nGrow )
+        .arg( s.nNew )
+        .arg( s.nPut )
+        .arg( s.nDrop )
+        .arg( s.peakBytes / (1024.0 * 1024.0), 0, 'f', 1 );
+}
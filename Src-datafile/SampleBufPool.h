@@ -0,0 +1,56 @@
+#ifndef SAMPLEBUFPOOL_H
+#define SAMPLEBUFPOOL_H
+
+#include "SGLTypes.h"
+
+#include <QMutex>
+#include <QString>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Recycles the vec_i16 blocks handed from trigger writers through
+// the DFWriter/DFHasher queues. Trigger side calls get() for an
+// empty vector with at least the requested capacity; the last
+// consumer calls put() to return its storage. Once the pool has
+// warmed up, steady recording does no heap allocation for blocks.
+//
+// Memory held is bounded by maxBufs and maxBytes; returns beyond
+// either are freed (counted as drops). trim() releases everything.
+//
+class SampleBufPool
+{
+public:
+    struct Stats {
+        quint64 nGet,
+                nHit,       // reused, capacity sufficed
+                nGrow,      // reused, had to grow
+                nNew,       // pool empty
+                nPut,
+                nDrop;      // returned but pool full
+        qint64  heldBytes,
+                peakBytes;
+    };
+
+private:
+    std::vector<vec_i16>    freeBufs;
+    mutable QMutex          poolMtx;
+    Stats                   S;
+    const int               maxBufs;
+    const qint64            maxBytes;
+
+public:
+    SampleBufPool( int maxBufs, qint64 maxBytes );
+
+    static SampleBufPool &global();
+
+    void get( vec_i16 &dst, size_t minCap );
+    void put( vec_i16 &src );
+    void trim();
+
+    Stats stats() const;
+    QString statsString() const;
+};
+
+#endif  // SAMPLEBUFPOOL_H
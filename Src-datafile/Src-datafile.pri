@@ -6,8 +6,13 @@ HEADERS += \
     $$PWD/DataFileIMLF.h \
     $$PWD/DataFileNI.h \
     $$PWD/DataFileOB.h \
+    $$PWD/DFBlockCache.h \
+    $$PWD/DFDirectWriter.h \
     $$PWD/DFName.h \
+    $$PWD/DFPyramid.h \
+    $$PWD/DFSyncEdges.h \
     $$PWD/ExportCtl.h \
+    $$PWD/SampleBufPool.h \
     $$PWD/SampleBufQ.h
 
 SOURCES += \
@@ -17,8 +22,13 @@ SOURCES += \
     $$PWD/DataFileIMLF.cpp \
     $$PWD/DataFileNI.cpp \
     $$PWD/DataFileOB.cpp \
+    $$PWD/DFBlockCache.cpp \
+    $$PWD/DFDirectWriter.cpp \
     $$PWD/DFName.cpp \
+    $$PWD/DFPyramid.cpp \
+    $$PWD/DFSyncEdges.cpp \
     $$PWD/ExportCtl.cpp \
+    $$PWD/SampleBufPool.cpp \
     $$PWD/SampleBufQ.cpp
 
 
@@ -17,6 +17,7 @@
 //
 
 #include "Biquad.h"
+#include "BiquadKernel.h"
 #include "Util.h"
 
 #include <QThread>
@@ -32,31 +33,7 @@ static Biquad   *ME;
 
 void BiquadWorker::run()
 {
-    double  Y   = 1.0 / maxInt,
-            A0  = ME->a0,
-            A1  = ME->a1,
-            A2  = ME->a2,
-            B1  = ME->b1,
-            B2  = ME->b2;
-
-    for( int it = 0; it < ntpts; ++it, data += nchans ) {
-
-        for( int c = cFirst; c < cLim; ++c ) {
-
-            double  in  = data[c] * Y,
-                    z1  = ME->vz1[c - c0],
-                    z2  = ME->vz2[c - c0],
-                    out = in * A0 + z1;
-
-            z1 = in * A1 + z2 - B1 * out;
-            z2 = in * A2 - B2 * out;
-
-            data[c] = qBound( -maxInt, int(out * maxInt), maxInt - 1 );
-
-            ME->vz1[c - c0] = z1;
-            ME->vz2[c - c0] = z2;
-        }
-    }
+    ME->applyRange( data, maxInt, ntpts, nchans, c0, cFirst, cLim );
 
     emit finished();
 }
@@ -182,12 +159,6 @@ void Biquad::applyBlockwiseThd(
 {
     ME = this;
 
-    double  Y   = 1.0 / maxInt,
-            A0  = a0,
-            A1  = a1,
-            A2  = a2,
-            B1  = b1,
-            B2  = b2;
     int     nneural = cLim - c0,
             cPer    = nneural / nThd,
             cFirst  = c0;
@@ -223,24 +194,7 @@ void Biquad::applyBlockwiseThd(
 
 // The final worker is me, the calling thread
 
-    for( int it = 0; it < ntpts; ++it, data += nchans ) {
-
-        for( int c = cFirst; c < cLim; ++c ) {
-
-            double  in  = data[c] * Y,
-                    z1  = vz1[c - c0],
-                    z2  = vz2[c - c0],
-                    out = in * A0 + z1;
-
-            z1 = in * A1 + z2 - B1 * out;
-            z2 = in * A2 - B2 * out;
-
-            data[c] = qBound( -maxInt, int(out * maxInt), maxInt - 1 );
-
-            vz1[c - c0] = z1;
-            vz2[c - c0] = z2;
-        }
-    }
+    applyRange( data, maxInt, ntpts, nchans, c0, cFirst, cLim );
 
 // Clean up workers
 
@@ -257,12 +211,6 @@ void Biquad::applyBlockwiseMem(
     int     c0,
     int     cLim )
 {
-    double  Y   = 1.0 / maxInt,
-            A0  = a0,
-            A1  = a1,
-            A2  = a2,
-            B1  = b1,
-            B2  = b2;
     int     nneural = cLim - c0;
 
     if( nneural != int(vz1.size()) ) {
@@ -271,24 +219,7 @@ void Biquad::applyBlockwiseMem(
         vz2.assign( nneural, 0 );
     }
 
-    for( int it = 0; it < ntpts; ++it, data += nchans ) {
-
-        for( int c = c0; c < cLim; ++c ) {
-
-            double  in  = data[c] * Y,
-                    z1  = vz1[c - c0],
-                    z2  = vz2[c - c0],
-                    out = in * A0 + z1;
-
-            z1 = in * A1 + z2 - B1 * out;
-            z2 = in * A2 - B2 * out;
-
-            data[c] = qBound( -maxInt, int(out * maxInt), maxInt - 1 );
-
-            vz1[c - c0] = z1;
-            vz2[c - c0] = z2;
-        }
-    }
+    applyRange( data, maxInt, ntpts, nchans, c0, c0, cLim );
 }
 
 
@@ -403,6 +334,30 @@ void Biquad::apply1BlockwiseNoMem(
 }
 
 
+// Filter channels [cFirst,cLim) of a range whose state
+// vectors start at channel c0, using the fastest kernel
+// this CPU supports (see BiquadKernel).
+//
+void Biquad::applyRange(
+    short   *data,
+    int     maxInt,
+    int     ntpts,
+    int     nchans,
+    int     c0,
+    int     cFirst,
+    int     cLim )
+{
+    if( cFirst >= cLim )
+        return;
+
+    BiquadKernel::Coefs K = {a0, a1, a2, b1, b2};
+
+    BiquadKernel::apply(
+        data, K, &vz1[cFirst - c0], &vz2[cFirst - c0],
+        maxInt, ntpts, nchans, cFirst, cLim );
+}
+
+
 void Biquad::calcBiquad()
 {
     vz1.clear();
@@ -209,6 +209,14 @@ public:
         int     ichan );
 
 private:
+    void applyRange(
+        short   *data,
+        int     maxInt,
+        int     ntpts,
+        int     nchans,
+        int     c0,
+        int     cFirst,
+        int     cLim );
     void calcBiquad();
 };
 
@@ -0,0 +1,198 @@
+#include "BiquadKernel.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define BQK_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define BQK_AVX2
+    #else
+        #define BQK_AVX2    __attribute__((target("avx2")))
+    #endif
+#endif
+
+
+/* ---------------------------------------------------------------- */
+/* scalar --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void BiquadKernel::scalar(
+    short       *data,
+    const Coefs &K,
+    double      *z1,
+    double      *z2,
+    int         maxInt,
+    int         ntpts,
+    int         nchans,
+    int         cFirst,
+    int         cLim )
+{
+    double  Y   = 1.0 / maxInt,
+            A0  = K.a0,
+            A1  = K.a1,
+            A2  = K.a2,
+            B1  = K.b1,
+            B2  = K.b2;
+
+    for( int it = 0; it < ntpts; ++it, data += nchans ) {
+
+        for( int c = cFirst; c < cLim; ++c ) {
+
+            double  in  = data[c] * Y,
+                    s1  = z1[c - cFirst],
+                    s2  = z2[c - cFirst],
+                    out = in * A0 + s1;
+
+            s1 = in * A1 + s2 - B1 * out;
+            s2 = in * A2 - B2 * out;
+
+            data[c] = std::max( -maxInt,
+                        std::min( int(out * maxInt), maxInt - 1 ) );
+
+            z1[c - cFirst] = s1;
+            z2[c - cFirst] = s2;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* avx2 ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef BQK_X86
+
+// Four channels: shorts -> doubles, step, clamp, truncate -> shorts.
+//
+#define BQK_STEP4( d, pz1, pz2 )                                        \
+    {                                                                   \
+        __m256d in  = _mm256_mul_pd(                                    \
+                        _mm256_cvtepi32_pd( _mm_cvtepi16_epi32(         \
+                        _mm_loadl_epi64( (const __m128i*)(d) ) ) ), Y );\
+        __m256d s1  = _mm256_loadu_pd( pz1 ),                           \
+                s2  = _mm256_loadu_pd( pz2 ),                           \
+                out = _mm256_add_pd( _mm256_mul_pd( in, A0 ), s1 );     \
+        s1 = _mm256_sub_pd(                                             \
+                _mm256_add_pd( _mm256_mul_pd( in, A1 ), s2 ),           \
+                _mm256_mul_pd( B1, out ) );                             \
+        s2 = _mm256_sub_pd(                                             \
+                _mm256_mul_pd( in, A2 ),                                \
+                _mm256_mul_pd( B2, out ) );                             \
+        _mm256_storeu_pd( pz1, s1 );                                    \
+        _mm256_storeu_pd( pz2, s2 );                                    \
+        out = _mm256_min_pd( _mm256_max_pd(                             \
+                _mm256_mul_pd( out, M ), LO ), HI );                    \
+        _mm_storel_epi64( (__m128i*)(d),                                \
+            _mm_packs_epi32( _mm256_cvttpd_epi32( out ),                \
+                             _mm_setzero_si128() ) );                   \
+    }
+
+BQK_AVX2
+void BiquadKernel::avx2(
+    short       *data,
+    const Coefs &K,
+    double      *z1,
+    double      *z2,
+    int         maxInt,
+    int         ntpts,
+    int         nchans,
+    int         cFirst,
+    int         cLim )
+{
+    int nvec = (cLim - cFirst) & ~3;
+
+    if( !nvec ) {
+        scalar( data, K, z1, z2, maxInt, ntpts, nchans, cFirst, cLim );
+        return;
+    }
+
+    const __m256d   Y   = _mm256_set1_pd( 1.0 / maxInt ),
+                    M   = _mm256_set1_pd( maxInt ),
+                    LO  = _mm256_set1_pd( -maxInt ),
+                    HI  = _mm256_set1_pd( maxInt - 1 ),
+                    A0  = _mm256_set1_pd( K.a0 ),
+                    A1  = _mm256_set1_pd( K.a1 ),
+                    A2  = _mm256_set1_pd( K.a2 ),
+                    B1  = _mm256_set1_pd( K.b1 ),
+                    B2  = _mm256_set1_pd( K.b2 );
+    int             cVec = cFirst + nvec,
+                    n8   = nvec & ~7;
+
+    for( int it = 0; it < ntpts; ++it, data += nchans ) {
+
+        short   *d = data + cFirst;
+        int     i  = 0;
+
+        for( ; i < n8; i += 8 ) {
+            BQK_STEP4( d + i,     z1 + i,     z2 + i );
+            BQK_STEP4( d + i + 4, z1 + i + 4, z2 + i + 4 );
+        }
+
+        if( i < nvec )
+            BQK_STEP4( d + i, z1 + i, z2 + i );
+    }
+
+// Odd channels at the end
+
+    if( cVec < cLim ) {
+        scalar(
+            data - ntpts * nchans, K, z1 + nvec, z2 + nvec,
+            maxInt, ntpts, nchans, cVec, cLim );
+    }
+}
+
+#undef BQK_STEP4
+
+#else
+
+void BiquadKernel::avx2(
+    short       *data,
+    const Coefs &K,
+    double      *z1,
+    double      *z2,
+    int         maxInt,
+    int         ntpts,
+    int         nchans,
+    int         cFirst,
+    int         cLim )
+{
+    scalar( data, K, z1, z2, maxInt, ntpts, nchans, cFirst, cLim );
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* Dispatch ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool BiquadKernel::haveAVX2()
+{
+#if !defined(BQK_X86)
+    return false;
+#elif defined(_MSC_VER)
+    int r[4];
+    __cpuid( r, 0 );
+    if( r[0] < 7 )
+        return false;
+    __cpuid( r, 1 );
+    // OSXSAVE and AVX, and OS saves YMM state
+    if( (r[2] & (1 << 27)) == 0 || (r[2] & (1 << 28)) == 0 )
+        return false;
+    if( (_xgetbv( 0 ) & 6) != 6 )
+        return false;
+    __cpuidex( r, 7, 0 );
+    return (r[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+#endif
+}
+
+
+BiquadKernel::Fn BiquadKernel::best()
+{
+    static const Fn fn = (haveAVX2() ? &BiquadKernel::avx2 : &BiquadKernel::scalar);
+
+    return fn;
+}
@@ -0,0 +1,76 @@
+#ifndef BIQUADKERNEL_H
+#define BIQUADKERNEL_H
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Inner loops of Biquad::applyBlockwise*, free of Qt so they can
+// be benchmarked standalone.
+//
+// Filter channels [cFirst,cLim) of interleaved (data) in place.
+// z1, z2 hold the per-channel state for cFirst..cLim-1.
+//
+// Channels are independent, so the vector kernel runs 8 adjacent
+// channels per step (two 4-wide double registers), in the same
+// double precision and operation order as the scalar loop, hence
+// produces identical output. apply() picks the best kernel the
+// CPU supports at runtime.
+//
+class BiquadKernel
+{
+public:
+    struct Coefs {
+        double  a0, a1, a2, b1, b2;
+    };
+
+    typedef void (*Fn)(
+        short       *data,
+        const Coefs &K,
+        double      *z1,
+        double      *z2,
+        int         maxInt,
+        int         ntpts,
+        int         nchans,
+        int         cFirst,
+        int         cLim );
+
+    static void scalar(
+        short       *data,
+        const Coefs &K,
+        double      *z1,
+        double      *z2,
+        int         maxInt,
+        int         ntpts,
+        int         nchans,
+        int         cFirst,
+        int         cLim );
+
+    static void avx2(
+        short       *data,
+        const Coefs &K,
+        double      *z1,
+        double      *z2,
+        int         maxInt,
+        int         ntpts,
+        int         nchans,
+        int         cFirst,
+        int         cLim );
+
+    static bool haveAVX2();
+    static Fn best();
+
+    static void apply(
+        short       *data,
+        const Coefs &K,
+        double      *z1,
+        double      *z2,
+        int         maxInt,
+        int         ntpts,
+        int         nchans,
+        int         cFirst,
+        int         cLim )
+        {best()( data, K, z1, z2, maxInt, ntpts, nchans, cFirst, cLim );}
+};
+
+#endif  // BIQUADKERNEL_H
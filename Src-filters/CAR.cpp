@@ -1,5 +1,6 @@
 
 #include "CAR.h"
+#include "MedianKernel.h"
 #include "GeomMap.h"
 #include "ShankMap.h"
 #include "IMROTbl.h"
@@ -22,32 +23,17 @@ void CAR::Median_1::init( const SUList &SU, int nAP )
             idx.push_back( ig );
     }
 
-    arrange.resize( nU = (int)idx.size() );
-    ibeg = arrange.begin();
-    iend = arrange.end();
-    imid = ibeg + nU / 2;
+    nU = (int)idx.size();
+    arrange.resize( MedianKernel::workSize( nU ) );
 }
 
 
-void CAR::Median_1::apply( qint16 *d, int ntpts, int nC ) const
+void CAR::Median_1::apply( qint16 *d, int ntpts, int nC, int nThd ) const
 {
-    const int   *pidx = &idx[0];
-    qint16      *parr = &arrange[0];
-
     if( nU <= 0 )
         return;
 
-    for( int it = 0; it < ntpts; ++it, d += nC ) {
-
-        for( int ig = 0; ig < nU; ++ig )
-            parr[ig] = d[pidx[ig]];
-
-        std::nth_element( ibeg, imid, iend );
-        int median = *imid;
-
-        for( int ig = 0; ig < nU; ++ig )
-            d[pidx[ig]] -= median;
-    }
+    MedianKernel::applyThd( d, &arrange[0], &idx[0], nU, ntpts, nC, nThd );
 }
 
 /* ---------------------------------------------------------------- */
@@ -69,33 +55,24 @@ void CAR::Median_4::init( const SUList &SU, int nAP )
     arrange.resize( 4 );
 
     for( int is = 0; is < 4; ++is ) {
-        arrange[is].resize( nU[is] = (int)idx[is].size() );
-        ibeg[is] = arrange[is].begin();
-        iend[is] = arrange[is].end();
-        imid[is] = ibeg[is] + nU[is] / 2;
+        nU[is] = (int)idx[is].size();
+        arrange[is].resize( MedianKernel::workSize( nU[is] ) );
     }
 }
 
 
-void CAR::Median_4::apply( qint16 *d, int ntpts, int nC ) const
+// Shanks are disjoint channel sets, so doing each shank
+// over the whole block matches doing all shanks per timepoint.
+//
+void CAR::Median_4::apply( qint16 *d, int ntpts, int nC, int nThd ) const
 {
-    for( int it = 0; it < ntpts; ++it, d += nC ) {
-
-        for( int is = 0; is < 4; ++is ) {
-
-            const int   *pidx = &idx[is][0];
-            qint16      *parr = &arrange[is][0];
-            int         nu    = nU[is];
-
-            for( int ig = 0; ig < nu; ++ig )
-                parr[ig] = d[pidx[ig]];
+    for( int is = 0; is < 4; ++is ) {
 
-            std::nth_element( ibeg[is], imid[is], iend[is] );
-            int median = *imid[is];
+        if( nU[is] <= 0 )
+            continue;
 
-            for( int ig = 0; ig < nu; ++ig )
-                d[pidx[ig]] -= median;
-        }
+        MedianKernel::applyThd(
+            d, &arrange[is][0], &idx[is][0], nU[is], ntpts, nC, nThd );
     }
 }
 
@@ -396,12 +373,14 @@ void CAR::gbl_med_auto_init()
 // Dependencies:
 // {setSepShanks, setChans, setSU, med_all_init()}
 //
-void CAR::gbl_med_auto( qint16 *d, int ntpts ) const
+// nThd > 1 splits large blocks among that many threads.
+//
+void CAR::gbl_med_auto( qint16 *d, int ntpts, int nThd ) const
 {
     if( nS )
-        med4.apply( d, ntpts, nC );
+        med4.apply( d, ntpts, nC, nThd );
     else
-        med1.apply( d, ntpts, nC );
+        med1.apply( d, ntpts, nC, nThd );
 }
 
 
@@ -419,9 +398,9 @@ void CAR::gbl_med_all_init()
 // Dependencies:
 // {setChans, setSU, med_all_init()}
 //
-void CAR::gbl_med_all( qint16 *d, int ntpts ) const
+void CAR::gbl_med_all( qint16 *d, int ntpts, int nThd ) const
 {
-    med1.apply( d, ntpts, nC );
+    med1.apply( d, ntpts, nC, nThd );
 }
 
 
@@ -439,9 +418,9 @@ void CAR::gbl_med_shk_init()
 // Dependencies:
 // {setChans, setSU, med_shk_init()}
 //
-void CAR::gbl_med_shk( qint16 *d, int ntpts ) const
+void CAR::gbl_med_shk( qint16 *d, int ntpts, int nThd ) const
 {
-    med4.apply( d, ntpts, nC );
+    med4.apply( d, ntpts, nC, nThd );
 }
 
 
@@ -25,26 +25,24 @@ class CAR
 private:
     struct Median_1 {
         std::vector<int>    idx;
-        mutable vec_i16     arrange;
-        vec_i16::iterator   ibeg, imid, iend;
+        mutable vec_i16     arrange;    // MedianKernel work
         int                 nU;
     public:
         Median_1()          {}
         virtual ~Median_1() {}
         void init( const SUList &SU, int nAP );
-        void apply( qint16 *d, int ntpts, int nC ) const;
+        void apply( qint16 *d, int ntpts, int nC, int nThd ) const;
     };
 
     struct Median_4 {
         std::vector<std::vector<int> >  idx;
         mutable std::vector<vec_i16 >   arrange;
-        vec_i16::iterator               ibeg[4], imid[4], iend[4];
         int                             nU[4];
     public:
         Median_4()          {}
         virtual ~Median_4() {}
         void init( const SUList &SU, int nAP );
-        void apply( qint16 *d, int ntpts, int nC ) const;
+        void apply( qint16 *d, int ntpts, int nC, int nThd ) const;
     };
 
     SUList                          SU;
@@ -92,13 +90,13 @@ public:
 /* ---------------------------------------------------------------- */
 
     void gbl_med_auto_init();
-    void gbl_med_auto( qint16 *d, int ntpts ) const;
+    void gbl_med_auto( qint16 *d, int ntpts, int nThd = 1 ) const;
 
     void gbl_med_all_init();
-    void gbl_med_all( qint16 *d, int ntpts ) const;
+    void gbl_med_all( qint16 *d, int ntpts, int nThd = 1 ) const;
 
     void gbl_med_shk_init();
-    void gbl_med_shk( qint16 *d, int ntpts ) const;
+    void gbl_med_shk( qint16 *d, int ntpts, int nThd = 1 ) const;
 
 /* ---------------------------------------------------------------- */
 /* Global average ------------------------------------------------- */
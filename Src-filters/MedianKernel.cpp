@@ -0,0 +1,254 @@
+#include "MedianKernel.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define MDK_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define MDK_AVX2
+    #else
+        #define MDK_AVX2    __attribute__((target("avx2")))
+    #endif
+#endif
+
+// Don't split blocks smaller than this among threads.
+#define MIN_TPTS_PER_THD    1024
+
+
+/* ---------------------------------------------------------------- */
+/* scalar --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void MedianKernel::scalar(
+    short       *d,
+    short       *work,
+    const int   *idx,
+    int         nU,
+    int         ntpts,
+    int         nC )
+{
+    if( nU <= 0 )
+        return;
+
+    short   *imid = work + nU / 2,
+            *iend = work + nU;
+
+    for( int it = 0; it < ntpts; ++it, d += nC ) {
+
+        for( int ig = 0; ig < nU; ++ig )
+            work[ig] = d[idx[ig]];
+
+        std::nth_element( work, imid, iend );
+        int median = *imid;
+
+        for( int ig = 0; ig < nU; ++ig )
+            d[idx[ig]] -= median;
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* avx2 ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef MDK_X86
+
+MDK_AVX2
+void MedianKernel::avx2(
+    short       *d,
+    short       *work,
+    const int   *idx,
+    int         nU,
+    int         ntpts,
+    int         nC )
+{
+// Lane counters are 16-bit
+
+    if( nU <= 0 )
+        return;
+
+    if( nU > 32767 ) {
+        scalar( d, work, idx, nU, ntpts, nC );
+        return;
+    }
+
+    const __m256i   G   = _mm256_set1_epi16( short(nU - nU / 2 - 1) ),
+                    ONE = _mm256_set1_epi16( 1 );
+    __m256i         *w  = (__m256i*)work;
+    int             nblk = ntpts & ~(LANES - 1);
+
+    for( int it = 0; it < nblk; it += LANES, d += LANES * nC ) {
+
+        // ---------------------------------
+        // Transpose: row ig = 16 timepoints
+        // ---------------------------------
+
+        for( int ig = 0; ig < nU; ++ig ) {
+
+            const short *src = d + idx[ig];
+            short       *dst = work + ig * LANES;
+
+            for( int il = 0; il < LANES; ++il )
+                dst[il] = src[il * nC];
+        }
+
+        // ----------------
+        // Per-lane min/max
+        // ----------------
+
+        __m256i lo = _mm256_loadu_si256( w ),
+                hi = lo;
+
+        for( int ig = 1; ig < nU; ++ig ) {
+            __m256i x = _mm256_loadu_si256( w + ig );
+            lo = _mm256_min_epi16( lo, x );
+            hi = _mm256_max_epi16( hi, x );
+        }
+
+        // --------------------------------------------------
+        // Bisect: smallest v with #(x > v) <= nU - nU/2 - 1
+        // --------------------------------------------------
+
+        while( _mm256_movemask_epi8( _mm256_cmpeq_epi16( lo, hi ) ) != -1 ) {
+
+            // floor((lo+hi)/2) without overflow
+            __m256i mid = _mm256_add_epi16(
+                            _mm256_and_si256( lo, hi ),
+                            _mm256_srai_epi16(
+                                _mm256_xor_si256( lo, hi ), 1 ) ),
+                    ngt = _mm256_setzero_si256();
+
+            for( int ig = 0; ig < nU; ++ig ) {
+                ngt = _mm256_sub_epi16( ngt,
+                        _mm256_cmpgt_epi16(
+                            _mm256_loadu_si256( w + ig ), mid ) );
+            }
+
+            __m256i up = _mm256_cmpgt_epi16( ngt, G );
+
+            lo = _mm256_blendv_epi8( lo, _mm256_add_epi16( mid, ONE ), up );
+            hi = _mm256_blendv_epi8( mid, hi, up );
+        }
+
+        // --------
+        // Subtract
+        // --------
+
+        for( int ig = 0; ig < nU; ++ig ) {
+
+            const short *src = work + ig * LANES;
+            short       *dst = d + idx[ig];
+
+            _mm256_storeu_si256( w + ig,
+                _mm256_sub_epi16( _mm256_loadu_si256( w + ig ), lo ) );
+
+            for( int il = 0; il < LANES; ++il )
+                dst[il * nC] = src[il];
+        }
+    }
+
+// Leftover timepoints
+
+    if( nblk < ntpts )
+        scalar( d, work, idx, nU, ntpts - nblk, nC );
+}
+
+#else
+
+void MedianKernel::avx2(
+    short       *d,
+    short       *work,
+    const int   *idx,
+    int         nU,
+    int         ntpts,
+    int         nC )
+{
+    scalar( d, work, idx, nU, ntpts, nC );
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* Dispatch ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool MedianKernel::haveAVX2()
+{
+#if !defined(MDK_X86)
+    return false;
+#elif defined(_MSC_VER)
+    int r[4];
+    __cpuid( r, 0 );
+    if( r[0] < 7 )
+        return false;
+    __cpuid( r, 1 );
+    // OSXSAVE and AVX, and OS saves YMM state
+    if( (r[2] & (1 << 27)) == 0 || (r[2] & (1 << 28)) == 0 )
+        return false;
+    if( (_xgetbv( 0 ) & 6) != 6 )
+        return false;
+    __cpuidex( r, 7, 0 );
+    return (r[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+#endif
+}
+
+
+MedianKernel::Fn MedianKernel::best()
+{
+    static const Fn fn = (haveAVX2() ? &MedianKernel::avx2 : &MedianKernel::scalar);
+
+    return fn;
+}
+
+/* ---------------------------------------------------------------- */
+/* Threading ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// Timepoints are independent, so each thread takes a contiguous
+// run of them (a multiple of LANES) with its own work buffer.
+// The final run is done by the calling thread, using (work).
+//
+void MedianKernel::applyThd(
+    short       *d,
+    short       *work,
+    const int   *idx,
+    int         nU,
+    int         ntpts,
+    int         nC,
+    int         nThd )
+{
+    nThd = std::min( nThd, ntpts / MIN_TPTS_PER_THD );
+
+    if( nThd <= 1 || nU <= 0 ) {
+        apply( d, work, idx, nU, ntpts, nC );
+        return;
+    }
+
+    int tPer = (ntpts / nThd + LANES - 1) & ~(LANES - 1),
+        t0   = 0;
+
+    std::vector<std::vector<short> >    vW( nThd - 1 );
+    std::vector<std::thread>            vT;
+
+    for( int i = 0; i < nThd - 1 && ntpts - t0 > tPer; ++i ) {
+
+        vW[i].resize( workSize( nU ) );
+
+        vT.push_back( std::thread(
+                        apply, d + (long long)t0 * nC, &vW[i][0],
+                        idx, nU, tPer, nC ) );
+
+        t0 += tPer;
+    }
+
+    apply( d + (long long)t0 * nC, work, idx, nU, ntpts - t0, nC );
+
+    for( int i = 0, n = int(vT.size()); i < n; ++i )
+        vT[i].join();
+}
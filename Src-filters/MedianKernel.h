@@ -0,0 +1,81 @@
+#ifndef MEDIANKERNEL_H
+#define MEDIANKERNEL_H
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Inner loop of CAR global median, free of Qt so it can be
+// benchmarked standalone.
+//
+// For each timepoint of interleaved (d), take the median of the
+// nU channels listed in (idx) and subtract it from those channels.
+// The median is the element std::nth_element would place at index
+// nU/2, so all kernels give output identical to the classic path.
+//
+// scalar: gather + nth_element, one timepoint at a time.
+//
+// avx2: 16 timepoints at once, one per 16-bit lane. Each lane
+// bisects the int16 value range between its own min and max,
+// counting channels above the trial value with vector compares.
+// The loop ends when every lane has converged, so it costs about
+// log2(range) passes over nU channels per 16 timepoints, with no
+// data-dependent branches.
+//
+// (work) needs workSize(nU) shorts, private to the caller.
+// applyThd() splits timepoints among nThd threads.
+//
+class MedianKernel
+{
+public:
+    enum { LANES = 16 };
+
+    typedef void (*Fn)(
+        short       *d,
+        short       *work,
+        const int   *idx,
+        int         nU,
+        int         ntpts,
+        int         nC );
+
+    static void scalar(
+        short       *d,
+        short       *work,
+        const int   *idx,
+        int         nU,
+        int         ntpts,
+        int         nC );
+
+    static void avx2(
+        short       *d,
+        short       *work,
+        const int   *idx,
+        int         nU,
+        int         ntpts,
+        int         nC );
+
+    static bool haveAVX2();
+    static Fn best();
+
+    static int workSize( int nU )   {return LANES * nU;}
+
+    static void apply(
+        short       *d,
+        short       *work,
+        const int   *idx,
+        int         nU,
+        int         ntpts,
+        int         nC )
+        {best()( d, work, idx, nU, ntpts, nC );}
+
+    static void applyThd(
+        short       *d,
+        short       *work,
+        const int   *idx,
+        int         nU,
+        int         ntpts,
+        int         nC,
+        int         nThd );
+};
+
+#endif  // MEDIANKERNEL_H
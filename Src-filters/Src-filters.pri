@@ -1,10 +1,14 @@
 
 HEADERS += \
     $$PWD/Biquad.h \
-    $$PWD/CAR.h
+    $$PWD/BiquadKernel.h \
+    $$PWD/CAR.h \
+    $$PWD/MedianKernel.h
 
 SOURCES += \
     $$PWD/Biquad.cpp \
-    $$PWD/CAR.cpp
+    $$PWD/BiquadKernel.cpp \
+    $$PWD/CAR.cpp \
+    $$PWD/MedianKernel.cpp
 
 
@@ -17,7 +17,9 @@
 #include "DataFileIMLF.h"
 #include "DataFileNI.h"
 #include "DataFileOB.h"
+#include "DFBlockCache.h"
 #include "DFName.h"
+#include "DFPyramid.h"
 #include "FVShankCtl_Im.h"
 #include "FVShankCtl_Ni.h"
 #include "MGraph.h"
@@ -345,6 +347,120 @@ int DataSource::read( vec_i16 &dst, qint64 smp0, int nsmp )
 }
 #endif
 
+
+#ifdef DSCached
+DataSource::~DataSource()
+{
+    DFBlockCache::global().cancel( this );
+}
+
+
+void DataSource::set_df( DataFile *df )
+{
+    DFBlockCache::global().cancel( this );
+
+    file    = DFBlockCache::fileID( df->inBinFileName() );
+    nTp     = df->sampCount();
+    nC      = df->numChans();
+    blkTp   = DFBlockCache::blockTpts( nC );
+    lastPos = -1;
+}
+
+
+// Same contract as DataFile::readSamps(), all channels.
+//
+int DataSource::read( vec_i16 &dst, qint64 smp0, int nsmp )
+{
+    if( smp0 >= nTp )
+        return -1;
+
+    nsmp = qMin( qint64(nsmp), nTp - smp0 );
+    dst.resize( qint64(nsmp) * nC );
+
+    DFBlockCache    &C      = DFBlockCache::global();
+    qint16          *d      = &dst[0];
+    int             nRead   = 0;
+
+    while( nRead < nsmp ) {
+
+        qint64              t   = smp0 + nRead,
+                            ib  = t / blkTp;
+        DFBlockCache::Blk   B   = C.get( file, nC, blkTp, ib );
+
+        if( !B ) {
+            Error() << "DataSource read error: block " << ib << " of " << file.path;
+            break;
+        }
+
+        int off     = int(t - ib * blkTp),
+            nThis   = qMin( int(B->size() / nC) - off, nsmp - nRead );
+
+        if( nThis <= 0 )
+            break;
+
+        memcpy( d, &(*B)[qint64(off) * nC], nThis * nC * sizeof(qint16) );
+
+        d       += qint64(nThis) * nC;
+        nRead   += nThis;
+    }
+
+    if( nRead < nsmp )
+        dst.resize( qint64(nRead) * nC );
+
+    return (nRead ? nRead : -1);
+}
+
+
+static void addBlks(
+    std::vector<qint64> &vblk,
+    qint64              t0,
+    qint64              t1,
+    qint64              nTp,
+    int                 blkTp )
+{
+    t0 = qMax( t0, 0LL );
+    t1 = qMin( t1, nTp );
+
+    if( t0 >= t1 )
+        return;
+
+    for( qint64 ib = t0 / blkTp, lim = (t1 - 1) / blkTp; ib <= lim; ++ib )
+        vblk.push_back( ib );
+}
+
+
+// Queue the windows adjacent to [pos, pos+span), the one in
+// the direction of travel first. Skip spans too big to hold.
+//
+void DataSource::prefetch( qint64 pos, qint64 span )
+{
+    if( span <= 0 || !nTp )
+        return;
+
+    DFBlockCache    &C = DFBlockCache::global();
+
+    if( 2 * span * nC * qint64(sizeof(qint16)) > C.getBudget() / 4 )
+        return;
+
+    bool    back = (lastPos >= 0 && pos < lastPos);
+
+    lastPos = pos;
+
+    std::vector<qint64> vblk;
+
+    if( back ) {
+        addBlks( vblk, pos - span, pos, nTp, blkTp );
+        addBlks( vblk, pos + span, pos + 2 * span, nTp, blkTp );
+    }
+    else {
+        addBlks( vblk, pos + span, pos + 2 * span, nTp, blkTp );
+        addBlks( vblk, pos - span, pos, nTp, blkTp );
+    }
+
+    C.prefetch( this, file, nC, blkTp, vblk );
+}
+#endif
+
 /* ---------------------------------------------------------------- */
 /* class TaggableLabel -------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -517,7 +633,7 @@ void FileViewerWindow::DCAve::init( int nChannels, int c0, int cLim, int maxInt
 
 
 void FileViewerWindow::DCAve::updateLvl(
-    const DataFile  *df,
+    DataSource      &DS,
     Biquad          *hipass,
     qint64          xpos,
     int             nRem,
@@ -545,7 +661,7 @@ void FileViewerWindow::DCAve::updateLvl(
         int     nthis = qMin( chunk, nRem ),
                 ntpts;
 
-        ntpts = df->readSamps( data, xpos, nthis, QBitArray() );
+        ntpts = DS.read( data, xpos, nthis );
 
         if( ntpts <= 0 )
             break;
@@ -620,7 +736,8 @@ static bool     _linkManUpdt, _linkCanDraw = true;
 FileViewerWindow::FileViewerWindow()
     :   QMainWindow(0),
         tMouseOver(-1.0), yMouseOver(-1.0),
-        df(0), shankCtl(0), shankMap(0), chanMap(0),
+        df(0), pyr(0), pyrBld(0),
+        shankCtl(0), shankMap(0), chanMap(0),
         hipass(0), lopass(0), igSelected(-1),
         igMaximized(-1), igMouseOver(-1), curSMap(0),
         didLayout(false), sortingDisabled(false),
@@ -634,8 +751,16 @@ FileViewerWindow::FileViewerWindow()
 
 FileViewerWindow::~FileViewerWindow()
 {
-    if( df )
+    if( pyrBld )
+        delete pyrBld;
+
+    if( pyr )
+        delete pyr;
+
+    if( df ) {
+        Debug() << DFBlockCache::global().statsString();
         delete df;
+    }
 
     if( chanMap )
         delete chanMap;
@@ -3013,6 +3138,7 @@ bool FileViewerWindow::openFile( QString &error, const QString &fname )
     }
 
     DS.set_df( df );
+    pyrOpen();
 
     double  srate   = df->samplingRateHz(),
             t0      = df->firstCt() / srate,
@@ -3036,6 +3162,60 @@ bool FileViewerWindow::openFile( QString &error, const QString &fname )
 }
 
 
+// Use sidecar if current, else build it in background.
+// Until then, all spans are drawn from raw samples.
+//
+void FileViewerWindow::pyrOpen()
+{
+    if( pyrBld ) {
+        delete pyrBld;
+        pyrBld = 0;
+    }
+
+    if( !pyr )
+        pyr = new DFPyramid;
+
+    QString bin = df->inBinFileName(),
+            err;
+
+    if( pyr->open( err, bin, QFileInfo( bin ).size(), df->numChans() ) )
+        return;
+
+    // Not worth it for short files
+
+    if( dfCount < 1024 * DFPyramid::BASE )
+        return;
+
+    pyrBld = new DFPyramidThread( bin, df->numChans() );
+    ConnectUI( pyrBld->worker, SIGNAL(finished()), this, SLOT(pyrBuilt()) );
+    pyrBld->start();
+}
+
+
+// Also reached by stale builds; only a sidecar
+// that validates against current file is used.
+//
+void FileViewerWindow::pyrBuilt()
+{
+    if( !df || !pyr || pyr->isOpen() )
+        return;
+
+    QString bin = df->inBinFileName(),
+            err;
+
+    if( !pyr->open( err, bin, QFileInfo( bin ).size(), df->numChans() ) )
+        return;
+
+    if( pyrBld ) {
+        delete pyrBld;
+        pyrBld = 0;
+    }
+
+    if( !sav.all.manualUpdate )
+        updateGraphs();
+}
+
+
 void FileViewerWindow::killActions()
 {
 // Remove submenus referencing actions
@@ -3629,6 +3809,9 @@ void FileViewerWindow::zoomTime()
 // - Rather, we treat a long span as several short chunks. We have to
 // retain state data for filters and DC calcs across chunks.
 //
+// - Wide spans are drawn from the pyramid sidecar instead, when its
+// bins are no coarser than dwnSmp (see pyrDraw).
+//
 void FileViewerWindow::updateGraphs()
 {
     if( !_linkCanDraw )
@@ -3690,6 +3873,13 @@ void FileViewerWindow::updateGraphs()
 
     binMax = (dwnSmp > 1 ? qMin( tbGetBinMax(), dwnSmp - 1 ) : 0);
 
+// ------------
+// Pyramid data
+// ------------
+
+    if( pyrDraw( iv2ig, ysc, pos, num2Read - xflt, dwnSmp ) )
+        return;
+
 // -----------
 // Size graphs
 // -----------
@@ -3746,14 +3936,14 @@ void FileViewerWindow::updateGraphs()
     if( tbGetTnChkOn() && tbGetBandSel() != 1 ) {
 
         Tn.init( nG, 0, nNeurChans, maxInt );
-        Tn.updateLvl( df, hipass, xpos, ntpts, chunk, dwnSmp );
+        Tn.updateLvl( DS, hipass, xpos, ntpts, chunk, dwnSmp );
     }
 
     // -<Tx>
 
     if( tbGetTxChkOn() ) {
         Tx.init( nG, nNeurChans, nAnaChans, 0 );
-        Tx.updateLvl( df, 0, xpos, ntpts, chunk, dwnSmp );
+        Tx.updateLvl( DS, 0, xpos, ntpts, chunk, dwnSmp );
     }
 
 // ----------
@@ -3767,6 +3957,10 @@ void FileViewerWindow::updateGraphs()
 // Process chunks
 // --------------
 
+#ifdef DSCached
+    DS.prefetch( pos, num2Read - xflt );
+#endif
+
     int nRem = ntpts;
 
 //#define PROFILE
@@ -4069,6 +4263,189 @@ Log()<<1000*sumL<<"  "<<1000*sumF<<"  "<<1000*sumG<<"  "<<1000*sumB;
 }
 
 
+// Draw span [pos, pos+nspan) from the coarsest pyramid level
+// with bins no wider than dwnSmp. Each graph point merges the
+// few bins it overlaps, so cost is O(pixels), not O(samples).
+// Return false to have caller draw from raw samples, which it
+// must whenever output depends on individual samples:
+//
+// - No usable level (fine zoom).
+// - CAR (-<S>) or LF band (lopass) selected.
+// - AP band (hipass) without binMax: a centered point mean
+//     is identically zero, so only true filtering can draw it.
+// - Shank view is visible (it is fed raw samples).
+//
+// Approximations:
+// - AP band (300 Hz hipass) with binMax is replaced by centering
+//     each point's envelope on its own mean; at these spans that
+//     shows the same envelope.
+// - -<Tn>, -<Tx> subtract span means of bin means.
+// - Stats are tallied from point envelopes.
+// - Digital words show the max of each point.
+//
+bool FileViewerWindow::pyrDraw(
+    const QVector<uint> &iv2ig,
+    float               ysc,
+    qint64              pos,
+    int                 nspan,
+    int                 dwnSmp )
+{
+    if( !pyr || !pyr->isOpen()
+        || tbGetSAveSel() || lopass
+        || (hipass && tbGetBandSel() == 1 && tbGetBinMax() <= 0)
+        || (shankCtl && shankCtl->isVisible()) ) {
+
+        return false;
+    }
+
+    int level = pyr->levelFor( dwnSmp );
+
+    if( level < 0 || pos >= dfCount )
+        return false;
+
+// ---------
+// Read bins
+// ---------
+
+    int     ntpts   = qMin( qint64(nspan), dfCount - pos ),
+            gtpts   = (ntpts + dwnSmp - 1) / dwnSmp;
+    qint64  fac     = DFPyramid::factor( level ),
+            bin0    = pos / fac;
+    vec_i16 B;
+    int     nb      = pyr->read(
+                        B, level, bin0,
+                        int((pos + ntpts - 1) / fac - bin0 + 1) );
+
+    if( gtpts <= 0 || nb <= 0 )
+        return false;
+
+// -----------
+// Size graphs
+// -----------
+
+    int nG      = df->numChans(),
+        nVis    = iv2ig.size();
+
+    for( int iv = 0; iv < nVis; ++iv )
+        grfY[iv2ig[iv]].resize( gtpts );
+
+    mscroll->theX->initVerts( gtpts );
+
+// ---------
+// DC levels
+// ---------
+
+    std::vector<int>    dc( nG, 0 );
+    bool                tn      = tbGetTnChkOn() && tbGetBandSel() != 1,
+                        tx      = tbGetTxChkOn(),
+                        center  = hipass && tbGetBandSel() == 1;
+
+    if( tn || tx ) {
+
+        for( int ig = 0; ig < nG; ++ig ) {
+
+            if( (tn && ig < nNeurChans)
+                || (tx && ig >= nNeurChans && ig < nNeurChans + nAnaChans) ) {
+
+                qint64  sum = 0;
+
+                for( int ib = 0; ib < nb; ++ib )
+                    sum += B[(ib*nG + ig)*3 + 2];
+
+                dc[ig] = sum / nb;
+            }
+        }
+    }
+
+// -------------------------
+// For each shown channel...
+// -------------------------
+
+    std::vector<float>  ybuf( gtpts ),
+                        ybuf2( gtpts );
+    bool                binMax = tbGetBinMax() > 0;
+
+    for( int iv = 0; iv < nVis; ++iv ) {
+
+        int         ig      = iv2ig[iv];
+        MGraphY     &Y      = grfY[ig];
+        GraphStats  &stat   = grfStats[ig];
+
+        stat.clear();
+        Y.drawBinMax = false;
+
+        // skip references
+        if( (Y.usrType == 0 || (Y.usrType == 1 && fType == fvLF))
+            && shankMap && !shankMap->e[ig].u ) {
+
+            continue;
+        }
+
+        for( int it = 0; it < gtpts; ++it ) {
+
+            qint64  s0  = pos + qint64(it) * dwnSmp,
+                    s1  = qMin( s0 + dwnSmp, pos + ntpts ) - 1;
+            int     ib  = int(qMin( s0 / fac - bin0, qint64(nb - 1) )),
+                    lim = int(qMin( s1 / fac - bin0, qint64(nb - 1) )),
+                    n   = 0,
+                    vmin,
+                    vmax,
+                    mean,
+                    sum = 0;
+            const qint16    *b = &B[(ib*nG + ig)*3];
+
+            vmin = b[0];
+            vmax = b[1];
+
+            for( ; ib <= lim; ++ib, ++n, b += 3*nG ) {
+
+                if( b[0] < vmin )
+                    vmin = b[0];
+                if( b[1] > vmax )
+                    vmax = b[1];
+
+                sum += b[2];
+            }
+
+            mean = sum / qMax( n, 1 );
+
+            if( Y.usrType == 2 ) {
+                ybuf[it] = vmax;
+                continue;
+            }
+
+            int off = (center && ig < nSpikeChans ? mean : dc[ig]);
+
+            vmin -= off;
+            vmax -= off;
+            mean -= off;
+
+            if( binMax ) {
+                ybuf[it]  = vmax * ysc;
+                ybuf2[it] = vmin * ysc;
+                stat.add( vmax );
+                stat.add( vmin );
+            }
+            else {
+                ybuf[it] = mean * ysc;
+                stat.add( mean );
+            }
+        }
+
+        if( binMax && Y.usrType != 2 ) {
+            Y.drawBinMax = true;
+            Y.yval2.putData( &ybuf2[0], gtpts );
+        }
+
+        Y.yval.putData( &ybuf[0], gtpts );
+    }
+
+    updateXSel();
+
+    return true;
+}
+
+
 // Values (v) are in range [-1,1].
 // (v+1)/2 is in range [0,1].
 // This is mapped to range [rmin,rmax].
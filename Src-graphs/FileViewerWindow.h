@@ -2,6 +2,7 @@
 #define FILEVIEWERWINDOW_H
 
 #include "DFName.h"
+#include "DFBlockCache.h"
 #include "CAR.h"
 #include "GraphStats.h"
 #include "SvyPrb.h"
@@ -14,6 +15,8 @@ class FVToolbar;
 class FVScanGrp;
 class DataFile;
 class DataSource;
+class DFPyramid;
+class DFPyramidThread;
 class FVShankCtl;
 struct ShankMap;
 struct ChanMap;
@@ -32,13 +35,15 @@ class QThread;
 
 // The set of DSXXX classes are experiments seeking
 // faster data loading, especially over a network.
-// To date, the original DSDirect method is fatest,
-// smallest mem, simplest.
+// DSDirect, the original, reads on demand.
+// DSCached reads through DFBlockCache, which is shared
+// by all viewers and fills ahead of scrolling.
 
 //#define DSMapAll
 //#define DSMapped
 //#define DSBuffered
-#define DSDirect
+//#define DSDirect
+#define DSCached
 
 #ifdef DSMapAll
 class DataSource {
@@ -143,6 +148,23 @@ public:
 };
 #endif
 
+#ifdef DSCached
+class DataSource {
+private:
+    DFBlockCache::FileID    file;
+    qint64                  nTp,
+                            lastPos;
+    int                     nC,
+                            blkTp;
+public:
+    DataSource() : nTp(0), lastPos(-1), nC(0), blkTp(1)    {}
+    virtual ~DataSource();
+    void set_df( DataFile *df );
+    int read( vec_i16 &dst, qint64 smp0, int nsmp );
+    void prefetch( qint64 pos, qint64 span );
+};
+#endif
+
 struct FVOpen {
     FileViewerWindow*   fvw;
     DFRunTag            runTag;
@@ -259,7 +281,7 @@ private:
     public:
         void init( int nChannels, int c0, int cLim, int maxInt );
         void updateLvl(
-            const DataFile  *df,
+            DataSource      &DS,
             Biquad          *hipass,
             qint64          xpos,
             int             nRem,
@@ -290,6 +312,8 @@ private:
     SvyVSBTT                SVY;
     QMap<int,int>           sh2bkMax;
     DataFile                *df;
+    DFPyramid               *pyr;
+    DFPyramidThread         *pyrBld;
     FVShankCtl              *shankCtl;
     ShankMap                *shankMap;
     ChanMap                 *chanMap;
@@ -507,6 +531,9 @@ private slots:
 // Timer targets
     void layoutGraphs();
 
+// Pyramid
+    void pyrBuilt();
+
 // Stream linking
     void linkRecvPos( double t0, double tSpan, int fChanged );
     void linkRecvSel( double tL, double tR );
@@ -547,6 +574,13 @@ private:
     void updateXSel();
     void zoomTime();
     void updateGraphs();
+    void pyrOpen();
+    bool pyrDraw(
+        const QVector<uint> &iv2ig,
+        float               ysc,
+        qint64              pos,
+        int                 nspan,
+        int                 dwnSmp );
 
     double scalePlotValue( double v, double gain );
     void computeGraphMouseOverVars(
@@ -1,62 +1,234 @@
 
 #include "GraphFetcher.h"
 #include "Util.h"
+#include "MainApp.h"
 #include "AIQ.h"
 #include "SVGrafsM.h"
+#include "ThreadPlace.h"
 
 #include <QThread>
+#include <QWaitCondition>
 
-#define PERIOD_SECS 0.1
+#include <algorithm>
+
+#define PERIOD_SECS     0.1
+#define REPORT_SECS     5.0
 
 /* ---------------------------------------------------------------- */
-/* GFWorker ------------------------------------------------------- */
+/* GFPool --------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
-void GFWorker::setStreams( const std::vector<GFStream> &gfs )
+// Threads serving all GraphFetchers; created with the first
+// fetcher, destroyed with the last.
+//
+class GFPool
 {
-    QMutexLocker    ml( &gfsMtx );
+    friend class GFWorker;
 
-    this->gfs = gfs;
+private:
+    std::vector<GraphFetcher*>  vF;
+    std::vector<QThread*>       vT;
+    std::vector<GFWorker*>      vW;
+    QMutex                      mtx;
+    QWaitCondition              cond;
+    bool                        pleaseStop;
 
-    for( int is = 0, ns = (int)gfs.size(); is < ns; ++is ) {
+    static QMutex               instMtx;
+    static GFPool               *inst;
+
+public:
+    static GFPool *attach( GraphFetcher *gf );
+    static void detach( GraphFetcher *gf );
+
+    QMutex *mutex()             {return &mtx;}
+    void wake()                 {cond.wakeAll();}
+    void waitIdle( GraphFetcher *gf )
+        {while( gf->nBusy ) cond.wait( &mtx );}
+
+private:
+    GFPool();
+    virtual ~GFPool();
+};
+
+
+QMutex  GFPool::instMtx;
+GFPool  *GFPool::inst = 0;
+
+
+// Several threads per machine, but at most one per stream
+// at a time, so this need not grow with stream count.
+//
+GFPool::GFPool() : pleaseStop(false)
+{
+    int nThd = qBound( 2, QThread::idealThreadCount() / 2, 8 );
+
+    for( int i = 0; i < nThd; ++i ) {
+
+        QThread     *thread = new QThread;
+        GFWorker    *worker = new GFWorker( this, i );
+
+        worker->moveToThread( thread );
+
+        Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+        Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+        Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+        thread->setServiceLevel( QThread::QualityOfService::Eco );
+        thread->start();
+        thread->setPriority( QThread::LowPriority );
+
+        vT.push_back( thread );
+        vW.push_back( worker );
+    }
+
+    Debug() << QString("Graph fetching started (%1 threads).").arg( nThd );
+}
+
+
+GFPool::~GFPool()
+{
+// worker objects auto-deleted asynchronously
+// thread objects manually deleted synchronously (so we can call wait())
+
+    mtx.lock();
+        pleaseStop = true;
+        cond.wakeAll();
+    mtx.unlock();
+
+    for( int i = 0, n = int(vT.size()); i < n; ++i ) {
+
+        if( vT[i]->isRunning() )
+            vT[i]->wait();
+
+        delete vT[i];
+    }
 
-        GFStream    &G = this->gfs[is];
+    Debug() << "Graph fetching stopped.";
+}
+
+
+GFPool *GFPool::attach( GraphFetcher *gf )
+{
+    QMutexLocker    ml( &instMtx );
+
+    if( !inst )
+        inst = new GFPool;
+
+    QMutexLocker    ml2( &inst->mtx );
+
+    inst->vF.push_back( gf );
+
+    return inst;
+}
+
+
+void GFPool::detach( GraphFetcher *gf )
+{
+    QMutexLocker    ml( &instMtx );
+
+    if( !inst )
+        return;
+
+    inst->mtx.lock();
+
+        inst->waitIdle( gf );
+
+        std::vector<GraphFetcher*>  &vF = inst->vF;
+
+        vF.erase( std::remove( vF.begin(), vF.end(), gf ), vF.end() );
+
+        bool    last = vF.empty();
+
+    inst->mtx.unlock();
 
-        G.setCts = PERIOD_SECS * G.aiQ->sRate();
-        G.nextCt = 0;
+    if( last ) {
+        delete inst;
+        inst = 0;
     }
 }
 
+/* ---------------------------------------------------------------- */
+/* GFWorker ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
 
+// Earliest-deadline-first over the ready (unpaused, idle)
+// streams of all fetchers. Sleep until the winner is due.
+//
 void GFWorker::run()
 {
-    Debug() << "Graph fetching started.";
+    ThreadPlace::pin( ThreadPlace::tpGraph, QString("graph%1").arg( id ) );
+
+    P->mtx.lock();
+
+    while( !P->pleaseStop ) {
+
+        GraphFetcher    *F = 0;
+        GFTask          *T = 0;
+
+        for( int iF = 0, nF = int(P->vF.size()); iF < nF; ++iF ) {
 
-    const int   loopPeriod_us = 1e6 * PERIOD_SECS;
+            GraphFetcher    *f = P->vF[iF];
 
-    while( !isStopped() ) {
+            if( f->isPaused() )
+                continue;
 
-        double  loopT = getTime();
+            for( int it = 0, nt = int(f->tasks.size()); it < nt; ++it ) {
 
-        if( !isPaused() ) {
+                GFTask  &t = f->tasks[it];
 
-            QMutexLocker    ml( &gfsMtx );
+                if( !t.busy && (!T || t.due < T->due) ) {
+                    F = f;
+                    T = &t;
+                }
+            }
+        }
+
+        if( !T ) {
+            P->cond.wait( &P->mtx, 1000 * PERIOD_SECS );
+            continue;
+        }
+
+        double  tStart = getTime();
 
-            for( int is = 0, ns = (int)gfs.size(); is < ns; ++is )
-                fetch( gfs[is] );
+        if( T->due > tStart ) {
+            P->cond.wait( &P->mtx, qMax( 1, int(1000 * (T->due - tStart)) ) );
+            continue;
         }
 
-        // Fetch no more often than every loopPeriod_us
+        if( T->due && tStart - T->due >= PERIOD_SECS )
+            T->nDrop += quint32((tStart - T->due) / PERIOD_SECS);
+
+        T->busy = true;
+        ++F->nBusy;
+
+        P->mtx.unlock();
+
+            fetch( T->S );
 
-        loopT = 1e6*(getTime() - loopT);    // microsec
+            double  tEnd = getTime(),
+                    lat  = tEnd - tStart;
 
-        if( loopT < loopPeriod_us )
-            QThread::usleep( loopPeriod_us - loopT );
-        else
-            QThread::usleep( 1000 * 10 );
+        P->mtx.lock();
+
+        T->latSum  += lat;
+        T->latMax   = qMax( T->latMax, lat );
+        ++T->nFetch;
+
+        // Fetch no more often than every PERIOD_SECS.
+        // Paused meanwhile: restart fresh (see pauseChanged).
+
+        T->due = (F->isPaused() ? 0 : tStart + PERIOD_SECS);
+
+        if( tEnd - T->tRpt >= REPORT_SECS )
+            report( *T, tEnd );
+
+        T->busy = false;
+        --F->nBusy;
+
+        P->cond.wakeAll();
     }
 
-    Debug() << "Graph fetching stopped.";
+    P->mtx.unlock();
 
     emit finished();
 }
@@ -122,39 +294,122 @@ void GFWorker::fetch( GFStream &S )
     S.nextCt += data.size() / S.aiQ->nChans();
 }
 
+
+// Post {ave, max} fetch latency (ms) and dropped frames.
+//
+void GFWorker::report( GFTask &T, double tNow )
+{
+    if( T.tRpt && T.nFetch ) {
+
+        QMetaObject::invokeMethod(
+            mainApp()->metrics(),
+            "prfUpdateGraph",
+            Qt::QueuedConnection,
+            Q_ARG(QString, T.S.stream),
+            Q_ARG(double, 1000 * T.latSum / T.nFetch),
+            Q_ARG(double, 1000 * T.latMax),
+            Q_ARG(quint32, T.nDrop) );
+    }
+
+    T.tRpt      = tNow;
+    T.latSum    = 0;
+    T.latMax    = 0;
+    T.nFetch    = 0;
+}
+
 /* ---------------------------------------------------------------- */
 /* GraphFetcher --------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
 GraphFetcher::GraphFetcher()
+    :   nBusy(0), hardPaused(false), softPaused(false)
 {
-    thread  = new QThread;
-    worker  = new GFWorker;
-
-    worker->moveToThread( thread );
+    P = GFPool::attach( this );
+}
 
-    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
-    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
-    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
 
-    thread->setServiceLevel( QThread::QualityOfService::Eco );
-    thread->start();
-    thread->setPriority( QThread::LowPriority );
+GraphFetcher::~GraphFetcher()
+{
+    GFPool::detach( this );
 }
 
 
-GraphFetcher::~GraphFetcher()
+// Replace stream set once none of ours are being fetched.
+//
+void GraphFetcher::setStreams( const std::vector<GFStream> &gfs )
 {
-// worker object auto-deleted asynchronously
-// thread object manually deleted synchronously (so we can call wait())
+    QMutexLocker    ml( P->mutex() );
+
+    P->waitIdle( this );
+
+    tasks.clear();
+
+    for( int is = 0, ns = (int)gfs.size(); is < ns; ++is ) {
+
+        GFTask  T( gfs[is] );
 
-    if( thread->isRunning() ) {
+        T.S.setCts = PERIOD_SECS * T.S.aiQ->sRate();
+        T.S.nextCt = 0;
 
-        worker->stop();
-        thread->wait();
+        tasks.push_back( T );
     }
 
-    delete thread;
+    P->wake();
+}
+
+
+bool GraphFetcher::hardPause( bool pause )
+{
+    QMutexLocker    ml( P->mutex() );
+
+    bool    was     = hardPaused,
+            wasP    = isPaused();
+
+    hardPaused = pause;
+    pauseChanged( wasP );
+
+    P->wake();
+
+    return was;
+}
+
+
+void GraphFetcher::softPause( bool pause )
+{
+    QMutexLocker    ml( P->mutex() );
+
+    bool    wasP = isPaused();
+
+    softPaused = pause;
+    pauseChanged( wasP );
+
+    P->wake();
+}
+
+
+// Caller holds pool mutex.
+// Paused time isn't missed fetches: on either transition,
+// idle tasks become due at once with no drop count (due=0).
+//
+void GraphFetcher::pauseChanged( bool wasPaused )
+{
+    if( isPaused() == wasPaused )
+        return;
+
+    for( int it = 0, nt = int(tasks.size()); it < nt; ++it ) {
+
+        if( !tasks[it].busy )
+            tasks[it].due = 0;
+    }
 }
 
 
+// If paused, return once no fetch of ours is in progress.
+//
+void GraphFetcher::waitPaused()
+{
+    QMutexLocker    ml( P->mutex() );
+
+    if( isPaused() )
+        P->waitIdle( this );
+}
@@ -8,6 +8,7 @@
 
 class SVGrafsM;
 class AIQ;
+class GFPool;
 
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
@@ -26,46 +27,40 @@ struct GFStream {
         :   stream(stream), W(W), aiQ(0), setCts(0), nextCt(0)  {}
 };
 
+// Schedule and stats for one stream of a GraphFetcher.
+// A fetch is due every PERIOD; a start more than one whole
+// period late counts the skipped periods as dropped frames.
+//
+struct GFTask {
+    GFStream    S;
+    double      due,
+                tRpt,       // last metrics report
+                latSum,     // since tRpt
+                latMax;     // since tRpt
+    quint32     nFetch,     // since tRpt
+                nDrop;      // cumulative
+    bool        busy;
+
+    GFTask( const GFStream &S )
+        :   S(S), due(0), tRpt(0), latSum(0), latMax(0),
+            nFetch(0), nDrop(0), busy(false)    {}
+};
+
+// One thread of the shared fetcher pool. Each takes the ready
+// stream with the earliest deadline, across all GraphFetchers,
+// so streams are fetched and processed concurrently, and one
+// slow stream can't hold up the others.
+//
 class GFWorker : public QObject
 {
     Q_OBJECT
 
 private:
-    std::vector<GFStream>   gfs;
-    mutable QMutex          gfsMtx,
-                            runMtx;
-    volatile bool           hardPaused, // Pause button
-                            softPaused, // Window state
-                            pleaseStop;
+    GFPool  *P;
+    int     id;
 
 public:
-    GFWorker()
-    :   QObject(0),
-        hardPaused(false), softPaused(false),
-        pleaseStop(false)   {}
-
-    void setStreams( const std::vector<GFStream> &gfs );
-
-    bool hardPause( bool pause )
-        {
-            QMutexLocker ml( &runMtx );
-            bool was = hardPaused;
-            hardPaused = pause;
-            return was;
-        }
-    void softPause( bool pause )
-        {QMutexLocker ml( &runMtx ); softPaused = pause;}
-    bool isPaused() const
-        {QMutexLocker ml( &runMtx ); return hardPaused || softPaused;}
-    void waitPaused()
-        {
-            QMutexLocker ml( &runMtx );
-            if( hardPaused || softPaused )  // wait for access to gfs
-                QMutexLocker ml2( &gfsMtx );
-        }
-
-    void stop()             {QMutexLocker ml( &runMtx ); pleaseStop = true;}
-    bool isStopped() const  {QMutexLocker ml( &runMtx ); return pleaseStop;}
+    GFWorker( GFPool *P, int id ) : QObject(0), P(P), id(id)    {}
 
 signals:
     void finished();
@@ -75,27 +70,38 @@ public slots:
 
 private:
     void fetch( GFStream &S );
+    void report( GFTask &T, double tNow );
 };
 
 
+// One per GraphsWindow; its streams are served by the pool.
+// All state below is guarded by the pool mutex.
+//
 class GraphFetcher
 {
+    friend class GFPool;
+    friend class GFWorker;
+
 private:
-    QThread     *thread;
-    GFWorker    *worker;
+    std::vector<GFTask> tasks;
+    GFPool              *P;
+    int                 nBusy;
+    bool                hardPaused, // Pause button
+                        softPaused; // Window state
 
 public:
     GraphFetcher();
     virtual ~GraphFetcher();
 
-    void setStreams( const std::vector<GFStream> &gfs )
-        {worker->setStreams( gfs );}
+    void setStreams( const std::vector<GFStream> &gfs );
+
+    bool hardPause( bool pause );
+    void softPause( bool pause );
+    void waitPaused();
 
-    bool hardPause( bool pause )    {return worker->hardPause( pause );}
-    void softPause( bool pause )    {worker->softPause( pause );}
-    void waitPaused()               {worker->waitPaused();}
+private:
+    bool isPaused() const   {return hardPaused || softPaused;}
+    void pauseChanged( bool wasPaused );
 };
 
 #endif  // GRAPHFETCHER_H
-
-
@@ -124,6 +124,9 @@ static void addLF2AP(
 #define V_S_AVE( d_ic )                         \
     (sAveLocal ? car.lcl_1( d_ic, ic ) : *d_ic)
 
+// putSamps tile size in samples (~128KB of int16).
+#define TILE_SAMPS  65536
+
 
 void SVGrafsM_Im::putSamps( vec_i16 &data, quint64 headCt )
 {
@@ -170,222 +173,231 @@ void SVGrafsM_Im::putSamps( vec_i16 &data, quint64 headCt )
 
     gw->getTTLColorCtl()->scanBlock( theX, data, headCt, nC, jsIM, ip );
 
-// -------
-// Filters
-// -------
-
-    // -----------
-    // AP bandpass
-    // -----------
+// ------------------------------------------
+// LOCK MUTEXES before accessing filters, set
+// ------------------------------------------
 
     fltMtx.lock();
-    if( hipass )
-        hipass->applyBlockwiseMem( &data[0], maxInt, ntpts, nC, 0, nAP );
-    if( lopass )
-        lopass->applyBlockwiseMem( &data[0], maxInt, ntpts, nC, 0, nAP );
-    fltMtx.unlock();
-
-    // ------------------------------------------
-    // LOCK MUTEX before accessing settings (set)
-    // ------------------------------------------
-
     drawMtx.lock();
 
     bool    drawBinMax  = set.binMaxOn && dwnSmp > 1,
-            sAveLocal   = false;
+            sAveLocal   = set.sAveSel == 1 || set.sAveSel == 2;
+    int     dS          = (drawBinMax ? 1 : dwnSmp),
+            nyAll       = ntpts / dwnSmp;
 
-    // ------------
-    // AP = AP + LF
-    // ------------
+    car.setChans( nC, nAP, dS );
 
-    // BK: We should superpose traces to see AP & LF, not add.
+// ---------------------------------------
+// Per-channel outputs, channel-major rows
+// ---------------------------------------
 
-    if( nLF && set.bandSel == 3 )
-        addLF2AP( E, &data[0], ntpts, nC, nAP, (drawBinMax ? 1 : dwnSmp) );
+    std::vector<float>  ybuf( nC * nyAll ),     // append en masse
+                        ybuf2( drawBinMax ? nAP * nyAll : 0 );
 
-    // ---------------------------------
-    // -<Tn>; not applied if AP filtered
-    // ---------------------------------
+    for( int ic = 0; ic < nC; ++ic ) {
 
-    if( set.tnChkOn ) {
+        if( ic2iy[ic] >= 0 ) {
+            ic2stat[ic].clear();
+            ic2Y[ic].drawBinMax = drawBinMax && ic < nAP;
+        }
+    }
 
-        Tn.updateLvl( &data[0], ntpts, dwnSmp );
+// --------------------------------------------------------
+// Fused sweep: all per-timepoint stages then binning, run
+// on cache-sized tiles (whole bins) so each tile is read
+// from memory once rather than once per stage/channel.
+// --------------------------------------------------------
 
-        if( set.bandSel == 0 || set.bandSel == 3 )
-            Tn.apply( &data[0], ntpts, (drawBinMax ? 1 : dwnSmp) );
-        else if( nLF )
-            Tn.applyLF( &data[0], ntpts, (drawBinMax ? 1 : dwnSmp) );
-    }
+    int tileT = qMax( 1, TILE_SAMPS / (nC * dwnSmp) ) * dwnSmp;
 
-    // ----
-    // -<S>
-    // ----
+    for( int t0 = 0; t0 < ntpts; t0 += tileT ) {
 
-    car.setChans( nC, nAP, (drawBinMax ? 1 : dwnSmp) );
+        qint16  *tile   = &data[t0 * nC];
+        int     nt      = qMin( tileT, ntpts - t0 ),
+                y0      = t0 / dwnSmp;
 
-    switch( set.sAveSel ) {
-        case 1:
-        case 2:
-            sAveLocal = true;
-            break;
-        case 3:
-            car.gbl_ave_auto( &data[0], ntpts );
-            break;
-        case 4:
-            car.gbl_dmx_tbl_auto( &data[0], ntpts );
-            break;
-        default:
-            ;
-    }
+        // -----------
+        // AP bandpass
+        // -----------
 
-// ---------------------
-// Append data to graphs
-// ---------------------
+        if( hipass )
+            hipass->applyBlockwiseMem( tile, maxInt, nt, nC, 0, nAP );
+        if( lopass )
+            lopass->applyBlockwiseMem( tile, maxInt, nt, nC, 0, nAP );
 
-    std::vector<float>  ybuf( ntpts ),  // append en masse
-                        ybuf2( drawBinMax ? ntpts : 0 );
+        // ------------
+        // AP = AP + LF
+        // ------------
 
-    theX->dataMtx.lock();
+        // BK: We should superpose traces to see AP & LF, not add.
 
-    for( int ic = 0; ic < nC; ++ic ) {
+        if( nLF && set.bandSel == 3 )
+            addLF2AP( E, tile, nt, nC, nAP, dS );
 
-        // -----------------
-        // For active graphs
-        // -----------------
+        // ---------------------------------
+        // -<Tn>; not applied if AP filtered
+        // ---------------------------------
 
-        if( ic2iy[ic] < 0 )
-            continue;
+        if( set.tnChkOn ) {
 
-        // ----------
-        // Init stats
-        // ----------
+            Tn.updateLvl( tile, nt, dwnSmp );
 
-        // Collect points, update mean, stddev
+            if( set.bandSel == 0 || set.bandSel == 3 )
+                Tn.apply( tile, nt, dS );
+            else if( nLF )
+                Tn.applyLF( tile, nt, dS );
+        }
 
-        GraphStats  &stat = ic2stat[ic];
+        // ----
+        // -<S>
+        // ----
 
-        stat.clear();
+        if( set.sAveSel == 3 )
+            car.gbl_ave_auto( tile, nt );
+        else if( set.sAveSel == 4 )
+            car.gbl_dmx_tbl_auto( tile, nt );
 
-        // ------------------
-        // By channel type...
-        // ------------------
+        // --------------------
+        // Bin tile to graph Ys
+        // --------------------
 
-        qint16  *d  = &data[ic];
-        int     ny  = 0;
+        for( int ic = 0; ic < nC; ++ic ) {
 
-        if( ic < nAP ) {
+            // -----------------
+            // For active graphs
+            // -----------------
 
-            ic2Y[ic].drawBinMax = false;
+            if( ic2iy[ic] < 0 )
+                continue;
 
-            if( !E.sns.shankMap.e[ic].u ) {
+            // Collect points, update mean, stddev
 
-                ny = (ntpts + dwnSmp - 1) / dwnSmp;
-                memset( &ybuf[0], 0, ny * sizeof(float) );
-                goto putData;
-            }
+            GraphStats  &stat   = ic2stat[ic];
+            float       *Y      = &ybuf[ic * nyAll + y0];
+            qint16      *d      = &tile[ic];
+            int         ny      = 0;
 
-            // ------
-            // BinMax
-            // ------
+            // ------------------
+            // By channel type...
+            // ------------------
 
-            // Within each bin, report both max and min
-            // values. This ensures spikes aren't missed.
-            // Max in ybuf, min in ybuf2.
+            if( ic < nAP ) {
 
-            if( drawBinMax ) {
+                if( !E.sns.shankMap.e[ic].u ) {
+                    ic2Y[ic].drawBinMax = false;
+                    continue;   // rows are zero-initialized
+                }
 
-                int ndRem = ntpts;
+                // ------
+                // BinMax
+                // ------
 
-                ic2Y[ic].drawBinMax = true;
+                // Within each bin, report both max and min
+                // values. This ensures spikes aren't missed.
+                // Max in ybuf, min in ybuf2.
 
-                for( int it = 0; it < ntpts; it += dwnSmp ) {
+                if( drawBinMax ) {
 
-                    int val     = V_S_AVE( d ),
-                        vmax    = val,
-                        vmin    = val,
-                        binWid  = dwnSmp;
+                    float   *Y2     = &ybuf2[ic * nyAll + y0];
+                    int     ndRem   = nt;
 
-                    stat.add( val );
+                    for( int it = 0; it < nt; it += dwnSmp ) {
 
-                    d += nC;
+                        int val     = V_S_AVE( d ),
+                            vmax    = val,
+                            vmin    = val,
+                            binWid  = dwnSmp;
 
-                    if( ndRem < binWid )
-                        binWid = ndRem;
+                        stat.add( val );
 
-                    for( int ib = 1; ib < binWid; ++ib, d += nC ) {
+                        d += nC;
 
-                        val = V_S_AVE( d );
+                        if( ndRem < binWid )
+                            binWid = ndRem;
 
-                        // By NOT statting every point in the bin:
-                        // (1) Stats agree for all binMax settings.
-                        // (2) BinMax ~30% faster.
-                        //
-                        // stat.add( val );
+                        for( int ib = 1; ib < binWid; ++ib, d += nC ) {
 
-                        if( val > vmax )
-                            vmax = val;
-                        else if( val < vmin )
-                            vmin = val;
-                    }
+                            val = V_S_AVE( d );
 
-                    ndRem -= binWid;
+                            // By NOT statting every point in the bin:
+                            // (1) Stats agree for all binMax settings.
+                            // (2) BinMax ~30% faster.
+                            //
+                            // stat.add( val );
 
-                    ybuf[ny]  = vmax * ysc;
-                    ybuf2[ny] = vmin * ysc;
-                    ++ny;
+                            if( val > vmax )
+                                vmax = val;
+                            else if( val < vmin )
+                                vmin = val;
+                        }
+
+                        ndRem -= binWid;
+
+                        Y[ny]  = vmax * ysc;
+                        Y2[ny] = vmin * ysc;
+                        ++ny;
+                    }
                 }
-            }
-            else if( sAveLocal ) {
+                else if( sAveLocal ) {
 
-                for( int it = 0; it < ntpts; it += dwnSmp, d += dstep ) {
+                    for( int it = 0; it < nt; it += dwnSmp, d += dstep ) {
 
-                    int val = car.lcl_1( d, ic );
+                        int val = car.lcl_1( d, ic );
 
-                    stat.add( val );
-                    ybuf[ny++] = val * ysc;
+                        stat.add( val );
+                        Y[ny++] = val * ysc;
+                    }
                 }
+                else
+                    goto draw_analog;
             }
-            else
-                goto draw_analog;
-        }
-        else if( ic < nNu ) {
+            else if( ic < nNu ) {
+
+                // ---
+                // LFP
+                // ---
 
-            // ---
-            // LFP
-            // ---
+                if( !E.sns.shankMap.e[ic - nAP].u )
+                    continue;
 
-            if( !E.sns.shankMap.e[ic - nAP].u ) {
+draw_analog:
+                for( int it = 0; it < nt; it += dwnSmp, d += dstep ) {
 
-                ny = (ntpts + dwnSmp - 1) / dwnSmp;
-                memset( &ybuf[0], 0, ny * sizeof(float) );
-                goto putData;
+                    stat.add( *d );
+                    Y[ny++] = *d * ysc;
+                }
             }
+            else {
 
-draw_analog:
-            for( int it = 0; it < ntpts; it += dwnSmp, d += dstep ) {
+                // ----
+                // Sync
+                // ----
 
-                stat.add( *d );
-                ybuf[ny++] = *d * ysc;
+                for( int it = 0; it < nt; it += dwnSmp, d += dstep )
+                    Y[ny++] = *d;
             }
         }
-        else {
+    }
 
-            // ----
-            // Sync
-            // ----
+    fltMtx.unlock();
 
-            for( int it = 0; it < ntpts; it += dwnSmp, d += dstep )
-                ybuf[ny++] = *d;
-        }
+// ---------------------
+// Append data to graphs
+// ---------------------
+
+    // Renormalize x-coords -> consecutive indices.
 
-        // Append points en masse
-        // Renormalize x-coords -> consecutive indices.
+    theX->dataMtx.lock();
+
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        if( ic2iy[ic] < 0 )
+            continue;
 
-putData:
-        ic2Y[ic].yval.putData( &ybuf[0], ny );
+        ic2Y[ic].yval.putData( &ybuf[ic * nyAll], nyAll );
 
         if( ic2Y[ic].drawBinMax )
-            ic2Y[ic].yval2.putData( &ybuf2[0], ny );
+            ic2Y[ic].yval2.putData( &ybuf2[ic * nyAll], nyAll );
     }
 
 // -----------------------
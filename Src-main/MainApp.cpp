@@ -17,6 +17,7 @@
 #include "Run.h"
 #include "CalSRateCtl.h"
 #include "SvyPrb.h"
+#include "BenchRun.h"
 #include "IMBISTCtl.h"
 #include "IMHSTCtl.h"
 #include "IMFirmCtl.h"
@@ -150,6 +151,7 @@ void AppData::loadSettings( QSettings &S )
     lastViewedFile  = S.value( "lastViewedFile", getDataDir( 0 ) ).toString();
     debug           = S.value( "debug", false ).toBool();
     editLog         = S.value( "editLog", false ).toBool();
+    cpuPlace        = S.value( "cpuPlace", "off" ).toString();
 
     S.endGroup();
 }
@@ -162,6 +164,7 @@ void AppData::saveSettings( QSettings &S ) const
     S.setValue( "lastViewedFile", lastViewedFile );
     S.setValue( "debug", debug );
     S.setValue( "editLog", editLog );
+    S.setValue( "cpuPlace", cpuPlace );
 
     QMutexLocker    ml( &remoteMtx );
     S.setValue( "dataDir", slDataDir );
@@ -237,7 +240,7 @@ MainApp::MainApp( int &argc, char **argv )
     :   QApplication(argc, argv, true),
         run(0), consoleWindow(0), mxWin(0), par2Win(0),
         configCtl(0), aoCtl(0), cmdSrv(new CmdSrvDlg),
-        rgtSrv(new RgtSrvDlg), calSRRun(0), svyPrbRun(0),
+        rgtSrv(new RgtSrvDlg), calSRRun(0), svyPrbRun(0), benchRun(0),
         rsWin(0), rsUI(0), initialized(false), quitting(false)
 {
 // --------------
@@ -323,6 +326,9 @@ MainApp::MainApp( int &argc, char **argv )
     np_dbg_setlogcallback( DBG_VERBOSE, npcallback );
     np_dbg_setlevel( DBG_VERBOSE );
 #endif
+
+    if( BenchRun::fromArgs( benchRun, arguments() ) )
+        QTimer::singleShot( 0, this, SLOT(runBenchStart()) );
 }
 
 
@@ -1701,6 +1707,8 @@ void MainApp::rsStarted()
         QTimer::singleShot(
             svyPrbRun->msPerBnk( true ), this, SLOT(runUpdateSvyTimer()) );
     }
+    else if( benchRun )
+        benchRun->started();
 }
 
 
@@ -1739,13 +1747,23 @@ void MainApp::rsStopped()
             svyPrbRun, "finish",
             Qt::QueuedConnection );
     }
+    else if( benchRun ) {
+
+        QMetaObject::invokeMethod(
+            benchRun, "finish",
+            Qt::QueuedConnection );
+    }
 }
 
 
 void MainApp::runDaqError( const QString &e )
 {
     run->stopRun();
-    QMessageBox::critical( 0, "DAQ Error", e );
+
+    if( benchRun )
+        Error() << "DAQ Error: " << e;  // headless
+    else
+        QMessageBox::critical( 0, "DAQ Error", e );
 }
 
 
@@ -1810,6 +1828,32 @@ void MainApp::runSvyFinished()
 }
 
 
+void MainApp::runBenchStart()
+{
+    QString err;
+
+    if( !benchRun->start( err ) ) {
+        Error() << "BENCH: " << err;
+        runBenchFinished();
+    }
+}
+
+
+// Benchmark is headless, so quit when done.
+//
+void MainApp::runBenchFinished()
+{
+    benchRun->deleteLater();
+    benchRun = 0;
+
+    quitting = true;
+    msg.appQuiting();
+    win.closeAll();
+
+    quit();
+}
+
+
 #ifdef DO_SNAPSHOTS
 void MainApp::runSnapBefore()
 {
@@ -21,6 +21,7 @@ class CmdSrvDlg;
 class RgtSrvDlg;
 class CalSRRun;
 class SvyPrbRun;
+class BenchRun;
 
 class QSettings;
 
@@ -31,6 +32,7 @@ class QSettings;
 struct AppData {
     QStringList     slDataDir;
     QString         lastViewedFile,
+                    cpuPlace,   // {off, auto, acq cpulist}
                     empty;
     bool            multidrive,
                     debug,
@@ -82,6 +84,7 @@ private:
     RgtSrvDlg           *rgtSrv;
     CalSRRun            *calSRRun;
     SvyPrbRun           *svyPrbRun;
+    BenchRun            *benchRun;
     QWidget             *rsWin;
     Ui::RunStartupWin   *rsUI;
     AppData             appData;
@@ -134,6 +137,7 @@ public:
     bool isQuitting() const         {return quitting;}
     bool isDebugMode() const        {return appData.debug;}
     bool isLogEditable() const      {return appData.editLog;}
+    const QString& cpuPlacement() const {return appData.cpuPlace;}
     bool isConsoleHidden() const;
     bool isShiftPressed() const;
 
@@ -232,6 +236,8 @@ public slots:
     void runCalFinished();
     void runUpdateSvyTimer();
     void runSvyFinished();
+    void runBenchStart();
+    void runBenchFinished();
 #ifdef DO_SNAPSHOTS
     void runSnapBefore();
     void runSnapStarted();
@@ -80,6 +80,7 @@ void MetricsWindow::runInit()
 {
     err.init();
     prf.init();
+    gfx.init();
     dsk.init();
 
     setWindowTitle(
@@ -397,6 +398,207 @@ void MetricsWindow::updateMx()
         te->setTextColor( defColor );
     }
 
+// Fetch loop
+
+    if( prf.loopMs.size() ) {
+
+        // --------------------
+        // Color title by worst
+        // --------------------
+
+        double  maxMs = 0;
+
+        QMap<QString,MXLoopStat>::iterator  it, end = prf.loopMs.end();
+
+        for( it = prf.loopMs.begin(); it != end; ++it )
+            maxMs = qMax( maxMs, it.value().maxMs );
+
+        if( maxMs >= 50 )
+            te->setTextColor( Qt::darkRed );
+        else if( maxMs >= 10 )
+            te->setTextColor( Qt::darkMagenta );
+        else
+            te->setTextColor( Qt::darkGreen );
+
+        te->append( "Stream-i (fetch loop ms ave|sd|max):" );
+
+        // --------------------
+        // Color and write each
+        // --------------------
+
+        int nOnLine = 0;
+
+        for( it = prf.loopMs.begin(); it != end; ++it ) {
+
+            if( !(nOnLine++ % 8) )
+                te->insertPlainText( "\n" );
+
+            te->moveCursor( QTextCursor::End );
+
+            const MXLoopStat    &L = it.value();
+
+            if( L.maxMs >= 50 )
+                te->setTextColor( Qt::darkRed );
+            else if( L.maxMs >= 10 )
+                te->setTextColor( Qt::darkMagenta );
+            else
+                te->setTextColor( Qt::darkGreen );
+
+            te->insertPlainText(
+                QString("  %1(%2|%3|%4)")
+                .arg( it.key() )
+                .arg( L.aveMs, 0, 'f', 2 )
+                .arg( L.sdMs, 0, 'f', 2 )
+                .arg( L.maxMs, 0, 'f', 1 ) );
+        }
+
+        te->setTextColor( defColor );
+    }
+
+// Filtered streams
+
+    if( prf.qf.size() ) {
+
+        // --------------------
+        // Color title by worst
+        // --------------------
+
+        double  maxShed = 0;
+
+        QMap<QString,MXQfStat>::iterator    it, end = prf.qf.end();
+
+        for( it = prf.qf.begin(); it != end; ++it )
+            maxShed = qMax( maxShed, it.value().shedSecs );
+
+        if( maxShed > 0 )
+            te->setTextColor( Qt::darkMagenta );
+        else
+            te->setTextColor( Qt::darkGreen );
+
+        te->append( "Filtered streams (max lag ms, zero-filled s):" );
+
+        // --------------------
+        // Color and write each
+        // --------------------
+
+        int nOnLine = 0;
+
+        for( it = prf.qf.begin(); it != end; ++it ) {
+
+            if( !(nOnLine++ % 8) )
+                te->insertPlainText( "\n" );
+
+            te->moveCursor( QTextCursor::End );
+
+            const MXQfStat  &Q = it.value();
+
+            if( Q.shedSecs > 0 )
+                te->setTextColor( Qt::darkMagenta );
+            else
+                te->setTextColor( Qt::darkGreen );
+
+            te->insertPlainText(
+                QString("  %1(%2 %3)")
+                .arg( it.key() )
+                .arg( Q.lagMs, 0, 'f', 1 )
+                .arg( Q.shedSecs, 0, 'f', 2 ) );
+        }
+
+        te->setTextColor( defColor );
+    }
+
+// Thread placement
+
+    if( prf.place.size() ) {
+
+        te->append( "Threads (cpu placement):" );
+
+        int nOnLine = 0;
+
+        QMap<QString,QString>::iterator it, end = prf.place.end();
+
+        for( it = prf.place.begin(); it != end; ++it ) {
+
+            if( !(nOnLine++ % 6) )
+                te->insertPlainText( "\n" );
+
+            te->moveCursor( QTextCursor::End );
+
+            if( it.value() == "unpinned" )
+                te->setTextColor( Qt::darkMagenta );
+            else
+                te->setTextColor( Qt::darkGreen );
+
+            te->insertPlainText(
+                QString("  %1{%2}")
+                .arg( it.key() )
+                .arg( it.value() ) );
+        }
+
+        te->setTextColor( defColor );
+    }
+
+// Graphs
+
+    if( gfx.fetch.size() ) {
+
+        // --------------------
+        // Color title by worst
+        // --------------------
+
+        double  maxMs   = 0;
+        quint32 nDrop   = 0;
+
+        QMap<QString,MXGfxStat>::iterator   it, end = gfx.fetch.end();
+
+        for( it = gfx.fetch.begin(); it != end; ++it ) {
+
+            maxMs = qMax( maxMs, it.value().maxMs );
+            nDrop = qMax( nDrop, it.value().nDrop );
+        }
+
+        if( maxMs >= 100 )
+            te->setTextColor( Qt::darkRed );
+        else if( maxMs >= 50 || nDrop )
+            te->setTextColor( Qt::darkMagenta );
+        else
+            te->setTextColor( Qt::darkGreen );
+
+        te->append( "Graphs (fetch ms ave|max, dropped frames):" );
+
+        // --------------------
+        // Color and write each
+        // --------------------
+
+        int nOnLine = 0;
+
+        for( it = gfx.fetch.begin(); it != end; ++it ) {
+
+            if( !(nOnLine++ % 8) )
+                te->insertPlainText( "\n" );
+
+            te->moveCursor( QTextCursor::End );
+
+            const MXGfxStat &G = it.value();
+
+            if( G.maxMs >= 100 )
+                te->setTextColor( Qt::darkRed );
+            else if( G.maxMs >= 50 || G.nDrop )
+                te->setTextColor( Qt::darkMagenta );
+            else
+                te->setTextColor( Qt::darkGreen );
+
+            te->insertPlainText(
+                QString("  %1(%2|%3 %4)")
+                .arg( it.key() )
+                .arg( G.aveMs, 0, 'f', 1 )
+                .arg( G.maxMs, 0, 'f', 1 )
+                .arg( G.nDrop ) );
+        }
+
+        te->setTextColor( defColor );
+    }
+
 // ----
 // Disk
 // ----
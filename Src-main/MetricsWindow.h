@@ -18,6 +18,16 @@ class MetricsWindow : public QWidget
 {
     Q_OBJECT
 
+public:
+    struct MXLoopStat {
+        double  aveMs,
+                sdMs,
+                maxMs;
+        MXLoopStat() : aveMs(0), sdMs(0), maxMs(0)  {}
+        MXLoopStat( double aveMs, double sdMs, double maxMs )
+        :   aveMs(aveMs), sdMs(sdMs), maxMs(maxMs)  {}
+    };
+
 private:
     struct MXErrFlags {
         quint32 errCOUNT,
@@ -58,14 +68,59 @@ private:
             }
     };
 
+    struct MXQfStat {
+        double  lagMs,
+                shedSecs;
+        MXQfStat() : lagMs(0), shedSecs(0)  {}
+        MXQfStat( double lagMs, double shedSecs )
+        :   lagMs(lagMs), shedSecs(shedSecs)    {}
+    };
+
     struct MXPrfRec {
-        QMap<QString,int>   fifoPct;
-        QMap<QString,int>   awakePct;
-        void init() {fifoPct.clear(); awakePct.clear();}
+        QMap<QString,int>           fifoPct;
+        QMap<QString,int>           awakePct;
+        QMap<QString,MXLoopStat>    loopMs;
+        QMap<QString,QString>       place;
+        QMap<QString,MXQfStat>      qf;
+        void init()
+            {
+                fifoPct.clear(); awakePct.clear();
+                loopMs.clear(); place.clear(); qf.clear();
+            }
         void setFifo( const QString &stream, int maxFifo )
             {fifoPct[stream]=maxFifo;}
         void setAwake( const QString &stream, int pct )
             {awakePct[stream]=pct;}
+        void setLoop(
+            const QString   &stream,
+            double          aveMs,
+            double          sdMs,
+            double          maxMs )
+            {loopMs[stream]=MXLoopStat( aveMs, sdMs, maxMs );}
+        void setPlace( const QString &thread, const QString &cpus )
+            {place[thread]=cpus;}
+        void setQf( const QString &stream, double lagMs, double shedSecs )
+            {qf[stream]=MXQfStat( lagMs, shedSecs );}
+    };
+
+    struct MXGfxStat {
+        double  aveMs,
+                maxMs;
+        quint32 nDrop;
+        MXGfxStat() : aveMs(0), maxMs(0), nDrop(0)   {}
+        MXGfxStat( double aveMs, double maxMs, quint32 nDrop )
+        :   aveMs(aveMs), maxMs(maxMs), nDrop(nDrop)   {}
+    };
+
+    struct MXGfxRec {
+        QMap<QString,MXGfxStat> fetch;
+        void init() {fetch.clear();}
+        void setFetch(
+            const QString   &stream,
+            double          aveMs,
+            double          maxMs,
+            quint32         nDrop )
+            {fetch[stream]=MXGfxStat( aveMs, maxMs, nDrop );}
     };
 
     struct MXDiskRec {
@@ -97,6 +152,7 @@ private:
     QTimer              mxTimer;
     MXErrRec            err;
     MXPrfRec            prf;
+    MXGfxRec            gfx;
     MXDiskRec           dsk;
     qreal               defSize;
     QColor              defColor;
@@ -117,6 +173,12 @@ public:
 
     QString getErrFlags( int js, int ip, int shank = -1 );
 
+    // Latest values, for BenchRun; call from GUI thread.
+    double getWrMBps() const    {return dsk.wbps;}
+    double getMaxFull() const
+        {return qMax( dsk.niFull, qMax( dsk.obFull, dsk.imFull ) );}
+    QMap<QString,MXLoopStat> getLoopStats() const   {return prf.loopMs;}
+
 signals:
     void closed( QWidget *w );
 
@@ -135,6 +197,22 @@ public slots:
         {prf.setFifo( stream, maxFifo );}
     void prfUpdateAwake( const QString &stream, int pct )
         {prf.setAwake( stream, pct );}
+    void prfUpdateLoop(
+        const QString   &stream,
+        double          aveMs,
+        double          sdMs,
+        double          maxMs )
+        {prf.setLoop( stream, aveMs, sdMs, maxMs );}
+    void prfUpdatePlace( const QString &thread, const QString &cpus )
+        {prf.setPlace( thread, cpus );}
+    void prfUpdateQf( const QString &stream, double lagMs, double shedSecs )
+        {prf.setQf( stream, lagMs, shedSecs );}
+    void prfUpdateGraph(
+        const QString   &stream,
+        double          aveMs,
+        double          maxMs,
+        quint32         dropped )
+        {gfx.setFetch( stream, aveMs, maxMs, dropped );}
 
     void dskUpdateGT( int g, int t )
         {dsk.setGT( g, t );}
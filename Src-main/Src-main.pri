@@ -8,6 +8,7 @@ HEADERS += \
     $$PWD/MainApp.h \
     $$PWD/MetricsWindow.h \
     $$PWD/MXLEDWidget.h \
+    $$PWD/ThreadPlace.h \
     $$PWD/Util.h \
     $$PWD/Version.h
 
@@ -21,6 +22,7 @@ SOURCES += \
     $$PWD/MainApp.cpp \
     $$PWD/MetricsWindow.cpp \
     $$PWD/MXLEDWidget.cpp \
+    $$PWD/ThreadPlace.cpp \
     $$PWD/Util.cpp \
     $$PWD/Util_osdep.cpp
 
@@ -0,0 +1,265 @@
+
+#include "ThreadPlace.h"
+#include "Util.h"
+#include "MainApp.h"
+#include "MetricsWindow.h"  // IWYU pragma: keep
+
+#include <QMutex>
+
+
+#define AUTO_MINCORES   8
+
+
+/* ---------------------------------------------------------------- */
+/* Statics -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+static QMutex   placeMtx;
+static quint64  roleMask[ThreadPlace::tpNRoles];
+static quint64  restMask    = 0;
+static int      planGen     = 0;    // bumped by plan/clear
+static bool     placeOn     = false;
+
+
+// Cores the process may use now (Run may have narrowed
+// that to P+E cores); every role mask is a subset.
+//
+static quint64 allCoresMask()
+{
+    quint64 mask = processAffinityMask();
+
+    if( !mask ) {
+        for( int i = 0, n = getNAssignedThreads(); i < n; ++i )
+            mask |= (1ULL << i);
+    }
+
+    return mask;
+}
+
+
+static int nCores( quint64 mask )
+{
+    int n = 0;
+
+    for( ; mask; mask &= mask - 1 )
+        ++n;
+
+    return n;
+}
+
+
+// Return the k highest set bits of mask.
+//
+static quint64 topCores( quint64 mask, int k )
+{
+    quint64 top = 0;
+
+    for( int c = 63; c >= 0 && k > 0; --c ) {
+
+        if( mask & (1ULL << c) ) {
+            top |= (1ULL << c);
+            --k;
+        }
+    }
+
+    return top;
+}
+
+
+// Return idx-th set bit (mod count) as a mask.
+//
+static quint64 oneCore( quint64 mask, int idx )
+{
+    int n = nCores( mask );
+
+    if( !n )
+        return 0;
+
+    idx %= n;
+
+    for( int c = 0; c < 64; ++c ) {
+
+        if( (mask & (1ULL << c)) && !idx-- )
+            return 1ULL << c;
+    }
+
+    return 0;
+}
+
+
+static void report( const QString &name, const QString &cpus )
+{
+    QMetaObject::invokeMethod(
+        mainApp()->metrics(),
+        "prfUpdatePlace",
+        Qt::QueuedConnection,
+        Q_ARG(QString, name),
+        Q_ARG(QString, cpus) );
+}
+
+/* ---------------------------------------------------------------- */
+/* ThreadPlace ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Call from GUI thread at run start.
+//
+void ThreadPlace::plan( const QString &policy, const QString &dataDir )
+{
+    QMutexLocker    ml( &placeMtx );
+
+    placeOn = false;
+    ++planGen;
+
+    QString pol = policy.trimmed().toLower();
+
+    if( pol.isEmpty() || pol == "off" )
+        return;
+
+    quint64 all = allCoresMask(),
+            acq = 0;
+
+    if( pol == "auto" ) {
+
+        acq = isolatedCoreMask() & all;
+
+        if( !acq ) {
+
+            // A quarter of our cores, taken from the top of
+            // the P-cores on hybrids (E-cores enumerate last).
+
+            int n = nCores( all );
+
+            if( n >= AUTO_MINCORES ) {
+
+                quint64 pool = coreAffinityMask( 1 ) & all;
+
+                if( !pool )
+                    pool = all;
+
+                acq = topCores( pool, qMin( n/4, nCores( pool )/2 ) );
+            }
+        }
+    }
+    else if( !(acq = cpuListMask( pol ) & all) ) {
+        Warning() <<
+            QString("Thread placement: bad cpulist '%1'; placement off.")
+            .arg( policy );
+        return;
+    }
+
+    restMask = all & ~acq;
+
+    if( !restMask ) {
+        Warning() << "Thread placement: no cores left for GUI; placement off.";
+        return;
+    }
+
+// Writers on storage node
+
+    quint64 wrt     = restMask;
+    int     node    = -1;
+
+    if( numaNodeCount() > 1 && (node = numaNodeOfPath( dataDir )) >= 0 ) {
+
+        quint64 m = numaNodeCoreMask( node ) & restMask;
+
+        if( m )
+            wrt = m;
+    }
+
+// Graphs off writer node if enough left
+
+    quint64 gfx = restMask & ~wrt;
+
+    if( nCores( gfx ) < 2 )
+        gfx = restMask;
+
+    roleMask[tpAcq]     = (acq ? acq : restMask);
+    roleMask[tpWriter]  = wrt;
+    roleMask[tpTrig]    = restMask;
+    roleMask[tpFilter]  = restMask;
+    roleMask[tpGraph]   = gfx;
+    roleMask[tpAux]     = restMask;
+    placeOn             = true;
+
+    Log() <<
+        QString("Thread placement: acq {%1} writer {%2}%3 graph {%4} gui {%5}")
+        .arg( acq ? cpuMaskList( acq ) : "float" )
+        .arg( cpuMaskList( wrt ) )
+        .arg( node >= 0 ? QString(" (node %1)").arg( node ) : QString() )
+        .arg( cpuMaskList( gfx ) )
+        .arg( cpuMaskList( restMask ) );
+
+    if( setCurrentThreadAffinityMask( restMask ) )
+        report( "gui", cpuMaskList( restMask ) );
+    else
+        report( "gui", "unpinned" );
+}
+
+
+// Call from the thread to place, at top of its run().
+//
+void ThreadPlace::pin( Role role, const QString &name, int idx )
+{
+    quint64 mask;
+
+    placeMtx.lock();
+        if( !placeOn ) {
+            placeMtx.unlock();
+            return;
+        }
+        mask = roleMask[role];
+    placeMtx.unlock();
+
+    if( role == tpAcq && mask != restMask )
+        mask = oneCore( mask, idx );
+
+    if( mask && setCurrentThreadAffinityMask( mask ) )
+        report( name, cpuMaskList( mask ) );
+    else {
+        Warning() <<
+            QString("Thread placement: could not pin %1.").arg( name );
+        report( name, "unpinned" );
+    }
+}
+
+
+// Call from a long-lived or pooled thread at the top of each
+// task. Applies the role mask (all cores once placement is
+// off) only if the plan changed since this thread last did;
+// not reported. Not for tpAcq.
+//
+void ThreadPlace::follow( Role role )
+{
+    static thread_local int seen = 0;
+
+    quint64 mask;
+
+    placeMtx.lock();
+        if( seen == planGen ) {
+            placeMtx.unlock();
+            return;
+        }
+        seen = planGen;
+        mask = (placeOn ? roleMask[role] : allCoresMask());
+    placeMtx.unlock();
+
+    if( mask )
+        setCurrentThreadAffinityMask( mask );
+}
+
+
+// Call from GUI thread at run end.
+//
+void ThreadPlace::clear()
+{
+    QMutexLocker    ml( &placeMtx );
+
+    if( placeOn ) {
+        setCurrentThreadAffinityMask( allCoresMask() );
+        placeOn = false;
+        ++planGen;
+    }
+}
+
+
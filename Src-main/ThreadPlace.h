@@ -0,0 +1,62 @@
+#ifndef THREADPLACE_H
+#define THREADPLACE_H
+
+#include <QString>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Run-time CPU placement of SpikeGLX worker threads.
+//
+// Setting MainApp/cpuPlace selects the policy:
+// - off:     (default) threads float.
+// - auto:    acq set is the kernel-isolated cores (isolcpus), else
+//            the top quarter of cores on systems having at least 8.
+// - cpulist: acq set given explicitly, e.g., "4-7".
+//
+// Roles:
+// - acq:     hard real-time fetch (imec workers); each pinned to
+//            one core of the acq set, round robin.
+// - writer:  file writers; cores of the NUMA node holding the first
+//            data directory, so buffers they first touch are local.
+// - trig:    trigger workers; all but the acq set.
+// - filter:  filtered stream (imQf) workers; as trig.
+// - graph:   graph fetchers; all but the acq set and, if enough
+//            remain, the writer node.
+// - aux:     other helpers busy during a run (audio feed, spike
+//            detect, remote fetch, file read-ahead); all but the
+//            acq set.
+// The GUI thread runs on all but the acq set.
+//
+// Each thread places itself by calling pin() at the top of its
+// run loop; placement is reported in the Metrics window. New
+// threads inherit the creator's mask only on Linux; on Windows
+// they get the process mask, acq cores included, so a thread
+// must place itself to stay off them. Long-lived or pooled
+// threads that span runs call follow() per task instead.
+// Short fan-out helpers (Biquad, median splits) are not placed.
+//
+class ThreadPlace
+{
+public:
+    enum Role {
+        tpAcq       = 0,
+        tpWriter    = 1,
+        tpTrig      = 2,
+        tpFilter    = 3,
+        tpGraph     = 4,
+        tpAux       = 5,
+        tpNRoles
+    };
+
+public:
+    static void plan( const QString &policy, const QString &dataDir );
+    static void pin( Role role, const QString &name, int idx = 0 );
+    static void follow( Role role );
+    static void clear();
+};
+
+#endif  // THREADPLACE_H
+
+
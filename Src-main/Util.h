@@ -358,9 +358,15 @@ int getNAssignedThreads();
 // Which processor is running calling thread
 int getCurProcessorIdx();
 
+// CPU seconds (user + kernel) used so far by calling thread
+double getThreadCPUSecs();
+
 // Mask-bits: logical threads with highest nTop power levels
 quint64 coreAffinityMask( int nTop );
 
+// Mask-bits: logical threads process may run on, zero if error
+quint64 processAffinityMask();
+
 // Mask-bits set which logical threads to run on
 void setProcessAffinityMask( quint64 mask );
 
@@ -368,6 +374,22 @@ void setProcessAffinityMask( quint64 mask );
 // Return previous mask, or zero if error.
 quint64 setCurrentThreadAffinityMask( quint64 mask );
 
+// Kernel cpulist format ("0-3,8") to/from mask-bits
+quint64 cpuListMask( const QString &list );
+QString cpuMaskList( quint64 mask );
+
+// Mask-bits: logical threads isolated from general scheduling
+quint64 isolatedCoreMask();
+
+// Online NUMA nodes, at least one
+int numaNodeCount();
+
+// Mask-bits: logical threads on NUMA node, zero if unknown
+quint64 numaNodeCoreMask( int node );
+
+// NUMA node of storage controller holding path, -1 if unknown
+int numaNodeOfPath( const QString &path );
+
 // Installed RAM as seen by 64-bit application
 double getRAMBytes64BitApp();
 
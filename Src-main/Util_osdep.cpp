@@ -10,6 +10,7 @@
 #include "Util.h"
 #include "MainApp.h"
 
+#include <QFileInfo>
 #include <QProcess>
 #include <QThreadPool>
 
@@ -38,6 +39,8 @@
     #include <sys/stat.h>
     #include <sys/statvfs.h>
     #include <sys/sysinfo.h>
+    #include <sys/sysmacros.h>
+    #include <pthread.h>
     #include <errno.h>
     #include <sched.h>
     #include <time.h>
@@ -46,6 +49,7 @@
 #elif defined(Q_OS_DARWIN)
     #include <CoreServices/CoreServices.h>
     #include <GL/gl.h>
+    #include <time.h>
 #endif
 
 /* ---------------------------------------------------------------- */
@@ -774,6 +778,40 @@ int getCurProcessorIdx()
 
 #endif
 
+/* ---------------------------------------------------------------- */
+/* getThreadCPUSecs ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_WIN
+
+double getThreadCPUSecs()
+{
+    FILETIME    create, exit, kern, user;
+
+    if( !GetThreadTimes( GetCurrentThread(), &create, &exit, &kern, &user ) )
+        return 0;
+
+    quint64 t100ns =
+        (quint64(kern.dwHighDateTime) << 32 | kern.dwLowDateTime) +
+        (quint64(user.dwHighDateTime) << 32 | user.dwLowDateTime);
+
+    return 1e-7 * t100ns;
+}
+
+#else
+
+double getThreadCPUSecs()
+{
+    struct timespec ts;
+
+    if( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) )
+        return 0;
+
+    return double(ts.tv_sec) + double(ts.tv_nsec) / 1e9;
+}
+
+#endif
+
 /* ---------------------------------------------------------------- */
 /* coreAffinityMask ----------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -897,6 +935,52 @@ quint64 coreAffinityMask( int nTop )
 
 #endif
 
+/* ---------------------------------------------------------------- */
+/* processAffinityMask -------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_WIN
+
+quint64 processAffinityMask()
+{
+    DWORD_PTR   proc, sys;
+
+    if( !GetProcessAffinityMask( GetCurrentProcess(), &proc, &sys ) )
+        return 0;
+
+    return static_cast<quint64>(proc);
+}
+
+#elif defined(Q_OS_LINUX)
+
+quint64 processAffinityMask()
+{
+    cpu_set_t   cpuset;
+    quint64     mask = 0;
+
+    CPU_ZERO( &cpuset );
+
+    if( sched_getaffinity( 0, sizeof(cpuset), &cpuset ) )
+        return 0;
+
+    for( int i = 0; i < 64; ++i ) {
+
+        if( CPU_ISSET( i, &cpuset ) )
+            mask |= (1ULL << i);
+    }
+
+    return mask;
+}
+
+#else /* !Q_OS_WIN && !Q_OS_LINUX */
+
+quint64 processAffinityMask()
+{
+    return 0;
+}
+
+#endif
+
 /* ---------------------------------------------------------------- */
 /* setProcessAffinityMask ----------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -991,7 +1075,40 @@ quint64 setCurrentThreadAffinityMask( quint64 mask )
         SetThreadAffinityMask( GetCurrentThread(), DWORD_PTR(mask) ));
 }
 
-#else /* !Q_OS_WIN */
+#elif defined(Q_OS_LINUX)
+
+quint64 setCurrentThreadAffinityMask( quint64 mask )
+{
+    cpu_set_t   cpuset;
+    quint64     prev        = 0;
+    int         nMaskBits   = sizeof(mask) * 8;
+
+    CPU_ZERO( &cpuset );
+
+    if( !pthread_getaffinity_np( pthread_self(), sizeof(cpuset), &cpuset ) ) {
+
+        for( int i = 0; i < nMaskBits; ++i ) {
+
+            if( CPU_ISSET( i, &cpuset ) )
+                prev |= (1ULL << i);
+        }
+    }
+
+    CPU_ZERO( &cpuset );
+
+    for( int i = 0; i < nMaskBits; ++i ) {
+
+        if( mask & (1ULL << i) )
+            CPU_SET( i, &cpuset );
+    }
+
+    if( pthread_setaffinity_np( pthread_self(), sizeof(cpuset), &cpuset ) )
+        return 0;
+
+    return (prev ? prev : mask);
+}
+
+#else /* !Q_OS_WIN && !Q_OS_LINUX */
 
 quint64 setCurrentThreadAffinityMask( quint64 )
 {
@@ -1001,6 +1118,190 @@ quint64 setCurrentThreadAffinityMask( quint64 )
 
 #endif
 
+/* ---------------------------------------------------------------- */
+/* cpuListMask ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Parse kernel cpulist format, e.g., "0-3,8,10-11".
+// CPUs beyond 63 are ignored.
+//
+quint64 cpuListMask( const QString &list )
+{
+    quint64 mask = 0;
+
+    foreach( const QString &item, list.trimmed().split( ",", Qt::SkipEmptyParts ) ) {
+
+        QStringList ends = item.split( "-" );
+        bool        ok1, ok2 = true;
+        int         c1, c2;
+
+        c1 = ends[0].trimmed().toInt( &ok1 );
+        c2 = (ends.size() > 1 ? ends[1].trimmed().toInt( &ok2 ) : c1);
+
+        if( !ok1 || !ok2 || ends.size() > 2 )
+            return 0;
+
+        for( int c = qMax( 0, c1 ), cmax = qMin( c2, 63 ); c <= cmax; ++c )
+            mask |= (1ULL << c);
+    }
+
+    return mask;
+}
+
+
+// Inverse of cpuListMask.
+//
+QString cpuMaskList( quint64 mask )
+{
+    QString s;
+
+    for( int c = 0; c < 64; ) {
+
+        if( !(mask & (1ULL << c)) ) {
+            ++c;
+            continue;
+        }
+
+        int c2 = c;
+
+        while( c2 < 63 && (mask & (1ULL << (c2 + 1))) )
+            ++c2;
+
+        if( !s.isEmpty() )
+            s += ",";
+
+        if( c2 > c )
+            s += QString("%1-%2").arg( c ).arg( c2 );
+        else
+            s += QString::number( c );
+
+        c = c2 + 1;
+    }
+
+    return s;
+}
+
+/* ---------------------------------------------------------------- */
+/* isolatedCoreMask ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_LINUX
+
+static QString readSysLine( const QString &path )
+{
+    QFile   f( path );
+
+    if( !f.open( QIODevice::ReadOnly | QIODevice::Text ) )
+        return QString();
+
+    return QString( f.readLine() ).trimmed();
+}
+
+
+quint64 isolatedCoreMask()
+{
+    return cpuListMask( readSysLine( "/sys/devices/system/cpu/isolated" ) );
+}
+
+#else
+
+quint64 isolatedCoreMask()
+{
+    return 0;
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* numaNodeCoreMask ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_LINUX
+
+int numaNodeCount()
+{
+    quint64 nodes   = cpuListMask(
+                        readSysLine( "/sys/devices/system/node/online" ) );
+    int     n       = 0;
+
+    for( ; nodes; nodes &= nodes - 1 )
+        ++n;
+
+    return qMax( 1, n );
+}
+
+
+quint64 numaNodeCoreMask( int node )
+{
+    return cpuListMask(
+            readSysLine(
+            QString("/sys/devices/system/node/node%1/cpulist").arg( node ) ) );
+}
+
+#else
+
+int numaNodeCount()
+{
+    return 1;
+}
+
+
+quint64 numaNodeCoreMask( int )
+{
+    return 0;
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* numaNodeOfPath ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_LINUX
+
+// Map path's filesystem to its block device in sysfs, then walk
+// up the device tree to the first ancestor (usually the PCI
+// storage controller) that reports a NUMA node.
+//
+int numaNodeOfPath( const QString &path )
+{
+    struct stat st;
+
+    if( stat( QFile::encodeName( path ).constData(), &st ) )
+        return -1;
+
+    QString dir = QFileInfo(
+                    QString("/sys/dev/block/%1:%2")
+                    .arg( major( st.st_dev ) )
+                    .arg( minor( st.st_dev ) ) ).canonicalFilePath();
+
+    while( dir.startsWith( "/sys/devices/" ) ) {
+
+        QString s = readSysLine( dir + "/numa_node" );
+
+        if( !s.isEmpty() ) {
+
+            bool    ok;
+            int     node = s.toInt( &ok );
+
+            return (ok ? node : -1);
+        }
+
+        dir = QFileInfo( dir ).path();
+    }
+
+    return -1;
+}
+
+#else
+
+int numaNodeOfPath( const QString & )
+{
+    return -1;
+}
+
+#endif
+
 /* ---------------------------------------------------------------- */
 /* getRAMBytes64BitApp -------------------------------------------- */
 /* ---------------------------------------------------------------- */
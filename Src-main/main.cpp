@@ -7,6 +7,8 @@
 #include <QProcess>
 #include <QSurfaceFormat>
 
+#include <string.h>
+
 
 
 
@@ -23,6 +25,15 @@ int main( int argc, char *argv[] )
     qputenv( "QT_QPA_PLATFORM", "xcb" );
 #endif
 
+    // Benchmark runs headless (see BenchRun.h).
+
+    for( int i = 1; i < argc; ++i ) {
+        if( !strncmp( argv[i], "-bench", 6 ) ) {
+            qputenv( "QT_QPA_PLATFORM", "offscreen" );
+            break;
+        }
+    }
+
     // These lines remind me what's available to force use of opengl
     // or other rendering options in similar manner. However, these
     // have no current role.
@@ -1440,6 +1440,12 @@ void ConfigCtl::paramsFromDialog(
     gateTab->fromGUI( q );
     trigTab->fromGUI( q );
     snsTab->fromGUI( q );
+
+// ----
+// Perf
+// ----
+
+    q.perf = acceptedParams.perf;
 }
 
 
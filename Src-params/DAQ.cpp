@@ -533,6 +533,30 @@ void Params::loadSettings( bool remote )
     sns.sepShanks =
     settings.value( "snsSepShanks", false ).toBool();
 
+// ----------
+// PerfParams
+// ----------
+
+    perf.simSpeed = 1.0;
+
+    perf.aiqLockFree =
+    settings.value( "perfAIQLockFree", false ).toBool();
+
+    perf.aiqShmExport =
+    settings.value( "perfAIQShmExport", false ).toBool();
+
+    perf.wrDirectIO =
+    settings.value( "perfWrDirectIO", false ).toBool();
+
+    perf.wrTreeCRC =
+    settings.value( "perfWrTreeCRC", false ).toBool();
+
+    perf.wrPyramid =
+    settings.value( "perfWrPyramid", false ).toBool();
+
+    perf.wrSyncEdges =
+    settings.value( "perfWrSyncEdges", false ).toBool();
+
     settings.endGroup();
 
 // ----
@@ -640,6 +664,17 @@ void Params::saveSettings( bool remote ) const
     settings.setValue( "snsFldPerProbe", sns.fldPerPrb );
     settings.setValue( "snsSepShanks", sns.sepShanks );
 
+// ----------
+// PerfParams
+// ----------
+
+    settings.setValue( "perfAIQLockFree", perf.aiqLockFree );
+    settings.setValue( "perfAIQShmExport", perf.aiqShmExport );
+    settings.setValue( "perfWrDirectIO", perf.wrDirectIO );
+    settings.setValue( "perfWrTreeCRC", perf.wrTreeCRC );
+    settings.setValue( "perfWrPyramid", perf.wrPyramid );
+    settings.setValue( "perfWrSyncEdges", perf.wrSyncEdges );
+
     settings.endGroup();
 
 // ----
@@ -124,6 +124,16 @@ struct SeeNSave {
                     sepShanks;
 };
 
+struct PerfParams {
+    double          simSpeed;       // sim probe rate x (bench; not saved)
+    bool            aiqLockFree,
+                    aiqShmExport,
+                    wrDirectIO,     // Linux O_DIRECT bin files
+                    wrTreeCRC,      // tree CRC32C in metadata
+                    wrPyramid,      // viewer pyramid sidecar
+                    wrSyncEdges;    // sync edge sidecar (CalSRate)
+};
+
 struct Params {
     CimCfg          im;
     CniCfg          ni;
@@ -134,6 +144,7 @@ struct Params {
     TrgSpikeParams  trgSpike;
     ModeParams      mode;
     SeeNSave        sns;
+    PerfParams      perf;
 
     static inline bool stream_isNI( const QString &stream )
         {return stream.startsWith( "n" );}
@@ -393,6 +393,43 @@ void Subset::subset(
         dst.resize( ntpts * nk );
 }
 
+/* ---------------------------------------------------------------- */
+/* appendSubset --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Given ntpts timepoints of (nchans) src channels in place,
+// append to dst only listed indices (iKeep[]).
+//
+// Caller must set iKeep[] appropriately.
+//
+void Subset::appendSubset(
+    vec_i16             &dst,
+    const qint16        *src,
+    int                 ntpts,
+    const QVector<uint> &iKeep,
+    int                 nchans )
+{
+    int nk = iKeep.size();
+
+    if( nk >= nchans ) {
+        dst.insert( dst.end(), src, src + ntpts * nchans );
+        return;
+    }
+
+    int size0 = int(dst.size());
+
+    dst.resize( size0 + ntpts * nk );
+
+    const uint  *K = &iKeep[0];
+    qint16      *D = &dst[size0];
+
+    for( int it = 0; it < ntpts; ++it, src += nchans ) {
+
+        for( int ik = 0; ik < nk; ++ik )
+            *D++ = src[K[ik]];
+    }
+}
+
 /* ---------------------------------------------------------------- */
 /* subsetBlock ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -41,6 +41,13 @@ public:
         const QVector<uint> &iKeep,
         int                 nchans );
 
+    static void appendSubset(
+        vec_i16             &dst,
+        const qint16        *src,
+        int                 ntpts,
+        const QVector<uint> &iKeep,
+        int                 nchans );
+
     static void subsetBlock(
         vec_i16             &dst,
         vec_i16             &src,
@@ -0,0 +1,169 @@
+#ifndef CMDBINPROTO_H
+#define CMDBINPROTO_H
+
+// Framed binary protocol for the command server.
+// Self-contained (no Qt) so client programs can
+// include it as is.
+//
+// Negotiation (per connection, opt-in):
+// Client sends text line "BINARYMODE". Server answers
+// "BINARYMODE <version>\n" and from then on reads frames.
+// A BYE frame returns the connection to the text protocol,
+// and the server closes the BINARYMODE command with "OK\n".
+//
+// Frame: CmdBinHdr followed by len payload bytes. Every
+// request frame gets exactly one reply frame with the same
+// op and seq. Reply status is CMDBIN_OK, or an error code
+// with a UTF-8 (unterminated) message as payload.
+//
+// All fields little-endian, naturally aligned. Payload
+// structs are multiples of 8 bytes; variable parts are
+// padded so the next struct starts 8-byte aligned.
+//
+// Ops and payloads:
+//
+// NOOP:        req: -
+//              rep: -
+//
+// FETCH:       req: CmdBinFetchReq, chan ids, {CmdBinRecipe}
+//              rep: CmdBinFetchRep, int16 data[nChans*nTpts]
+//
+// FETCHMULTI:  req: CmdBinMultiHdr, nReq x {CmdBinFetchReq, chan ids,
+//                  {CmdBinRecipe}}
+//              rep: CmdBinMultiHdr, nReq x {CmdBinFetchRep, data}
+//              Each stream has its own status; a bad stream
+//              doesn't fail the others.
+//
+// FETCHALIGNED:
+//              req: CmdBinAlignReq, nReq x {CmdBinFetchReq, chan ids}
+//              rep: CmdBinMultiHdr, nReq x {CmdBinFetchRep, data}
+//              Window [refCt, refCt + secs) of stream iRef is
+//              mapped to each stream by sync edges, and whole
+//              windows are returned for all streams, or an error.
+//              Request fromCt, nMax are ignored; recipes are
+//              not supported.
+//
+// MAPSAMPLE:   req: CmdBinMapReq
+//              rep: CmdBinMapRep
+//
+// BYE:         req: -
+//              rep: -
+//
+// Channel ids: CmdBinFetchReq.nChan selects:
+// -1 = all, -2 = saved, else nChan uint16 acquisition
+// indices (padded to a multiple of 4 ids). The server
+// rejects nChan < -2, nChan > CMDBIN_MAXIDS, or more ids
+// than the stream has channels.
+//
+// Recipe: if CmdBinFetchReq.recipe is nonzero, a CmdBinRecipe
+// follows the chan ids, and the server filters the stream's
+// neural channels before subsetting and downsampling. Fields
+// mirror the text FETCH recipe (hp, lp, car, in, out, dec).
+//
+
+#include <stdint.h>
+
+#define CMDBIN_MAGIC    0x424C4753  // "SGLB"
+#define CMDBIN_VERSION  1
+#define CMDBIN_MAXREQ   (1024*1024) // request payload limit
+#define CMDBIN_MAXIDS   (CMDBIN_MAXREQ / 2) // chan ids per request
+
+enum CmdBinOp {
+    CMDBIN_NOOP         = 0,
+    CMDBIN_FETCH        = 1,
+    CMDBIN_FETCHMULTI   = 2,
+    CMDBIN_MAPSAMPLE    = 3,
+    CMDBIN_BYE          = 4,
+    CMDBIN_FETCHALIGNED = 5
+};
+
+enum CmdBinStatus {
+    CMDBIN_OK           = 0,
+    CMDBIN_ERROR        = 1,    // bad request or not running
+    CMDBIN_TOOLATE      = 2,    // data no longer in stream queue
+    CMDBIN_BADOP        = 3
+};
+
+struct CmdBinHdr {
+    uint32_t    magic;
+    uint16_t    op,
+                status;     // request: 0
+    uint32_t    seq,        // client's; echoed in reply
+                len;        // payload bytes
+};
+
+struct CmdBinFetchReq {
+    int32_t     js,
+                ip;
+    uint64_t    fromCt;
+    int32_t     nMax,       // max timepoints
+                dnsmp,      // downsample factor
+                nChan,      // see above
+                recipe;     // 1=CmdBinRecipe follows ids
+};
+
+struct CmdBinRecipe {
+    float       hp,         // Hz, 0=off
+                lp;
+    int32_t     car,        // {0=none,1=local,2=gblave,3=gblmed,4=gbldmx}
+                carIn,      // local radii (sites), -1=default
+                carOut,
+                dec;        // {0=ave,1=binmax,2=aa}
+};
+
+struct CmdBinFetchRep {
+    uint64_t    fromCt;     // first timepoint
+    int32_t     nChans,
+                nTpts,
+                status,     // FETCHMULTI
+                bySync;     // FETCHALIGNED: 0=mapped by wall time
+};
+
+struct CmdBinMultiHdr {
+    int32_t     nReq,
+                pad;
+};
+
+struct CmdBinAlignReq {
+    int32_t     iRef,       // reference stream index
+                nReq;
+    uint64_t    refCt;      // window start in reference stream
+    double      secs;       // window length
+};
+
+struct CmdBinMapReq {
+    int32_t     dstjs,
+                dstip,
+                srcjs,
+                srcip;
+    uint64_t    srcCt;
+};
+
+struct CmdBinMapRep {
+    uint64_t    dstCt;
+};
+
+// Bytes of chan id list, padded.
+// 64-bit so no client nChan can wrap it.
+static inline uint64_t cmdBinChanBytes( int32_t nChan )
+{
+    return (nChan > 0 ?
+            ((uint64_t(nChan) + 3) & ~uint64_t(3)) * sizeof(uint16_t) : 0);
+}
+
+// Bytes of one fetch request: struct, ids, recipe.
+static inline uint64_t cmdBinReqBytes( const CmdBinFetchReq *F )
+{
+    return sizeof(CmdBinFetchReq) + cmdBinChanBytes( F->nChan )
+            + (F->recipe ? sizeof(CmdBinRecipe) : 0);
+}
+
+// Bytes of reply data, padded.
+static inline uint32_t cmdBinDataBytes( int32_t nChans, int32_t nTpts )
+{
+    return ((uint32_t(nChans) * nTpts + 3) & ~3u) * sizeof(int16_t);
+}
+
+#endif  // CMDBINPROTO_H
+
+
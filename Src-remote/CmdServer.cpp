@@ -1,5 +1,6 @@
 
 #include "CmdServer.h"
+#include "FetchProc.h"
 #include "Util.h"
 #include "MainApp.h"
 #include "Version.h"
@@ -10,8 +11,10 @@
 #include "Sync.h"
 #include "Subset.h"
 #include "Sha1Verifier.h"
+#include "SpikeDet.h"
 #include "Par2Window.h"
 #include "Stim.h"
+#include "ThreadPlace.h"
 
 #include <QDir>
 #include <QDirIterator>
@@ -148,6 +151,8 @@ void CmdWorker::run()
 
         if( line.length() ) {
 
+            ThreadPlace::follow( ThreadPlace::tpAux );
+
             if( processLine( line ) ) {
                 sendOK();
                 errCt = 0;
@@ -300,6 +305,40 @@ ConfigCtl* CmdWorker::okStreamToks( const QString &cmd, int &js, int &ip, const
 }
 
 
+// Parse optional channel subset pattern at toks[itok]:
+// {absent or "-1#"=all, "-2#"=saved, else "id1#id2#..."}.
+//
+bool CmdWorker::okChanBits(
+    QBitArray           &chanBits,
+    const DAQ::Params   &p,
+    int                 js,
+    int                 ip,
+    int                 nChans,
+    const QStringList   &toks,
+    int                 itok )
+{
+    if( toks.size() <= itok || toks.at( itok ) == "-1#" )
+        chanBits.fill( true, nChans );
+    else if( toks.at( itok ) == "-2#" )
+        savedChanBits( chanBits, p, js, ip );
+    else {
+
+        chanBits.fill( true, nChans );
+
+        QString err =
+            Subset::cmdStr2Bits(
+                chanBits, chanBits, toks.at( itok ), nChans );
+
+        if( !err.isEmpty() ) {
+            errMsg = err;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 Run* CmdWorker::okRunStarted( const QString &cmd )
 {
     Run *run = mainApp()->getRun();
@@ -313,6 +352,319 @@ Run* CmdWorker::okRunStarted( const QString &cmd )
 }
 
 
+void CmdWorker::savedChanBits(
+    QBitArray           &chanBits,
+    const DAQ::Params   &p,
+    int                 js,
+    int                 ip )
+{
+    switch( js ) {
+        case jsNI:  chanBits = p.ni.sns.saveBits; break;
+        case jsOB:  chanBits = p.im.get_iStrOneBox( ip ).sns.saveBits; break;
+        case jsIM:
+        case -jsIM: chanBits = p.im.prbj[ip].sns.saveBits; break;
+    }
+}
+
+
+// Gather up to nMax whole timepoints from fromCt, keeping
+// listed channels (iKeep), downsampled by dnsmp, into data.
+// If no data yet, wait briefly for some.
+//
+// Return 1 if OK (data may be empty), 0 if too late,
+// -1 if low memory; errMsg set on failure.
+//
+int CmdWorker::fetchGather(
+    vec_i16                 &data,
+    const AIQ               *aiQ,
+    const QVector<uint>     &iKeep,
+    quint64                 fromCt,
+    int                     nMax,
+    int                     dnsmp,
+    const QString           &cmd )
+{
+    AIQ::View   V;
+
+    data.clear();
+
+    for( int itry = 0; itry < 3; ++itry ) {
+
+        if( aiQ->getViewFromCt( V, fromCt, nMax ) < 0 ) {
+            errMsg = QString("%1: Too late.").arg( cmd );
+            return 0;
+        }
+
+        if( V.nTpts() )
+            break;
+
+        quint64  endCt = aiQ->endCount();
+
+        // Try to give client at least a small amount of data.
+        // 24 = 2 imec packets of samples.
+        // Bound sleeps to < 2 millisec to keep latency lower.
+
+        if( fromCt + 24 > endCt ) {
+
+            int gap_us = 1e6*(fromCt + 24 - endCt)/aiQ->sRate();
+
+            QThread::usleep( qBound( 250, gap_us, 2000 ) );
+        }
+    }
+
+    if( !V.nTpts() )
+        return 1;
+
+// ----------------------------------------------
+// Requested subset, gathered straight from queue
+// ----------------------------------------------
+
+    try {
+        data.reserve( V.nTpts() * iKeep.size() );
+    }
+    catch( const std::exception& ) {
+        errMsg = QString("%1: Low mem.").arg( cmd );
+        return -1;
+    }
+
+    for( int k = 0; k < 2; ++k ) {
+
+        if( V.ntpts[k] ) {
+            Subset::appendSubset(
+                data, V.src[k], V.ntpts[k], iKeep, V.nchans );
+        }
+    }
+
+    if( !V.intact() ) {
+        data.clear();
+        errMsg = QString("%1: Too late.").arg( cmd );
+        return 0;
+    }
+
+// ----------
+// Downsample
+// ----------
+
+    if( dnsmp > 1 )
+        Subset::downsample( data, data, iKeep.size(), dnsmp );
+
+    return 1;
+}
+
+
+// As fetchGather, but run recipe (R) on the server first.
+// Whole timepoints are fetched from a lead-in ahead of fromCt
+// so filters settle; only the processed iKeep subset, after
+// downsampling, is returned in data.
+//
+int CmdWorker::fetchProcessed(
+    vec_i16                 &data,
+    const AIQ               *aiQ,
+    const QVector<uint>     &iKeep,
+    quint64                 fromCt,
+    int                     nMax,
+    int                     dnsmp,
+    const FetchRecipe       &R,
+    const DAQ::Params       &p,
+    int                     js,
+    int                     ip,
+    const QString           &cmd )
+{
+    FetchProc   P;
+    QString     err = P.init( R, p, js, ip, dnsmp );
+
+    data.clear();
+
+    if( !err.isEmpty() ) {
+        errMsg = QString("%1: %2").arg( cmd ).arg( err );
+        return -1;
+    }
+
+// -------------------------
+// Lead-in, clipped to queue
+// -------------------------
+
+    quint64 headCt  = aiQ->qHeadCt();
+    int     lead    = P.leadIn();
+
+    if( fromCt <= headCt )
+        lead = 0;
+    else if( quint64(lead) > fromCt - headCt )
+        lead = int(fromCt - headCt);
+
+// -----------------------
+// Whole timepoints, apply
+// -----------------------
+
+    QVector<uint>   iAll;
+    vec_i16         blk;
+
+    Subset::defaultVec( iAll, aiQ->nChans() );
+
+    int ret = fetchGather(
+                blk, aiQ, iAll, fromCt - lead,
+                nMax + lead, 1, cmd );
+
+    if( ret <= 0 )
+        return ret;
+
+    try {
+        P.apply( data, blk, lead, iKeep );
+    }
+    catch( const std::exception& ) {
+        data.clear();
+        errMsg = QString("%1: Low mem.").arg( cmd );
+        return -1;
+    }
+
+    return 1;
+}
+
+
+// Map srcCt in stream (srcjs, srcip) to the corresponding
+// sample count in stream (dstjs, dstip).
+//
+bool CmdWorker::mapSampleCt(
+    quint64 &dstCt,
+    int     dstjs,
+    int     dstip,
+    quint64 srcCt,
+    int     srcjs,
+    int     srcip )
+{
+    ConfigCtl   *C;
+
+    if( !okjsip( "MAPSAMPLE (dst)", dstjs, dstip ) )
+        return false;
+
+    if( !(C = okjsip( "MAPSAMPLE (src)", srcjs, srcip )) )
+        return false;
+
+    dstjs = qAbs( dstjs );
+    srcjs = qAbs( srcjs );
+
+    if( dstjs == srcjs && dstip == srcip ) {
+        dstCt = srcCt;
+        return true;
+    }
+
+    const DAQ::Params   &p      = C->acceptedParams;
+    const Run           *run    = mainApp()->getRun();
+    const AIQ           *dstQ   = run->getQ( dstjs, dstip ),
+                        *srcQ   = run->getQ( srcjs, srcip );
+
+    if( !dstQ || !srcQ ) {
+        errMsg = "MAPSAMPLE: Not running.";
+        return false;
+    }
+
+    SyncStream  dstS, srcS;
+    dstS.init( dstQ, dstjs, dstip, p );
+    srcS.init( srcQ, srcjs, srcip, p );
+    syncDstTAbs( srcCt, &srcS, &dstS, p );
+
+    dstCt = dstS.TAbs2Ct( dstS.tAbs );
+
+    return true;
+}
+
+
+// Map window start refCt of stream vS[iRef] to each stream
+// in vS via syncDstTAbsMult(), wait until the whole window
+// of secs is in every queue, then gather listed channels
+// (vKeep[is]) of each into data[is], with start fromCt[is].
+// All windows are returned, or none.
+//
+// Return 1 if OK, 0 if too late, -1 on other error;
+// errMsg set on failure.
+//
+int CmdWorker::alignedGather(
+    std::vector<vec_i16>                &data,
+    std::vector<quint64>                &fromCt,
+    const std::vector<SyncStream>       &vS,
+    const std::vector<QVector<uint> >   &vKeep,
+    int                                 iRef,
+    quint64                             refCt,
+    double                              secs,
+    const DAQ::Params                   &p,
+    const QString                       &cmd )
+{
+    int nS = vS.size();
+
+    if( !(secs > 0 && secs <= 10) ) {
+        errMsg = QString("%1: Window must be in range (0..10] secs.").arg( cmd );
+        return -1;
+    }
+
+// ---
+// Map
+// ---
+
+    std::vector<int>    nTpts( nS );
+
+    fromCt.resize( nS );
+
+    syncDstTAbsMult( refCt, iRef, vS, p );
+
+    for( int is = 0; is < nS; ++is ) {
+
+        const SyncStream    &S = vS[is];
+
+        if( is == iRef )
+            fromCt[is] = refCt;
+        else if( S.tAbs < S.Q->tZero() ) {
+            errMsg = QString("%1: Window precedes start of stream %2.")
+                        .arg( cmd ).arg( is );
+            return 0;
+        }
+        else
+            fromCt[is] = S.TAbs2Ct( S.tAbs );
+
+        nTpts[is] = qMax( 1, int(secs * S.Q->sRate() + 0.5) );
+    }
+
+// ------------------
+// Wait whole windows
+// ------------------
+
+    double  tEnd = getTime() + secs + 1.0;
+
+    for( int is = 0; is < nS; ++is ) {
+
+        quint64 lastCt = fromCt[is] + nTpts[is] - 1;
+
+        while( !vS[is].Q->waitForData( lastCt, 50 ) ) {
+
+            if( allStop() || getTime() > tEnd ) {
+                errMsg = QString("%1: Window incomplete in stream %2.")
+                            .arg( cmd ).arg( is );
+                return -1;
+            }
+        }
+    }
+
+// ------
+// Gather
+// ------
+
+    for( int is = 0; is < nS; ++is ) {
+
+        int ret = fetchGather(
+                    data[is], vS[is].Q, vKeep[is],
+                    fromCt[is], nTpts[is], 1, cmd );
+
+        if( ret <= 0 )
+            return ret;
+
+        if( int(data[is].size()) != nTpts[is] * vKeep[is].size() ) {
+            errMsg = QString("%1: Too late.").arg( cmd );
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+
 void CmdWorker::getGeomMap( QString &resp, const QStringList &toks )
 {
     if( toks.size() < 1 ) {
@@ -834,44 +1186,16 @@ void CmdWorker::mapSample( QString &resp, const QStringList &toks )
         return;
     }
 
-    quint64 srcC    = toks.at( 2 ).toLongLong();
-    int     dstjs   = toks.at( 0 ).toInt(),
-            dstip   = toks.at( 1 ).toInt(),
-            srcjs   = toks.at( 3 ).toInt(),
-            srcip   = toks.at( 4 ).toInt();
+    quint64 dstC,
+            srcC    = toks.at( 2 ).toLongLong();
 
-    ConfigCtl   *C;
+    if( mapSampleCt(
+            dstC,
+            toks.at( 0 ).toInt(), toks.at( 1 ).toInt(), srcC,
+            toks.at( 3 ).toInt(), toks.at( 4 ).toInt() ) ) {
 
-    if( !okjsip( "MAPSAMPLE (dst)", dstjs, dstip ) )
-        return;
-
-    if( !(C = okjsip( "MAPSAMPLE (src)", srcjs, srcip )) )
-        return;
-
-    dstjs = qAbs( dstjs );
-    srcjs = qAbs( srcjs );
-
-    if( dstjs == srcjs && dstip == srcip ) {
-        resp = toks.at( 2 ).trimmed() + "\n";
-        return;
+        resp = QString("%1\n").arg( dstC );
     }
-
-    const DAQ::Params   &p      = C->acceptedParams;
-    const Run           *run    = mainApp()->getRun();
-    const AIQ           *dstQ   = run->getQ( dstjs, dstip ),
-                        *srcQ   = run->getQ( srcjs, srcip );
-
-    if( dstQ && srcQ ) {
-
-        SyncStream  dstS, srcS;
-        dstS.init( dstQ, dstjs, dstip, p );
-        srcS.init( srcQ, srcjs, srcip, p );
-        syncDstTAbs( srcC, &srcS, &dstS, p );
-
-        resp = QString("%1\n").arg( dstS.TAbs2Ct( dstS.tAbs ) );
-    }
-    else
-        errMsg = "MAPSAMPLE: Not running.";
 }
 
 
@@ -902,8 +1226,536 @@ void CmdWorker::opto_getAttens( QString &resp, const QStringList &toks )
         errMsg = resp;
         resp.clear();
     }
-    else
-        resp += "\n";
+    else
+        resp += "\n";
+}
+
+
+// Return the fetch request at req if its channel count is
+// sane and all its parts (struct, ids, recipe) lie before
+// end; else 0 with errMsg. The count is checked before any
+// size is computed from it.
+//
+const CmdBinFetchReq* CmdWorker::binFetchReq(
+    const char      *req,
+    const char      *end,
+    const QString   &cmd )
+{
+    const CmdBinFetchReq    *F = (const CmdBinFetchReq*)req;
+
+    if( end - req < qint64(sizeof(CmdBinFetchReq)) ) {
+        errMsg = QString("%1: Short request.").arg( cmd );
+        return 0;
+    }
+
+    if( F->nChan < -2 || F->nChan > CMDBIN_MAXIDS ) {
+        errMsg = QString("%1: Bad channel count %2.").arg( cmd ).arg( F->nChan );
+        return 0;
+    }
+
+    if( quint64(end - req) < cmdBinReqBytes( F ) ) {
+        errMsg = QString("%1: Short request.").arg( cmd );
+        return 0;
+    }
+
+    return F;
+}
+
+
+// Validate stream and channel list of a BINARYMODE fetch
+// request, filling iKeep. Return queue, or 0 with errMsg.
+//
+const AIQ* CmdWorker::binStream(
+    QVector<uint>           &iKeep,
+    const CmdBinFetchReq    &Q,
+    const quint16           *ids,
+    const QString           &cmd )
+{
+    ConfigCtl   *C = okjsip( cmd, Q.js, Q.ip );
+
+    if( !C )
+        return 0;
+
+    const AIQ*  aiQ = mainApp()->getRun()->getQ( Q.js, Q.ip );
+
+    if( !aiQ ) {
+        errMsg = QString("%1: Not running or stream not enabled.").arg( cmd );
+        return 0;
+    }
+
+    if( Q.js == -jsIM )
+        aiQ->qf_remoteClient( true );
+
+    int nC = aiQ->nChans();
+
+    iKeep.clear();
+
+    if( Q.nChan == -1 )
+        Subset::defaultVec( iKeep, nC );
+    else if( Q.nChan == -2 ) {
+
+        QBitArray   chanBits;
+
+        savedChanBits( chanBits, C->acceptedParams, Q.js, Q.ip );
+        Subset::bits2Vec( iKeep, chanBits );
+    }
+    else if( Q.nChan > nC ) {
+        errMsg =
+            QString("%1: Channel count %2 exceeds stream's %3.")
+            .arg( cmd ).arg( Q.nChan ).arg( nC );
+        return 0;
+    }
+    else if( Q.nChan > 0 ) {
+
+        iKeep.resize( Q.nChan );
+
+        for( int i = 0; i < Q.nChan; ++i ) {
+
+            if( ids[i] >= nC ) {
+                errMsg =
+                    QString("%1: Channel %2 not in range [0..%3].")
+                    .arg( cmd ).arg( ids[i] ).arg( nC - 1 );
+                return 0;
+            }
+
+            iKeep[i] = ids[i];
+        }
+    }
+
+    if( iKeep.isEmpty() ) {
+        errMsg = QString("%1: Empty channel list.").arg( cmd );
+        return 0;
+    }
+
+    return aiQ;
+}
+
+
+// Fetch one stream for BINARYMODE into (data, R).
+// Return (and set) R.status; errMsg set on failure.
+//
+int CmdWorker::binFetch(
+    vec_i16                 &data,
+    CmdBinFetchRep          &R,
+    const CmdBinFetchReq    &Q,
+    const quint16           *ids,
+    const QString           &cmd )
+{
+    R.fromCt    = Q.fromCt;
+    R.nChans    = 0;
+    R.nTpts     = 0;
+    R.status    = CMDBIN_ERROR;
+    R.bySync    = 0;
+
+    data.clear();
+
+    QVector<uint>   iKeep;
+    const AIQ       *aiQ = binStream( iKeep, Q, ids, cmd );
+    int             ret;
+
+    if( !aiQ )
+        return R.status;
+
+    if( Q.recipe ) {
+
+        const CmdBinRecipe  *B = (const CmdBinRecipe*)
+                                    ((const char*)ids
+                                    + cmdBinChanBytes( Q.nChan ));
+        FetchRecipe         FR;
+
+        FR.hp       = B->hp;
+        FR.lp       = B->lp;
+        FR.car      = B->car;
+        FR.carIn    = B->carIn;
+        FR.carOut   = B->carOut;
+        FR.dec      = B->dec;
+
+        ret = fetchProcessed(
+                data, aiQ, iKeep, Q.fromCt, Q.nMax, Q.dnsmp, FR,
+                mainApp()->cfgCtl()->acceptedParams, Q.js, Q.ip, cmd );
+    }
+    else {
+        ret = fetchGather(
+                data, aiQ, iKeep, Q.fromCt,
+                Q.nMax, Q.dnsmp, cmd );
+    }
+
+    switch( ret ) {
+
+        case 1:
+            R.nChans    = iKeep.size();
+            R.nTpts     = data.size() / R.nChans;
+            R.status    = CMDBIN_OK;
+            break;
+        case 0:
+            R.status    = CMDBIN_TOOLATE;
+            break;
+    }
+
+    return R.status;
+}
+
+
+// Serve FETCH or FETCHMULTI request payload (req).
+// Reply is sent here on success; else caller sends error.
+//
+int CmdWorker::binFetchFrame( const CmdBinHdr &Q, const char *req )
+{
+    QString     cmd     = "FETCH";
+    const char  *end    = req + Q.len;
+    int         nReq    = 1;
+    bool        multi   = Q.op == CMDBIN_FETCHMULTI;
+
+    if( multi ) {
+
+        cmd = "FETCHMULTI";
+
+        if( Q.len < sizeof(CmdBinMultiHdr) ) {
+            errMsg = "FETCHMULTI: Short request.";
+            return CMDBIN_ERROR;
+        }
+
+        nReq = ((const CmdBinMultiHdr*)req)->nReq;
+
+        if( nReq < 1
+            || nReq > int(Q.len / sizeof(CmdBinFetchReq)) ) {
+
+            errMsg = QString("FETCHMULTI: Bad stream count %1.").arg( nReq );
+            return CMDBIN_ERROR;
+        }
+
+        req += sizeof(CmdBinMultiHdr);
+    }
+
+    if( int(binData.size()) < nReq )
+        binData.resize( nReq );
+
+    binReps.resize( nReq );
+
+    for( int i = 0; i < nReq; ++i ) {
+
+        const CmdBinFetchReq    *F = binFetchReq( req, end, cmd );
+
+        if( !F )
+            return CMDBIN_ERROR;
+
+        CmdBinFetchRep  &R = binReps[i];
+
+        if( binFetch( binData[i], R, *F, (const quint16*)(F + 1), cmd ) ) {
+
+            // Streams fail individually in a batch
+
+            if( !multi )
+                return R.status;
+
+            Warning() << errMsg << " (stream " << i << ")";
+            errMsg.clear();
+        }
+
+        req += cmdBinReqBytes( F );
+    }
+
+    binSendFetched( Q, multi );
+
+    return CMDBIN_OK;
+}
+
+
+// Serve FETCHALIGNED request payload (req).
+// Reply is sent here on success; else caller sends error.
+//
+int CmdWorker::binFetchAligned( const CmdBinHdr &Q, const char *req )
+{
+    const char  *end = req + Q.len;
+
+    if( Q.len < sizeof(CmdBinAlignReq) ) {
+        errMsg = "FETCHALIGNED: Short request.";
+        return CMDBIN_ERROR;
+    }
+
+    const CmdBinAlignReq    *A = (const CmdBinAlignReq*)req;
+    int                     nReq = A->nReq;
+
+    if( nReq < 1
+        || nReq > int(Q.len / sizeof(CmdBinFetchReq))
+        || A->iRef < 0 || A->iRef >= nReq ) {
+
+        errMsg =
+            QString("FETCHALIGNED: Bad stream count %1 or reference %2.")
+            .arg( nReq ).arg( A->iRef );
+        return CMDBIN_ERROR;
+    }
+
+    req += sizeof(CmdBinAlignReq);
+
+// -------
+// Streams
+// -------
+
+    const DAQ::Params               &p = mainApp()->cfgCtl()->acceptedParams;
+    std::vector<SyncStream>         vS( nReq );
+    std::vector<QVector<uint> >     vKeep( nReq );
+    std::vector<int>                dnsmp( nReq );
+
+    for( int i = 0; i < nReq; ++i ) {
+
+        const CmdBinFetchReq    *F = binFetchReq( req, end, "FETCHALIGNED" );
+
+        if( !F )
+            return CMDBIN_ERROR;
+
+        if( F->recipe ) {
+            errMsg = "FETCHALIGNED: Recipe not supported.";
+            return CMDBIN_ERROR;
+        }
+
+        const AIQ   *aiQ =
+            binStream( vKeep[i], *F, (const quint16*)(F + 1), "FETCHALIGNED" );
+
+        if( !aiQ )
+            return CMDBIN_ERROR;
+
+        vS[i].init( aiQ, qAbs( F->js ), F->ip, p );
+        dnsmp[i] = F->dnsmp;
+
+        req += cmdBinReqBytes( F );
+    }
+
+// -----
+// Fetch
+// -----
+
+    std::vector<quint64>    fromCt;
+
+    if( int(binData.size()) < nReq )
+        binData.resize( nReq );
+
+    switch( alignedGather(
+                binData, fromCt, vS, vKeep,
+                A->iRef, A->refCt, A->secs, p, "FETCHALIGNED" ) ) {
+
+        case 0:     return CMDBIN_TOOLATE;
+        case -1:    return CMDBIN_ERROR;
+    }
+
+    binReps.resize( nReq );
+
+    for( int i = 0; i < nReq; ++i ) {
+
+        vec_i16         &data   = binData[i];
+        CmdBinFetchRep  &R      = binReps[i];
+
+        R.nChans    = vKeep[i].size();
+
+        if( dnsmp[i] > 1 )
+            Subset::downsample( data, data, R.nChans, dnsmp[i] );
+
+        R.fromCt    = fromCt[i];
+        R.nTpts     = data.size() / R.nChans;
+        R.status    = CMDBIN_OK;
+        R.bySync    = vS[i].bySync;
+    }
+
+    binSendFetched( Q, true );
+
+    return CMDBIN_OK;
+}
+
+
+// Send reply for FETCH family from (binReps, binData):
+// {CmdBinMultiHdr if multi}, then per stream: rep, data.
+//
+bool CmdWorker::binSendFetched( const CmdBinHdr &Q, bool multi )
+{
+    static const char   zeros[8] = {0};
+
+    CmdBinHdr   H       = Q;
+    int         nReq    = binReps.size();
+
+    H.status    = CMDBIN_OK;
+    H.len       = (multi ? sizeof(CmdBinMultiHdr) : 0);
+
+    for( int i = 0; i < nReq; ++i ) {
+
+        const CmdBinFetchRep    &R = binReps[i];
+
+        H.len += sizeof(CmdBinFetchRep) + cmdBinDataBytes( R.nChans, R.nTpts );
+    }
+
+    SU.appendBinary( &H, sizeof(H) );
+
+    if( multi ) {
+        CmdBinMultiHdr  M = {nReq, 0};
+        SU.appendBinary( &M, sizeof(M) );
+    }
+
+    for( int i = 0; i < nReq; ++i ) {
+
+        const CmdBinFetchRep    &R      = binReps[i];
+        qint64                  bytes   = qint64(R.nChans) * R.nTpts * sizeof(qint16),
+                                pad     = cmdBinDataBytes( R.nChans, R.nTpts ) - bytes;
+
+        SU.appendBinary( &R, sizeof(R) );
+
+        if( bytes )
+            SU.appendBinary( &binData[i][0], bytes );
+
+        if( pad )
+            SU.appendBinary( zeros, pad );
+    }
+
+    return SU.sendAppended();
+}
+
+
+// Send reply frame for request Q. Payload is (src, bytes),
+// or, if status is an error, the errMsg text.
+//
+bool CmdWorker::binReply(
+    const CmdBinHdr &Q,
+    int             status,
+    const void      *src,
+    qint64          bytes )
+{
+    CmdBinHdr   H = Q;
+    QByteArray  err;
+
+    if( status != CMDBIN_OK ) {
+        err     = errMsg.toUtf8();
+        src     = err.constData();
+        bytes   = err.size();
+    }
+
+    H.status    = status;
+    H.len       = bytes;
+
+    SU.appendBinary( &H, sizeof(H) );
+
+    if( bytes )
+        SU.appendBinary( src, bytes );
+
+    return SU.sendAppended();
+}
+
+
+// Expected tok params: none.
+//
+// Switch connection to the framed binary protocol of
+// CmdBinProto.h: Send( 'BINARYMODE %d\n', version ).
+// Serve frames until client sends a BYE frame, then
+// return to text protocol, normally sending "OK\n".
+//
+// Frames need no string parsing; requests are fixed
+// structs, and FETCH data go straight from the queue
+// to the socket. Like the text loop, the connection
+// is dropped on read timeout or five errors in a row.
+//
+void CmdWorker::binaryMode()
+{
+    SU.send( QString("BINARYMODE %1\n").arg( CMDBIN_VERSION ), true );
+
+    std::vector<quint64>    req;    // 8-byte aligned payload
+    const int               max_errCt   = 5;
+    int                     errCt       = 0;
+
+    for(;;) {
+
+        if( allStop() || !SU.sockValid() )
+            return;
+
+        // ----------
+        // Read frame
+        // ----------
+
+        CmdBinHdr   Q;
+
+        if( !SU.readBinary( &Q, sizeof(Q) ) ) {
+            sock->close();
+            return;
+        }
+
+        if( Q.magic != CMDBIN_MAGIC || Q.len > CMDBIN_MAXREQ ) {
+            errMsg = "BINARYMODE: Bad frame header.";
+            sock->close();
+            return;
+        }
+
+        req.resize( Q.len / sizeof(quint64) + 1 );
+
+        if( Q.len && !SU.readBinary( &req[0], Q.len ) ) {
+            sock->close();
+            return;
+        }
+
+        // --------
+        // Dispatch
+        // --------
+
+        const char  *P      = (const char*)&req[0];
+        int         status  = CMDBIN_OK;
+
+        errMsg.clear();
+
+        ThreadPlace::follow( ThreadPlace::tpAux );
+
+        switch( Q.op ) {
+
+            case CMDBIN_NOOP:
+                binReply( Q, status );
+                break;
+            case CMDBIN_FETCH:
+            case CMDBIN_FETCHMULTI:
+                status = binFetchFrame( Q, P );
+                break;
+            case CMDBIN_FETCHALIGNED:
+                status = binFetchAligned( Q, P );
+                break;
+            case CMDBIN_MAPSAMPLE: {
+
+                const CmdBinMapReq  *M = (const CmdBinMapReq*)P;
+                quint64             dstCt;
+
+                if( Q.len < sizeof(CmdBinMapReq) ) {
+                    errMsg = "MAPSAMPLE: Short request.";
+                    status = CMDBIN_ERROR;
+                }
+                else if( mapSampleCt(
+                            dstCt,
+                            M->dstjs, M->dstip, M->srcCt,
+                            M->srcjs, M->srcip ) ) {
+
+                    CmdBinMapRep    R = {dstCt};
+                    binReply( Q, status, &R, sizeof(R) );
+                }
+                else
+                    status = CMDBIN_ERROR;
+                break;
+            }
+            case CMDBIN_BYE:
+                binReply( Q, status );
+                return;
+            default:
+                errMsg = QString("BINARYMODE: Unknown op %1.").arg( Q.op );
+                status = CMDBIN_BADOP;
+        }
+
+        // ------
+        // Errors
+        // ------
+
+        if( status == CMDBIN_OK )
+            errCt = 0;
+        else {
+
+            Warning() << errMsg;
+            binReply( Q, status );
+
+            if( ++errCt >= max_errCt ) {
+                sock->close();
+                return;
+            }
+        }
+    }
 }
 
 
@@ -963,6 +1815,10 @@ bool CmdWorker::enumDir( const QString &path )
 // 3) max count
 // 4) <channel subset pattern "id1#id2#...">
 // 5) <integer downsample factor>
+// 6) <processing recipe "hp=300,car=gblmed,dec=binmax">
+//
+// See FetchProc.h for recipe keys. With a recipe, filters
+// and CAR run on the server before subset/downsample.
 //
 // Send( 'BINARY_DATA %d %d uint64(%ld)'\n", nChans, nSamps, headCt ).
 // Write binary data stream.
@@ -996,129 +1852,242 @@ void CmdWorker::fetch( const QStringList &toks )
 // -----
 
     QBitArray   chanBits;
-    int         nChans  = aiQ->nChans();
-    uint        dnsmp   = 1;
+    int         nChans  = aiQ->nChans(),
+                dnsmp   = 1;
 
-    if( toks.size() < 5 || toks.at( 4 ) == "-1#" )
-        chanBits.fill( true, nChans );
-    else if( toks.at( 4 ) == "-2#" ) {
+    if( !okChanBits( chanBits, p, js, ip, nChans, toks, 4 ) )
+        return;
 
-        switch( js ) {
-            case jsNI:  chanBits = p.ni.sns.saveBits; break;
-            case jsOB:  chanBits = p.im.get_iStrOneBox( ip ).sns.saveBits; break;
-            case jsIM:
-            case -jsIM: chanBits = p.im.prbj[ip].sns.saveBits; break;
-        }
-    }
-    else {
+// ----------
+// Downsample
+// ----------
 
-        chanBits.fill( true, nChans );
+    if( toks.size() >= 6 )
+        dnsmp = toks.at( 5 ).toUInt();
 
-        QString err =
-            Subset::cmdStr2Bits(
-                chanBits, chanBits, toks.at( 4 ), nChans );
+// ------
+// Recipe
+// ------
+
+    FetchRecipe R;
+
+    if( toks.size() >= 7 ) {
+
+        QString err = R.fromString( toks.at( 6 ) );
 
         if( !err.isEmpty() ) {
-            errMsg = err;
+            errMsg = "FETCH: " + err;
             return;
         }
     }
 
-// ----------
-// Downsample
-// ----------
-
-    if( toks.size() >= 6 )
-        dnsmp = toks.at( 5 ).toUInt();
-
 // ---------------------------------
 // Fetch whole timepoints from queue
 // ---------------------------------
 
-    vec_i16 data;
-    quint64 fromCt  = toks.at( 2 ).toLongLong();
-    int     nMax    = toks.at( 3 ).toInt(),
-            size,
-            ret;
+    QVector<uint>   iKeep;
+    vec_i16         data;
+    quint64         fromCt  = toks.at( 2 ).toLongLong();
+    int             size;
 
-    try {
-        data.reserve( nChans * nMax );
-    }
-    catch( const std::exception& ) {
-        errMsg = "FETCH: Low mem.";
-        return;
-    }
+    Subset::bits2Vec( iKeep, chanBits );
 
-    for( int itry = 0; itry < 3; ++itry ) {
+    if( R.isPlain() ) {
 
-        ret = aiQ->getNSampsFromCt( data, fromCt, nMax );
+        if( fetchGather(
+                data, aiQ, iKeep, fromCt,
+                toks.at( 3 ).toInt(), dnsmp, "FETCH" ) <= 0 ) {
 
-        if( ret < 0 ) {
-            errMsg = "FETCH: Too late.";
             return;
         }
+    }
+    else if( fetchProcessed(
+                data, aiQ, iKeep, fromCt,
+                toks.at( 3 ).toInt(), dnsmp, R, p, js, ip, "FETCH" ) <= 0 ) {
 
-        if( ret == 0 ) {
-            errMsg = "FETCH: Low mem.";
-            return;
-        }
+        return;
+    }
 
-        size = (int)data.size();
+    if( (size = (int)data.size()) )
+        nChans = iKeep.size();
 
-        if( size )
-            break;
+// ----
+// Send
+// ----
 
-        quint64  endCt = aiQ->endCount();
+    SU.send(
+        QString("BINARY_DATA %1 %2 uint64(%3)\n")
+        .arg( nChans )
+        .arg( size / nChans )
+        .arg( fromCt ),
+        true );
 
-        // Try to give client at least a small amount of data.
-        // 24 = 2 imec packets of samples.
-        // Bound sleeps to < 2 millisec to keep latency lower.
+    SU.sendBinary( &data[0], size*sizeof(qint16) );
+}
 
-        if( fromCt + 24 > endCt ) {
 
-            int gap_us = 1e6*(fromCt + 24 - endCt)/aiQ->sRate();
+// Expected tok params:
+// 0) reference stream index (into list below)
+// 1) reference start sample index
+// 2) window length (secs)
+// 3...) three per stream: js ip <channel subset pattern>
+//
+// Map the window start from the reference stream to each
+// listed stream using the sync edges, then return the whole
+// window of every stream in one reply, all or none:
+// Send( 'ALIGNED_DATA %d\n', nStreams ).
+// For each stream, in list order:
+// Send( 'BINARY_DATA %d %d uint64(%ld) %d\n',
+//       nChans, nSamps, headCt, bySync ).
+// Write binary data stream.
+//
+// bySync = 0 means the stream's start was mapped by
+// wall time alone (no matching sync edges).
+//
+void CmdWorker::fetchAligned( const QStringList &toks )
+{
+    if( toks.size() < 6 || (toks.size() - 3) % 3 ) {
+        errMsg = "FETCHALIGNED: Requires 3 params + 3 per stream.";
+        return;
+    }
 
-            QThread::usleep( qBound( 250, gap_us, 2000 ) );
-        }
+    ConfigCtl   *C = okCfgValidated( "FETCHALIGNED" );
+
+    if( !C )
+        return;
+
+    const DAQ::Params   &p      = C->acceptedParams;
+    const Run           *run    = mainApp()->getRun();
+    int                 nS      = (toks.size() - 3) / 3,
+                        iRef    = toks.at( 0 ).toInt();
+
+    if( iRef < 0 || iRef >= nS ) {
+        errMsg = QString("FETCHALIGNED: Reference must be in range [0..%1].")
+                    .arg( nS - 1 );
+        return;
     }
 
-    if( size ) {
+// -------
+// Streams
+// -------
+
+    std::vector<SyncStream>         vS( nS );
+    std::vector<QVector<uint> >     vKeep( nS );
+
+    for( int is = 0; is < nS; ++is ) {
 
-        // ----------------
-        // Requested subset
-        // ----------------
+        int js = toks.at( 3 + 3*is ).toInt(),
+            ip = toks.at( 4 + 3*is ).toInt();
 
-        if( chanBits.count( true ) < nChans ) {
+        if( !okjsip( "FETCHALIGNED", js, ip ) )
+            return;
 
-            QVector<uint>   iKeep;
+        const AIQ   *aiQ = run->getQ( js, ip );
 
-            Subset::bits2Vec( iKeep, chanBits );
-            Subset::subset( data, data, iKeep, nChans );
-            nChans = iKeep.size();
+        if( !aiQ ) {
+            errMsg = "FETCHALIGNED: Not running or stream not enabled.";
+            return;
         }
 
-        // ----------
-        // Downsample
-        // ----------
+        if( js == -jsIM )
+            aiQ->qf_remoteClient( true );
 
-        if( dnsmp > 1 )
-            Subset::downsample( data, data, nChans, dnsmp );
+        QBitArray   chanBits;
+
+        if( !okChanBits( chanBits, p, js, ip, aiQ->nChans(), toks, 5 + 3*is ) )
+            return;
+
+        Subset::bits2Vec( vKeep[is], chanBits );
+        vS[is].init( aiQ, qAbs( js ), ip, p );
+    }
+
+// -----
+// Fetch
+// -----
+
+    std::vector<vec_i16>    data( nS );
+    std::vector<quint64>    fromCt;
+
+    if( alignedGather(
+            data, fromCt, vS, vKeep, iRef,
+            toks.at( 1 ).toLongLong(), toks.at( 2 ).toDouble(),
+            p, "FETCHALIGNED" ) <= 0 ) {
 
-        size = (int)data.size();
+        return;
     }
 
 // ----
 // Send
 // ----
 
+    SU.send( QString("ALIGNED_DATA %1\n").arg( nS ), true );
+
+    for( int is = 0; is < nS; ++is ) {
+
+        int nC = vKeep[is].size();
+
+        SU.send(
+            QString("BINARY_DATA %1 %2 uint64(%3) %4\n")
+            .arg( nC )
+            .arg( data[is].size() / nC )
+            .arg( fromCt[is] )
+            .arg( vS[is].bySync ),
+            true );
+
+        SU.sendBinary( &data[is][0], data[is].size()*sizeof(qint16) );
+    }
+}
+
+
+// Expected tok params:
+// 0) ip
+// 1) starting event sequence number
+// 2) max count
+//
+// Events of the online spike detector for imec probe ip
+// (see SETSPIKEDETECT), 16 bytes each:
+// {uint64 ct, uint16 chan, int16 amp, uint32 width}.
+// If the starting event is no longer held, fromSeq is
+// advanced to the oldest held, so clients can count loss.
+//
+// Send( 'SPIKE_DATA %d uint64(%ld) uint64(%ld)\n',
+//      nEvts, fromSeq, nextSeq ).
+// Write binary event records.
+//
+void CmdWorker::fetchSpikes( const QStringList &toks )
+{
+    if( toks.size() < 3 ) {
+        errMsg = "FETCHSPIKES: Requires params {ip, fromSeq, maxCount}.";
+        return;
+    }
+
+    Run *run = okRunStarted( "FETCHSPIKES" );
+
+    if( !run )
+        return;
+
+    std::vector<SpkEvt> E;
+    quint64             fromSeq = toks.at( 1 ).toULongLong(),
+                        nextSeq = 0;
+
+    errMsg = run->spkDetFetch(
+                E, fromSeq, nextSeq,
+                toks.at( 0 ).toInt(), toks.at( 2 ).toInt() );
+
+    if( !errMsg.isEmpty() ) {
+        errMsg = "FETCHSPIKES: " + errMsg;
+        return;
+    }
+
+    int nE = E.size();
+
     SU.send(
-        QString("BINARY_DATA %1 %2 uint64(%3)\n")
-        .arg( nChans )
-        .arg( size / nChans )
-        .arg( fromCt ),
+        QString("SPIKE_DATA %1 uint64(%2) uint64(%3)\n")
+        .arg( nE ).arg( fromSeq ).arg( nextSeq ),
         true );
 
-    SU.sendBinary( &data[0], size*sizeof(qint16) );
+    if( nE )
+        SU.sendBinary( &E[0], nE*sizeof(SpkEvt) );
 }
 
 
@@ -2093,6 +3062,50 @@ void CmdWorker::setRunName( const QStringList &toks )
 }
 
 
+// Expected tok params:
+// 0) ip
+// 1) threshold uV (negative crossing of this magnitude; 0 = off)
+// 2) inarow (min samples over threshold)
+// 3) refractory millisec
+// 4) Boolean 0/1: write sidecar "<runName>.imec<ip>.spikes"
+//
+// Requires filtered imec streams (imQf). Restarting resets
+// the event sequence numbers.
+//
+void CmdWorker::setSpikeDetect( const QStringList &toks )
+{
+    if( toks.size() < 2 ) {
+        errMsg =
+        "SETSPIKEDETECT: Requires params {ip, uV, [inarow, refracMs, sidecar]}.";
+        return;
+    }
+
+    Run *run = okRunStarted( "SETSPIKEDETECT" );
+
+    if( !run )
+        return;
+
+    SpkDetParams    P;
+    bool            sidecar = false;
+
+    P.uV = toks.at( 1 ).toDouble();
+
+    if( toks.size() > 2 )
+        P.inarow = toks.at( 2 ).toInt();
+
+    if( toks.size() > 3 )
+        P.refracMs = toks.at( 3 ).toDouble();
+
+    if( toks.size() > 4 )
+        sidecar = toks.at( 4 ).toInt();
+
+    errMsg = run->spkDetSet( toks.at( 0 ).toInt(), P, sidecar );
+
+    if( !errMsg.isEmpty() )
+        errMsg = "SETSPIKEDETECT: " + errMsg;
+}
+
+
 // Expected tok params:
 // 0) Hertz
 // 1) millisec
@@ -2166,6 +3179,233 @@ void CmdWorker::stopRun()
 }
 
 
+// Expected tok params:
+// 0) js
+// 1) ip
+// 2) starting sample index {-1=current end}
+// 3) <channel subset pattern "id1#id2#...">
+// 4) <integer downsample factor>
+// 5) <max KB queued to client before dropping>
+//
+// Push frames as soon as the stream publishes new data:
+// Send( 'SUBDATA %d %d uint64(%ld) uint64(%ld)\n',
+//       nChans, nSamps, headCt, nDroppedSoFar ).
+// Write binary data stream.
+//
+// A client that falls behind by more than the queue limit,
+// or is lapped by the stream, is skipped ahead to the newest
+// data (dropped samples tallied); it never stalls acquisition.
+//
+// Client sends any line (e.g., "UNSUBSCRIBE") to end. Then:
+// Send( 'SUBEND nFrames nSamps nDropSamps nDropEvents\n' ).
+//
+void CmdWorker::subscribe( const QStringList &toks )
+{
+    if( toks.size() < 3 ) {
+        errMsg = "SUBSCRIBE: Requires at least 3 params.";
+        return;
+    }
+
+    int         js, ip;
+    ConfigCtl   *C = okStreamToks( "SUBSCRIBE", js, ip, toks );
+
+    if( !C )
+        return;
+
+    Run         *run = mainApp()->getRun();
+    const AIQ   *aiQ = run->subAttach( js, ip );
+
+    if( !aiQ ) {
+        errMsg = "SUBSCRIBE: Not running or stream not enabled.";
+        return;
+    }
+
+    if( js == -jsIM )
+        aiQ->qf_remoteClient( true );
+
+// -----
+// Chans
+// -----
+
+    QBitArray       chanBits;
+    QVector<uint>   iKeep;
+
+    if( !okChanBits(
+            chanBits, C->acceptedParams,
+            js, ip, aiQ->nChans(), toks, 3 ) ) {
+
+        run->subDetach();
+        return;
+    }
+
+    Subset::bits2Vec( iKeep, chanBits );
+
+// -------
+// Options
+// -------
+
+    qint64  fromCt0 = toks.at( 2 ).toLongLong(),
+            maxQ    = 8192;
+    int     dnsmp   = 1;
+
+    if( toks.size() >= 5 )
+        dnsmp = qMax( 1, toks.at( 4 ).toInt() );
+
+    if( toks.size() >= 6 )
+        maxQ = qMax( 64LL, toks.at( 5 ).toLongLong() );
+
+    maxQ *= 1024;
+
+// ---------
+// Push loop
+// ---------
+
+    AIQ::View   V;
+    vec_i16     data;
+    quint64     fromCt      = (fromCt0 < 0 ? aiQ->endCount() : fromCt0),
+                nFrames     = 0,
+                nSamps      = 0,
+                nDrop       = 0,
+                nDropEvt    = 0;
+    int         nKeep       = iKeep.size(),
+                frameMax    = qMax( dnsmp, int(aiQ->sRate() / 10) );
+    bool        sockOK      = true;
+
+    frameMax -= frameMax % dnsmp;
+
+    try {
+        data.reserve( frameMax * nKeep );
+    }
+    catch( const std::exception& ) {
+        run->subDetach();
+        errMsg = "SUBSCRIBE: Low mem.";
+        return;
+    }
+
+    for(;;) {
+
+        // ------------------------
+        // Client ended, run ended?
+        // ------------------------
+
+        sock->waitForReadyRead( 0 );
+
+        if( sock->canReadLine() ) {
+            SU.readLine();
+            break;
+        }
+
+        if( allStop() || !SU.sockValid() ) {
+            sockOK = false;
+            break;
+        }
+
+        if( run->subStopping() )
+            break;
+
+        // ---------------------------------
+        // Wait for at least one output tpt
+        // ---------------------------------
+
+        if( !aiQ->waitForData( fromCt + dnsmp - 1, 20 ) )
+            continue;
+
+        quint64 endCt = aiQ->endCount();
+
+        // ------------
+        // Backpressure
+        // ------------
+
+        if( SU.bytesQueued() > maxQ ) {
+            nDrop   += endCt - fromCt;
+            fromCt   = endCt;
+            ++nDropEvt;
+            continue;
+        }
+
+        // ---------------------------------
+        // Gather subset straight from queue
+        // ---------------------------------
+
+        int nMax    = (int)qMin( endCt - fromCt, quint64(frameMax) ),
+            ret;
+
+        nMax -= nMax % dnsmp;
+
+        if( (ret = aiQ->getViewFromCt( V, fromCt, nMax )) >= 0 ) {
+
+            data.clear();
+
+            for( int k = 0; k < 2; ++k ) {
+
+                if( V.ntpts[k] ) {
+                    Subset::appendSubset(
+                        data, V.src[k], V.ntpts[k], iKeep, V.nchans );
+                }
+            }
+        }
+
+        if( ret < 0 || !V.intact() ) {
+
+            // Lapped: skip to oldest data still held
+
+            quint64 headCt = aiQ->qHeadCt();
+
+            if( headCt > fromCt ) {
+                nDrop   += headCt - fromCt;
+                fromCt   = headCt;
+                ++nDropEvt;
+            }
+            continue;
+        }
+
+        int ntpts = V.nTpts();
+
+        if( !ntpts )
+            continue;
+
+        if( dnsmp > 1 )
+            Subset::downsample( data, data, nKeep, dnsmp );
+
+        // ----
+        // Push
+        // ----
+
+        SU.queue(
+            QString("SUBDATA %1 %2 uint64(%3) uint64(%4)\n")
+            .arg( nKeep )
+            .arg( data.size() / nKeep )
+            .arg( fromCt )
+            .arg( nDrop ) );
+
+        SU.queueBinary( &data[0], data.size()*sizeof(qint16) );
+
+        fromCt  += ntpts;
+        nSamps  += ntpts;
+        ++nFrames;
+    }
+
+    run->subDetach();
+
+// ------
+// Report
+// ------
+
+    Log() <<
+        QString("CmdSrv subscriber %1 js %2 ip %3:"
+        " frames %4 samps %5 dropped %6 (%7 events).")
+        .arg( SU.addr() ).arg( js ).arg( ip )
+        .arg( nFrames ).arg( nSamps ).arg( nDrop ).arg( nDropEvt );
+
+    if( sockOK ) {
+        SU.send(
+            QString("SUBEND %1 %2 %3 %4\n")
+            .arg( nFrames ).arg( nSamps ).arg( nDrop ).arg( nDropEvt ),
+            true );
+    }
+}
+
+
 // Expected tok params:
 // 0) g {-1,0,1}
 // 1) t {-1,0,1}
@@ -2409,6 +3649,8 @@ bool CmdWorker::doCommand( const QString &cmd, const QStringList &toks )
     if( cmd == "NOOP" ) {
         // do nothing, will just send OK in caller
     }
+    else if( cmd == "BINARYMODE" )
+        binaryMode();
     else if( cmd == "CONSOLEHIDE" )
         consoleShow( false );
     else if( cmd == "CONSOLESHOW" )
@@ -2417,6 +3659,10 @@ bool CmdWorker::doCommand( const QString &cmd, const QStringList &toks )
         enumDir( mainApp()->dataDir( DIRID ) );
     else if( cmd == "FETCH" )
         fetch( toks );
+    else if( cmd == "FETCHALIGNED" )
+        fetchAligned( toks );
+    else if( cmd == "FETCHSPIKES" )
+        fetchSpikes( toks );
     else if( cmd == "GETSTREAMSHANKMAP" )
         getStreamShankMap( toks );
     else if( cmd == "NIDOSET" )
@@ -2469,6 +3715,8 @@ bool CmdWorker::doCommand( const QString &cmd, const QStringList &toks )
         setRecordingEnabled( toks );
     else if( cmd == "SETRUNNAME" )
         setRunName( toks );
+    else if( cmd == "SETSPIKEDETECT" )
+        setSpikeDetect( toks );
     else if( cmd == "SETTRIGGEROFFBEEP" )
         setTriggerOffBeep( toks );
     else if( cmd == "SETTRIGGERONBEEP" )
@@ -2477,6 +3725,8 @@ bool CmdWorker::doCommand( const QString &cmd, const QStringList &toks )
         startRun();
     else if( cmd == "STOPRUN" )
         stopRun();
+    else if( cmd == "SUBSCRIBE" )
+        subscribe( toks );
     else if( cmd == "TRIGGERGT" )
         triggerGT( toks );
     else if( cmd == "VERIFYPARAMS" )
@@ -2,12 +2,18 @@
 #define COMMANDSERVER_H
 
 #include "SockUtil.h"
+#include "CmdBinProto.h"
+#include "SGLTypes.h"
 
 #include <QTcpServer>
 #include <QStringList>
+#include <QVector>
 
 class Par2Worker;
 class MainApp;
+class AIQ;
+struct SyncStream;
+struct FetchRecipe;
 class ConfigCtl;
 class Run;
 
@@ -15,6 +21,7 @@ namespace DAQ {
 struct Params;
 }
 
+class QBitArray;
 class QTcpSocket;
 
 /* ---------------------------------------------------------------- */
@@ -57,12 +64,14 @@ class CmdWorker : public QObject
     Q_OBJECT
 
 private:
-    QString     errMsg;
-    Par2Worker  *par2;
-    QTcpSocket  *sock;
-    SockUtil    SU;
-    qintptr     sockFd,     // socket 'file descriptor'
-                timeout;
+    QString                     errMsg;
+    std::vector<vec_i16>        binData;    // BINARYMODE fetch
+    std::vector<CmdBinFetchRep> binReps;
+    Par2Worker                  *par2;
+    QTcpSocket                  *sock;
+    SockUtil                    SU;
+    qintptr                     sockFd,     // socket 'file descriptor'
+                                timeout;
 
 public:
     CmdWorker( qintptr sockFd, int timeout )
@@ -88,7 +97,81 @@ private:
     ConfigCtl* okCfgValidated( const QString &cmd );
     ConfigCtl* okjsip( const QString &cmd, int js, int ip );
     ConfigCtl* okStreamToks( const QString &cmd, int &js, int &ip, const QStringList &toks );
+    bool okChanBits(
+        QBitArray           &chanBits,
+        const DAQ::Params   &p,
+        int                 js,
+        int                 ip,
+        int                 nChans,
+        const QStringList   &toks,
+        int                 itok );
     Run* okRunStarted( const QString &cmd );
+    static void savedChanBits(
+        QBitArray           &chanBits,
+        const DAQ::Params   &p,
+        int                 js,
+        int                 ip );
+    int fetchGather(
+        vec_i16                 &data,
+        const AIQ               *aiQ,
+        const QVector<uint>     &iKeep,
+        quint64                 fromCt,
+        int                     nMax,
+        int                     dnsmp,
+        const QString           &cmd );
+    int fetchProcessed(
+        vec_i16                 &data,
+        const AIQ               *aiQ,
+        const QVector<uint>     &iKeep,
+        quint64                 fromCt,
+        int                     nMax,
+        int                     dnsmp,
+        const FetchRecipe       &R,
+        const DAQ::Params       &p,
+        int                     js,
+        int                     ip,
+        const QString           &cmd );
+    int alignedGather(
+        std::vector<vec_i16>                &data,
+        std::vector<quint64>                &fromCt,
+        const std::vector<SyncStream>       &vS,
+        const std::vector<QVector<uint> >   &vKeep,
+        int                                 iRef,
+        quint64                             refCt,
+        double                              secs,
+        const DAQ::Params                   &p,
+        const QString                       &cmd );
+    bool mapSampleCt(
+        quint64 &dstCt,
+        int     dstjs,
+        int     dstip,
+        quint64 srcCt,
+        int     srcjs,
+        int     srcip );
+    const CmdBinFetchReq* binFetchReq(
+        const char      *req,
+        const char      *end,
+        const QString   &cmd );
+    const AIQ* binStream(
+        QVector<uint>           &iKeep,
+        const CmdBinFetchReq    &Q,
+        const quint16           *ids,
+        const QString           &cmd );
+    int binFetch(
+        vec_i16                 &data,
+        CmdBinFetchRep          &R,
+        const CmdBinFetchReq    &Q,
+        const quint16           *ids,
+        const QString           &cmd );
+    int binFetchFrame( const CmdBinHdr &Q, const char *req );
+    int binFetchAligned( const CmdBinHdr &Q, const char *req );
+    bool binSendFetched( const CmdBinHdr &Q, bool multi );
+    bool binReply(
+        const CmdBinHdr &Q,
+        int             status,
+        const void      *src = 0,
+        qint64          bytes = 0 );
+    void binaryMode();
     void getGeomMap( QString &resp, const QStringList &toks );
     void getImecChanGains( QString &resp, const QStringList &toks );
     void getLastGT( QString &resp );
@@ -114,6 +197,8 @@ private:
     void consoleShow( bool show );
     bool enumDir( const QString &path );
     void fetch( const QStringList &toks );
+    void fetchAligned( const QStringList &toks );
+    void fetchSpikes( const QStringList &toks );
     void getStreamShankMap( const QStringList &toks );
     void niDOSet( QStringList toks );
     void niWaveArm( const QStringList &toks );
@@ -140,10 +225,12 @@ private:
     void setParamsOneBox( const QStringList &toks );
     void setRecordingEnabled( const QStringList &toks );
     void setRunName( const QStringList &toks );
+    void setSpikeDetect( const QStringList &toks );
     void setTriggerOffBeep( const QStringList &toks );
     void setTriggerOnBeep( const QStringList &toks );
     void startRun();
     void stopRun();
+    void subscribe( const QStringList &toks );
     void triggerGT( const QStringList &toks );
     void verifyParams();
     void verifySha1( QString file );
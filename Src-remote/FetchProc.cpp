@@ -0,0 +1,382 @@
+
+#include "FetchProc.h"
+#include "DAQ.h"
+#include "Biquad.h"
+#include "Subset.h"
+#include "ThreadPlace.h"
+
+#include <QMutex>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+
+#define LEAD_MAX_SECS   1.0     // cap on settling lead-in
+
+
+/* ---------------------------------------------------------------- */
+/* Statics -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Shared by all command connections; a quarter of the
+// cores so remote clients can't starve acquisition.
+//
+static QThreadPool* fetchPool()
+{
+    static QThreadPool  *pool = 0;
+    static QMutex       poolMtx;
+
+    QMutexLocker    ml( &poolMtx );
+
+    if( !pool ) {
+        pool = new QThreadPool;
+        pool->setMaxThreadCount(
+            qBound( 1, QThread::idealThreadCount() / 4, 8 ) );
+        pool->setExpiryTimeout( 30000 );
+    }
+
+    return pool;
+}
+
+/* ---------------------------------------------------------------- */
+/* FetchRecipe ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+QString FetchRecipe::fromString( const QString &s )
+{
+    *this = FetchRecipe();
+
+    foreach( const QString &kv, s.split( ",", Qt::SkipEmptyParts ) ) {
+
+        QStringList pair = kv.split( "=" );
+        QString     key, val;
+        bool        ok = true;
+
+        if( pair.size() != 2 )
+            return QString("Bad recipe item '%1'.").arg( kv );
+
+        key = pair[0].trimmed().toLower();
+        val = pair[1].trimmed().toLower();
+
+        if( key == "hp" )
+            hp = val.toDouble( &ok );
+        else if( key == "lp" )
+            lp = val.toDouble( &ok );
+        else if( key == "in" )
+            carIn = val.toInt( &ok );
+        else if( key == "out" )
+            carOut = val.toInt( &ok );
+        else if( key == "car" ) {
+
+            if( val == "none" )
+                car = carNone;
+            else if( val == "local" )
+                car = carLocal;
+            else if( val == "gblave" )
+                car = carGblAve;
+            else if( val == "gblmed" )
+                car = carGblMed;
+            else if( val == "gbldmx" )
+                car = carGblDmx;
+            else
+                ok = false;
+        }
+        else if( key == "dec" ) {
+
+            if( val == "ave" )
+                dec = decAve;
+            else if( val == "binmax" )
+                dec = decBinMax;
+            else if( val == "aa" )
+                dec = decAA;
+            else
+                ok = false;
+        }
+        else
+            return QString("Unknown recipe key '%1'.").arg( key );
+
+        if( !ok )
+            return QString("Bad recipe value '%1'.").arg( kv );
+    }
+
+    return QString();
+}
+
+/* ---------------------------------------------------------------- */
+/* FetchProc ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+QString FetchProc::init(
+    const FetchRecipe   &R,
+    const DAQ::Params   &p,
+    int                 js,
+    int                 ip,
+    int                 dnsmp )
+{
+// Range checks shared by text and binary protocols.
+// Negated compares also reject NaN.
+
+    if( !(R.hp >= 0) || !(R.lp >= 0) )
+        return "Recipe cutoffs must be numbers >= 0.";
+
+    if( R.car < FetchRecipe::carNone || R.car > FetchRecipe::carGblDmx )
+        return QString("Bad recipe car mode (%1).").arg( R.car );
+
+    if( R.dec < FetchRecipe::decAve || R.dec > FetchRecipe::decAA )
+        return QString("Bad recipe dec mode (%1).").arg( R.dec );
+
+    this->R     = R;
+    this->dnsmp = qMax( 1, dnsmp );
+
+    this->js    = js = qAbs( js );
+    srate       = p.stream_rate( js, ip );
+    nC          = p.stream_nChans( js, ip );
+
+    int rin = 0, rout = 2;
+
+    switch( js ) {
+        case jsNI:
+            nNeu        = p.ni.niCumTypCnt[CniCfg::niSumNeural];
+            maxInt      = 32768;
+            muxFactor   = p.ni.muxFactor;
+            car.setChans( nC, nNeu, 1 );
+            car.setSU( &p.ni.sns.shankMap );
+            break;
+        case jsIM: {
+                const CimCfg::PrbEach   &E = p.im.prbj[ip];
+                nNeu    = E.imCumTypCnt[CimCfg::imSumAP];
+                maxInt  = E.roTbl->maxInt();
+                E.roTbl->locFltRadii( rin, rout, 1 );
+                car.setAuto( E.roTbl );
+                car.setChans( nC, nNeu, 1 );
+                car.setSU( &E.sns.shankMap );
+            }
+            break;
+        default:
+            nNeu    = 0;
+            maxInt  = 32768;
+    }
+
+    if( !nNeu && (R.hp || R.lp || R.car != FetchRecipe::carNone) )
+        return "Recipe needs neural channels; stream has none.";
+
+    if( R.hp >= srate/2 || R.lp >= srate/2 )
+        return QString("Recipe cutoff not below Nyquist (%1 Hz).")
+                .arg( srate/2 );
+
+    switch( R.car ) {
+        case FetchRecipe::carLocal:
+            if( R.carIn >= 0 )
+                rin = R.carIn;
+            if( R.carOut >= 0 )
+                rout = R.carOut;
+            if( rout <= rin )
+                return "Recipe local CAR needs in < out.";
+            if( js == jsNI )
+                car.lcl_init( &p.ni.sns.shankMap, rin, rout, true );
+            else
+                car.lcl_init( &p.im.prbj[ip].sns.shankMap, rin, rout, true );
+            break;
+        case FetchRecipe::carGblMed:
+            car.gbl_med_auto_init();
+            break;
+        default:
+            ;
+    }
+
+    return QString();
+}
+
+
+// Timepoints to fetch ahead of the window so filters settle:
+// about 1/Fc for the slowest Biquad, capped.
+//
+int FetchProc::leadIn() const
+{
+    double  Fc = 0;
+
+    if( R.hp )
+        Fc = R.hp;
+
+    if( R.lp && (!Fc || R.lp < Fc) )
+        Fc = R.lp;
+
+    if( R.dec == FetchRecipe::decAA && dnsmp > 1 ) {
+
+        double  aa = 0.4 * srate / dnsmp;
+
+        if( !Fc || aa < Fc )
+            Fc = aa;
+    }
+
+    if( !Fc )
+        return 0;
+
+    return qMin( int(srate / Fc), int(LEAD_MAX_SECS * srate) );
+}
+
+
+// blk holds whole timepoints (nC chans), the first lead of
+// which are dropped after filtering. Output is the iKeep
+// subset, decimated per recipe.
+//
+void FetchProc::apply(
+    vec_i16             &out,
+    vec_i16             &blk,
+    int                 lead,
+    const QVector<uint> &iKeep )
+{
+    out.clear();
+
+    int ntpts = int(blk.size()) / nC;
+
+    if( ntpts <= lead )
+        return;
+
+    qint16  *d = &blk[0];
+
+// ------
+// Filter
+// ------
+
+    if( R.hp )
+        filter( d, ntpts, bq_type_highpass, R.hp / srate );
+
+    if( R.lp )
+        filter( d, ntpts, bq_type_lowpass, R.lp / srate );
+
+// ---
+// CAR
+// ---
+
+    applyCAR( d, ntpts );
+
+// ----------
+// Anti-alias
+// ----------
+
+    if( R.dec == FetchRecipe::decAA && dnsmp > 1 )
+        filter( d, ntpts, bq_type_lowpass, 0.4 / dnsmp );
+
+// -----------------------
+// Drop lead-in and subset
+// -----------------------
+
+    out.reserve( (ntpts - lead) * iKeep.size() );
+    Subset::appendSubset( out, d + lead * nC, ntpts - lead, iKeep, nC );
+
+// --------
+// Decimate
+// --------
+
+    if( dnsmp > 1 )
+        decimate( out, iKeep );
+}
+
+
+// Split neural channels among the pool and the caller.
+// Each task owns a Biquad for its channel range, starting
+// from rest (state of earlier calls is not meaningful).
+//
+void FetchProc::filter( qint16 *d, int ntpts, int type, double Fc ) const
+{
+    QThreadPool *pool   = fetchPool();
+    QSemaphore  done;
+    int         nT      = qBound( 1, nNeu / 64, pool->maxThreadCount() + 1 );
+
+    auto    range = [this, d, ntpts, type, Fc, nT]( int it ) {
+        Biquad  bq( type, Fc );
+        bq.applyBlockwiseMem(
+            d, maxInt, ntpts, nC,
+            nNeu * it / nT, nNeu * (it + 1) / nT );
+    };
+
+    for( int it = 1; it < nT; ++it ) {
+        pool->start( QRunnable::create( [&range, &done, it]() {
+            ThreadPlace::follow( ThreadPlace::tpAux );
+            range( it );
+            done.release();
+        }) );
+    }
+
+    range( 0 );
+    done.acquire( nT - 1 );
+}
+
+
+void FetchProc::applyCAR( qint16 *d, int ntpts )
+{
+    switch( R.car ) {
+        case FetchRecipe::carLocal: {
+                QVector<int>    ident( nNeu );
+                for( int i = 0; i < nNeu; ++i )
+                    ident[i] = i;
+                car.lcl_auto( d, ntpts, ident, ident );
+            }
+            break;
+        case FetchRecipe::carGblAve:
+            car.gbl_ave_auto( d, ntpts );
+            break;
+        case FetchRecipe::carGblMed:
+            car.gbl_med_auto( d, ntpts,
+                fetchPool()->maxThreadCount() + 1 );
+            break;
+        case FetchRecipe::carGblDmx:
+            if( js == jsNI )
+                car.gbl_dmx_stride_auto( d, ntpts, muxFactor );
+            else
+                car.gbl_dmx_tbl_auto( d, ntpts );
+            break;
+        default:
+            ;
+    }
+}
+
+
+// In place decimation of iKeep subset.
+// ave:    bin average, as plain FETCH.
+// binmax: neural chans keep largest magnitude in bin.
+// aa:     first sample of (already lowpassed) bin.
+// Non-neural chans take first sample for binmax and aa.
+//
+void FetchProc::decimate( vec_i16 &out, const QVector<uint> &iKeep ) const
+{
+    int nK = iKeep.size();
+
+    if( R.dec == FetchRecipe::decAve ) {
+        Subset::downsample( out, out, nK, dnsmp );
+        return;
+    }
+
+    int     ntpts   = int(out.size()) / nK,
+            dtpts   = (ntpts + dnsmp - 1) / dnsmp;
+    qint16  *D      = &out[0];
+
+    for( int it = 0; it < ntpts; it += dnsmp, D += nK ) {
+
+        const qint16    *S  = &out[it * nK];
+        int             ns  = qMin( ntpts - it, dnsmp );
+
+        for( int k = 0; k < nK; ++k ) {
+
+            qint16  v = S[k];
+
+            if( R.dec == FetchRecipe::decBinMax && int(iKeep[k]) < nNeu ) {
+
+                const qint16    *s = S + k + nK;
+
+                for( int is = 1; is < ns; ++is, s += nK ) {
+                    if( qAbs( *s ) > qAbs( v ) )
+                        v = *s;
+                }
+            }
+
+            D[k] = v;
+        }
+    }
+
+    out.resize( dtpts * nK );
+}
+
+
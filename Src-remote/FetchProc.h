@@ -0,0 +1,118 @@
+#ifndef FETCHPROC_H
+#define FETCHPROC_H
+
+#include "CAR.h"
+
+#include <QString>
+#include <QVector>
+
+namespace DAQ {
+struct Params;
+}
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Processing a remote FETCH asks the server to apply before
+// channel subsetting and decimation, so clients get reduced
+// data rather than the full-rate stream.
+//
+// Text form (FETCH recipe token), comma-separated keys:
+// hp=Hz        highpass (0=off)
+// lp=Hz        lowpass (0=off)
+// car=mode     {none, local, gblave, gblmed, gbldmx}
+// in=n         local CAR inner radius (sites)
+// out=n        local CAR outer radius (sites)
+// dec=mode     {ave, binmax, aa}
+//
+// Filters and CAR act on the neural channels: imec AP, or
+// nidq MN+MA. Local CAR radii default to the graphs' first
+// local filter for the stream. Decimation: ave = bin average (plain FETCH
+// behavior), binmax = largest magnitude per bin (spikes are
+// kept), aa = anti-alias lowpass then pick. For binmax/aa,
+// non-neural channels take the first sample of each bin.
+//
+struct FetchRecipe
+{
+    enum CARMode {
+        carNone     = 0,
+        carLocal    = 1,
+        carGblAve   = 2,
+        carGblMed   = 3,
+        carGblDmx   = 4
+    };
+
+    enum DecMode {
+        decAve      = 0,
+        decBinMax   = 1,
+        decAA       = 2
+    };
+
+    double  hp,
+            lp;
+    int     car,
+            carIn,  // -1=stream default
+            carOut,
+            dec;
+
+    FetchRecipe()
+    :   hp(0), lp(0), car(carNone), carIn(-1), carOut(-1), dec(decAve)  {}
+
+    bool isPlain() const
+        {return !hp && !lp && car == carNone && dec == decAve;}
+
+    // Parse only; FetchProc::init() validates ranges.
+    // Return error string, empty if OK.
+    QString fromString( const QString &s );
+};
+
+
+// Runs a recipe on a block of whole timepoints (all channels).
+// Filter passes are split by channel across a worker pool that
+// all command connections share; CAR runs over time.
+//
+// Biquads start from rest each call, so the caller fetches
+// leadIn() extra timepoints ahead of the wanted window, to be
+// dropped once filter transients have settled.
+//
+class FetchProc
+{
+private:
+    FetchRecipe R;
+    CAR         car;
+    double      srate;
+    int         js,
+                nC,
+                nNeu,
+                maxInt,
+                muxFactor,
+                dnsmp;
+
+public:
+    FetchProc() : srate(1), js(0), nC(0), nNeu(0), maxInt(32768), muxFactor(1), dnsmp(1) {}
+
+    QString init(
+        const FetchRecipe   &R,
+        const DAQ::Params   &p,
+        int                 js,
+        int                 ip,
+        int                 dnsmp );
+
+    int leadIn() const;
+
+    void apply(
+        vec_i16             &out,
+        vec_i16             &blk,
+        int                 lead,
+        const QVector<uint> &iKeep );
+
+private:
+    void filter( qint16 *d, int ntpts, int type, double Fc ) const;
+    void applyCAR( qint16 *d, int ntpts );
+    void decimate( vec_i16 &out, const QVector<uint> &iKeep ) const;
+};
+
+#endif  // FETCHPROC_H
+
+
@@ -149,6 +149,83 @@ bool SockUtil::sendBinary( const void* src, qint64 bytes )
 }
 
 
+// Hand bytes to the socket without pushing them out;
+// sendAppended() then sends all pieces together, so
+// small frame headers don't go as separate packets.
+//
+bool SockUtil::appendBinary( const void* src, qint64 bytes )
+{
+    if( !sockExists() )
+        return false;
+
+    sock->write( (const char*)src, bytes );
+
+    return true;
+}
+
+
+bool SockUtil::sendAppended()
+{
+    if( !sockExists() )
+        return false;
+
+    if( sock->bytesToWrite()
+        && !sock->waitForBytesWritten( timeout_ms ) ) {
+
+        appendError( errOut, errorToString( sock->error() ) );
+
+        if( autoAbort )
+            sock->abort();
+
+        return false;
+    }
+
+    return true;
+}
+
+
+// Non-blocking send for streaming: data are appended
+// to the socket's write buffer and pushed out as far
+// as the kernel will take them now. Caller watches
+// bytesQueued() to detect a peer falling behind.
+//
+bool SockUtil::queue( const QString &msg )
+{
+    if( !sockExists() )
+        return false;
+
+    sock->write( STR2CHR( msg ) );
+    sock->flush();
+
+    return true;
+}
+
+
+bool SockUtil::queueBinary( const void* src, qint64 bytes )
+{
+    if( !sockExists() )
+        return false;
+
+    sock->write( (const char*)src, bytes );
+    sock->flush();
+
+    return true;
+}
+
+
+// Bytes accepted by queue() not yet handed to the OS.
+//
+qint64 SockUtil::bytesQueued()
+{
+    if( !sockExists() )
+        return 0;
+
+    sock->flush();
+
+    return sock->bytesToWrite();
+}
+
+
 // Return data string, or,
 // return empty QString to signal end of communication.
 //
@@ -177,6 +254,49 @@ QString SockUtil::readLine()
 }
 
 
+// Fill dst with exactly (bytes).
+// Return false on timeout or socket error.
+//
+bool SockUtil::readBinary( void* dst, qint64 bytes )
+{
+    char    *d = (char*)dst;
+
+    while( bytes > 0 ) {
+
+        if( !sock->bytesAvailable() ) {
+
+            if( !sockValid() )
+                return false;
+
+            if( !sock->waitForReadyRead( timeout_ms ) ) {
+
+                QString err;
+
+                if( sock->error() != QAbstractSocket::UnknownSocketError )
+                    err = errorToString( sock->error() );
+                else
+                    err = "timeout or peer shutdown during read";
+
+                appendError( errOut, err );
+                return false;
+            }
+        }
+
+        qint64  n = sock->read( d, bytes );
+
+        if( n < 0 ) {
+            appendError( errOut, errorToString( sock->error() ) );
+            return false;
+        }
+
+        d     += n;
+        bytes -= n;
+    }
+
+    return true;
+}
+
+
 // Note:
 // -----
 // Calling sock->error() on a new healthy socket returns value
@@ -61,8 +61,15 @@ public:
 
     bool send( const QString &msg, bool debugInput = false );
     bool sendBinary( const void* src, qint64 bytes );
+    bool appendBinary( const void* src, qint64 bytes );
+    bool sendAppended();
+
+    bool queue( const QString &msg );
+    bool queueBinary( const void* src, qint64 bytes );
+    qint64 bytesQueued();
 
     QString readLine();
+    bool readBinary( void* dst, qint64 bytes );
 
     static QString errorToString( QAbstractSocket::SocketError e );
     static void appendError( QString *eDst, const QString &eNew );
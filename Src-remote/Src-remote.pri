@@ -1,7 +1,9 @@
 
 HEADERS += \
+    $$PWD/CmdBinProto.h \
     $$PWD/CmdSrvDlg.h \
     $$PWD/CmdServer.h \
+    $$PWD/FetchProc.h \
     $$PWD/RgtServer.h \
     $$PWD/RgtSrvDlg.h \
     $$PWD/SockUtil.h
@@ -9,6 +11,7 @@ HEADERS += \
 SOURCES += \
     $$PWD/CmdSrvDlg.cpp \
     $$PWD/CmdServer.cpp \
+    $$PWD/FetchProc.cpp \
     $$PWD/RgtServer.cpp \
     $$PWD/RgtSrvDlg.cpp \
     $$PWD/SockUtil.cpp
@@ -1,5 +1,7 @@
 
 #include "AIQ.h"
+#include "AIQShm.h"
+#include "Sync.h"
 #include "Util.h"
 
 
@@ -14,7 +16,7 @@
 
 class RingWalker {
 private:
-    const vec_i16   &buf;
+    const qint16    *buf;
     int             bufmax,
                     bufhead,
                     buflen,
@@ -28,7 +30,7 @@ public:
     const qint16    *cur;
 public:
     RingWalker(
-        const vec_i16   &buf,
+        const qint16    *buf,
         int             bufmax,
         int             bufhead,
         int             buflen,
@@ -41,6 +43,7 @@ public:
     bool setStart( quint64 fromCt, quint64 endCt );
     bool next();
     quint64 curCt() {return headCt + icur;}
+    quint64 startCt() {return headCt;}
 };
 
 
@@ -88,7 +91,7 @@ bool RingWalker::next()
 
 class RingFltWalker {
 private:
-    const vec_i16       &buf;
+    const qint16        *buf;
     int                 bufmax,
                         bufhead,
                         buflen,
@@ -105,7 +108,7 @@ public:
     const qint16    *cur;
 public:
     RingFltWalker(
-        const vec_i16       &buf,
+        const qint16        *buf,
         int                 bufmax,
         int                 bufhead,
         int                 buflen,
@@ -118,6 +121,7 @@ public:
     bool setStart( quint64 fromCt, quint64 endCt );
     bool next();
     quint64 curCt() {return headCt + icur;}
+    quint64 startCt() {return headCt;}
 private:
     void filter();
 };
@@ -189,11 +193,88 @@ void RingFltWalker::filter()
 /* AIQ ------------------------------------------------------------ */
 /* ---------------------------------------------------------------- */
 
-AIQ::AIQ( double srate, int nchans, double capacitySecs )
+// Locked mode (default):
+// Producer and readers serialize on QMtx.
+//
+// Lock-free mode:
+// Single producer, multiple consumers, no reader ever blocks
+// the producer. The producer announces the span it is about
+// to overwrite via wrCt, copies the data, then publishes the
+// new endCt. Readers derive the ring layout from endCt alone,
+// read in place, then validate seqlock-style: if wrCt shows
+// the producer has since lapped any sample they read, the
+// result is discarded as if those samples fell off the left
+// end of the stream.
+//
+AIQ::AIQ(
+    double  srate,
+    int     nchans,
+    double  capacitySecs,
+    bool    lockFree )
     :   srate(srate), nchans(nchans), bufmax(capacitySecs * srate),
-        tzero(0), endCt(0), bufhead(0), buflen(0), clients(0)
+        shm(0), sidx(0), tzero(0), endCt(0), wrCt(0), bufhead(0), buflen(0),
+        nWaiters(0), clients(0), lockFree(lockFree)
+{
+    bufStore.resize( SAMPS(bufmax) );
+    buf = &bufStore[0];
+}
+
+
+AIQ::~AIQ()
+{
+    if( shm ) {
+        delete shm;
+        shm = 0;
+    }
+
+    if( sidx ) {
+        delete sidx;
+        sidx = 0;
+    }
+}
+
+
+// Move ring into named shared memory so local processes can
+// map it read-only (see AIQShmHdr.h for the reader protocol).
+// Call right after construction, before any enqueue.
+//
+bool AIQ::shmExport( const QString &name )
 {
-    buf.resize( SAMPS(bufmax) );
+    AIQShm  *S = new AIQShm;
+
+    if( !S->create( name, srate, nchans, bufmax ) ) {
+        delete S;
+        return false;
+    }
+
+    shm = S;
+    buf = shm->ring();
+    vec_i16().swap( bufStore );
+
+    return true;
+}
+
+
+// Take ownership of a sync edge index fed by the producer.
+// Call right after construction, before any enqueue.
+//
+void AIQ::setSyncIdx( SyncEdgeIdx *X )
+{
+    if( sidx )
+        delete sidx;
+
+    sidx = X;
+}
+
+
+void AIQ::setTZero( double t0 ) const
+{
+    tzero = t0;
+
+    if( shm ) {
+        shm->header()->tzero = t0;
+        std::atomic_thread_fence( std::memory_order_release );
+    }
 }
 
 
@@ -241,6 +322,17 @@ void AIQ::qf_remoteClient( bool on ) const
 }
 
 
+void AIQ::qf_detectClient( bool on ) const
+{
+    QMutexLocker    ml( &qfMtx );
+
+    if( on )
+        clients |= 16;
+    else
+        clients &= ~16;
+}
+
+
 bool AIQ::qf_isClient() const
 {
     QMutexLocker    ml( &qfMtx );
@@ -262,13 +354,13 @@ void AIQ::enqueueZero( double t0, double tLim )
 //
 void AIQ::enqueueZeroIM( int nCts, int nStat, quint16 status )
 {
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
 
-    endCt += nCts;
+    wrBegin( nCts );
 
     if( nCts >= bufmax ) {
         // Keep only newest bufmax-worth.
-        bufhead = 0;
+        bufhead = (endCt.load( std::memory_order_relaxed ) + nCts) % bufmax;
         buflen  = bufmax;
         memset( &buf[0], 0, BYTES(bufmax) );
 
@@ -292,21 +384,21 @@ void AIQ::enqueueZeroIM( int nCts, int nStat, quint16 status )
 
         // status words
         if( nStat > 0 ) {
-            qint16  *dst = &buf[SAMPS(oldtail)-nStat];
+            qint16  *dst = &buf[SAMPS(oldtail)+nchans-nStat];
             for( int it = 0; it < ncpy1; ++it, dst += nchans ) {
                 for( int is = 0; is < nStat; ++is )
                     dst[is] = status;
             }
         }
 
-        if( nCts -= ncpy1 ) {
+        if( int nlhs = nCts - ncpy1 ) {
 
-            memset( &buf[0], 0, BYTES(nCts) );
+            memset( &buf[0], 0, BYTES(nlhs) );
 
             // status words
             if( nStat > 0 ) {
                 qint16  *dst = &buf[nchans-nStat];
-                for( int it = 0; it < nCts; ++it, dst += nchans ) {
+                for( int it = 0; it < nlhs; ++it, dst += nchans ) {
                     for( int is = 0; is < nStat; ++is )
                         dst[is] = status;
                 }
@@ -316,36 +408,19 @@ void AIQ::enqueueZeroIM( int nCts, int nStat, quint16 status )
         bufhead = newhead;
         buflen  = newlen;
     }
+
+    if( sidx )
+        sidx->gap();
+
+    wrEnd( nCts );
 }
 
 
 void AIQ::enqueue( const qint16 *src, int nCts )
 {
-    QMutexLocker    ml( &QMtx );
-
-    endCt += nCts;
-
-    if( nCts >= bufmax ) {
-        // Keep only newest bufmax-worth.
-        bufhead = 0;
-        buflen  = bufmax;
-        memcpy( &buf[0], &src[SAMPS(nCts-bufmax)], BYTES(bufmax) );
-    }
-    else {
-        // All new data fit, with some room for old data.
-        int newlen  = std::min( buflen + nCts, bufmax ),
-            newhead = (bufhead + buflen + nCts - newlen) % bufmax,
-            oldtail = (bufhead + buflen) % bufmax,
-            ncpy1   = std::min( nCts, bufmax - oldtail );
-
-        memcpy( &buf[SAMPS(oldtail)], &src[0], BYTES(ncpy1) );
-
-        if( nCts -= ncpy1 )
-            memcpy( &buf[0], &src[SAMPS(ncpy1)], BYTES(nCts) );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
 
-        bufhead = newhead;
-        buflen  = newlen;
-    }
+    store( src, nCts );
 }
 
 
@@ -357,34 +432,12 @@ void AIQ::enqueueProfile(
 {
     double  t, t0 = getTime();
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
 
     t       = getTime();
     tLock   =  t - t0;  // time to get lock
 
-    endCt += nCts;
-
-    if( nCts >= bufmax ) {
-        // Keep only newest bufmax-worth.
-        bufhead = 0;
-        buflen  = bufmax;
-        memcpy( &buf[0], &src[SAMPS(nCts-bufmax)], BYTES(bufmax) );
-    }
-    else {
-        // All new data fit, with some room for old data.
-        int newlen  = std::min( buflen + nCts, bufmax ),
-            newhead = (bufhead + buflen + nCts - newlen) % bufmax,
-            oldtail = (bufhead + buflen) % bufmax,
-            ncpy1   = std::min( nCts, bufmax - oldtail );
-
-        memcpy( &buf[SAMPS(oldtail)], &src[0], BYTES(ncpy1) );
-
-        if( nCts -= ncpy1 )
-            memcpy( &buf[0], &src[SAMPS(ncpy1)], BYTES(nCts) );
-
-        bufhead = newhead;
-        buflen  = newlen;
-    }
+    store( src, nCts );
 
     tWork = getTime() - t;  // time for everything else
 }
@@ -394,9 +447,12 @@ void AIQ::enqueueProfile(
 //
 quint64 AIQ::qHeadCt() const
 {
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    return endCt - buflen;
+    snap( S );
+
+    return S.endCt - S.buflen;
 }
 
 
@@ -404,9 +460,7 @@ quint64 AIQ::qHeadCt() const
 //
 quint64 AIQ::endCount() const
 {
-    QMutexLocker    ml( &QMtx );
-
-    return endCt;
+    return endCt.load( std::memory_order_acquire );
 }
 
 
@@ -414,9 +468,38 @@ quint64 AIQ::endCount() const
 //
 double AIQ::endTime() const
 {
-    QMutexLocker    ml( &QMtx );
+    return tzero + endCount() / srate;
+}
+
 
-    return tzero + endCt / srate;
+// Block until a sample with count >= fromCt is published,
+// or timeout_ms elapses. Producers only pay for a wake-up
+// when someone is actually waiting; the seq_cst ordering is
+// all on this (waiter) side. A waiter registering at the very
+// instant a batch is published may miss that wake-up and
+// sleep until the next batch, bounded by timeout_ms.
+//
+// Return true if such data are available.
+//
+bool AIQ::waitForData( quint64 fromCt, int timeout_ms ) const
+{
+    if( endCount() > fromCt )
+        return true;
+
+    QMutexLocker    ml( &waitMtx );
+
+    nWaiters.fetch_add( 1, std::memory_order_seq_cst );
+
+    bool    avail = endCount() > fromCt;
+
+    if( !avail ) {
+        condData.wait( &waitMtx, timeout_ms );
+        avail = endCount() > fromCt;
+    }
+
+    nWaiters.fetch_sub( 1, std::memory_order_relaxed );
+
+    return avail;
 }
 
 
@@ -427,17 +510,20 @@ int AIQ::mapTime2Ct( quint64 &ct, double t ) const
 {
     ct = 0;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    if( t < tzero || !endCt )
+    snap( S );
+
+    if( t < tzero || !S.endCt )
         return -2;
 
     quint64 C = (t - tzero) * srate;
 
-    if( C >= endCt )
+    if( C >= S.endCt )
         return 1;
 
-    if( C < endCt - buflen )
+    if( C < S.endCt - S.buflen )
         return -1;
 
     ct = C;
@@ -453,15 +539,18 @@ int AIQ::mapCt2Time( double &t, quint64 ct ) const
 {
     t = 0;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
+
+    snap( S );
 
-    if( !endCt )
+    if( !S.endCt )
         return -2;
 
-    if( ct >= endCt )
+    if( ct >= S.endCt )
         return 1;
 
-    if( ct < endCt - buflen )
+    if( ct < S.endCt - S.buflen )
         return -1;
 
     t = tzero + ct / srate;
@@ -482,11 +571,14 @@ int AIQ::getNSampsFromCtProfile(
     quint64         fromCt,
     int             nMax ) const
 {
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    quint64 headCt = endCt - buflen;
+    snap( S );
 
-    if( fromCt >= endCt ) {
+    quint64 headCt = S.endCt - S.buflen;
+
+    if( fromCt >= S.endCt ) {
         pctFromLeft = 101.0;
         return 1;
     }
@@ -496,11 +588,12 @@ int AIQ::getNSampsFromCtProfile(
         return -1;
     }
 
-    pctFromLeft = 100.0 * (fromCt - headCt) / buflen;
+    pctFromLeft = 100.0 * (fromCt - headCt) / S.buflen;
 
     int offset  = fromCt - headCt,
-        head    = (bufhead + offset) % bufmax,
-        len     = buflen - offset;
+        head    = (S.bufhead + offset) % bufmax,
+        len     = S.buflen - offset,
+        size0   = dest.size();
 
     nMax = std::min( nMax, len );
 
@@ -511,8 +604,8 @@ int AIQ::getNSampsFromCtProfile(
     try {
         dest.insert(
             dest.end(),
-            buf.begin() + SAMPS(head),
-            buf.begin() + SAMPS(head + nrhs) );
+            buf + SAMPS(head),
+            buf + SAMPS(head + nrhs) );
     }
     catch( const std::exception& ) {
         Warning()
@@ -527,8 +620,8 @@ int AIQ::getNSampsFromCtProfile(
         try {
             dest.insert(
                 dest.end(),
-                buf.begin(),
-                buf.begin() + SAMPS(nMax) );
+                buf,
+                buf + SAMPS(nMax) );
         }
         catch( const std::exception& ) {
             Warning()
@@ -537,6 +630,13 @@ int AIQ::getNSampsFromCtProfile(
         }
     }
 
+// Lapped by producer?
+
+    if( !intact( fromCt ) ) {
+        dest.resize( size0 );
+        return -1;
+    }
+
     return 1;
 }
 
@@ -552,19 +652,23 @@ int AIQ::getNSampsFromCt(
     quint64         fromCt,
     int             nMax ) const
 {
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    quint64 headCt = endCt - buflen;
+    snap( S );
 
-    if( fromCt >= endCt )
+    quint64 headCt = S.endCt - S.buflen;
+
+    if( fromCt >= S.endCt )
         return 1;
 
     if( fromCt < headCt )
         return -1;
 
     int offset  = fromCt - headCt,
-        head    = (bufhead + offset) % bufmax,
-        len     = buflen - offset;
+        head    = (S.bufhead + offset) % bufmax,
+        len     = S.buflen - offset,
+        size0   = dest.size();
 
     nMax = std::min( nMax, len );
 
@@ -575,8 +679,8 @@ int AIQ::getNSampsFromCt(
     try {
         dest.insert(
             dest.end(),
-            buf.begin() + SAMPS(head),
-            buf.begin() + SAMPS(head + nrhs) );
+            buf + SAMPS(head),
+            buf + SAMPS(head + nrhs) );
     }
     catch( const std::exception& ) {
         Warning()
@@ -591,8 +695,8 @@ int AIQ::getNSampsFromCt(
         try {
             dest.insert(
                 dest.end(),
-                buf.begin(),
-                buf.begin() + SAMPS(nMax) );
+                buf,
+                buf + SAMPS(nMax) );
         }
         catch( const std::exception& ) {
             Warning()
@@ -601,6 +705,71 @@ int AIQ::getNSampsFromCt(
         }
     }
 
+// Lapped by producer?
+
+    if( !intact( fromCt ) ) {
+        dest.resize( size0 );
+        return -1;
+    }
+
+    return 1;
+}
+
+
+// Zero-copy: describe up to N samples with count >= fromCt
+// in place. Caller must check V.intact() after consuming V.
+//
+// Return {-1=left of stream, 1=success}.
+//
+int AIQ::getViewFromCt(
+    View            &V,
+    quint64         fromCt,
+    int             nMax,
+    double          *pctFromLeft ) const
+{
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
+
+    snap( S );
+
+    quint64 headCt = S.endCt - S.buflen;
+
+    V           = View();
+    V.Q         = this;
+    V.fromCt    = fromCt;
+    V.nchans    = nchans;
+
+    if( fromCt >= S.endCt ) {
+        if( pctFromLeft )
+            *pctFromLeft = 101.0;
+        return 1;
+    }
+
+    if( fromCt < headCt ) {
+        if( pctFromLeft )
+            *pctFromLeft = -1.0;
+        return -1;
+    }
+
+    if( pctFromLeft )
+        *pctFromLeft = 100.0 * (fromCt - headCt) / S.buflen;
+
+    int offset  = fromCt - headCt,
+        head    = (S.bufhead + offset) % bufmax,
+        len     = S.buflen - offset;
+
+    nMax = std::min( nMax, len );
+
+// Up to RHS limit
+
+    V.src[0]    = &buf[SAMPS(head)];
+    V.ntpts[0]  = std::min( nMax, bufmax - head );
+
+// Any remainder from LHS
+
+    if( (V.ntpts[1] = nMax - V.ntpts[0]) )
+        V.src[1] = &buf[0];
+
     return 1;
 }
 
@@ -619,9 +788,12 @@ qint64 AIQ::getNSampsFromCtMono(
     int             nSamps,
     int             chan ) const
 {
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    quint64 headCt = endCt - buflen;
+    snap( S );
+
+    quint64 headCt = S.endCt - S.buflen;
 
 // Off left end?
 
@@ -631,8 +803,8 @@ qint64 AIQ::getNSampsFromCtMono(
 // Enough samples available?
 
     int offset  = fromCt - headCt,
-        head    = (bufhead + offset) % bufmax,
-        len     = buflen - offset;
+        head    = (S.bufhead + offset) % bufmax,
+        len     = S.buflen - offset;
 
     if( len < nSamps )
         return -1;
@@ -652,6 +824,11 @@ qint64 AIQ::getNSampsFromCtMono(
     for( int i = nrhs; i < nSamps; ++i, src += nchans )
         dst[i] = *src;
 
+// Lapped by producer?
+
+    if( !intact( fromCt ) )
+        return -1;
+
     return fromCt;
 }
 
@@ -671,9 +848,12 @@ qint64 AIQ::getNSampsFromCtStereo(
     int             chan1,
     int             chan2 ) const
 {
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
+
+    snap( S );
 
-    quint64 headCt = endCt - buflen;
+    quint64 headCt = S.endCt - S.buflen;
 
 // Off left end?
 
@@ -683,8 +863,8 @@ qint64 AIQ::getNSampsFromCtStereo(
 // Enough samples available?
 
     int offset  = fromCt - headCt,
-        head    = (bufhead + offset) % bufmax,
-        len     = buflen - offset;
+        head    = (S.bufhead + offset) % bufmax,
+        len     = S.buflen - offset;
 
     if( len < nSamps )
         return -1;
@@ -711,6 +891,11 @@ qint64 AIQ::getNSampsFromCtStereo(
         dst[i+1] = src[chan2];
     }
 
+// Lapped by producer?
+
+    if( !intact( fromCt ) )
+        return -1;
+
     return fromCt;
 }
 
@@ -781,11 +966,14 @@ bool AIQ::findRisingEdge(
 
     outCt = fromCt;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
+
+    snap( S );
 
-    RingWalker  W( buf, bufmax, bufhead, buflen, nchans, chan );
+    RingWalker  W( buf, bufmax, S.bufhead, S.buflen, nchans, chan );
 
-    if( !W.setStart( fromCt, endCt ) )
+    if( !W.setStart( fromCt, S.endCt ) )
         return false;
 
 // -------------------
@@ -817,7 +1005,7 @@ seek_edge:
             nok     = 1;
 
             if( inarow == 1 )
-                return true;
+                return scanIntact( outCt, W.startCt() );
 
             // Check extended run length
             while( W.next() ) {
@@ -825,7 +1013,7 @@ seek_edge:
                 if( *W.cur >= T ) {
 
                     if( ++nok >= inarow )
-                        return true;
+                        return scanIntact( outCt, W.startCt() );
                 }
                 else {
                     nok = 0;
@@ -848,7 +1036,9 @@ fail:
     if( nok )
         outCt -= 1;
     else
-        outCt = endCt - 1;
+        outCt = S.endCt - 1;
+
+    scanIntact( outCt, W.startCt() );
 
     return false;
 }
@@ -875,11 +1065,14 @@ bool AIQ::findFltRisingEdge(
 
     outCt = fromCt;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
+
+    snap( S );
 
-    RingFltWalker  W( buf, bufmax, bufhead, buflen, nchans, usrFlt );
+    RingFltWalker  W( buf, bufmax, S.bufhead, S.buflen, nchans, usrFlt );
 
-    if( !W.setStart( fromCt, endCt ) )
+    if( !W.setStart( fromCt, S.endCt ) )
         return false;
 
 // -------------------
@@ -911,7 +1104,7 @@ seek_edge:
             nok     = 1;
 
             if( inarow == 1 )
-                return true;
+                return scanIntact( outCt, W.startCt() );
 
             // Check extended run length
             while( W.next() ) {
@@ -919,7 +1112,7 @@ seek_edge:
                 if( *W.cur >= T ) {
 
                     if( ++nok >= inarow )
-                        return true;
+                        return scanIntact( outCt, W.startCt() );
                 }
                 else {
                     nok = 0;
@@ -942,7 +1135,9 @@ fail:
     if( nok )
         outCt -= 1;
     else
-        outCt = endCt - 1;
+        outCt = S.endCt - 1;
+
+    scanIntact( outCt, W.startCt() );
 
     return false;
 }
@@ -969,11 +1164,14 @@ bool AIQ::findBitRisingEdge(
 
     outCt = fromCt;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    RingWalker  W( buf, bufmax, bufhead, buflen, nchans, chan );
+    snap( S );
 
-    if( !W.setStart( fromCt, endCt ) )
+    RingWalker  W( buf, bufmax, S.bufhead, S.buflen, nchans, chan );
+
+    if( !W.setStart( fromCt, S.endCt ) )
         return false;
 
 // -------------------
@@ -1005,7 +1203,7 @@ seek_edge:
             nok     = 1;
 
             if( inarow == 1 )
-                return true;
+                return scanIntact( outCt, W.startCt() );
 
             // Check extended run length
             while( W.next() ) {
@@ -1013,7 +1211,7 @@ seek_edge:
                 if( (*W.cur >> bit) & 1 ) {
 
                     if( ++nok >= inarow )
-                        return true;
+                        return scanIntact( outCt, W.startCt() );
                 }
                 else {
                     nok = 0;
@@ -1036,7 +1234,9 @@ fail:
     if( nok )
         outCt -= 1;
     else
-        outCt = endCt - 1;
+        outCt = S.endCt - 1;
+
+    scanIntact( outCt, W.startCt() );
 
     return false;
 }
@@ -1061,11 +1261,14 @@ bool AIQ::findFallingEdge(
 
     outCt = fromCt;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    RingWalker  W( buf, bufmax, bufhead, buflen, nchans, chan );
+    snap( S );
 
-    if( !W.setStart( fromCt, endCt ) )
+    RingWalker  W( buf, bufmax, S.bufhead, S.buflen, nchans, chan );
+
+    if( !W.setStart( fromCt, S.endCt ) )
         return false;
 
 // --------------------
@@ -1097,7 +1300,7 @@ seek_edge:
             nok     = 1;
 
             if( inarow == 1 )
-                return true;
+                return scanIntact( outCt, W.startCt() );
 
             // Check extended run length
             while( W.next() ) {
@@ -1105,7 +1308,7 @@ seek_edge:
                 if( *W.cur < T ) {
 
                     if( ++nok >= inarow )
-                        return true;
+                        return scanIntact( outCt, W.startCt() );
                 }
                 else {
                     nok = 0;
@@ -1128,7 +1331,9 @@ fail:
     if( nok )
         outCt -= 1;
     else
-        outCt = endCt - 1;
+        outCt = S.endCt - 1;
+
+    scanIntact( outCt, W.startCt() );
 
     return false;
 }
@@ -1155,11 +1360,14 @@ bool AIQ::findFltFallingEdge(
 
     outCt = fromCt;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
 
-    RingFltWalker  W( buf, bufmax, bufhead, buflen, nchans, usrFlt );
+    snap( S );
 
-    if( !W.setStart( fromCt, endCt ) )
+    RingFltWalker  W( buf, bufmax, S.bufhead, S.buflen, nchans, usrFlt );
+
+    if( !W.setStart( fromCt, S.endCt ) )
         return false;
 
 // --------------------
@@ -1191,7 +1399,7 @@ seek_edge:
             nok     = 1;
 
             if( inarow == 1 )
-                return true;
+                return scanIntact( outCt, W.startCt() );
 
             // Check extended run length
             while( W.next() ) {
@@ -1199,7 +1407,7 @@ seek_edge:
                 if( *W.cur < T ) {
 
                     if( ++nok >= inarow )
-                        return true;
+                        return scanIntact( outCt, W.startCt() );
                 }
                 else {
                     nok = 0;
@@ -1222,7 +1430,9 @@ fail:
     if( nok )
         outCt -= 1;
     else
-        outCt = endCt - 1;
+        outCt = S.endCt - 1;
+
+    scanIntact( outCt, W.startCt() );
 
     return false;
 }
@@ -1249,11 +1459,14 @@ bool AIQ::findBitFallingEdge(
 
     outCt = fromCt;
 
-    QMutexLocker    ml( &QMtx );
+    QMutexLocker    ml( lockFree ? 0 : &QMtx );
+    Snap            S;
+
+    snap( S );
 
-    RingWalker  W( buf, bufmax, bufhead, buflen, nchans, chan );
+    RingWalker  W( buf, bufmax, S.bufhead, S.buflen, nchans, chan );
 
-    if( !W.setStart( fromCt, endCt ) )
+    if( !W.setStart( fromCt, S.endCt ) )
         return false;
 
 // --------------------
@@ -1285,7 +1498,7 @@ seek_edge:
             nok     = 1;
 
             if( inarow == 1 )
-                return true;
+                return scanIntact( outCt, W.startCt() );
 
             // Check extended run length
             while( W.next() ) {
@@ -1293,7 +1506,7 @@ seek_edge:
                 if( !((*W.cur >> bit) & 1) ) {
 
                     if( ++nok >= inarow )
-                        return true;
+                        return scanIntact( outCt, W.startCt() );
                 }
                 else {
                     nok = 0;
@@ -1316,9 +1529,138 @@ fail:
     if( nok )
         outCt -= 1;
     else
-        outCt = endCt - 1;
+        outCt = S.endCt - 1;
+
+    scanIntact( outCt, W.startCt() );
 
     return false;
 }
 
 
+// Producer side of enqueue; caller holds QMtx if locked mode.
+//
+void AIQ::store( const qint16 *src, int nCts )
+{
+    quint64         ct0     = endCt.load( std::memory_order_relaxed );
+    const qint16    *src0   = src;
+
+    wrBegin( nCts );
+
+    if( nCts >= bufmax ) {
+        // Keep only newest bufmax-worth.
+        bufhead = (endCt.load( std::memory_order_relaxed ) + nCts) % bufmax;
+        buflen  = bufmax;
+
+        int ncpy1 = bufmax - bufhead;
+
+        src += SAMPS(nCts - bufmax);
+        memcpy( &buf[SAMPS(bufhead)], &src[0], BYTES(ncpy1) );
+
+        if( bufhead )
+            memcpy( &buf[0], &src[SAMPS(ncpy1)], BYTES(bufhead) );
+    }
+    else {
+        // All new data fit, with some room for old data.
+        int newlen  = std::min( buflen + nCts, bufmax ),
+            newhead = (bufhead + buflen + nCts - newlen) % bufmax,
+            oldtail = (bufhead + buflen) % bufmax,
+            ncpy1   = std::min( nCts, bufmax - oldtail );
+
+        memcpy( &buf[SAMPS(oldtail)], &src[0], BYTES(ncpy1) );
+
+        if( nCts - ncpy1 )
+            memcpy( &buf[0], &src[SAMPS(ncpy1)], BYTES(nCts - ncpy1) );
+
+        bufhead = newhead;
+        buflen  = newlen;
+    }
+
+// Index sync edges before publishing, so any reader that
+// sees these samples also finds their edges.
+
+    if( sidx )
+        sidx->update( src0, nCts, nchans, ct0 );
+
+    wrEnd( nCts );
+}
+
+
+// Announce span about to be overwritten before touching
+// any ring data. Consulted by lock-free readers, by
+// zero-copy views in either mode, and by shm readers.
+//
+void AIQ::wrBegin( int nCts )
+{
+    quint64 w = endCt.load( std::memory_order_relaxed ) + nCts;
+
+    wrCt.store( w, std::memory_order_relaxed );
+
+    if( shm )
+        shm->header()->wrCt.store( w, std::memory_order_relaxed );
+
+    std::atomic_thread_fence( std::memory_order_release );
+}
+
+
+// Publish new data and wake any waitForData() callers.
+//
+void AIQ::wrEnd( int nCts )
+{
+    quint64 e = endCt.load( std::memory_order_relaxed ) + nCts;
+
+    if( shm )
+        shm->header()->endCt.store( e, std::memory_order_release );
+
+    endCt.store( e, std::memory_order_release );
+
+    if( nWaiters.load( std::memory_order_seq_cst ) ) {
+        QMutexLocker    ml( &waitMtx );
+        condData.wakeAll();
+    }
+}
+
+
+// Locked mode: caller holds QMtx.
+// Lock-free: derive layout from published endCt.
+//
+void AIQ::snap( Snap &S ) const
+{
+    if( lockFree ) {
+        S.endCt     = endCt.load( std::memory_order_acquire );
+        S.buflen    = std::min( S.endCt, quint64(bufmax) );
+        S.bufhead   = (S.endCt - S.buflen) % bufmax;
+    }
+    else {
+        S.endCt     = endCt.load( std::memory_order_relaxed );
+        S.bufhead   = bufhead;
+        S.buflen    = buflen;
+    }
+}
+
+
+// True if samples >= fromCt that a reader accessed without
+// holding QMtx (lock-free reads, views) have not since been
+// overwritten by the producer.
+//
+bool AIQ::intact( quint64 fromCt ) const
+{
+    std::atomic_thread_fence( std::memory_order_acquire );
+
+    quint64 w = wrCt.load( std::memory_order_relaxed );
+
+    return w <= quint64(bufmax) || fromCt >= w - bufmax;
+}
+
+
+// Edge scans: if scanned samples were overwritten,
+// report no edge and resume from startCt, which the
+// next scan clamps to the new head.
+//
+bool AIQ::scanIntact( quint64 &outCt, quint64 startCt ) const
+{
+    if( intact( startCt ) )
+        return true;
+
+    outCt = startCt;
+    return false;
+}
@@ -8,6 +8,12 @@
 #include "SGLTypes.h"
 
 #include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+
+class AIQShm;
+class SyncEdgeIdx;
 
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
@@ -34,41 +40,96 @@ public:
         virtual void operator()( int nflt ) = 0;
     };
 
+    // Zero-copy read access to the ring.
+    // A view spans up to two runs of whole timepoints,
+    // either side of the wrap. Data are read in place,
+    // so after consuming a view, call intact() to check
+    // the producer didn't overwrite it in the meantime.
+    struct View {
+        const AIQ       *Q;
+        const qint16    *src[2];
+        quint64         fromCt;
+        int             ntpts[2],
+                        nchans;
+
+        View() : Q(0), fromCt(0), nchans(0)
+            {src[0]=src[1]=0; ntpts[0]=ntpts[1]=0;}
+
+        int nTpts() const   {return ntpts[0] + ntpts[1];}
+        const qint16 *tpt( int it ) const
+            {
+                return (it < ntpts[0] ?
+                        src[0] + it * nchans :
+                        src[1] + (it - ntpts[0]) * nchans);
+            }
+        bool intact() const {return !Q || Q->intact( fromCt );}
+    };
+
+private:
+    // Ring state as seen by a reader.
+    // Invariant: bufhead == (endCt - buflen) % bufmax.
+    struct Snap {
+        quint64 endCt;
+        int     bufhead,
+                buflen;
+    };
+
 /* ---- */
 /* Data */
 /* ---- */
 
 private:
-    const double    srate;
-    const int       nchans,
-                    bufmax;
-    vec_i16         buf;
-    mutable QMutex  QMtx,
-                    qfMtx;
-    mutable double  tzero;
-    quint64         endCt;
-    int             bufhead,
-                    buflen;
-    mutable uint    clients;
+    const double            srate;
+    const int               nchans,
+                            bufmax;
+    vec_i16                 bufStore;   // private ring
+    qint16                  *buf;       // bufStore or shared memory
+    AIQShm                  *shm;
+    SyncEdgeIdx             *sidx;      // optional
+    mutable QMutex          QMtx,
+                            qfMtx,
+                            waitMtx;
+    mutable QWaitCondition  condData;
+    mutable double          tzero;
+    std::atomic<quint64>    endCt,      // published count
+                            wrCt;       // count being written
+    int                     bufhead,    // producer's copy
+                            buflen;     // producer's copy
+    mutable std::atomic<int> nWaiters;  // waitForData() callers
+    mutable uint            clients;
+    const bool              lockFree;
 
 /* ------- */
 /* Methods */
 /* ------- */
 
 public:
-    AIQ( double srate, int nchans, double capacitySecs );
+    AIQ(
+        double  srate,
+        int     nchans,
+        double  capacitySecs,
+        bool    lockFree = false );
+    virtual ~AIQ();
 
     double sRate() const                {return srate;}
     double chanRate() const             {return nchans * srate;}
     int nChans() const                  {return nchans;}
+    bool isLockFree() const             {return lockFree;}
 
-    void setTZero( double t0 ) const    {tzero = t0;}
+    bool shmExport( const QString &name );
+    bool isShmExported() const          {return shm != 0;}
+
+    void setSyncIdx( SyncEdgeIdx *X );
+    const SyncEdgeIdx *syncIdx() const  {return sidx;}
+
+    void setTZero( double t0 ) const;
     double tZero() const                {return tzero;}
 
     void qf_audioClient( bool on ) const;
     void qf_shankClient( bool on ) const;
     void qf_spikeClient( bool on ) const;
     void qf_remoteClient( bool on ) const;
+    void qf_detectClient( bool on ) const;
     bool qf_isClient() const;
 
     void enqueueZero( double t0, double tLim );
@@ -85,6 +146,7 @@ public:
     quint64 qHeadCt() const;
     quint64 endCount() const;
     double endTime() const;
+    bool waitForData( quint64 fromCt, int timeout_ms ) const;
     int mapTime2Ct( quint64 &ct, double t ) const;
     int mapCt2Time( double &t, quint64 ct ) const;
 
@@ -99,6 +161,12 @@ public:
         quint64         fromCt,
         int             nMax ) const;
 
+    int getViewFromCt(
+        View            &V,
+        quint64         fromCt,
+        int             nMax,
+        double          *pctFromLeft = 0 ) const;
+
     qint64 getNSampsFromCtMono(
         qint16          *dst,
         quint64         fromCt,
@@ -164,6 +232,14 @@ public:
         int             chan,
         int             bit,
         int             inarow ) const;
+
+private:
+    void store( const qint16 *src, int nCts );
+    void wrBegin( int nCts );
+    void wrEnd( int nCts );
+    void snap( Snap &S ) const;
+    bool intact( quint64 fromCt ) const;
+    bool scanIntact( quint64 &outCt, quint64 startCt ) const;
 };
 
 #endif  // AIQ_H
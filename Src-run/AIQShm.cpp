@@ -0,0 +1,143 @@
+#include "AIQShm.h"
+#include "Util.h"
+
+#ifdef Q_OS_WIN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <errno.h>
+    #include <string.h>
+#endif
+
+#include <new>
+
+
+// Header padded to a page so the ring is page aligned.
+//
+#define HDRBYTES    4096
+
+/* ---------------------------------------------------------------- */
+/* AIQShm --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool AIQShm::create(
+    const QString   &name,
+    double          srate,
+    int             nchans,
+    int             bufmax )
+{
+    destroy();
+
+    this->name  = name;
+    bytes       = HDRBYTES + size_t(nchans) * bufmax * sizeof(qint16);
+
+    void    *base = 0;
+
+#ifdef Q_OS_WIN
+    QString wname = QString("Local\\%1").arg( name );
+
+    hMap = CreateFileMappingW(
+            INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            DWORD(quint64(bytes) >> 32), DWORD(bytes & 0xFFFFFFFF),
+            (LPCWSTR)wname.utf16() );
+
+    if( !hMap ) {
+        Error() <<
+            QString("AIQShm: CreateFileMapping '%1' failed [%2].")
+            .arg( wname ).arg( GetLastError() );
+        return false;
+    }
+
+    base = MapViewOfFile( hMap, FILE_MAP_ALL_ACCESS, 0, 0, bytes );
+
+    if( !base ) {
+        Error() <<
+            QString("AIQShm: MapViewOfFile '%1' failed [%2].")
+            .arg( wname ).arg( GetLastError() );
+        CloseHandle( hMap );
+        hMap = 0;
+        return false;
+    }
+#else
+    QByteArray  pname = QString("/%1").arg( name ).toLatin1();
+
+    // Remove any stale segment left by a crashed run.
+    shm_unlink( pname.constData() );
+
+    int fd = shm_open( pname.constData(), O_CREAT | O_EXCL | O_RDWR, 0644 );
+
+    if( fd < 0 ) {
+        Error() <<
+            QString("AIQShm: shm_open '%1' failed [%2].")
+            .arg( QString(pname) ).arg( strerror( errno ) );
+        return false;
+    }
+
+    if( ftruncate( fd, bytes ) != 0 ) {
+        Error() <<
+            QString("AIQShm: ftruncate '%1' failed [%2].")
+            .arg( QString(pname) ).arg( strerror( errno ) );
+        close( fd );
+        shm_unlink( pname.constData() );
+        return false;
+    }
+
+    base = mmap( 0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+
+    if( base == MAP_FAILED ) {
+        Error() <<
+            QString("AIQShm: mmap '%1' failed [%2].")
+            .arg( QString(pname) ).arg( strerror( errno ) );
+        shm_unlink( pname.constData() );
+        return false;
+    }
+#endif
+
+// Publish header; endCt goes live last
+
+    hdr = new (base) AIQShmHdr;
+
+    hdr->version    = AIQSHM_VERSION;
+    hdr->hdrBytes   = HDRBYTES;
+    hdr->nchans     = nchans;
+    hdr->bufmax     = bufmax;
+    hdr->live       = 1;
+    hdr->srate      = srate;
+    hdr->tzero      = 0;
+    hdr->wrCt.store( 0, std::memory_order_relaxed );
+    hdr->endCt.store( 0, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    hdr->magic      = AIQSHM_MAGIC;
+
+    Log() <<
+        QString("AIQShm: Exporting '%1' (%2 MB).")
+        .arg( name ).arg( bytes / (1024*1024) );
+
+    return true;
+}
+
+
+void AIQShm::destroy()
+{
+    if( !hdr )
+        return;
+
+    hdr->live = 0;
+    std::atomic_thread_fence( std::memory_order_release );
+
+#ifdef Q_OS_WIN
+    UnmapViewOfFile( hdr );
+    CloseHandle( hMap );
+    hMap = 0;
+#else
+    munmap( hdr, bytes );
+    shm_unlink( QString("/%1").arg( name ).toLatin1().constData() );
+#endif
+
+    hdr     = 0;
+    bytes   = 0;
+}
@@ -0,0 +1,39 @@
+#ifndef AIQSHM_H
+#define AIQSHM_H
+
+#include "AIQShmHdr.h"
+
+#include <QString>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Owner (writer) side of a shared-memory AIQ export.
+// POSIX shm_open/mmap on Unix, named file mapping on Windows.
+// The mapping is removed when this object is destroyed.
+//
+class AIQShm
+{
+private:
+    QString     name;
+    AIQShmHdr   *hdr;
+    size_t      bytes;
+    void        *hMap;  // Windows mapping handle
+
+public:
+    AIQShm() : hdr(0), bytes(0), hMap(0)    {}
+    virtual ~AIQShm()                       {destroy();}
+
+    bool create(
+        const QString   &name,
+        double          srate,
+        int             nchans,
+        int             bufmax );
+    void destroy();
+
+    AIQShmHdr *header()     {return hdr;}
+    qint16 *ring()          {return (qint16*)((char*)hdr + hdr->hdrBytes);}
+};
+
+#endif  // AIQSHM_H
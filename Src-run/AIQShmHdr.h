@@ -0,0 +1,47 @@
+#ifndef AIQSHMHDR_H
+#define AIQSHMHDR_H
+
+// Layout of an AIQ ring exported to shared memory.
+// Self-contained (no Qt) so local client programs
+// can include it as is.
+//
+// Naming:
+// POSIX:   "/SpikeGLX_<stream>", e.g. /SpikeGLX_imQ0, /SpikeGLX_imQf0,
+//          /SpikeGLX_obQ0, /SpikeGLX_niQ.
+// Windows: "Local\SpikeGLX_<stream>".
+//
+// The ring begins hdrBytes past the header and holds bufmax
+// whole timepoints of nchans interleaved int16 samples. The
+// timepoint with count ct lives at ring index (ct % bufmax).
+//
+// Reader protocol (seqlock-style, never blocks the writer):
+// (1) e = endCt.load( acquire ); valid counts: [max(0,e-bufmax), e).
+// (2) Copy (or consume in place) the timepoints wanted.
+// (3) atomic_thread_fence( acquire ); w = wrCt.load( relaxed ).
+// (4) Data with count >= fromCt are good iff
+//     w <= bufmax || fromCt >= w - bufmax; else retry further right.
+//
+
+#include <atomic>
+#include <stdint.h>
+
+#define AIQSHM_MAGIC    0x514C4753  // "SGLQ"
+#define AIQSHM_VERSION  1
+
+struct AIQShmHdr {
+    uint32_t                magic,
+                            version,
+                            hdrBytes,   // offset to ring
+                            nchans,
+                            bufmax,     // ring capacity (timepoints)
+                            live;       // 0 after writer detaches
+    double                  srate,
+                            tzero;      // stream wall time at count 0
+    std::atomic<uint64_t>   endCt,      // published count
+                            wrCt;       // count being written
+
+    const int16_t *ring() const
+        {return (const int16_t*)((const char*)this + hdrBytes);}
+};
+
+#endif  // AIQSHMHDR_H
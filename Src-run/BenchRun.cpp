@@ -0,0 +1,339 @@
+
+#include "BenchRun.h"
+#include "Util.h"
+#include "MainApp.h"
+#include "ConfigCtl.h"
+#include "MetricsWindow.h"
+#include "Run.h"
+#include "AIQ.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+
+
+/* ---------------------------------------------------------------- */
+/* BenchCPU ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+QMutex  BenchCPU::mtx;
+double  BenchCPU::secs[BenchCPU::nStages] = {0, 0, 0, 0};
+
+
+// Call as last act of stage thread.
+//
+void BenchCPU::add( Stage s )
+{
+    double  t = getThreadCPUSecs();
+
+    QMutexLocker    ml( &mtx );
+
+    secs[s] += t;
+}
+
+
+void BenchCPU::reset()
+{
+    QMutexLocker    ml( &mtx );
+
+    for( int i = 0; i < nStages; ++i )
+        secs[i] = 0;
+}
+
+
+double BenchCPU::get( Stage s )
+{
+    QMutexLocker    ml( &mtx );
+
+    return secs[s];
+}
+
+
+const char *BenchCPU::name( Stage s )
+{
+    static const char   *nm[nStages] = {"acquire", "trigger", "write", "hash"};
+
+    return nm[s];
+}
+
+/* ---------------------------------------------------------------- */
+/* BenchRun ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+BenchRun::BenchRun()
+    :   QObject(0), secs(60), speed(1), tStart(0), tEnd(0)
+{
+    sampTimer.setInterval( 1000 );
+    ConnectUI( &sampTimer, SIGNAL(timeout()), this, SLOT(sample()) );
+}
+
+
+// Create (B) if command line has -bench[=SECS[,SPEED]],
+// with optional -benchdevs=DEVSTRING.
+//
+bool BenchRun::fromArgs( BenchRun *&B, const QStringList &args )
+{
+    QString sBench, sDevs;
+    bool    isBench = false;
+
+    B = 0;
+
+    for( int i = 1, n = args.size(); i < n; ++i ) {
+
+        const QString   &a = args[i];
+
+        if( a == "-bench" )
+            isBench = true;
+        else if( a.startsWith( "-bench=" ) ) {
+            sBench  = a.mid( 7 );
+            isBench = true;
+        }
+        else if( a.startsWith( "-benchdevs=" ) )
+            sDevs = a.mid( 11 );
+    }
+
+    if( !isBench )
+        return false;
+
+    B = new BenchRun;
+
+    QStringList sl = sBench.split( ",", Qt::SkipEmptyParts );
+
+    if( sl.size() > 0 )
+        B->secs  = qMax( 1.0, sl[0].toDouble() );
+
+    if( sl.size() > 1 )
+        B->speed = qBound( 1.0, sl[1].toDouble(), 100.0 );
+
+    B->devs = sDevs;
+
+    return true;
+}
+
+
+// Select and validate devices as for remote SELECTDEVS,
+// assert bench params and start the run.
+//
+bool BenchRun::start( QString &err )
+{
+    MainApp     *app = mainApp();
+    ConfigCtl   *cfg = app->cfgCtl();
+
+    if( devs.isEmpty() ) {
+        err = "Requires -benchdevs=DEVSTRING, e.g., \"(2,1,1)(2,2,1)\".";
+        return false;
+    }
+
+    Log() << QString("BENCH: selecting devices %1").arg( devs );
+
+    err = cfg->cmdSrvSelectsDevices( devs, 1 );
+    cfg->dialog()->close();
+
+    if( !err.isEmpty() )
+        return false;
+
+    initRun();
+    BenchCPU::reset();
+
+    err = app->remoteStartsRun();
+
+    return err.isEmpty();
+}
+
+
+void BenchRun::started()
+{
+    mainApp()->getRun()->grfHardPause( true );
+
+    getCounts( ct0 );
+    tStart = getTime();
+
+    sampTimer.start();
+    QTimer::singleShot( int(1000 * secs), this, SLOT(timesUp()) );
+
+    Log() <<
+        QString("BENCH: running %1 s at %2x real time...")
+        .arg( secs ).arg( speed );
+}
+
+
+void BenchRun::finish()
+{
+    MainApp *app = mainApp();
+    QString rpt  = report();
+
+    sampTimer.stop();
+
+    foreach( const QString &s, rpt.split( "\n", Qt::SkipEmptyParts ) )
+        Log() << s;
+
+    QFile   f( QString("%1/%2.bench.txt")
+                .arg( app->dataDir() ).arg( runName ) );
+
+    if( f.open( QIODevice::WriteOnly | QIODevice::Text ) ) {
+        QTextStream ts( &f );
+        ts << rpt;
+    }
+    else
+        Warning() << "BENCH: Can't write report " << f.fileName();
+
+    app->cfgCtl()->setParams( oldParams, true );
+    app->runBenchFinished();
+}
+
+
+// Skip first two seconds of file creation and startup.
+// Counts are also taken here in case the run stops early.
+//
+void BenchRun::sample()
+{
+    double  t = getTime();
+
+    if( t - tStart < 2.0 )
+        return;
+
+    MetricsWindow   *mx = mainApp()->metrics();
+
+    wrMBps.add( mx->getWrMBps() );
+    qFill.add( mx->getMaxFull() );
+
+    getCounts( ct1 );
+    tEnd = t;
+}
+
+
+void BenchRun::timesUp()
+{
+    sample();
+    sampTimer.stop();
+
+    mainApp()->remoteStopsRun();
+}
+
+
+// Assert run parameters for benchmarking.
+//
+void BenchRun::initRun()
+{
+    ConfigCtl   *cfg = mainApp()->cfgCtl();
+    DAQ::Params p;
+    QDateTime   tCreate( QDateTime::currentDateTime() );
+
+    p = oldParams = cfg->acceptedParams;
+
+    p.mode.mGate            = DAQ::eGateImmed;
+    p.mode.mTrig            = DAQ::eTrigImmed;
+    p.mode.manOvShowBut     = false;
+    p.mode.manOvInitOff     = false;
+    p.sync.isCalRun         = false;
+    p.im.prbAll.isSvyRun    = false;
+    p.perf.simSpeed         = speed;
+
+    p.sns.notes     =
+        QString("Benchmark %1 s at %2x real time").arg( secs ).arg( speed );
+    p.sns.runName   = runName =
+        QString("Bench_%1")
+        .arg( dateTime2Str( tCreate, Qt::ISODate ).replace( ":", "." ) );
+    p.sns.fldPerPrb = false;
+
+    cfg->setParams( p, false );
+}
+
+
+void BenchRun::getCounts( QMap<QString,quint64> &ct )
+{
+    const DAQ::Params   &p      = mainApp()->cfgCtl()->acceptedParams;
+    Run                 *run    = mainApp()->getRun();
+
+    for( int iq = 0, nq = p.stream_nq(); iq < nq; ++iq ) {
+
+        int         ip,
+                    js  = p.iq2jsip( ip, iq );
+        const AIQ   *Q  = run->getQ( js, ip );
+
+        if( Q ) {
+            QString stream      = p.jsip2stream( js, ip );
+            ct[stream]          = Q->endCount();
+            bytesPerCt[stream]  = Q->nChans() * sizeof(qint16);
+        }
+    }
+}
+
+
+QString BenchRun::report() const
+{
+    QString     s;
+    QTextStream ts( &s );
+    double      el = tEnd - tStart;
+
+    ts << QString("BENCH %1: %2 s at %3x real time, %4 streams\n")
+            .arg( runName ).arg( el, 0, 'f', 1 ).arg( speed )
+            .arg( ct1.size() );
+
+    if( el <= 0 ) {
+        ts << "  Run ended before first sample.\n";
+        return s;
+    }
+
+// Generated
+
+    double  sumMB = 0;
+
+    QMap<QString,quint64>::const_iterator   it, end = ct1.end();
+
+    for( it = ct1.begin(); it != end; ++it ) {
+
+        double  MB = (it.value() - ct0.value( it.key() ))
+                        * bytesPerCt.value( it.key() ) / (1024.0 * 1024.0);
+
+        ts << QString("  %1 generated MB/s %2\n")
+                .arg( it.key() ).arg( MB / el, 0, 'f', 2 );
+
+        sumMB += MB;
+    }
+
+    ts << QString("  Total generated MB/s %1\n").arg( sumMB / el, 0, 'f', 2 );
+
+// Written
+
+    ts << QString("  Written MB/s ave %1 peak %2\n")
+            .arg( wrMBps.ave(), 0, 'f', 2 )
+            .arg( wrMBps.max, 0, 'f', 2 );
+
+    ts << QString("  Writer queue fill % ave %1 max %2\n")
+            .arg( qFill.ave(), 0, 'f', 1 )
+            .arg( qFill.max, 0, 'f', 1 );
+
+// Fetch loop
+
+    QMap<QString,MetricsWindow::MXLoopStat> L =
+        mainApp()->metrics()->getLoopStats();
+
+    QMap<QString,MetricsWindow::MXLoopStat>::const_iterator il, lend = L.end();
+
+    for( il = L.begin(); il != lend; ++il ) {
+
+        ts << QString("  %1 fetch loop ms ave %2 sd %3 max %4\n")
+                .arg( il.key() )
+                .arg( il.value().aveMs, 0, 'f', 3 )
+                .arg( il.value().sdMs, 0, 'f', 3 )
+                .arg( il.value().maxMs, 0, 'f', 3 );
+    }
+
+// CPU
+
+    for( int i = 0; i < BenchCPU::nStages; ++i ) {
+
+        BenchCPU::Stage stg = BenchCPU::Stage(i);
+        double          cpu = BenchCPU::get( stg );
+
+        ts << QString("  CPU %1 s %2 (%3% of one core)\n")
+                .arg( BenchCPU::name( stg ) )
+                .arg( cpu, 0, 'f', 2 )
+                .arg( 100 * cpu / el, 0, 'f', 1 );
+    }
+
+    return s;
+}
+
+
@@ -0,0 +1,111 @@
+#ifndef BENCHRUN_H
+#define BENCHRUN_H
+
+#include "DAQ.h"
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QTimer>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// CPU seconds used by each pipeline stage, summed over the
+// stage's threads as each exits (see getThreadCPUSecs()).
+//
+class BenchCPU
+{
+public:
+    enum Stage {
+        acq     = 0,    // fetch : scale : enqueue
+        trig    = 1,    // trigger readers
+        write   = 2,    // DFWriter
+        hash    = 3,    // DFHasher
+        nStages = 4
+    };
+
+private:
+    static QMutex   mtx;
+    static double   secs[nStages];
+
+public:
+    static void add( Stage s );
+    static void reset();
+    static double get( Stage s );
+    static const char *name( Stage s );
+};
+
+
+// Headless recording benchmark.
+//
+// Launch: SpikeGLX -bench=SECS[,SPEED] -benchdevs=DEVSTRING
+//
+// DEVSTRING selects devices as for remote SELECTDEVS, e.g.,
+// "(2,1,1)(2,2,1)(2,3,1)" for three probes in slot 2. Enable
+// simulated probes at those addresses beforehand using the
+// Configure/IM Setup simulated probes dialog, or run a build
+// without HAVE_IMEC. SPEED > 1 generates samples faster than
+// real time.
+//
+// Runs SECS seconds with immediate gate and trigger, recording
+// on, and graph fetching paused, so the measured load is the
+// acquisition -> AIQ -> trigger -> writer chain. The report
+// (Log and <dataDir>/<runName>.bench.txt) gives generated and
+// written MB/s, writer queue fill, fetch-loop jitter and CPU
+// time per stage. Then the app quits.
+//
+class BenchRun : public QObject
+{
+    Q_OBJECT
+
+private:
+    struct Fill {
+        double  sum,
+                max;
+        int     n;
+        Fill() : sum(0), max(0), n(0)   {}
+        void add( double v )
+            {sum += v; if( v > max ) max = v; ++n;}
+        double ave() const  {return (n ? sum / n : 0);}
+    };
+
+    DAQ::Params             oldParams;
+    QString                 devs,
+                            runName;
+    QTimer                  sampTimer;
+    QMap<QString,quint64>   ct0,
+                            ct1;
+    QMap<QString,double>    bytesPerCt;
+    Fill                    wrMBps,
+                            qFill;
+    double                  secs,
+                            speed,
+                            tStart,
+                            tEnd;
+
+public:
+    BenchRun();
+
+    static bool fromArgs( BenchRun *&B, const QStringList &args );
+
+    bool start( QString &err );
+    void started();
+
+public slots:
+    void finish();
+
+private slots:
+    void sample();
+    void timesUp();
+
+private:
+    void initRun();
+    void getCounts( QMap<QString,quint64> &ct );
+    QString report() const;
+};
+
+#endif  // BENCHRUN_H
+
+
@@ -6,6 +6,7 @@
 #include "DataFileIMAP.h"
 #include "DataFileNI.h"
 #include "DataFileOB.h"
+#include "DFSyncEdges.h"
 
 #include <QMessageBox>
 #include <QProgressDialog>
@@ -13,6 +14,8 @@
 
 #include <math.h>
 
+#include <thread>
+
 
 //#define EDGEFILES
 
@@ -81,62 +84,86 @@ QString CalSRStream::remark() const
 
 void CalSRWorker::run()
 {
-    int nIM = (int)vIM.size(),
-        nOB = (int)vOB.size(),
-        nNI = (int)vNI.size();
+    for( int is = 0, ns = (int)vIM.size(); is < ns; ++is )
+        vJob.push_back( &vIM[is] );
 
-    pctCum = 0;
-    pctMax = 10*(nIM + nOB + nNI);
-    pctRpt = 0;
+    for( int is = 0, ns = (int)vOB.size(); is < ns; ++is )
+        vJob.push_back( &vOB[is] );
 
-    for( int is = 0; is < nIM; ++is ) {
+    for( int is = 0, ns = (int)vNI.size(); is < ns; ++is )
+        vJob.push_back( &vNI[is] );
 
-        calcRateIM( vIM[is] );
+    int nJob = (int)vJob.size();
 
-        if( isCanceled() )
-            goto exit;
+    vTenth.assign( nJob, 0 );
+    iNext   = 0;
+    pctMax  = 10*qMax( nJob, 1 );
+    pctRpt  = 0;
 
-        reportTenth( 10 );
-        pctCum += 10;
-    }
+// Helpers share the job list with this thread
 
-    if( isCanceled() )
-        goto exit;
+    std::vector<std::thread>    vT;
+    int                         nThd = qMin( nJob, QThread::idealThreadCount() );
 
-    for( int is = 0; is < nOB; ++is ) {
+    for( int it = 1; it < nThd; ++it )
+        vT.push_back( std::thread( &CalSRWorker::runJobs, this ) );
 
-        calcRateOB( vOB[is] );
+    runJobs();
 
-        if( isCanceled() )
-            goto exit;
+    for( int it = 0, nt = (int)vT.size(); it < nt; ++it )
+        vT[it].join();
 
-        reportTenth( 10 );
-        pctCum += 10;
-    }
+    reportTenth( -1, pctMax );
+    emit finished();
+}
 
-    if( isCanceled() )
-        goto exit;
 
-    for( int is = 0; is < nNI; ++is ) {
+void CalSRWorker::runJobs()
+{
+    for(;;) {
 
-        calcRateNI( vNI[is] );
+        runMtx.lock();
 
-        if( isCanceled() )
-            goto exit;
+            if( _cancel || iNext >= (int)vJob.size() ) {
+                runMtx.unlock();
+                break;
+            }
 
-        reportTenth( 10 );
-        pctCum += 10;
-    }
+            int ij = iNext++;
 
-exit:
-    reportTenth( pctMax );
-    emit finished();
+        runMtx.unlock();
+
+        CalSRStream &S = *vJob[ij];
+
+        switch( S.js ) {
+            case jsIM: calcRateIM( S, ij ); break;
+            case jsOB: calcRateOB( S, ij ); break;
+            default:   calcRateNI( S, ij );
+        }
+
+        reportTenth( ij, 10 );
+    }
 }
 
 
-void CalSRWorker::reportTenth( int tenth )
+// Set job (ij) progress in tenths, or if (ij) < 0,
+// just add (tenth) to the total.
+//
+void CalSRWorker::reportTenth( int ij, int tenth )
 {
-    int pct = qMin( 100.0, 100.0 * (pctCum + tenth) / pctMax );
+    QMutexLocker    ml( &runMtx );
+
+    int sum = 0;
+
+    if( ij >= 0 )
+        vTenth[ij] = qMin( tenth, 10 );
+    else
+        sum = tenth;
+
+    for( int i = 0, n = (int)vTenth.size(); i < n; ++i )
+        sum += vTenth[i];
+
+    int pct = qMin( 100.0, 100.0 * sum / pctMax );
 
     if( pct > pctRpt ) {
 
@@ -146,11 +173,11 @@ void CalSRWorker::reportTenth( int tenth )
 }
 
 
-void CalSRWorker::calcRateIM( CalSRStream &S )
+void CalSRWorker::calcRateIM( CalSRStream &S, int ij )
 {
     QVariant    qv;
+    DFSyncSpec  sy;
     double      syncPer;
-    int         syncBit;
 
 // ---------
 // Open file
@@ -177,15 +204,14 @@ void CalSRWorker::calcRateIM( CalSRStream &S )
     else
         syncPer = qv.toDouble();
 
-    syncBit = 6;    // Sync signal always at bit 6 of AUX word
+    sy.acqChan  = df->cumTypCnt()[CimCfg::imSumNeural];
+    sy.bit      = 6;    // Sync signal always at bit 6 of AUX word
 
 // ----
 // Scan
 // ----
 
-    scanDigital(
-        S, df, syncPer, syncBit,
-        df->cumTypCnt()[CimCfg::imSumNeural] );
+    scanEdges( S, ij, df, syncPer, sy );
 
 // -----
 // Close
@@ -196,11 +222,11 @@ close:
 }
 
 
-void CalSRWorker::calcRateOB( CalSRStream &S )
+void CalSRWorker::calcRateOB( CalSRStream &S, int ij )
 {
     QVariant    qv;
+    DFSyncSpec  sy;
     double      syncPer;
-    int         syncBit;
 
 // ---------
 // Open file
@@ -227,15 +253,14 @@ void CalSRWorker::calcRateOB( CalSRStream &S )
     else
         syncPer = qv.toDouble();
 
-    syncBit = 6;    // Sync signal always at bit 6 of AUX word
+    sy.acqChan  = df->cumTypCnt()[CimCfg::obSumData];
+    sy.bit      = 6;    // Sync signal always at bit 6 of AUX word
 
 // ----
 // Scan
 // ----
 
-    scanDigital(
-        S, df, syncPer, syncBit,
-        df->cumTypCnt()[CimCfg::obSumData] );
+    scanEdges( S, ij, df, syncPer, sy );
 
 // -----
 // Close
@@ -246,9 +271,10 @@ close:
 }
 
 
-void CalSRWorker::calcRateNI( CalSRStream &S )
+void CalSRWorker::calcRateNI( CalSRStream &S, int ij )
 {
     QVariant    qv;
+    DFSyncSpec  sy;
     double      syncPer,
                 syncThresh;
     int         syncType,
@@ -309,17 +335,24 @@ void CalSRWorker::calcRateNI( CalSRStream &S )
     else
         syncChan = qv.toInt();
 
+    if( syncType == 0 ) {
+        sy.acqChan  = df->cumTypCnt()[CniCfg::niSumAnalog] + syncChan/16;
+        sy.bit      = syncChan % 16;
+    }
+    else {
+        sy.acqChan  = syncChan;
+        sy.bit      = -1;
+        sy.thresh   = qBound(
+                        -32768.0,
+                        syncThresh / df->vRange().rmax * 32768,
+                        32767.0 );
+    }
+
 // ----
 // Scan
 // ----
 
-    if( syncType == 0 ) {
-        scanDigital(
-            S, df, syncPer, syncChan,
-            df->cumTypCnt()[CniCfg::niSumAnalog] + syncChan/16 );
-    }
-    else
-        scanAnalog( S, df, syncPer, syncThresh, syncChan );
+    scanEdges( S, ij, df, syncPer, sy );
 
 // -----
 // Close
@@ -330,202 +363,99 @@ close:
 }
 
 
-void CalSRWorker::scanDigital(
-    CalSRStream     &S,
-    DataFile        *df,
-    double          syncPer,
-    int             syncBit,
-    int             dword )
+// Get rising edges of the sync channel from the sidecar
+// if recorded, else by reading just that channel.
+//
+void CalSRWorker::scanEdges(
+    CalSRStream         &S,
+    int                 ij,
+    DataFile            *df,
+    double              syncPer,
+    const DFSyncSpec    &sy )
 {
-#ifdef EDGEFILES
-QFile f( QString("%1/%2_edges.txt")
-        .arg( mainApp()->dataDir() )
-        .arg( df->fileLblFromObj() ) );
-(void)f.open( QIODevice::WriteOnly | QIODevice::Text );
-QTextStream ts( &f );
-#endif
-
-// We set statN to the statistical sample size we want for averaging.
-// Given statN and the pulser period, we next see how wide a counting
-// window (nthEdge = n pulser periods) we can use given the time span
-// of the file. Wider counting windows are better because the count
-// error tends to be order(1) for a good clock no matter how wide the
-// window. Wider windows give better standard error estimators.
-
-    const int statN = 10;
-
-    std::vector<Bin>    vB;
-    int                 nb = 0;
-
-    double  srate   = df->samplingRateHz();
-    qint64  nCts    = df->sampCount(),
-            nRem    = nCts,
-            xpos    = 0,
-            lastX   = 0;
-    int     nC      = df->numChans(),
-            nthEdge = (quint64(nRem / (srate * syncPer)) - 1) / statN,
-            iEdge   = nthEdge - 1,
-            tenth   = 0;
-    bool    isHi    = false;
-
-    int iword   = df->fileChans().indexOf( (uint)dword ),
-        mask    = 1 << (syncBit % 16);
-
-    if( iword < 0 ) {
-        S.err =
-        QString("%1 sync word (chan %2) not included in saved channels")
-        .arg( df->streamFromObj() )
-        .arg( dword );
-        return;
-    }
-
-// --------------------------
-// Collect and bin the counts
-// --------------------------
-
-    for(;;) {
-
-        if( isCanceled() ) {
-            S.err = "canceled";
-            return;
+    std::vector<qint64> edges;
+    QString             bin     = df->inBinFileName();
+    int                 nC      = df->numChans(),
+                        ic      = df->fileChans().indexOf( (uint)sy.acqChan );
+
+    if( ic < 0 ) {
+
+        if( sy.bit >= 0 ) {
+            S.err =
+            QString("%1 sync word (chan %2) not included in saved channels")
+            .arg( df->streamFromObj() )
+            .arg( sy.acqChan );
         }
-
-        vec_i16 data;
-        qint64  ntpts,
-                chunk = srate,
-                nthis = qMin( chunk, nRem );
-
-        ntpts = df->readSamps( data, xpos, nthis, QBitArray() );
-
-        if( ntpts <= 0 )
-            break;
-
-        // Init high/low flag
-
-        if( !xpos )
-            isHi = (data[iword] & mask) > 0;
-
-        // Scan block for edges
-
-        for( int i = 0; i < ntpts; ++i ) {
-
-            if( isHi ) {
-
-                if( (data[i*nC + iword] & mask) < 1 )
-                    isHi = false;
-            }
-            else {
-
-                if( (data[i*nC + iword] & mask) > 0 ) {
-
-                    if( ++iEdge >= nthEdge ) {
-
-                        if( lastX > 0 ) {
-
-                            qint64  c = xpos + i - lastX;
-
-#ifdef EDGEFILES
-ts << c << "\n";
-#endif
-
-                            for( int ib = 0; ib < nb; ++ib ) {
-
-                                if( vB[ib].isIn( c ) )
-                                    goto binned;
-                            }
-
-                            vB.push_back( Bin( c, nCts, srate ) );
-                            ++nb;
-                        }
-
-binned:
-                        lastX = xpos + i;
-                        iEdge = 0;
-                        reportTenth( ++tenth );
-                    }
-
-                    isHi = true;
-                }
-            }
+        else {
+            S.err =
+            QString("%1 sync chan [%2] not included in saved channels")
+            .arg( df->streamFromObj() )
+            .arg( sy.acqChan );
         }
-
-        // Advance for next block
-
-        xpos    += ntpts;
-        nRem    -= ntpts;
+        return;
     }
 
-// ---------------
-// Remove outliers
-// ---------------
+// -------
+// Sidecar
+// -------
 
-    if( nb ) {
-
-        for( int ib = nb - 1; ib >= 0; --ib ) {
+    QString err;
 
-            if( vB[ib].n <= 1 ) {
-                vB.erase( vB.begin() + ib );
-                --nb;
-            }
-        }
+    if( DFSyncEdges::read( err, edges, bin, nC, ic, sy.bit ) ) {
+        binCounts( S, df, syncPer, edges );
+        return;
     }
-    else
-        S.err = QString("%1 no edges found").arg( df->fileLblFromObj() );
 
-// -----------------
-// Collect stat sums
-// -----------------
+// ----
+// Scan
+// ----
 
-    double  s1 = 0,
-            s2 = 0;
-    int     N  = 0;
+    DFChanReader    R;
+    DFSyncEdgeScan  E;
 
-    for( int ib = 0; ib < nb; ++ib ) {
+    if( !R.open( S.err, bin, nC, ic ) )
+        return;
 
-        const Bin   &b = vB[ib];
+    E.init( 1, 0, sy.bit, sy.thresh );
 
-        for( int ic = 0; ic < b.n; ++ic ) {
+    qint64  nCts    = R.sampCount(),
+            chunk   = 8 * df->samplingRateHz(),
+            xpos    = 0;
 
-            double  c = b.C[ic];
+    for(;;) {
 
-            s1 += c;
-            s2 += c*c;
+        if( isCanceled() ) {
+            S.err = "canceled";
+            return;
         }
 
-        N += b.n;
-    }
+        vec_i16 data;
+        qint64  ntpts = R.read( data, xpos, chunk );
 
-// ----------------------------
-// Stats (tolerate one outlier)
-// ----------------------------
+        if( ntpts < 0 ) {
+            S.err = QString("%1 read error").arg( df->fileLblFromObj() );
+            return;
+        }
 
-    if( N >= statN - 1 ) {
+        if( !ntpts )
+            break;
 
-        double  var = (s2 - s1*s1/N) / (N - 1);
-        double  per = nthEdge * syncPer;
+        E.scan( edges, &data[0], ntpts, xpos );
 
-        if( var > 0.0 )
-            S.se = sqrt( var / N ) / per;
+        xpos += ntpts;
 
-        S.av = s1 / (N * per);
-    }
-    else {
-        S.err = QString("%1 too many outliers")
-                .arg( df->fileLblFromObj() );
+        reportTenth( ij, 9 * xpos / nCts );
     }
 
-#ifdef EDGEFILES
-Log() << df->fileLblFromObj() << " win N " << nthEdge << " " << N;
-#endif
+    binCounts( S, df, syncPer, edges );
 }
 
 
-void CalSRWorker::scanAnalog(
-    CalSRStream     &S,
-    DataFile        *df,
-    double          syncPer,
-    double          syncThresh,
-    int             syncChan )
+void CalSRWorker::binCounts(
+    CalSRStream                 &S,
+    DataFile                    *df,
+    double                      syncPer,
+    const std::vector<qint64>   &edges )
 {
 #ifdef EDGEFILES
 QFile f( QString("%1/%2_edges.txt")
@@ -548,24 +478,12 @@ QTextStream ts( &f );
     int                 nb = 0;
 
     double  srate   = df->samplingRateHz();
-    qint64  nCts    = df->sampCount(),
-            nRem    = nCts,
-            xpos    = 0,
-            lastX   = 0;
-    int     nC      = df->numChans(),
-            nthEdge = (quint64(nRem / (srate * syncPer)) - 1) / statN,
-            iEdge   = nthEdge - 1,
-            tenth   = 0;
-    bool    isHi    = false;
-
-    int iword   = df->fileChans().indexOf( (uint)syncChan ),
-        T       = syncThresh / df->vRange().rmax * 32768;
-
-    if( iword < 0 ) {
-        S.err =
-        QString("%1 sync chan [%2] not included in saved channels")
-        .arg( df->streamFromObj() )
-        .arg( syncChan );
+    qint64  nCts    = df->sampCount();
+    int     nthEdge = (quint64(nCts / (srate * syncPer)) - 1) / statN,
+            nEdge   = (int)edges.size();
+
+    if( nthEdge < 1 ) {
+        S.err = QString("%1 run too short").arg( df->fileLblFromObj() );
         return;
     }
 
@@ -573,76 +491,26 @@ QTextStream ts( &f );
 // Collect and bin the counts
 // --------------------------
 
-    for(;;) {
-
-        if( isCanceled() ) {
-            S.err = "canceled";
-            return;
-        }
-
-        vec_i16 data;
-        qint64  ntpts,
-                chunk = srate,
-                nthis = qMin( chunk, nRem );
-
-        ntpts = df->readSamps( data, xpos, nthis, QBitArray() );
-
-        if( ntpts <= 0 )
-            break;
-
-        // Init high/low flag
-
-        if( !xpos )
-            isHi = data[iword] > T;
-
-        // Scan block for edges
+// Counting windows span every nthEdge-th edge from the first.
 
-        for( int i = 0; i < ntpts; ++i ) {
+    for( int ie = nthEdge; ie < nEdge; ie += nthEdge ) {
 
-            if( isHi ) {
-
-                if( data[i*nC + iword] <= T )
-                    isHi = false;
-            }
-            else {
-
-                if( data[i*nC + iword] > T ) {
-
-                    if( ++iEdge >= nthEdge ) {
-
-                        if( lastX > 0 ) {
-
-                            qint64  c = xpos + i - lastX;
+        qint64  c = edges[ie] - edges[ie - nthEdge];
 
 #ifdef EDGEFILES
 ts << c << "\n";
 #endif
 
-                            for( int ib = 0; ib < nb; ++ib ) {
+        for( int ib = 0; ib < nb; ++ib ) {
 
-                                if( vB[ib].isIn( c ) )
-                                    goto binned;
-                            }
-
-                            vB.push_back( Bin( c, nCts, srate ) );
-                            ++nb;
-                        }
-
-binned:
-                        lastX = xpos + i;
-                        iEdge = 0;
-                        reportTenth( ++tenth );
-                    }
-
-                    isHi = true;
-                }
-            }
+            if( vB[ib].isIn( c ) )
+                goto binned;
         }
 
-        // Advance for next block
+        vB.push_back( Bin( c, nCts, srate ) );
+        ++nb;
 
-        xpos    += ntpts;
-        nRem    -= ntpts;
+binned:;
     }
 
 // ---------------
@@ -819,6 +687,9 @@ void CalSRRun::initRun()
     p.sns.fldPerPrb = false;
     p.sns.sepShanks = false;
 
+    // Edges indexed while recording: no rescan needed
+    p.perf.wrSyncEdges = true;
+
     cfg->setParams( p, false );
 }
 
@@ -8,6 +8,7 @@
 #include <QThread>
 
 class DataFile;
+struct DFSyncSpec;
 class QProgressDialog;
 
 /* ---------------------------------------------------------------- */
@@ -32,6 +33,10 @@ private:
 };
 
 
+// Streams are measured concurrently, one thread each up to
+// the core count. A stream recorded with a sync edge sidecar
+// needs no scan; otherwise only its sync channel is read.
+//
 class CalSRWorker : public QObject
 {
     Q_OBJECT
@@ -80,8 +85,10 @@ private:
     std::vector<CalSRStream>    &vIM,
                                 &vOB,
                                 &vNI;
+    std::vector<CalSRStream*>   vJob;
+    std::vector<int>            vTenth;     // progress per job
     mutable QMutex              runMtx;
-    int                         pctCum,
+    int                         iNext,
                                 pctMax,
                                 pctRpt;
     bool                        _cancel;
@@ -106,24 +113,24 @@ public slots:
 
 private:
     bool isCanceled()   {QMutexLocker ml( &runMtx ); return _cancel;}
-    void reportTenth( int tenth );
-    void calcRateIM( CalSRStream &S );
-    void calcRateOB( CalSRStream &S );
-    void calcRateNI( CalSRStream &S );
-
-    void scanDigital(
-        CalSRStream     &S,
-        DataFile        *df,
-        double          syncPer,
-        int             syncBit,
-        int             dword );
-
-    void scanAnalog(
-        CalSRStream     &S,
-        DataFile        *df,
-        double          syncPer,
-        double          syncThresh,
-        int             syncChan );
+    void runJobs();
+    void reportTenth( int ij, int tenth );
+    void calcRateIM( CalSRStream &S, int ij );
+    void calcRateOB( CalSRStream &S, int ij );
+    void calcRateNI( CalSRStream &S, int ij );
+
+    void scanEdges(
+        CalSRStream         &S,
+        int                 ij,
+        DataFile            *df,
+        double              syncPer,
+        const DFSyncSpec    &sy );
+
+    void binCounts(
+        CalSRStream                 &S,
+        DataFile                    *df,
+        double                      syncPer,
+        const std::vector<qint64>   &edges );
 };
 
 
@@ -5,10 +5,51 @@
 
 #include <QWaitCondition>
 
+#include <math.h>
+
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
+// Fetch-loop period statistics over a report interval;
+// call tick() at the top of each loop iteration.
+//
+struct AcqLoopStats {
+    double  tLast,
+            sum,
+            sum2,
+            max;
+    int     n;
+
+    AcqLoopStats() : tLast(0)   {reset();}
+
+    void reset()    {sum = 0; sum2 = 0; max = 0; n = 0;}
+
+    void tick( double t )
+    {
+        if( tLast ) {
+            double  dt = t - tLast;
+            sum  += dt;
+            sum2 += dt * dt;
+            if( dt > max )
+                max = dt;
+            ++n;
+        }
+        tLast = t;
+    }
+
+    double aveMs() const    {return (n ? 1000 * sum / n : 0);}
+    double maxMs() const    {return 1000 * max;}
+    double sdMs() const
+    {
+        if( n < 2 )
+            return 0;
+        double  var = (sum2 - sum * sum / n) / (n - 1);
+        return (var > 0 ? 1000 * sqrt( var ) : 0);
+    }
+};
+
+
 // Base class for IMEC data acquisition
 //
 class CimAcq : public QObject
@@ -2,17 +2,20 @@
 #ifdef HAVE_IMEC
 
 #include "CimAcqImec.h"
+#include "BenchRun.h"
 #include "Util.h"
 #include "MainApp.h"
 #include "ConfigCtl.h"
 #include "MetricsWindow.h"  // IWYU pragma: keep
 #include "Run.h"
 #include "Subset.h"
-#include "Biquad.h"
+#include "ThreadPlace.h"
 
 #include <QRegularExpression>
 #include <QThread>
 
+#include <algorithm>
+
 
 // TPNTPERFETCH reflects the AP/LF sample rate ratio.
 #define TPNTPERFETCH    12
@@ -20,6 +23,18 @@
 #define AVEE            5
 #define MAXE            24
 
+// Acq worker scheduling
+#define SCHED_OVHDCHANS 64      // per-stream overhead as channels
+#define SCHED_CAPNP1    3       // worker capacity in NP1 probes
+#define SCHED_NP1CHANS  769     // NP1 nCH: AP + LF + SY
+#define SCHED_BUSY      0.50    // worker core fraction deemed pressed
+#define SCHED_FIFOPCT   2       // stream fifo% deemed pressed
+#define SCHED_MINGAIN   0.05    // min peak load drop to move stream
+#define SCHED_MOVESECS  15.0    // min secs between moves
+#define YIELD_PKTS      60      // fetch target, timepoints
+#define YIELD_MINUS     50      // shortest worthwhile sleep
+#define YIELD_MAXUS     1000
+
 // Experiment switches
 // #define TESTDUPSAMPS
 // #define TSTAMPCHECKS
@@ -411,11 +426,12 @@ void ImSimDat::fetchT2(struct PacketInfo* H, int16_t* D, int is, int nAP, int sm
 /* ---------------------------------------------------------------- */
 
 // Loop period is 1.0 packet (TPNTPERFETCH).
+// Files are read (speed) times faster than real time.
 //
 void ImSimPrbWorker::run()
 {
     double      T0              = getTime();
-    const int   rate            = 3e4;
+    const int   rate            = 3e4 * speed;
     const int   loopPeriod_us   = TPNTPERFETCH * 1e6 / rate;
 
     while( !isStopped() ) {
@@ -442,10 +458,10 @@ void ImSimPrbWorker::run()
 /* ImSimThread ----------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
-ImSimPrbThread::ImSimPrbThread( std::vector<ImSimDat> &simDat )
+ImSimPrbThread::ImSimPrbThread( std::vector<ImSimDat> &simDat, double speed )
 {
     thread  = new QThread;
-    worker  = new ImSimPrbWorker( simDat );
+    worker  = new ImSimPrbWorker( simDat, speed );
 
     worker->moveToThread( thread );
 
@@ -476,7 +492,7 @@ ImSimPrbThread::~ImSimPrbThread()
 /* ---------------------------------------------------------------- */
 
 ImAcqShared::ImAcqShared()
-    :   awake(0), asleep(0), ip_CAR(-1), stop(false)
+    :   awake(0), asleep(0), stop(false)
 {
 // Experiment to histogram successive timestamp differences.
 #ifdef TSTAMPCHECKS
@@ -616,100 +632,6 @@ void ImAcqShared::tStampHist_PInfo( const PacketInfo* H, int ip, int it )
 #endif
 }
 
-/* ---------------------------------------------------------------- */
-/* ImAcqQFlt ------------------------------------------------------ */
-/* ---------------------------------------------------------------- */
-
-ImAcqQFlt::ImAcqQFlt( const DAQ::Params &p, AIQ *Qf, int ip )
-    :   tTrip(0), Qf(Qf)
-{
-    const CimCfg::PrbEach   &E = p.im.prbj[ip];
-
-    hipass = 0;
-    lopass = 0;
-
-    if( p.im.prbAll.qf_loCutStr != "0" ) {
-        hipass = new Biquad( bq_type_highpass,
-                        p.im.prbAll.qf_loCutStr.toDouble() / E.srate );
-    }
-
-    if( p.im.prbAll.qf_hiCutStr != "INF" ) {
-        lopass = new Biquad( bq_type_lowpass,
-                        p.im.prbAll.qf_hiCutStr.toDouble() / E.srate );
-    }
-
-    maxInt  = E.roTbl->maxInt();
-    nC      = p.stream_nChans( jsIM, ip );
-    nAP     = E.imCumTypCnt[CimCfg::imSumAP];
-
-    car.setAuto( E.roTbl );
-    car.setChans( nC, nAP, 1 );
-    car.setSU( &E.sns.shankMap );
-}
-
-
-ImAcqQFlt::~ImAcqQFlt()
-{
-    if( hipass ) {
-        delete hipass;
-        hipass = 0;
-    }
-
-    if( lopass ) {
-        delete lopass;
-        lopass = 0;
-    }
-}
-
-
-void ImAcqQFlt::mapChanged( const DAQ::Params &p, int ip )
-{
-    QMutexLocker    ml( &carMtx );
-    car.setSU( &p.im.prbj[ip].sns.shankMap );
-}
-
-
-void ImAcqQFlt::trip()
-{
-    tTrip = getTime();
-}
-
-
-bool ImAcqQFlt::testTrip()
-{
-    if( tTrip && (getTime() - tTrip) < 4.0 )
-        return true;
-
-    tTrip = 0;
-    return false;
-}
-
-
-void ImAcqQFlt::enqueue( qint16 *D, int ntpts )
-{
-    if( testTrip() || !Qf->qf_isClient() )
-        enqueueZero( ntpts );
-    else {
-        if( hipass )
-            hipass->applyBlockwiseMem( D, maxInt, ntpts, nC, 0, nAP );
-
-        if( lopass )
-            lopass->applyBlockwiseMem( D, maxInt, ntpts, nC, 0, nAP );
-
-        carMtx.lock();
-            car.gbl_dmx_tbl_auto( D, ntpts );
-        carMtx.unlock();
-
-        Qf->enqueue( D, ntpts );
-    }
-}
-
-
-void ImAcqQFlt::enqueueZero( int ntpts ) const
-{
-    Qf->enqueueZeroIM( ntpts, 0, 0 );
-}
-
 /* ---------------------------------------------------------------- */
 /* ImAcqStream ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -721,10 +643,11 @@ ImAcqStream::ImAcqStream(
     int                         js,
     int                         ip )
     :   tLastErrFlagsReport(0), tLastFifoReport(0), peakDT(0),
-        sumTot(0), totPts(0ULL), Q(Q), QFlt(0),
+        sumTot(0), totPts(0ULL), Q(Q),
         tStampLastFetch(0),
         errCOUNT{0,0,0,0}, errSERDES{0,0,0,0}, errLOCK{0,0,0,0},
         errPOP{0,0,0,0}, errSYNC{0,0,0,0}, errMISS{0,0,0,0},
+        cost(0), busy(-1), fifoLast(0), fifoSched(0), owner(0), moveTo(-1),
         fifoAve(0), fifoN(0), sumN(0), js(js), ip(ip),
         statusLastFetch(0), simType(false)
 #ifdef PAUSEWHOLESLOT
@@ -764,6 +687,9 @@ ImAcqStream::ImAcqStream(
 
         fetchType   = E.roTbl->apiFetchType();
         simType     = T.simprb.isSimProbe( adr );
+
+        if( fetchType == t_fetch_np1 )
+            lfLast.assign( nLF, 0 );
     }
     else {
 
@@ -786,11 +712,6 @@ ImAcqStream::ImAcqStream(
 ImAcqStream::~ImAcqStream()
 {
     sendErrMetrics();
-
-    if( QFlt ) {
-        delete QFlt;
-        QFlt = 0;
-    }
 }
 
 
@@ -1070,9 +991,6 @@ bool ImAcqStream::checkFifo( int *packets, CimAcqImec *acq )
             sqb.ave();
         }
 
-        if( QFlt && (fifoAve > 1 || sqb.is_increased()) )
-            QFlt->trip();
-
         QString stream = metricsName();
 
         QMetaObject::invokeMethod(
@@ -1118,6 +1036,7 @@ bool ImAcqStream::checkFifo( int *packets, CimAcqImec *acq )
             }
         }
 
+        fifoLast        = fifoAve;
         fifoAve         = 0;
         fifoN           = 0;
         tLastFifoReport = tFifo;
@@ -1127,48 +1046,239 @@ bool ImAcqStream::checkFifo( int *packets, CimAcqImec *acq )
     return true;
 }
 
+/* ---------------------------------------------------------------- */
+/* ImAcqSched ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void ImAcqSched::clear()
+{
+    for( int is = 0, ns = (int)streams.size(); is < ns; ++is )
+        delete streams[is];
+
+    streams.clear();
+    solo.clear();
+    nThd = 0;
+}
+
+
+// Cost is enqueued samples/s plus a fixed per-stream overhead
+// (API calls, fifo polls) worth SCHED_OVHDCHANS channels.
+// Worker capacity is SCHED_CAPNP1 NP1 probes, costed the
+// same way (all nCH channels at 30 kHz).
+//
+void ImAcqSched::place()
+{
+    std::vector<int>    order;
+    std::vector<double> load;
+    double              sumCost = 0,
+                        capCost = SCHED_CAPNP1
+                                    * (SCHED_NP1CHANS + SCHED_OVHDCHANS)
+                                    * 30000.0;
+
+    nThd = 0;
+    solo.clear();
+
+    for( int is = 0, ns = (int)streams.size(); is < ns; ++is ) {
+
+        ImAcqStream *S = streams[is];
+
+        S->cost     = (S->nCH + SCHED_OVHDCHANS) * S->Q->sRate();
+        S->busy     = -1;
+        S->moveTo   = -1;
+
+        if( S->js == jsIM && S->nAP > 384 ) {
+            S->owner = nThd++;
+            solo.push_back( true );
+        }
+        else {
+            order.push_back( is );
+            sumCost += S->cost;
+        }
+    }
+
+    if( !order.size() )
+        return;
+
+// Largest first, each to least loaded
+
+    int nShr = qBound( 1, int(ceil( sumCost / capCost )), (int)order.size() );
+
+    std::stable_sort( order.begin(), order.end(),
+        [this]( int a, int b ) {
+            return streams[a]->cost > streams[b]->cost;
+        } );
+
+    load.assign( nShr, 0 );
+
+    for( int io = 0, no = (int)order.size(); io < no; ++io ) {
+
+        ImAcqStream *S  = streams[order[io]];
+        int         lo  = 0;
+
+        for( int t = 1; t < nShr; ++t ) {
+            if( load[t] < load[lo] )
+                lo = t;
+        }
+
+        S->owner    = nThd + lo;
+        load[lo]   += S->cost;
+    }
+
+    nThd += nShr;
+    solo.resize( nThd, false );
+}
+
+
+// Refresh worker's stream list: release streams marked
+// to move elsewhere, adopt any newly assigned.
+//
+void ImAcqSched::mine(
+    std::vector<ImAcqStream*>   &vS,
+    int                         &myGen,
+    int                         iThd )
+{
+    QMutexLocker    ml( &schedMtx );
+
+    vS.clear();
+
+    for( int is = 0, ns = (int)streams.size(); is < ns; ++is ) {
+
+        ImAcqStream *S = streams[is];
+
+        if( S->owner != iThd )
+            continue;
+
+        if( S->moveTo >= 0 ) {
+            S->owner    = S->moveTo;
+            S->moveTo   = -1;
+            S->busy     = -1;
+            ++gen;
+        }
+        else
+            vS.push_back( S );
+    }
+
+    myGen = gen;
+}
+
+
+void ImAcqSched::report( ImAcqStream &S, double busy )
+{
+    QMutexLocker    ml( &schedMtx );
+
+    S.busy      = busy;
+    S.fifoSched = S.fifoLast;
+}
+
+
+// At most one move per SCHED_MOVESECS, once every stream
+// has a measurement, and only if it lowers the peak load.
+//
+void ImAcqSched::balance( double tNow )
+{
+    QMutexLocker    ml( &schedMtx );
+
+    if( tNow - tLastMove < SCHED_MOVESECS )
+        return;
+
+    std::vector<double> load( nThd, 0 );
+    std::vector<int>    fifo( nThd, 0 );
+
+    for( int is = 0, ns = (int)streams.size(); is < ns; ++is ) {
+
+        const ImAcqStream   *S = streams[is];
+
+        if( S->busy < 0 || S->moveTo >= 0 )
+            return;
+
+        load[S->owner] += S->busy;
+        fifo[S->owner]  = qMax( fifo[S->owner], S->fifoSched );
+    }
+
+    int hi = -1, lo = -1;
+
+    for( int t = 0; t < nThd; ++t ) {
+
+        if( solo[t] )
+            continue;
+
+        if( hi < 0 || load[t] > load[hi] )
+            hi = t;
+
+        if( lo < 0 || load[t] < load[lo] )
+            lo = t;
+    }
+
+    if( hi == lo || (load[hi] < SCHED_BUSY && fifo[hi] < SCHED_FIFOPCT) )
+        return;
+
+    ImAcqStream *best       = 0;
+    double      bestPeak    = load[hi] - SCHED_MINGAIN;
+
+    for( int is = 0, ns = (int)streams.size(); is < ns; ++is ) {
+
+        ImAcqStream *S = streams[is];
+
+        if( S->owner != hi )
+            continue;
+
+        double  peak = qMax( load[hi] - S->busy, load[lo] + S->busy );
+
+        if( peak < bestPeak ) {
+            best        = S;
+            bestPeak    = peak;
+        }
+    }
+
+    if( !best )
+        return;
+
+    Log() <<
+        QString("IMEC moving %1 from acq worker %2 (%3% busy) to %4 (%5% busy).")
+        .arg( best->metricsName().trimmed() )
+        .arg( hi ).arg( int(100*load[hi]) )
+        .arg( lo ).arg( int(100*load[lo]) );
+
+    best->moveTo    = lo;
+    tLastMove       = tNow;
+    ++gen;
+}
+
 /* ---------------------------------------------------------------- */
 /* ImAcqWorker ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
 ImAcqWorker::ImAcqWorker(
-    CimAcqImec                  *acq,
-    ImAcqShared                 &shr,
-    std::vector<ImAcqStream>    &streams )
+    CimAcqImec  *acq,
+    ImAcqShared &shr,
+    ImAcqSched  &sched,
+    int         iThd )
     :   QObject(0), tLastYieldReport(getTime()), yieldSum(0),
-        acq(acq), shr(shr), streams(streams)
+        acq(acq), shr(shr), sched(sched), iThd(iThd), schedGen(-1)
 {
 }
 
 
 void ImAcqWorker::run()
 {
+    ThreadPlace::pin( ThreadPlace::tpAcq, QString("imacq%1").arg( iThd ), iThd );
+
 // Size buffers
 // ------------
-// - lfLast[][]: each probe must retain the prev LF for all channels.
+// Any stream may be moved to this worker, so size over all.
 // - i16Buf[]:   max sized over stream nCH; reused each iID.
 // - D[]:        max sized over {fetchType, MAXE}; reused each iID.
 //
-    std::vector<std::vector<qint16> >   lfLast;
-    vec_i16                             i16Buf;
+    vec_i16 i16Buf;
+    int     nCHMax  = 0,
+            T2Chans = OBX_N_ACQ,
+            nT0     = 0,
+            nT2     = 0,    // NP 2.0 or OneBox
+            nSY     = 1;    // for NP2020
 
-    const int   nID     = (int)streams.size();
-    int         nCHMax  = 0,
-                T2Chans = OBX_N_ACQ,
-                nT0     = 0,
-                nT2     = 0,    // NP 2.0 or OneBox
-                nSY     = 1;    // for NP2020
+    for( int is = 0, ns = (int)sched.streams.size(); is < ns; ++is ) {
 
-    lfLast.resize( nID );
-
-    for( int iID = 0; iID < nID; ++iID ) {
-
-        ImAcqStream &S = streams[iID];
-
-        // init stream QFlt
-
-        if( S.js == jsIM && acq->owner->imQf.size() )
-            S.QFlt = new ImAcqQFlt( acq->p, acq->owner->imQf[S.ip], S.ip );
+        const ImAcqStream   &S = *sched.streams[is];
 
         // stream chans (i16Buf)
 
@@ -1178,22 +1288,29 @@ void ImAcqWorker::run()
         // acq voltage chans (D)
 
         switch( S.fetchType ) {
-            case t_fetch_np1:   ++nT0; lfLast[iID].assign( S.nLF, 0 ); break;
+            case t_fetch_np1:   ++nT0; break;
             case t_fetch_qb:    nSY = 4;    [[fallthrough]];
             case t_fetch_np2:   ++nT2; T2Chans = qMax( T2Chans, S.nAP ); break;
             case t_fetch_obx:   ++nT2; T2Chans = qMax( T2Chans, OBX_N_ACQ ); break;
         }
+    }
+
+    sched.mine( streams, schedGen, iThd );
 
-        // GENSERDES
+// GENSERDES
 
 #ifdef GENSERDES
+    for( int iID = 0, nID = (int)streams.size(); iID < nID; ++iID ) {
+
+        ImAcqStream &S = *streams[iID];
+
         if( S.js == jsIM && GENSERDES == S.ip ) {
             np_configureSerDesErrorGenerator( S.adr.slot, S.adr.port,
                 SERDES_ERROR_RATE_MEDIUM, SERDES_ERROR_COUNT_1024 );
             np_enableSerDesErrorGenerator( S.adr.slot, S.adr.port, true );
         }
-#endif
     }
+#endif
 
     i16Buf.resize( MAXE * TPNTPERFETCH * nCHMax );
 
@@ -1217,31 +1334,27 @@ void ImAcqWorker::run()
     while( !acq->isStopped() && !shr.stopping() ) {
 
         loopT = getTime();
+        loop.tick( loopT );
 
         // -------------
         // Do my streams
         // -------------
 
-        for( int iID = 0; iID < nID; ++iID ) {
+        if( sched.generation() != schedGen )
+            sched.mine( streams, schedGen, iThd );
 
-            ImAcqStream &S = streams[iID];
+        for( int iID = 0, nID = (int)streams.size(); iID < nID; ++iID ) {
 
-            if( !S.totPts ) {
-                S.Q->setTZero( loopT );
-                if( S.QFlt )
-                    S.QFlt->Qf->setTZero( loopT );
-            }
+            ImAcqStream &S = *streams[iID];
 
-            if( S.QFlt && S.ip == shr.checkCAR() ) {
-                shr.updateCAR( -1 );
-                S.QFlt->mapChanged( acq->p, S.ip );
-            }
+            if( !S.totPts )
+                S.Q->setTZero( loopT );
 
             double  dtTot = getTime();
             bool    ok;
 
             switch( S.fetchType ) {
-                case t_fetch_np1:   ok = doProbe_T0( &lfLast[iID][0], i16Buf, S ); break;
+                case t_fetch_np1:   ok = doProbe_T0( &S.lfLast[0], i16Buf, S ); break;
                 case t_fetch_np2:
                 case t_fetch_qb:    ok = doProbe_T2( i16Buf, S ); break;
                 case t_fetch_obx:   ok = do_obx( i16Buf, S ); break;
@@ -1272,26 +1385,34 @@ void ImAcqWorker::run()
 
         if( loopT - lastCheckT >= 5.0 ) {
 
-            for( int iID = 0; iID < nID; ++iID ) {
+            double  span = loopT - lastCheckT;
 
-                ImAcqStream &S = streams[iID];
+            for( int iID = 0, nID = (int)streams.size(); iID < nID; ++iID ) {
+
+                ImAcqStream &S = *streams[iID];
 
 #ifdef PROFILE
                 profile( S );
 #endif
+                sched.report( S, S.sumTot / span );
+
                 S.peakDT    = 0;
                 S.sumTot    = 0;
                 S.sumN      = 0;
             }
 
+            sched.balance( loopT );
+
+            loopReport();
+
             lastCheckT  = getTime();
         }
     }
 
 exit:
-    for( int iID = 0; iID < nID; ++iID ) {
+    for( int iID = 0, nID = (int)streams.size(); iID < nID; ++iID ) {
 
-        ImAcqStream &S = streams[iID];
+        ImAcqStream &S = *streams[iID];
 
         S.fileMissReport();
 
@@ -1301,6 +1422,8 @@ exit:
 #endif
     }
 
+    BenchCPU::add( BenchCPU::acq );
+
     emit finished();
 }
 
@@ -1372,8 +1495,6 @@ bool ImAcqWorker::doProbe_T0( qint16 *lfLast, vec_i16 &dst1D, ImAcqStream &S )
 
                 if( nQ ) {
                     S.Q->enqueue( &dst1D[0], nQ );
-                    if( S.QFlt )
-                        S.QFlt->enqueue( &dst1D[0], nQ );
                     S.totPts += nQ;
                     dst = &dst1D[0];
                     nQ  = 0;
@@ -1384,8 +1505,6 @@ bool ImAcqWorker::doProbe_T0( qint16 *lfLast, vec_i16 &dst1D, ImAcqStream &S )
 
                 S.Q->enqueueZeroIM( z, 1,
                     S.vstatusMiss[ie * TPNTPERFETCH + it] );
-                if( S.QFlt )
-                    S.QFlt->enqueueZero( z );
                 S.totPts += z;
             }
 
@@ -1445,8 +1564,6 @@ bool ImAcqWorker::doProbe_T0( qint16 *lfLast, vec_i16 &dst1D, ImAcqStream &S )
 #endif
 
     S.Q->enqueue( &dst1D[0], nQ );
-    if( S.QFlt )
-        S.QFlt->enqueue( &dst1D[0], nQ );
     S.totPts += nQ;
 
     S.tPostEnq = getTime();
@@ -1591,8 +1708,6 @@ next_j:;
 
             if( nQ ) {
                 S.Q->enqueue( &dst1D[0], nQ );
-                if( S.QFlt )
-                    S.QFlt->enqueue( &dst1D[0], nQ );
                 S.totPts += nQ;
                 dst = &dst1D[0];
                 nQ  = 0;
@@ -1603,8 +1718,6 @@ next_j:;
 
             S.Q->enqueueZeroIM( z, (S.fetchType == t_fetch_np2 ? 1 : 4),
                 S.vstatusMiss[it] );
-            if( S.QFlt )
-                S.QFlt->enqueueZero( z );
             S.totPts += z;
         }
 
@@ -1675,8 +1788,6 @@ next_j:;
 #endif
 
     S.Q->enqueue( &dst1D[0], nQ );
-    if( S.QFlt )
-        S.QFlt->enqueue( &dst1D[0], nQ );
     S.totPts += nQ;
 
     S.tPostEnq = getTime();
@@ -1871,15 +1982,18 @@ next_j:;
 
 bool ImAcqWorker::workerYield()
 {
-// Sum outstanding packets for this worker thread
+// Sum outstanding packets for this worker thread,
+// and the rate (per second) at which they accrue.
 
-    int sumPkts = 0,
-        nID     = (int)streams.size();
+    double  rate    = 0;
+    int     sumPkts = 0,
+            nID     = (int)streams.size();
 
     for( int iID = 0; iID < nID; ++iID ) {
 
-        ImAcqStream &S = streams[iID];
-        int         packets;
+        ImAcqStream &S      = *streams[iID];
+        int         packets,
+                    nShank  = 1;
 
         if( !S.checkFifo( &packets, acq ) )
             return false;
@@ -1887,28 +2001,24 @@ bool ImAcqWorker::workerYield()
         if( S.fetchType == t_fetch_np1 )
             packets *= TPNTPERFETCH;
         else if( S.fetchType == t_fetch_qb )
-            packets *= S.nAP / 384;
+            packets *= (nShank = S.nAP / 384);
 
         sumPkts += packets;
+        rate    += nShank * S.Q->sRate();
     }
 
-// Yield time if fewer than the average fetched packet count.
-// For high channel count probes, sleep less often.
+// Yield time if fewer than the average fetched packet count:
+// sleep about half the time remaining until the backlog reaches
+// that count, so fuller fifos get shorter sleeps.
 
     double  t = getTime();
 
-    if( !acq->p.im.prbAll.lowLatency && sumPkts < 60 ) {
+    if( !acq->p.im.prbAll.lowLatency && sumPkts < YIELD_PKTS && rate > 0 ) {
 
-        double  udev    = uniformDev();
-        bool    sleep   = false;
+        double  us = 0.5e6 * (YIELD_PKTS - sumPkts) / rate;
 
-        if( acq->p.im.prbAll.qf_on )
-            sleep = udev <= 0.08;
-        else
-            sleep = udev <= 0.40;
-
-        if( sleep ) {
-            QThread::usleep( 250 );
+        if( us >= YIELD_MINUS ) {
+            QThread::usleep( qMin( int(us), YIELD_MAXUS ) );
             yieldSum += getTime() - t;
         }
     }
@@ -1923,7 +2033,7 @@ bool ImAcqWorker::workerYield()
                 mainApp()->metrics(),
                 "prfUpdateAwake",
                 Qt::QueuedConnection,
-                Q_ARG(QString, streams[iID].metricsName()),
+                Q_ARG(QString, streams[iID]->metricsName()),
                 Q_ARG(int, awakePct) );
         }
 
@@ -1935,6 +2045,30 @@ bool ImAcqWorker::workerYield()
 }
 
 
+// Post fetch-loop period stats for each of my streams.
+//
+void ImAcqWorker::loopReport()
+{
+    double  ave = loop.aveMs(),
+            sd  = loop.sdMs(),
+            mx  = loop.maxMs();
+
+    for( int iID = 0, nID = (int)streams.size(); iID < nID; ++iID ) {
+
+        QMetaObject::invokeMethod(
+            mainApp()->metrics(),
+            "prfUpdateLoop",
+            Qt::QueuedConnection,
+            Q_ARG(QString, streams[iID]->metricsName()),
+            Q_ARG(double, ave),
+            Q_ARG(double, sd),
+            Q_ARG(double, mx) );
+    }
+
+    loop.reset();
+}
+
+
 // sumN is the number of loop executions in the 5 sec check
 // interval. The minimum value is 5*srate/(MAXE*TPNTPERFETCH).
 //
@@ -1977,12 +2111,13 @@ void ImAcqWorker::profile( ImAcqStream &S )
 /* ---------------------------------------------------------------- */
 
 ImAcqThread::ImAcqThread(
-    CimAcqImec                  *acq,
-    ImAcqShared                 &shr,
-    std::vector<ImAcqStream>    &streams )
+    CimAcqImec  *acq,
+    ImAcqShared &shr,
+    ImAcqSched  &sched,
+    int         iThd )
 {
     thread  = new QThread;
-    worker  = new ImAcqWorker( acq, shr, streams );
+    worker  = new ImAcqWorker( acq, shr, sched, iThd );
 
     worker->moveToThread( thread );
 
@@ -1993,14 +2128,14 @@ ImAcqThread::ImAcqThread(
 // Boost priority for worker handling single high channel count probe.
 // As of Qt 6.9.
 
-    if( streams.size() == 1 && streams[0].nAP > 384 )
+    if( sched.solo[iThd] )
         thread->setServiceLevel( QThread::QualityOfService::High );
 
     thread->start();
 
 // Boost priority for worker handling single high channel count probe.
 
-    if( streams.size() == 1 && streams[0].nAP > 384 )
+    if( sched.solo[iThd] )
         thread->setPriority( QThread::HighestPriority );
 }
 
@@ -2059,6 +2194,8 @@ CimAcqImec::~CimAcqImec()
         }
     }
 
+    acqSched.clear();
+
     QThread::msleep( 2000 );
 
 // Disable sync, close hardware
@@ -2145,7 +2282,7 @@ void CimAcqImec::run()
 // Wake all workers
 
     if( simDat.size() )
-        simThd = new ImSimPrbThread( simDat );
+        simThd = new ImSimPrbThread( simDat, p.perf.simSpeed );
 
     acqShr.condWake.wakeAll();
 
@@ -2289,9 +2426,6 @@ void CimAcqImec::update( int ip )
 // Update settings this probe
 // --------------------------
 
-    if( p.im.prbAll.qf_on )
-        acqShr.updateCAR( ip );
-
     if( T.simprb.isSimProbe( P.adr ) )
         return;
 
@@ -3002,50 +3136,36 @@ bool CimAcqImec::configure()
 /* createAcqWorkerThreads ----------------------------------------- */
 /* ---------------------------------------------------------------- */
 
-// High channel count probes get own worker
+// Stream placement by ImAcqSched; high channel count
+// probes get own worker.
 //
 void CimAcqImec::createAcqWorkerThreads()
 {
-// @@@ FIX Tune streams per thread here and in triggers
-    const int                   nStrPerThd = 3;
-    std::vector<ImAcqStream>    streams;
-
 // Probes, PXI & OneBox
 
     for( int ip = 0, np = p.stream_nIM(); ip < np; ++ip ) {
 
-        if( p.im.prbj[ip].imCumTypCnt[CimCfg::imSumAP] > 384 ) {
-
-            std::vector<ImAcqStream>    solo;
-            solo.push_back( ImAcqStream( T, p, owner->imQ[ip], jsIM, ip ) );
-            acqThd.push_back( new ImAcqThread( this, acqShr, solo ) );
-            continue;
-        }
-
-        streams.push_back( ImAcqStream( T, p, owner->imQ[ip], jsIM, ip ) );
-
-        if( streams.size() >= nStrPerThd ) {
-            acqThd.push_back( new ImAcqThread( this, acqShr, streams ) );
-            streams.clear();
-        }
+        acqSched.streams.push_back(
+            new ImAcqStream( T, p, owner->imQ[ip], jsIM, ip ) );
     }
 
 // OneBox ADC streams
 
     for( int ip = 0, np = p.stream_nOB(); ip < np; ++ip ) {
+        acqSched.streams.push_back(
+            new ImAcqStream( T, p, owner->obQ[ip], jsOB, ip ) );
+    }
 
-        streams.push_back( ImAcqStream( T, p, owner->obQ[ip], jsOB, ip ) );
+// Workers
 
-        if( streams.size() >= nStrPerThd ) {
-            acqThd.push_back( new ImAcqThread( this, acqShr, streams ) );
-            streams.clear();
-        }
-    }
+    acqSched.place();
 
-// Push last stream if needed
+    for( int iThd = 0; iThd < acqSched.nThd; ++iThd )
+        acqThd.push_back( new ImAcqThread( this, acqShr, acqSched, iThd ) );
 
-    if( streams.size() )
-        acqThd.push_back( new ImAcqThread( this, acqShr, streams ) );
+    Log() <<
+        QString("IMEC %1 streams on %2 acquisition workers.")
+        .arg( acqSched.streams.size() ).arg( acqSched.nThd );
 }
 
 /* ---------------------------------------------------------------- */
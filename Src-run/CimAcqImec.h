@@ -5,10 +5,8 @@
 
 #include "CimAcq.h"
 #include "IMEC/NeuropixAPI.h"
-#include "CAR.h"
 
 class CimAcqImec;
-class Biquad;
 
 class QFile;
 
@@ -89,11 +87,12 @@ class ImSimPrbWorker : public QObject
 private:
     std::vector<ImSimDat>   &simDat;
     mutable QMutex          runMtx;
+    double                  speed;
     volatile bool           pleaseStop;
 
 public:
-    ImSimPrbWorker( std::vector<ImSimDat> &simDat )
-        :   QObject(0), simDat(simDat), pleaseStop(false)   {}
+    ImSimPrbWorker( std::vector<ImSimDat> &simDat, double speed )
+        :   QObject(0), simDat(simDat), speed(speed), pleaseStop(false) {}
 
     void stop()             {QMutexLocker ml( &runMtx ); pleaseStop = true;}
     bool isStopped() const  {QMutexLocker ml( &runMtx ); return pleaseStop;}
@@ -113,7 +112,7 @@ private:
     ImSimPrbWorker  *worker;
 
 public:
-    ImSimPrbThread( std::vector<ImSimDat> &simDat );
+    ImSimPrbThread( std::vector<ImSimDat> &simDat, double speed );
     virtual ~ImSimPrbThread();
 };
 
@@ -199,12 +198,10 @@ struct ImAcqShared {
 // Experiment to histogram successive timestamp differences.
     std::vector<quint64>    tStampBins,
                             tStampEvtByPrb;
-    QMutex                  runMtx,
-                            carMtx;
+    QMutex                  runMtx;
     QWaitCondition          condWake;
     int                     awake,
-                            asleep,
-                            ip_CAR;
+                            asleep;
     bool                    stop;
 
     ImAcqShared();
@@ -214,18 +211,6 @@ struct ImAcqShared {
     void tStampHist_EPack( const electrodePacket* E, int ip, int ie, int it );
     void tStampHist_PInfo( const PacketInfo* H, int ip, int it );
 
-    void updateCAR( int ip )
-    {
-        QMutexLocker    ml( &carMtx );
-        ip_CAR = ip;
-    }
-
-    int checkCAR()
-    {
-        QMutexLocker    ml( &carMtx );
-        return ip_CAR;
-    }
-
     bool wait()
     {
         bool    run;
@@ -254,27 +239,6 @@ struct ImAcqShared {
 };
 
 
-struct ImAcqQFlt {
-    double          tTrip;
-    AIQ             *Qf;
-    Biquad          *hipass,
-                    *lopass;
-    CAR             car;
-    mutable QMutex  carMtx;
-    int             maxInt,
-                    nC,
-                    nAP;
-
-    ImAcqQFlt( const DAQ::Params &p, AIQ *Qf, int ip );
-    virtual ~ImAcqQFlt();
-    void mapChanged( const DAQ::Params &p, int ip );
-    void trip();
-    bool testTrip();
-    void enqueue( qint16 *D, int ntpts );
-    void enqueueZero( int ntpts ) const;
-};
-
-
 struct qbfifo {
     int delta_is,
         delta_was,
@@ -326,8 +290,8 @@ struct ImAcqStream {
                 sumEnq;
     quint64     totPts;
     AIQ         *Q;
-    ImAcqQFlt   *QFlt;
     QVector<uint>           vXA;
+    vec_i16                 lfLast;     // NP1 prev LF, all chans
     QMap<quint64,int>       mtStampMiss;
     std::vector<quint32>    vtStampMiss;
     std::vector<quint16>    vstatusMiss;
@@ -340,6 +304,13 @@ struct ImAcqStream {
                 errSYNC[4],
                 errMISS[4];
     PAddr       adr;
+// Scheduler: busy, fifoSched, owner, moveTo guarded by schedMtx.
+    double      cost,           // estimated load
+                busy;           // measured core fraction, -1 = none yet
+    int         fifoLast,       // last 5-sec fifo% average
+                fifoSched,
+                owner,          // worker index
+                moveTo;         // hand off to worker, -1 = stay
     int         fifoAve,
                 fifoN,
                 sumN;
@@ -374,6 +345,41 @@ struct ImAcqStream {
 };
 
 
+// Places streams on acquisition workers, and moves them
+// between workers to even out measured load.
+//
+// Placement: stream cost is estimated from its enqueue rate.
+// High channel count probes get their own (boosted) worker.
+// Other streams are spread over as few workers as estimated
+// capacity allows, largest first, each to the least loaded.
+//
+// Every 5 seconds each worker reports, per stream, the core
+// fraction spent fetching it, and its fifo fill. When the
+// busiest worker is pressed, one stream may move to the least
+// busy worker. The owner hands the stream off between fetches
+// and the new owner adopts it at the top of its next loop.
+//
+struct ImAcqSched {
+    std::vector<ImAcqStream*>   streams;    // owned
+    std::vector<bool>           solo;       // by worker
+    QMutex                      schedMtx;
+    double                      tLastMove;
+    int                         nThd,
+                                gen;
+
+    ImAcqSched() : tLastMove(0), nThd(0), gen(0)   {}
+    virtual ~ImAcqSched()   {clear();}
+
+    void clear();
+    void place();
+    int generation()
+        {QMutexLocker ml( &schedMtx ); return gen;}
+    void mine( std::vector<ImAcqStream*> &vS, int &myGen, int iThd );
+    void report( ImAcqStream &S, double busy );
+    void balance( double tNow );
+};
+
+
 // Handles several streams of mixed type.
 //
 class ImAcqWorker : public QObject
@@ -385,17 +391,22 @@ private:
                                 yieldSum,
                                 loopT,
                                 lastCheckT;
+    AcqLoopStats                loop;
     CimAcqImec                  *acq;
     ImAcqShared                 &shr;
-    std::vector<ImAcqStream>    streams;
+    ImAcqSched                  &sched;
+    std::vector<ImAcqStream*>   streams;
     std::vector<PacketInfo>     H;
     std::vector<qint32>         D;
+    int                         iThd,
+                                schedGen;
 
 public:
     ImAcqWorker(
-        CimAcqImec                  *acq,
-        ImAcqShared                 &shr,
-        std::vector<ImAcqStream>    &streams );
+        CimAcqImec  *acq,
+        ImAcqShared &shr,
+        ImAcqSched  &sched,
+        int         iThd );
 
 signals:
     void finished();
@@ -408,6 +419,7 @@ private:
     bool doProbe_T2( vec_i16 &dst1D, ImAcqStream &S );
     bool do_obx( vec_i16 &dst1D, ImAcqStream &S );
     bool workerYield();
+    void loopReport();
     void profile( ImAcqStream &S );
 };
 
@@ -420,9 +432,10 @@ public:
 
 public:
     ImAcqThread(
-        CimAcqImec                  *acq,
-        ImAcqShared                 &shr,
-        std::vector<ImAcqStream>    &streams );
+        CimAcqImec  *acq,
+        ImAcqShared &shr,
+        ImAcqSched  &sched,
+        int         iThd );
     virtual ~ImAcqThread();
 };
 
@@ -439,6 +452,7 @@ private:
     CimCfg::ImProbeTable        &T;
     ImCfgShared                 cfgShr;
     ImAcqShared                 acqShr;
+    ImAcqSched                  acqSched;
     std::vector<ImSimDat>       simDat;
     std::vector<ImCfgThread*>   cfgThd;
     std::vector<ImAcqThread*>   acqThd;
@@ -1,8 +1,10 @@
 
 #include "CimAcqSim.h"
+#include "BenchRun.h"
 #include "Util.h"
 #include "MainApp.h"
 #include "ConfigCtl.h"
+#include "MetricsWindow.h"  // IWYU pragma: keep
 
 #include <QThread>
 
@@ -81,7 +83,7 @@ void ImSimAcqWorker::run()
     i16Buf.resize( nID );
 
     for( int iID = 0; iID < nID; ++iID )
-        i16Buf[iID].resize( MAXS * probes[iID].nCH );
+        i16Buf[iID].resize( acq->maxS * probes[iID].nCH );
 
     if( !shr.wait() )
         goto exit;
@@ -95,6 +97,7 @@ void ImSimAcqWorker::run()
     while( !acq->isStopped() && !shr.stopping() ) {
 
         loopT = getTime();
+        loop.tick( loopT );
 
         // ------------
         // Do my probes
@@ -148,11 +151,15 @@ void ImSimAcqWorker::run()
                 P.sumN      = 0;
             }
 
+            loopReport();
+
             lastCheckT  = getTime();
         }
     }
 
 exit:
+    BenchCPU::add( BenchCPU::acq );
+
     emit finished();
 }
 
@@ -206,6 +213,30 @@ bool ImSimAcqWorker::doProbe( vec_i16 &dst1D, ImSimAcqProbe &P )
 }
 
 
+// Post fetch-loop period stats for each of my probes.
+//
+void ImSimAcqWorker::loopReport()
+{
+    double  ave = loop.aveMs(),
+            sd  = loop.sdMs(),
+            mx  = loop.maxMs();
+
+    for( int iID = 0, nID = (int)probes.size(); iID < nID; ++iID ) {
+
+        QMetaObject::invokeMethod(
+            mainApp()->metrics(),
+            "prfUpdateLoop",
+            Qt::QueuedConnection,
+            Q_ARG(QString, QString("imec%1").arg( probes[iID].ip )),
+            Q_ARG(double, ave),
+            Q_ARG(double, sd),
+            Q_ARG(double, mx) );
+    }
+
+    loop.reset();
+}
+
+
 // sumN is the number of loop executions in the 5 sec check
 // interval. The minimum value is 5*srate/MAXS.
 //
@@ -288,7 +319,9 @@ ImSimAcqThread::~ImSimAcqThread()
 // MS: 1 probe 0.004 with both audio and shankview
 //
 CimAcqSim::CimAcqSim( IMReaderWorker *owner, const DAQ::Params &p )
-    :   CimAcq(owner, p), T(mainApp()->cfgCtl()->prbTab), maxV(MAXVOLTS)
+    :   CimAcq(owner, p), T(mainApp()->cfgCtl()->prbTab), maxV(MAXVOLTS),
+        speed(qMax( 1.0, p.perf.simSpeed )),
+        maxS(int(ceil( MAXS * qMax( 1.0, p.perf.simSpeed ) )))
 {
 }
 
@@ -477,11 +510,11 @@ int CimAcqSim::fetchE(
     int nS = 0;
 
     double  t0          = owner->imQ[P.ip]->tZero();
-    quint64 targetCt    = (loopT+LOOPSECS - t0) * p.im.prbj[P.ip].srate;
+    quint64 targetCt    = (loopT+LOOPSECS - t0) * p.im.prbj[P.ip].srate * speed;
 
     if( targetCt > P.totPts ) {
 
-        nS = qMin( int((targetCt - P.totPts)), MAXS );
+        nS = qMin( int((targetCt - P.totPts)), maxS );
 
         if( nS <= 0 )
             return nS;
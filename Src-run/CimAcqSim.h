@@ -81,6 +81,7 @@ private:
     CimAcqSim                   *acq;
     ImSimAcqShared              &shr;
     std::vector<ImSimAcqProbe>  probes;
+    AcqLoopStats                loop;
     double                      loopT,
                                 lastCheckT;
 
@@ -99,6 +100,7 @@ public slots:
 
 private:
     bool doProbe( vec_i16 &dst1D, ImSimAcqProbe &P );
+    void loopReport();
     void profile( ImSimAcqProbe &P );
 };
 
@@ -128,7 +130,9 @@ private:
     const CimCfg::ImProbeTable      &T;
     ImSimAcqShared                  shr;
     std::vector<ImSimAcqThread*>    imT;
-    const double                    maxV;
+    const double                    maxV,
+                                    speed;  // x real time
+    const int                       maxS;   // per fetch
 
 public:
     CimAcqSim( IMReaderWorker *owner, const DAQ::Params &p );
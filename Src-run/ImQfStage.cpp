@@ -0,0 +1,319 @@
+
+#include "ImQfStage.h"
+#include "Util.h"
+#include "AIQ.h"
+#include "Biquad.h"
+#include "DAQ.h"
+#include "MainApp.h"
+#include "MetricsWindow.h"  // IWYU pragma: keep
+#include "ThreadPlace.h"
+
+#include <QThread>
+
+#include <string.h>
+
+
+#define QF_CHUNKSECS    0.02    // max data per filter pass
+#define QF_MAXLAGSECS   0.50    // skip ahead beyond this
+#define QF_PRBPERTHD    2
+#define QF_REPORTSECS   5.0
+
+
+/* ---------------------------------------------------------------- */
+/* ImQfProbe ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+ImQfProbe::ImQfProbe( const DAQ::Params &p, const AIQ *Q, AIQ *Qf, int ip )
+    :   Q(Q), Qf(Qf), hipass(0), lopass(0), lagMax(0), shed(0),
+        nextCt(0), ip(ip), tzSet(false)
+{
+    const CimCfg::PrbEach   &E = p.im.prbj[ip];
+
+    if( p.im.prbAll.qf_loCutStr != "0" ) {
+        hipass = new Biquad( bq_type_highpass,
+                        p.im.prbAll.qf_loCutStr.toDouble() / E.srate );
+    }
+
+    if( p.im.prbAll.qf_hiCutStr != "INF" ) {
+        lopass = new Biquad( bq_type_lowpass,
+                        p.im.prbAll.qf_hiCutStr.toDouble() / E.srate );
+    }
+
+    srate       = Q->sRate();
+    maxInt      = E.roTbl->maxInt();
+    nC          = p.stream_nChans( jsIM, ip );
+    nAP         = E.imCumTypCnt[CimCfg::imSumAP];
+    maxTpts     = qMax( 1, int(QF_CHUNKSECS * srate) );
+    maxLagTpts  = int(QF_MAXLAGSECS * srate);
+
+    car.setAuto( E.roTbl );
+    car.setChans( nC, nAP, 1 );
+    car.setSU( &E.sns.shankMap );
+
+    buf.resize( maxTpts * nC );
+}
+
+
+ImQfProbe::~ImQfProbe()
+{
+    if( hipass ) {
+        delete hipass;
+        hipass = 0;
+    }
+
+    if( lopass ) {
+        delete lopass;
+        lopass = 0;
+    }
+}
+
+
+void ImQfProbe::mapChanged( const DAQ::Params &p )
+{
+    QMutexLocker    ml( &carMtx );
+    car.setSU( &p.im.prbj[ip].sns.shankMap );
+}
+
+
+// Filter up to QF_CHUNKSECS of new Q data into Qf.
+// Return true if any data were consumed.
+//
+bool ImQfProbe::doSome()
+{
+    quint64 endCt = Q->endCount();
+
+    if( endCt <= nextCt )
+        return false;
+
+    if( !tzSet ) {
+        Qf->setTZero( Q->tZero() );
+        tzSet = true;
+    }
+
+    quint64 lag = endCt - nextCt;
+
+    lagMax = qMax( lagMax, lag / srate );
+
+// Nobody listening, or too far behind: zero-fill to present
+
+    if( !Qf->qf_isClient() ) {
+        zeroTo( endCt );
+        return true;
+    }
+
+    if( lag > quint64(maxLagTpts) ) {
+        shed += lag / srate;
+        zeroTo( endCt );
+        return true;
+    }
+
+// Copy (filters work in place), then check copy still valid
+
+    AIQ::View   V;
+
+    if( Q->getViewFromCt( V, nextCt, maxTpts ) < 0 ) {
+        quint64 headCt = Q->qHeadCt();
+        shed += (headCt - nextCt) / srate;
+        zeroTo( headCt );
+        return true;
+    }
+
+    int ntpts = V.nTpts();
+
+    if( !ntpts )
+        return false;
+
+    memcpy( &buf[0], V.src[0], V.ntpts[0] * nC * sizeof(qint16) );
+
+    if( V.ntpts[1] ) {
+        memcpy( &buf[V.ntpts[0] * nC], V.src[1],
+            V.ntpts[1] * nC * sizeof(qint16) );
+    }
+
+    if( !V.intact() ) {
+        quint64 headCt = Q->qHeadCt();
+        shed += (headCt - nextCt) / srate;
+        zeroTo( headCt );
+        return true;
+    }
+
+    qint16  *D = &buf[0];
+
+    if( hipass )
+        hipass->applyBlockwiseMem( D, maxInt, ntpts, nC, 0, nAP );
+
+    if( lopass )
+        lopass->applyBlockwiseMem( D, maxInt, ntpts, nC, 0, nAP );
+
+    carMtx.lock();
+        car.gbl_dmx_tbl_auto( D, ntpts );
+    carMtx.unlock();
+
+    Qf->enqueue( D, ntpts );
+    nextCt += ntpts;
+
+    return true;
+}
+
+
+// Post and reset period stats.
+//
+void ImQfProbe::report()
+{
+    QString stream = QString("imec%1").arg( ip, 2, 10, QChar('0') );
+
+    QMetaObject::invokeMethod(
+        mainApp()->metrics(),
+        "prfUpdateQf",
+        Qt::QueuedConnection,
+        Q_ARG(QString, stream),
+        Q_ARG(double, 1000 * lagMax),
+        Q_ARG(double, shed) );
+
+    if( shed > 0 ) {
+        Warning() <<
+            QString("Filtered stream %1 fell behind; %2 s zero-filled.")
+            .arg( stream ).arg( shed, 0, 'f', 2 );
+    }
+
+    lagMax  = 0;
+    shed    = 0;
+}
+
+
+void ImQfProbe::zeroTo( quint64 ct )
+{
+    if( ct > nextCt ) {
+        Qf->enqueueZeroIM( int(ct - nextCt), 0, 0 );
+        nextCt = ct;
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* ImQfWorker ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void ImQfWorker::run()
+{
+    ThreadPlace::pin( ThreadPlace::tpFilter, QString("qf%1").arg( id ) );
+
+    const int   nip         = (int)vip.size();
+    double      tLastReport = getTime();
+
+    while( !shr.isStopped() ) {
+
+        const AIQ   *Qwait  = 0;
+        quint64     ctWait  = 0;
+        bool        busy    = false;
+
+        for( int iip = 0; iip < nip; ++iip ) {
+
+            ImQfProbe   *P = shr.prb[vip[iip]];
+
+            if( P->doSome() )
+                busy = true;
+            else if( !Qwait )
+                P->waitPoint( Qwait, ctWait );
+        }
+
+        // Idle: sleep until new data for one of ours
+
+        if( !busy && Qwait )
+            Qwait->waitForData( ctWait, 5 );
+
+        double  t = getTime();
+
+        if( t - tLastReport >= QF_REPORTSECS ) {
+
+            for( int iip = 0; iip < nip; ++iip )
+                shr.prb[vip[iip]]->report();
+
+            tLastReport = t;
+        }
+    }
+
+    emit finished();
+}
+
+/* ---------------------------------------------------------------- */
+/* ImQfThread ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+ImQfThread::ImQfThread( ImQfShared &shr, std::vector<int> &vip, int id )
+{
+    thread  = new QThread;
+    worker  = new ImQfWorker( shr, vip, id );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+
+// Yield to acquisition workers.
+
+    thread->setPriority( QThread::LowPriority );
+}
+
+
+ImQfThread::~ImQfThread()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() )
+        thread->wait();
+
+    delete thread;
+}
+
+/* ---------------------------------------------------------------- */
+/* ImQfStage ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// Probes dealt round robin over nThd threads.
+//
+ImQfStage::ImQfStage(
+    const DAQ::Params       &p,
+    const QVector<AIQ*>     &imQ,
+    const QVector<AIQ*>     &imQf )
+{
+    int np      = imQf.size(),
+        nThd    = qBound( 1, (np + QF_PRBPERTHD - 1) / QF_PRBPERTHD,
+                    qMax( 1, QThread::idealThreadCount() / 4 ) );
+
+    for( int ip = 0; ip < np; ++ip )
+        shr.prb.push_back( new ImQfProbe( p, imQ[ip], imQf[ip], ip ) );
+
+    for( int iThd = 0; iThd < nThd && iThd < np; ++iThd ) {
+
+        std::vector<int>    vip;
+
+        for( int ip = iThd; ip < np; ip += nThd )
+            vip.push_back( ip );
+
+        qfT.push_back( new ImQfThread( shr, vip, iThd ) );
+    }
+}
+
+
+ImQfStage::~ImQfStage()
+{
+    shr.kill();
+
+    for( int i = 0, n = qfT.size(); i < n; ++i )
+        delete qfT[i];
+
+    qfT.clear();
+}
+
+
+void ImQfStage::mapChanged( const DAQ::Params &p, int ip )
+{
+    if( ip >= 0 && ip < (int)shr.prb.size() )
+        shr.prb[ip]->mapChanged( p );
+}
+
+
@@ -0,0 +1,141 @@
+#ifndef IMQFSTAGE_H
+#define IMQFSTAGE_H
+
+#include "CAR.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+namespace DAQ {
+struct Params;
+}
+
+class AIQ;
+class Biquad;
+
+class QThread;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Filters one probe: imQ -> {hipass, lopass, global demux CAR} -> imQf.
+// Qf counts track Q counts one for one. Spans not filtered (no
+// Qf clients, or shed to catch up) are zero-filled.
+//
+class ImQfProbe
+{
+private:
+    const AIQ       *Q;
+    AIQ             *Qf;
+    Biquad          *hipass,
+                    *lopass;
+    CAR             car;
+    mutable QMutex  carMtx;
+    vec_i16         buf;
+    double          srate,
+                    lagMax,     // secs, this report period
+                    shed;       // secs dropped, this report period
+    quint64         nextCt;
+    int             ip,
+                    maxInt,
+                    nC,
+                    nAP,
+                    maxTpts,
+                    maxLagTpts;
+    bool            tzSet;
+
+public:
+    ImQfProbe( const DAQ::Params &p, const AIQ *Q, AIQ *Qf, int ip );
+    virtual ~ImQfProbe();
+
+    void mapChanged( const DAQ::Params &p );
+    bool doSome();
+    void waitPoint( const AIQ* &Q, quint64 &ct ) const
+        {Q = this->Q; ct = nextCt;}
+    void report();
+
+private:
+    void zeroTo( quint64 ct );
+};
+
+
+struct ImQfShared {
+    std::vector<ImQfProbe*> prb;    // by ip, owned
+    QMutex                  runMtx;
+    bool                    stop;
+
+    ImQfShared() : stop(false)  {}
+    virtual ~ImQfShared()
+        {
+            for( int ip = 0, np = prb.size(); ip < np; ++ip )
+                delete prb[ip];
+        }
+
+    bool isStopped()
+        {QMutexLocker ml( &runMtx ); return stop;}
+    void kill()
+        {QMutexLocker ml( &runMtx ); stop = true;}
+};
+
+
+class ImQfWorker : public QObject
+{
+    Q_OBJECT
+
+private:
+    ImQfShared          &shr;
+    std::vector<int>    vip;
+    int                 id;
+
+public:
+    ImQfWorker( ImQfShared &shr, std::vector<int> &vip, int id )
+    :   QObject(0), shr(shr), vip(vip), id(id)  {}
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+};
+
+
+class ImQfThread
+{
+public:
+    QThread     *thread;
+    ImQfWorker  *worker;
+
+public:
+    ImQfThread( ImQfShared &shr, std::vector<int> &vip, int id );
+    virtual ~ImQfThread();
+};
+
+
+// Pipeline stage producing the filtered imec streams (imQf)
+// from the raw ones (imQ), on its own low priority threads,
+// so filter cost never lands on the acquisition workers.
+// A probe that falls more than a set lag behind skips ahead,
+// zero-filling, rather than holding data back. Lag and shed
+// time are reported in the Metrics window.
+//
+class ImQfStage
+{
+private:
+    ImQfShared                  shr;
+    std::vector<ImQfThread*>    qfT;
+
+public:
+    ImQfStage(
+        const DAQ::Params       &p,
+        const QVector<AIQ*>     &imQ,
+        const QVector<AIQ*>     &imQf );
+    virtual ~ImQfStage();
+
+    void mapChanged( const DAQ::Params &p, int ip );
+};
+
+#endif  // IMQFSTAGE_H
+
+
@@ -4,6 +4,7 @@
 #include "MainApp.h"
 #include "ConfigCtl.h"
 #include "IMReader.h"
+#include "ImQfStage.h"
 #include "NIReader.h"
 #include "GateTCP.h"
 #include "TrigTCP.h"
@@ -12,7 +13,11 @@
 #include "AOCtl.h"
 #include "ColorTTLCtl.h"
 #include "SOCtl.h"
+#include "SampleBufPool.h"
+#include "SpikeDet.h"
 #include "Stim.h"
+#include "Sync.h"
+#include "ThreadPlace.h"
 #include "Version.h"
 
 #include <QAction>
@@ -129,7 +134,8 @@ void Run::GWPair::stopFetching()
 
 Run::Run( MainApp *app )
     :   QObject(0), app(app), niQ(0), imReader(0), niReader(0),
-        gate(0), trg(0), running(false), stopping(false)
+        gate(0), trg(0), spkDet(0), qfStage(0), nSubs(0), running(false), stopping(false),
+        subStop(false)
 {
 }
 
@@ -523,6 +529,67 @@ double Run::getStreamTime() const
     return getTime();
 }
 
+/* ---------------------------------------------------------------- */
+/* Remote subscriber ops ------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// A streaming remote client holds its queue across many
+// reads. It must attach to get the queue, poll subStopping()
+// regularly, and detach when done; stopRun() waits for all
+// subscribers to detach before deleting the queues.
+//
+const AIQ* Run::subAttach( int js, int ip )
+{
+    QMutexLocker    ml( &runMtx );
+
+    if( !running || stopping )
+        return 0;
+
+    const AIQ   *aiQ = 0;
+
+    switch( js ) {
+        case jsNI: aiQ = niQ; break;
+        case jsOB:
+            if( ip < obQ.size() )
+                aiQ = obQ[ip];
+            break;
+        case jsIM:
+            if( ip < imQ.size() )
+                aiQ = imQ[ip];
+            break;
+        case -jsIM:
+            if( ip < imQf.size() )
+                aiQ = imQf[ip];
+            break;
+    }
+
+    if( aiQ ) {
+        QMutexLocker    ms( &subMtx );
+        ++nSubs;
+    }
+
+    return aiQ;
+}
+
+
+void Run::subDetach()
+{
+    QMutexLocker    ms( &subMtx );
+
+    if( nSubs > 0 )
+        --nSubs;
+
+    subCond.wakeAll();
+}
+
+
+bool Run::subStopping() const
+{
+    QMutexLocker    ms( &subMtx );
+
+    return subStop;
+}
+
 /* ---------------------------------------------------------------- */
 /* Run control ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -578,6 +645,8 @@ bool Run::startRun( QString &err )
     if( cpus )
         setProcessAffinityMask( cpus );
 
+    ThreadPlace::plan( app->cpuPlacement(), app->dataDir() );
+
     setProcessorMin( 100 );     // Necessary for Xeon
     setHighPriority( true );
     setPreciseTiming( true );
@@ -594,27 +663,58 @@ bool Run::startRun( QString &err )
     if( nIM && p.im.prbAll.vigilant )
         setStayAwake( true );
 
+    bool    lockFree = p.perf.aiqLockFree;
+
     for( int ip = 0; ip < nIM; ++ip ) {
         imQ.push_back( new AIQ(
-        p.stream_rate( jsIM, ip ), p.stream_nChans( jsIM, ip ), streamSecs ) );
+        p.stream_rate( jsIM, ip ), p.stream_nChans( jsIM, ip ), streamSecs,
+        lockFree ) );
     }
 
     if( p.im.prbAll.qf_on ) {
         for( int ip = 0; ip < nIM; ++ip ) {
             imQf.push_back( new AIQ(
             p.stream_rate( jsIM, ip ), p.stream_nChans( jsIM, ip ),
-            p.im.prbAll.qf_secsStr.toDouble() ) );
+            p.im.prbAll.qf_secsStr.toDouble(), lockFree ) );
         }
     }
 
     for( int ip = 0; ip < nOB; ++ip ) {
         obQ.push_back( new AIQ(
-        p.stream_rate( jsOB, ip ), p.stream_nChans( jsOB, ip ), streamSecs ) );
+        p.stream_rate( jsOB, ip ), p.stream_nChans( jsOB, ip ), streamSecs,
+        lockFree ) );
     }
 
     if( nNI ) {
         niQ = new AIQ(
-        p.stream_rate( jsNI, 0 ), p.stream_nChans( jsNI, 0 ), streamSecs );
+        p.stream_rate( jsNI, 0 ), p.stream_nChans( jsNI, 0 ), streamSecs,
+        lockFree );
+    }
+
+    for( int ip = 0; ip < nIM; ++ip )
+        syncIdxAttach( imQ[ip], jsIM, ip, p );
+
+    for( int ip = 0; ip < nOB; ++ip )
+        syncIdxAttach( obQ[ip], jsOB, ip, p );
+
+    syncIdxAttach( niQ, jsNI, 0, p );
+
+    if( imQf.size() )
+        qfStage = new ImQfStage( p, imQ, imQf );
+
+    if( p.perf.aiqShmExport ) {
+
+        for( int ip = 0; ip < nIM; ++ip )
+            imQ[ip]->shmExport( QString("SpikeGLX_imQ%1").arg( ip ) );
+
+        for( int ip = 0, np = imQf.size(); ip < np; ++ip )
+            imQf[ip]->shmExport( QString("SpikeGLX_imQf%1").arg( ip ) );
+
+        for( int ip = 0; ip < nOB; ++ip )
+            obQ[ip]->shmExport( QString("SpikeGLX_obQ%1").arg( ip ) );
+
+        if( niQ )
+            niQ->shmExport( "SpikeGLX_niQ" );
     }
 
 // ------
@@ -658,6 +758,10 @@ bool Run::startRun( QString &err )
 
     running = true;
 
+    subMtx.lock();
+    subStop = false;
+    subMtx.unlock();
+
     grfUpdateWindowTitles();
 
     QString s = "Acquisition starting up ...";
@@ -686,6 +790,14 @@ void Run::stopRun()
     running  = false;
     stopping = true;
 
+// Release remote subscribers before their queues go away.
+
+    subMtx.lock();
+    subStop = true;
+    while( nSubs )
+        subCond.wait( &subMtx );
+    subMtx.unlock();
+
 #ifdef DO_SNAPSHOTS
     QTimer::singleShot( 0, mainApp(), SLOT(runSnapStopping()) );
 #endif
@@ -711,6 +823,19 @@ void Run::stopRun()
         trg = 0;
     }
 
+    if( spkDet ) {
+        delete spkDet;
+        spkDet = 0;
+    }
+
+    if( qfStage ) {
+        delete qfStage;
+        qfStage = 0;
+    }
+
+    Log() << SampleBufPool::global().statsString();
+    SampleBufPool::global().trim();
+
     if( niReader ) {
         delete niReader;
         niReader = 0;
@@ -751,6 +876,7 @@ void Run::stopRun()
     setStayAwake( false );
     setHighPriority( false );
     setProcessorMin( 5 );
+    ThreadPlace::clear();
     setProcessAffinityMask( 0 );
 
     QString s = "Acquisition stopped.";
@@ -772,6 +898,9 @@ void Run::imecUpdate( int ip )
 
     if( imReader )
         imReader->worker->update( ip );
+
+    if( qfStage )
+        qfStage->mapChanged( app->cfgCtl()->acceptedParams, ip );
 }
 
 /* ---------------------------------------------------------------- */
@@ -1113,6 +1242,54 @@ void Run::qf_remoteClientDisable()
         imQf[ip]->qf_remoteClient( false );
 }
 
+/* ---------------------------------------------------------------- */
+/* Spike detector ops --------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Detector threads are created on first use in a run.
+// Sidecar goes to "<dataDir>/<runName>.imec<ip>.spikes".
+//
+QString Run::spkDetSet( int ip, const SpkDetParams &P, bool sidecar )
+{
+    QMutexLocker    ml( &runMtx );
+
+    if( !running || stopping )
+        return "Not running.";
+
+    if( !imQf.size() )
+        return "Filtered imec streams (imQf) not enabled.";
+
+    const DAQ::Params   &p = app->cfgCtl()->acceptedParams;
+
+    if( !spkDet )
+        spkDet = new SpikeDet( p, imQf );
+
+    QString path;
+
+    if( sidecar ) {
+        path = QString("%1/%2.imec%3.spikes")
+                .arg( app->dataDir() ).arg( p.sns.runName ).arg( ip );
+    }
+
+    return spkDet->set( ip, P, path );
+}
+
+
+QString Run::spkDetFetch(
+    std::vector<SpkEvt> &dst,
+    quint64             &fromSeq,
+    quint64             &nextSeq,
+    int                 ip,
+    int                 nMax )
+{
+    QMutexLocker    ml( &runMtx );
+
+    if( !spkDet )
+        return "Spike detection not running.";
+
+    return spkDet->fetch( dst, fromSeq, nextSeq, ip, nMax );
+}
+
 /* ---------------------------------------------------------------- */
 /* Private slots -------------------------------------------------- */
 /* ---------------------------------------------------------------- */
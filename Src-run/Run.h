@@ -6,6 +6,7 @@
 #include <QObject>
 #include <QMutex>
 #include <QVector>
+#include <QWaitCondition>
 
 #include <vector>
 
@@ -22,6 +23,10 @@ class NIReader;
 class Gate;
 class Trigger;
 class AIQ;
+class SpikeDet;
+class ImQfStage;
+struct SpkDetParams;
+struct SpkEvt;
 
 class QFileInfo;
 
@@ -59,10 +64,16 @@ private:
     NIReader            *niReader;      // guarded by runMtx
     Gate                *gate;          // guarded by runMtx
     Trigger             *trg;           // guarded by runMtx
-    mutable QMutex      runMtx;
+    SpikeDet            *spkDet;        // guarded by runMtx
+    ImQfStage           *qfStage;       // guarded by runMtx
+    mutable QMutex      runMtx,
+                        subMtx;
+    QWaitCondition      subCond;
+    int                 nSubs;          // guarded by subMtx
     bool                running,        // guarded by runMtx
                         stopping,       // guarded by runMtx
-                        dumx[2];
+                        subStop,        // guarded by subMtx
+                        dumx[1];
 
 public:
     Run( MainApp *app );
@@ -91,6 +102,11 @@ public:
     const AIQ* getQ( int js, int ip ) const;
     double getStreamTime() const;
 
+// Remote subscriber ops
+    const AIQ* subAttach( int js, int ip );
+    void subDetach();
+    bool subStopping() const;
+
 // Run control
     bool isRunning() const;
     bool startRun( QString &err );
@@ -135,6 +151,15 @@ public slots:
 // AIQ ops
     void qf_remoteClientDisable();
 
+// Spike detector ops
+    QString spkDetSet( int ip, const SpkDetParams &P, bool sidecar );
+    QString spkDetFetch(
+        std::vector<SpkEvt> &dst,
+        quint64             &fromSeq,
+        quint64             &nextSeq,
+        int                 ip,
+        int                 nMax );
+
 private slots:
     void gettingSamples();
     void workerStopsRun();
@@ -0,0 +1,487 @@
+
+#include "SpikeDet.h"
+#include "Util.h"
+#include "DAQ.h"
+#include "AIQ.h"
+#include "ThreadPlace.h"
+
+#include <QThread>
+
+#include <limits.h>
+#include <string.h>
+
+
+#define SPK_VERSION     1
+#define SPK_RINGEVTS    (256*1024)  // per probe, 4 MB
+#define SPK_CHUNKSECS   0.05        // max data per detect pass
+#define SPK_PRBPERTHD   2
+
+static const char spkMagic[8] = {'S','G','L','X','S','P','K','1'};
+
+/* ---------------------------------------------------------------- */
+/* SpkEvtRing ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void SpkEvtRing::append( const SpkEvt *E, int n )
+{
+    QMutexLocker    ml( &ringMtx );
+
+    int cap = buf.size();
+
+    for( int i = 0; i < n; ++i )
+        buf[(total + i) % cap] = E[i];
+
+    total += n;
+}
+
+
+// Copy up to nMax events from seq fromSeq into dst.
+// If fromSeq is no longer held, it's advanced to the
+// oldest held. Return count.
+//
+int SpkEvtRing::fetch(
+    std::vector<SpkEvt> &dst,
+    quint64             &fromSeq,
+    int                 nMax ) const
+{
+    QMutexLocker    ml( &ringMtx );
+
+    quint64 cap     = buf.size(),
+            oldest  = (total > cap ? total - cap : 0);
+
+    if( fromSeq < oldest )
+        fromSeq = oldest;
+
+    if( fromSeq >= total || nMax <= 0 ) {
+        dst.clear();
+        return 0;
+    }
+
+    int n = int(qMin( quint64(nMax), total - fromSeq ));
+
+    dst.resize( n );
+
+    for( int i = 0; i < n; ++i )
+        dst[i] = buf[(fromSeq + i) % cap];
+
+    return n;
+}
+
+
+quint64 SpkEvtRing::nextSeq() const
+{
+    QMutexLocker    ml( &ringMtx );
+
+    return total;
+}
+
+/* ---------------------------------------------------------------- */
+/* SpkDetProbe ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+SpkDetProbe::SpkDetProbe(
+    const DAQ::Params   &p,
+    const AIQ           *Qf,
+    int                 ip,
+    const SpkDetParams  &P )
+    :   Qf(Qf), ring(SPK_RINGEVTS), P(P), nSide(0), ip(ip)
+{
+    const CimCfg::PrbEach   &E = p.im.prbj[ip];
+    const IMROTbl           *R = E.roTbl;
+
+    nC      = Qf->nChans();
+    nAP     = E.imCumTypCnt[CimCfg::imSumAP];
+    maxTpts = qMax( 1, int(SPK_CHUNKSECS * Qf->sRate()) );
+
+    refracCt = quint64(P.refracMs * 1e-3 * Qf->sRate());
+
+// Thresholds in int16 units, per AP gain
+
+    double  v2i = R->maxInt() * P.uV * 1e-6 / R->maxVolts();
+
+    T.resize( nAP );
+
+    for( int c = 0; c < nAP; ++c )
+        T[c] = -qBound( 1, int(v2i * R->apGain( c )), SHRT_MAX );
+
+    runCt.resize( nAP );
+    okCt.resize( nAP );
+    runLen.resize( nAP );
+    pk.resize( nAP );
+
+    reset();
+
+    nextCt = Qf->endCount();
+}
+
+
+SpkDetProbe::~SpkDetProbe()
+{
+    closeSidecar();
+}
+
+
+// Sidecar placeholder header, sealed by closeSidecar().
+//
+bool SpkDetProbe::openSidecar( QString &err, const QString &path )
+{
+    fSide.setFileName( path );
+
+    if( !fSide.open( QIODevice::WriteOnly ) ) {
+        err = QString("<%1> opening(write) '%2'")
+                .arg( fSide.errorString() ).arg( path );
+        return false;
+    }
+
+    SpkEvtHdr   H;
+    memset( &H, 0, sizeof(H) );
+
+    if( fSide.write( (char*)&H, sizeof(H) ) != sizeof(H) ) {
+        err = QString("<%1> writing '%2'")
+                .arg( fSide.errorString() ).arg( path );
+        fSide.close();
+        fSide.remove();
+        return false;
+    }
+
+    return true;
+}
+
+
+// Detect in up to SPK_CHUNKSECS of new data.
+// Return true if any data were consumed.
+//
+bool SpkDetProbe::detectSome()
+{
+    AIQ::View   V;
+
+    if( Qf->getViewFromCt( V, nextCt, maxTpts ) < 0 ) {
+
+        // Fell behind: resume at oldest data
+
+        Warning() <<
+            QString("SpikeDet imec%1 fell behind; events lost.").arg( ip );
+
+        reset();
+        nextCt = Qf->qHeadCt();
+        return true;
+    }
+
+    int ntpts = V.nTpts();
+
+    if( !ntpts )
+        return false;
+
+    evts.clear();
+
+    scan( V.src[0], V.ntpts[0], nextCt );
+
+    if( V.ntpts[1] )
+        scan( V.src[1], V.ntpts[1], nextCt + V.ntpts[0] );
+
+    if( !V.intact() ) {
+        reset();
+        nextCt = Qf->qHeadCt();
+        return true;
+    }
+
+    nextCt += ntpts;
+
+    if( evts.size() ) {
+
+        ring.append( &evts[0], evts.size() );
+
+        if( fSide.isOpen() ) {
+
+            qint64  bytes = evts.size() * sizeof(SpkEvt);
+
+            if( fSide.write( (char*)&evts[0], bytes ) == bytes )
+                nSide += evts.size();
+            else {
+                Warning() <<
+                    QString("SpikeDet imec%1 sidecar write error <%2>.")
+                    .arg( ip ).arg( fSide.errorString() );
+                closeSidecar();
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// Forget partial runs, e.g., across a data gap.
+//
+void SpkDetProbe::reset()
+{
+    for( int c = 0; c < nAP; ++c ) {
+        runLen[c]   = 0;
+        okCt[c]     = 0;
+    }
+}
+
+
+// Walk timepoints in order (cache friendly), tracking each
+// AP channel's run of samples at or below its threshold.
+// A run of at least inarow samples, starting outside the
+// channel's refractory window, makes one event.
+//
+void SpkDetProbe::scan( const qint16 *src, int ntpts, quint64 ct0 )
+{
+    const qint16    *t      = &T[0];
+    qint16          *p      = &pk[0];
+    int             *n      = &runLen[0];
+    int             inarow  = P.inarow;
+
+    for( int it = 0; it < ntpts; ++it, src += nC ) {
+
+        quint64 ct = ct0 + it;
+
+        for( int c = 0; c < nAP; ++c ) {
+
+            qint16  v = src[c];
+
+            if( v <= t[c] ) {
+
+                if( !n[c]++ ) {
+                    runCt[c]    = ct;
+                    p[c]        = v;
+                }
+                else if( v < p[c] )
+                    p[c] = v;
+            }
+            else if( n[c] ) {
+
+                if( n[c] >= inarow && runCt[c] >= okCt[c] ) {
+
+                    SpkEvt  E;
+                    E.ct    = runCt[c];
+                    E.chan  = c;
+                    E.amp   = p[c];
+                    E.width = n[c];
+                    evts.push_back( E );
+
+                    okCt[c] = runCt[c] + refracCt;
+                }
+
+                n[c] = 0;
+            }
+        }
+    }
+}
+
+
+void SpkDetProbe::closeSidecar()
+{
+    if( !fSide.isOpen() )
+        return;
+
+    SpkEvtHdr   H;
+    memset( &H, 0, sizeof(H) );
+
+    memcpy( H.magic, spkMagic, 8 );
+    H.version   = SPK_VERSION;
+    H.ip        = ip;
+    H.srate     = Qf->sRate();
+    H.uV        = P.uV;
+    H.refracMs  = P.refracMs;
+    H.inarow    = P.inarow;
+    H.nEvts     = nSide;
+
+    if( !fSide.seek( 0 ) || fSide.write( (char*)&H, sizeof(H) ) != sizeof(H) ) {
+        Warning() <<
+            QString("SpikeDet imec%1 sidecar seal error <%2>.")
+            .arg( ip ).arg( fSide.errorString() );
+    }
+
+    fSide.close();
+}
+
+/* ---------------------------------------------------------------- */
+/* SpkDetWorker --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void SpkDetWorker::run()
+{
+    const int   nip = (int)vip.size();
+
+    ThreadPlace::pin(
+        ThreadPlace::tpAux, QString("spkdet%1").arg( nip ? vip[0] : 0 ) );
+
+    while( !shr.isStopped() ) {
+
+        const AIQ   *Qwait  = 0;
+        quint64     ctWait  = 0;
+        bool        busy    = false;
+
+        for( int iip = 0; iip < nip; ++iip ) {
+
+            SpkDetShared::Slot  *S = shr.slot[vip[iip]];
+            QMutexLocker        ml( &S->slotMtx );
+
+            if( S->P ) {
+
+                if( S->P->detectSome() )
+                    busy = true;
+                else if( !Qwait )
+                    S->P->waitPoint( Qwait, ctWait );
+            }
+        }
+
+        // Idle: sleep until new data for one of ours
+
+        if( !busy ) {
+
+            if( Qwait )
+                Qwait->waitForData( ctWait, 10 );
+            else
+                QThread::msleep( 50 );
+        }
+    }
+
+    emit finished();
+}
+
+/* ---------------------------------------------------------------- */
+/* SpkDetThread --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+SpkDetThread::SpkDetThread( SpkDetShared &shr, std::vector<int> &vip )
+{
+    thread  = new QThread;
+    worker  = new SpkDetWorker( shr, vip );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+}
+
+
+SpkDetThread::~SpkDetThread()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() )
+        thread->wait();
+
+    delete thread;
+}
+
+/* ---------------------------------------------------------------- */
+/* SpikeDet ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+SpikeDet::SpikeDet( const DAQ::Params &p, const QVector<AIQ*> &imQf )
+    :   p(p), imQf(imQf), shr(imQf.size())
+{
+    int np = imQf.size();
+
+    for( int ip0 = 0; ip0 < np; ip0 += SPK_PRBPERTHD ) {
+
+        std::vector<int>    vip;
+
+        for( int k = 0; k < SPK_PRBPERTHD && ip0 + k < np; ++k )
+            vip.push_back( ip0 + k );
+
+        spkT.push_back( new SpkDetThread( shr, vip ) );
+    }
+}
+
+
+SpikeDet::~SpikeDet()
+{
+    shr.kill();
+
+    for( int i = 0, n = spkT.size(); i < n; ++i )
+        delete spkT[i];
+
+    spkT.clear();
+
+    for( int ip = 0, np = imQf.size(); ip < np; ++ip ) {
+        if( shr.slot[ip]->P )
+            imQf[ip]->qf_detectClient( false );
+    }
+}
+
+
+// Start, restart (uV > 0) or stop (uV <= 0) detection on probe ip.
+// Restarting resets the event sequence. Empty sidecar path means
+// no sidecar file. On error detection is left stopped.
+// Return error string, empty if OK.
+//
+QString SpikeDet::set( int ip, const SpkDetParams &P, const QString &sidecar )
+{
+    if( ip < 0 || ip >= imQf.size() )
+        return QString("Probe %1 has no filtered stream.").arg( ip );
+
+    if( P.uV > 0 && (P.inarow < 1 || P.refracMs < 0) )
+        return "Requires inarow >= 1 and refractory >= 0.";
+
+    SpkDetShared::Slot  *S = shr.slot[ip];
+    SpkDetProbe         *D = 0;
+    QString             err;
+
+// Retire old detector first: that seals its sidecar
+// before a new detector may reopen the same path.
+
+    S->slotMtx.lock();
+        D    = S->P;
+        S->P = 0;
+    S->slotMtx.unlock();
+
+    delete D;
+    D = 0;
+
+    if( P.uV > 0 ) {
+
+        D = new SpkDetProbe( p, imQf[ip], ip, P );
+
+        if( !sidecar.isEmpty() && !D->openSidecar( err, sidecar ) ) {
+            delete D;
+            D   = 0;
+            err = "Sidecar error " + err;
+        }
+    }
+
+    S->slotMtx.lock();
+        S->P = D;
+    S->slotMtx.unlock();
+
+// Client flag tracks the slot, never a probe's lifetime
+
+    imQf[ip]->qf_detectClient( D != 0 );
+
+    return err;
+}
+
+
+QString SpikeDet::fetch(
+    std::vector<SpkEvt> &dst,
+    quint64             &fromSeq,
+    quint64             &nextSeq,
+    int                 ip,
+    int                 nMax )
+{
+    dst.clear();
+
+    if( ip < 0 || ip >= imQf.size() )
+        return QString("Probe %1 has no filtered stream.").arg( ip );
+
+    SpkDetShared::Slot  *S = shr.slot[ip];
+    QMutexLocker        ml( &S->slotMtx );
+
+    if( !S->P )
+        return QString("Spike detection not running on probe %1.").arg( ip );
+
+    S->P->events().fetch( dst, fromSeq, nMax );
+    nextSeq = S->P->events().nextSeq();
+
+    return QString();
+}
+
+
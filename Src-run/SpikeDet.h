@@ -0,0 +1,224 @@
+#ifndef SPIKEDET_H
+#define SPIKEDET_H
+
+#include "SGLTypes.h"
+
+#include <QFile>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+namespace DAQ {
+struct Params;
+}
+
+class AIQ;
+
+class QThread;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// One threshold crossing, as served remotely and stored in
+// the sidecar (16 bytes, little-endian).
+//
+struct SpkEvt {
+    quint64 ct;     // imQf count of first sample over threshold
+    quint16 chan;   // AP channel (acq index)
+    qint16  amp;    // peak (most negative) value, int16 units
+    quint32 width;  // timepoints over threshold
+};
+
+
+struct SpkDetParams {
+    double  uV,         // threshold magnitude; crossings are negative
+            refracMs;   // per channel dead time after an event
+    int     inarow;     // min consecutive samples over threshold
+
+    SpkDetParams() : uV(0), refracMs(1.0), inarow(3)    {}
+};
+
+
+// Fixed-capacity event ring. Events are numbered (seq) from
+// zero since the detector started; readers ask for events
+// from a seq, and learn the first seq still held if they
+// fell behind.
+//
+class SpkEvtRing
+{
+private:
+    mutable QMutex      ringMtx;
+    std::vector<SpkEvt> buf;
+    quint64             total;
+
+public:
+    SpkEvtRing( int capacity ) : buf(capacity), total(0)    {}
+
+    void append( const SpkEvt *E, int n );
+    int fetch(
+        std::vector<SpkEvt> &dst,
+        quint64             &fromSeq,
+        int                 nMax ) const;
+    quint64 nextSeq() const;
+};
+
+
+// Sidecar "<dataDir>/<runName>.imec<ip>.spikes":
+// header, magic written last so partial files are rejected;
+// then nEvts SpkEvt.
+//
+struct SpkEvtHdr {
+    char    magic[8];
+    quint32 version,
+            ip;
+    double  srate,
+            uV,
+            refracMs;
+    qint32  inarow,
+            pad;
+    qint64  nEvts;
+};
+
+
+// Detection state for one probe's AP channels.
+// Crossings are negative-going, per-channel thresholds are
+// uV scaled by each channel's AP gain (as Heatmap). An event
+// is emitted when its run of over-threshold samples ends, so
+// ct order is exact per channel, approximate across channels.
+//
+class SpkDetProbe
+{
+private:
+    const AIQ               *Qf;
+    SpkEvtRing              ring;
+    SpkDetParams            P;
+    QFile                   fSide;
+    std::vector<SpkEvt>     evts;
+    std::vector<quint64>    runCt,
+                            okCt;   // refractory end
+    std::vector<int>        runLen;
+    vec_i16                 T,
+                            pk;
+    quint64                 nextCt,
+                            refracCt,
+                            nSide;
+    int                     ip,
+                            nC,
+                            nAP,
+                            maxTpts;
+
+public:
+    SpkDetProbe(
+        const DAQ::Params   &p,
+        const AIQ           *Qf,
+        int                 ip,
+        const SpkDetParams  &P );
+    virtual ~SpkDetProbe();
+
+    bool openSidecar( QString &err, const QString &path );
+    const SpkEvtRing &events() const    {return ring;}
+
+    bool detectSome();
+    void waitPoint( const AIQ* &Q, quint64 &ct ) const
+        {Q = Qf; ct = nextCt;}
+
+private:
+    void reset();
+    void scan( const qint16 *src, int ntpts, quint64 ct0 );
+    void closeSidecar();
+};
+
+
+// Shared by workers; probes come and go on remote command.
+// Each probe slot has its own lock, held by a worker while
+// it detects, and by SpikeDet to swap or read the probe.
+//
+struct SpkDetShared {
+    struct Slot {
+        QMutex      slotMtx;
+        SpkDetProbe *P;
+        Slot() : P(0)   {}
+    };
+
+    std::vector<Slot*>  slot;   // by ip
+    QMutex              runMtx;
+    bool                stop;
+
+    SpkDetShared( int np ) : stop(false)
+        {for( int ip = 0; ip < np; ++ip ) slot.push_back( new Slot );}
+    virtual ~SpkDetShared()
+        {
+            for( int ip = 0, np = slot.size(); ip < np; ++ip ) {
+                delete slot[ip]->P;
+                delete slot[ip];
+            }
+        }
+
+    bool isStopped()
+        {QMutexLocker ml( &runMtx ); return stop;}
+    void kill()
+        {QMutexLocker ml( &runMtx ); stop = true;}
+};
+
+
+class SpkDetWorker : public QObject
+{
+    Q_OBJECT
+
+private:
+    SpkDetShared        &shr;
+    std::vector<int>    vip;
+
+public:
+    SpkDetWorker( SpkDetShared &shr, std::vector<int> &vip )
+    :   QObject(0), shr(shr), vip(vip)  {}
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+};
+
+
+class SpkDetThread
+{
+public:
+    QThread         *thread;
+    SpkDetWorker    *worker;
+
+public:
+    SpkDetThread( SpkDetShared &shr, std::vector<int> &vip );
+    virtual ~SpkDetThread();
+};
+
+
+// Online threshold-crossing detector over imQf AP channels.
+// Probes are spread over a few worker threads, two per
+// thread, as TrigSpike does.
+//
+class SpikeDet
+{
+private:
+    const DAQ::Params           &p;
+    const QVector<AIQ*>         &imQf;
+    SpkDetShared                shr;
+    std::vector<SpkDetThread*>  spkT;
+
+public:
+    SpikeDet( const DAQ::Params &p, const QVector<AIQ*> &imQf );
+    virtual ~SpikeDet();
+
+    QString set( int ip, const SpkDetParams &P, const QString &sidecar );
+    QString fetch(
+        std::vector<SpkEvt> &dst,
+        quint64             &fromSeq,
+        quint64             &nextSeq,
+        int                 ip,
+        int                 nMax );
+};
+
+#endif  // SPIKEDET_H
+
+
@@ -1,6 +1,9 @@
 
 HEADERS += \
     $$PWD/AIQ.h \
+    $$PWD/AIQShm.h \
+    $$PWD/AIQShmHdr.h \
+    $$PWD/BenchRun.h \
     $$PWD/CalSRate.h \
     $$PWD/CalSRateCtl.h \
     $$PWD/CimAcq.h \
@@ -12,15 +15,19 @@ HEADERS += \
     $$PWD/IMBISTCtl.h \
     $$PWD/IMFirmCtl.h \
     $$PWD/IMHSTCtl.h \
+    $$PWD/ImQfStage.h \
     $$PWD/IMReader.h \
     $$PWD/NIReader.h \
     $$PWD/Run.h \
+    $$PWD/SpikeDet.h \
     $$PWD/Stim.h \
     $$PWD/SvyPrb.h \
     $$PWD/Sync.h
 
 SOURCES += \
     $$PWD/AIQ.cpp \
+    $$PWD/AIQShm.cpp \
+    $$PWD/BenchRun.cpp \
     $$PWD/CalSRate.cpp \
     $$PWD/CalSRateCtl.cpp \
     $$PWD/CimAcqImec.cpp \
@@ -34,9 +41,11 @@ SOURCES += \
     $$PWD/IMBISTCtl.cpp \
     $$PWD/IMFirmCtl.cpp \
     $$PWD/IMHSTCtl.cpp \
+    $$PWD/ImQfStage.cpp \
     $$PWD/IMReader.cpp \
     $$PWD/NIReader.cpp \
     $$PWD/Run.cpp \
+    $$PWD/SpikeDet.cpp \
     $$PWD/Stim.cpp \
     $$PWD/SvyPrb.cpp \
     $$PWD/Sync.cpp
@@ -3,6 +3,133 @@
 #include "DAQ.h"
 
 
+#define SYNC_INAROW     100
+
+/* ---------------------------------------------------------------- */
+/* SyncEdgeIdx ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+SyncEdgeIdx::SyncEdgeIdx( int chan, int bit, qint16 T, int inarow )
+    :   ring(NEDGE), startCt(0), candCt(0), head(0), len(0),
+        chan(chan), bit(bit), inarow(qMax( 1, inarow )), nok(0),
+        T(T), state(needLow)
+{
+}
+
+
+// Advance the edge state machine over nCts new timepoints
+// whose first count is ct0. Only confirmed edges are stored,
+// so coverage runs up to any candidate still in progress.
+//
+void SyncEdgeIdx::update(
+    const qint16    *src,
+    int             nCts,
+    int             nchans,
+    quint64         ct0 )
+{
+    QMutexLocker    ml( &idxMtx );
+
+    src += chan;
+
+    for( int i = 0; i < nCts; ++i, src += nchans ) {
+
+        bool    hi = isHigh( *src );
+
+        switch( state ) {
+            case needLow:
+            case high:
+                if( !hi )
+                    state = low;
+                break;
+            case low:
+                if( hi ) {
+                    candCt  = ct0 + i;
+                    nok     = 1;
+                    state   = run;
+                    if( inarow == 1 ) {
+                        push( candCt );
+                        state = high;
+                    }
+                }
+                break;
+            case run:
+                if( !hi )
+                    state = low;
+                else if( ++nok >= inarow ) {
+                    push( candCt );
+                    state = high;
+                }
+                break;
+        }
+    }
+}
+
+
+// Samples just enqueued were synthesized (zero-fill);
+// require a fresh low before the next edge.
+//
+void SyncEdgeIdx::gap()
+{
+    QMutexLocker    ml( &idxMtx );
+
+    state = needLow;
+}
+
+
+// Seek first edge with count > fromCt, as an AIQ scan
+// starting at fromCt would report it.
+//
+// Return:
+// -1 = fromCt precedes indexed span; caller must scan.
+//  0 = no edge yet.
+//  1 = edge @ outCt.
+//
+int SyncEdgeIdx::find( quint64 &outCt, quint64 fromCt ) const
+{
+    QMutexLocker    ml( &idxMtx );
+
+    if( fromCt < startCt )
+        return -1;
+
+// Binary search for first element > fromCt
+
+    int lo = 0,
+        hi = len;
+
+    while( lo < hi ) {
+
+        int mid = (lo + hi) / 2;
+
+        if( ring[(head + mid) % NEDGE] > fromCt )
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    if( lo >= len )
+        return 0;
+
+    outCt = ring[(head + lo) % NEDGE];
+    return 1;
+}
+
+
+// Dropping the oldest edge advances coverage to it:
+// there may have been older edges we no longer hold.
+//
+void SyncEdgeIdx::push( quint64 ct )
+{
+    if( len == NEDGE ) {
+        startCt = ring[head];
+        head    = (head + 1) % NEDGE;
+        --len;
+    }
+
+    ring[(head + len) % NEDGE] = ct;
+    ++len;
+}
+
+
 /* ---------------------------------------------------------------- */
 /* SyncStream ----------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -50,10 +177,20 @@ bool SyncStream::findEdge(
 
     fromCt -= (fromCt >= stepBack ? stepBack : fromCt);
 
+    const SyncEdgeIdx   *X = Q->syncIdx();
+
+    if( X ) {
+
+        int found = X->find( outCt, fromCt );
+
+        if( found >= 0 )
+            return found > 0;
+    }
+
     if( bit < 0 )
-        return Q->findRisingEdge( outCt, fromCt, chan, thresh, 100 );
+        return Q->findRisingEdge( outCt, fromCt, chan, thresh, SYNC_INAROW );
     else
-        return Q->findBitRisingEdge( outCt, fromCt, chan, bit, 100 );
+        return Q->findBitRisingEdge( outCt, fromCt, chan, bit, SYNC_INAROW );
 }
 
 /* ---------------------------------------------------------------- */
@@ -201,3 +338,20 @@ void syncDstTAbsMult(
 }
 
 
+// Have Q index its sync edges as they arrive, so that
+// SyncStream::findEdge() is a lookup rather than a scan.
+// Call before the stream starts.
+//
+void syncIdxAttach( AIQ *Q, int js, int ip, const DAQ::Params &p )
+{
+    if( !Q || p.sync.sourceIdx == DAQ::eSyncSourceNone )
+        return;
+
+    SyncStream  S;
+
+    S.init( Q, js, ip, p );
+
+    Q->setSyncIdx( new SyncEdgeIdx( S.chan, S.bit, S.thresh, SYNC_INAROW ) );
+}
+
+
@@ -3,6 +3,8 @@
 
 #include "AIQ.h"
 
+#include <QMutex>
+
 namespace DAQ {
 struct Params;
 }
@@ -11,6 +13,59 @@ struct Params;
 /* Types ---------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
+// Rising edges of a stream's sync signal, found as data are
+// enqueued, so mapping needn't walk the ring. Edges qualify as
+// for AIQ::findBitRisingEdge/findRisingEdge: a low, then at
+// least inarow highs. The newest NEDGE edge counts are kept.
+//
+// Producer (AIQ enqueue) calls update/gap; any thread calls find.
+//
+class SyncEdgeIdx
+{
+private:
+    enum {
+        NEDGE   = 4096
+    };
+
+    enum State {
+        needLow,
+        low,
+        run,
+        high
+    };
+
+    std::vector<quint64>    ring;
+    mutable QMutex          idxMtx;
+    quint64                 startCt,    // coverage begins
+                            candCt;
+    int                     head,
+                            len,
+                            chan,
+                            bit,        // -1=analog
+                            inarow,
+                            nok;
+    qint16                  T;
+    State                   state;
+
+public:
+    SyncEdgeIdx( int chan, int bit, qint16 T, int inarow );
+
+    void update(
+        const qint16    *src,
+        int             nCts,
+        int             nchans,
+        quint64         ct0 );
+    void gap();
+
+    int find( quint64 &outCt, quint64 fromCt ) const;
+
+private:
+    bool isHigh( qint16 v ) const
+        {return (bit >= 0 ? (v >> bit) & 1 : v >= T);}
+    void push( quint64 ct );
+};
+
+
 struct SyncStream
 {
     mutable double  tAbs;   // output
@@ -61,6 +116,8 @@ void syncDstTAbsMult(
     const std::vector<SyncStream>   &vS,
     const DAQ::Params               &p );
 
+void syncIdxAttach( AIQ *Q, int js, int ip, const DAQ::Params &p );
+
 #endif  // SYNC_H
 
 
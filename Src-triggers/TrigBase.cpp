@@ -8,6 +8,7 @@
 #include "MainApp.h"
 #include "GraphsWindow.h"
 #include "MetricsWindow.h"
+#include "SampleBufPool.h"
 
 #include <QDir>
 #include <QFileInfo>
@@ -30,9 +31,9 @@ TrigBase::TrigBase(
     const QVector<AIQ*> &imQ,
     const QVector<AIQ*> &obQ,
     const AIQ           *niQ )
-    :   QObject(0), imQ(imQ), obQ(obQ), niQ(niQ), dfNi(0),
+    :   QObject(0), imQ(imQ), obQ(obQ), niQ(niQ), wakeQ(0), dfNi(0),
         ovr(p), startT(-1), gateHiT(-1), gateLoT(-1), trigHiT(-1),
-        firstCtNi(0), offHertz(0), offmsec(0), onHertz(0), onmsec(0),
+        firstCtNi(0), wakeCt(0), offHertz(0), offmsec(0), onHertz(0), onmsec(0),
         nImQ(imQ.size()), nObQ(obQ.size()), nNiQ(niQ != 0),
         iGate(-1), iTrig(-1), g_reported(-1), t_reported(-1),
         gateHi(false), pleaseStop(false), p(p), gw(gw), statusT(-1)
@@ -433,13 +434,16 @@ void TrigBase::setSyncWriteMode()
 }
 
 
+// Get zero-copy view of stream samples starting at fromCt.
+// The view is consumed (and validated) by writeAndInvalView().
+//
 // A positive nMax value is the number of samples to retrieve.
 // A negative nMax is negative of LOOP_MS.
 //
 // Return ok.
 //
-bool TrigBase::nSampsFromCt(
-    vec_i16     &data,
+bool TrigBase::viewFromCt(
+    AIQ::View   &V,
     quint64     fromCt,
     int         nMax,
     int         js,
@@ -470,20 +474,7 @@ bool TrigBase::nSampsFromCt(
         nMax = 4.0 * 0.001 * -nMax * Q->sRate();
     }
 
-    try {
-        data.reserve( nMax * Q->nChans() );
-    }
-    catch( const std::exception& ) {
-        Error() <<  "Trigger low mem (See log window text).";
-        Log() <<    "(1) Check Windows System Event Log to see if SpikeGLX"
-                    " or another app was using excessive memory at this time.";
-        Log() <<    "(2) If SpikeGLX, make sure you write runs to a local SSD"
-                    " drive that maintains the required write rate for the"
-                    " duration of the run (see Metrics Window help).";
-        return false;
-    }
-
-    ret = Q->getNSampsFromCtProfile( pct, data, fromCt, nMax );
+    ret = Q->getViewFromCt( V, fromCt, nMax, &pct );
 
     if( tProf - tLastProf[iq] >= 2.0 ) {
 
@@ -529,18 +520,15 @@ bool TrigBase::nSampsFromCt(
 
 
 // This function dispatches ALL stream writing to the
-// proper DataFile(s).
+// proper DataFile(s). Samples are copied straight out
+// of the stream's ring.
 //
-bool TrigBase::writeAndInvalData(
-    int         js,
-    int         ip,
-    vec_i16     &data,
-    quint64     headCt )
+bool TrigBase::writeAndInvalView( int js, int ip, const AIQ::View &V )
 {
     switch( js ) {
-        case jsNI:          return writeDataNI( data, headCt );
-        case jsOB:          return writeDataOB( data, headCt, ip );
-        default /*jsIM*/:   return writeDataIM( data, headCt, ip );
+        case jsNI:          return writeDataNI( V );
+        case jsOB:          return writeDataOB( V, ip );
+        default /*jsIM*/:   return writeDataIM( V, ip );
     }
 }
 
@@ -916,13 +904,31 @@ void TrigBase::setYieldPeriod_ms( int loopPeriod_ms )
 }
 
 
-void TrigBase::yield( double loopT )
+// If Qwake given, block until Qwake has data newer than at
+// our last wake, or until loopPeriod_us elapses, so an edge
+// search runs as soon as each acquisition batch lands.
+//
+// Else, loop no more often than every loopPeriod_us.
+//
+void TrigBase::yield( double loopT, const AIQ *Qwake )
 {
-// Loop no more often than every loopPeriod_us
-
     loopT = 1e6 * (getTime() - loopT);  // microsec
 
-    if( loopT < loopPeriod_us )
+    if( Qwake ) {
+
+        if( Qwake != wakeQ ) {
+            wakeQ   = Qwake;
+            wakeCt  = Qwake->endCount();
+        }
+
+        if( loopT < loopPeriod_us ) {
+            Qwake->waitForData(
+                wakeCt, qMax( 1, int(loopPeriod_us - loopT) / 1000 ) );
+        }
+
+        wakeCt = Qwake->endCount();
+    }
+    else if( loopT < loopPeriod_us )
         QThread::usleep( loopPeriod_us - loopT );
     else
         QThread::usleep( 1000 * 10 );
@@ -934,6 +940,11 @@ bool TrigBase::openFile( DataFile *df, int ig, int it )
     if( !df )
         return true;
 
+    df->setDirectIO( p.perf.wrDirectIO );
+    df->setTreeCRC( p.perf.wrTreeCRC );
+    df->setPyramid( p.perf.wrPyramid );
+    df->setSyncEdges( p.perf.wrSyncEdges );
+
     if( !df->openForWrite( p, ig, it, forceName ) ) {
 
         if( forceName.isEmpty() ) {
@@ -960,9 +971,8 @@ bool TrigBase::openFile( DataFile *df, int ig, int it )
 
 // Write LF samples on X12 boundaries (sample%12==0).
 //
-// - inplace true means data param will not be used
-// for AP, so we can write the X12 samples into it.
-// Otherwise we allocate an alternate dst.
+// The X12 timepoints are gathered from the view into
+// a new (1/12-size) block for the LF file.
 //
 // - xtra true means that the first sample in the file
 // is not an X12, so we will need to construct the prior
@@ -970,42 +980,32 @@ bool TrigBase::openFile( DataFile *df, int ig, int it )
 // X12 and the timepoint preceding it. The constructed
 // sync data are a copy of the first timepoint values.
 //
-bool TrigBase::writeDataLF(
-    vec_i16     &data,
-    quint64     headCt,
-    int         ip,
-    bool        inplace,
-    bool        xtra )
+bool TrigBase::writeDataLF( const AIQ::View &V, int ip, bool xtra )
 {
-    vec_i16     dstAlt;
-    vec_i16     *dst;
-    qint16      *D, *S;
+    vec_i16     dst;
+    qint16      *D;
     const int   *cum    = p.im.prbj[ip].imCumTypCnt;
-    int         R       = headCt % 12,
+    int         R       = V.fromCt % 12,
                 nCh     = cum[CimCfg::imSumAll],
                 nAP     = cum[CimCfg::imSumAP],
                 nLF     = cum[CimCfg::imSumNeural] - nAP,
-                size    = int(data.size()),
-                nTp     = size / nCh;
+                nTp     = V.nTpts();
 
-// Set up dst = destination workspace
-// D points to first destination for X12 copies
+// R = first source X12 timepoint
 
-    if( inplace )
-        dst = &data;
-    else {
-        dstAlt.resize( ((xtra ? 2 : 1) + nTp) * nCh );
-        dst = &dstAlt;
-    }
+    if( R )
+        R = 12 - R;
 
-    D = &dst->front();
+    if( R >= nTp )
+        return true;
 
-// S points to first source timepoint
+// Set up dst = destination workspace
 
-    if( R )
-        R = 12 - R;
+    int nD = ((xtra ? 1 : 0) + (nTp - R + 11) / 12) * nCh;
 
-    S = &data[R*nCh];
+    SampleBufPool::global().get( dst, nD );
+    dst.resize( nD );
+    D = &dst[0];
 
 // Extrapolate extra first timepoint if needed
 
@@ -1014,8 +1014,9 @@ bool TrigBase::writeDataLF(
         // Point p2 to the LF data for the first X12 timepoint.
         // Point p1 to the LF data for the previous timepoint.
 
-        qint16  *p2 = S  + nAP,
-                *p1 = p2 - nCh;
+        const qint16    *p2 = V.tpt( R ) + nAP,
+                        *p1 = V.tpt( R - 1 ) + nAP,
+                        *s0 = V.tpt( 0 );
 
         D += nAP;   // D offset temporarily to LF channels
 
@@ -1027,22 +1028,30 @@ bool TrigBase::writeDataLF(
         // sync channels
 
         for( int is = nAP + nLF; is < nCh; ++is )
-            D[is] = data[is];
+            D[is] = s0[is];
 
         D += nCh;
     }
 
 // S to D X12 copies
 
-    for( int it = R; it < nTp; it += 12, D += nCh, S += 12*nCh )
-        memcpy( D + nAP, S + nAP, (nCh - nAP) * sizeof(qint16) );
+    for( int it = R; it < nTp; it += 12, D += nCh )
+        memcpy( D + nAP, V.tpt( it ) + nAP, (nCh - nAP) * sizeof(qint16) );
 
-    dst->resize( D - &dst->front() );
-
-    if( dst->size() && !dfImLf[ip]->writeAndInvalSamps( *dst ) )
+    if( !V.intact() ) {
+        Error()
+            << "writeDataLF: Samples overwritten during copy [stream: "
+            << dfImLf[ip]->fileLblFromObj()
+            << "].";
         return false;
+    }
 
-    return true;
+    bool    ok = dfImLf[ip]->writeAndInvalSamps( dst );
+
+// Queued writes took dst's storage; else recycle it here.
+
+    SampleBufPool::global().put( dst );
+    return ok;
 }
 
 
@@ -1052,7 +1061,7 @@ bool TrigBase::writeDataLF(
 // Here, all AP data are written, but only LF samples
 // on X12-boundary (sample%12==0) are written.
 //
-bool TrigBase::writeDataIM( vec_i16 &data, quint64 headCt, int ip )
+bool TrigBase::writeDataIM( const AIQ::View &V, int ip )
 {
     int     np      = (int)firstCtIm.size();
     bool    isAP    = (ip < np && dfImAp[ip]),
@@ -1062,9 +1071,10 @@ bool TrigBase::writeDataIM( vec_i16 &data, quint64 headCt, int ip )
     if( !(isAP || isLF) )
         return true;
 
-    int size = int(data.size());
+    quint64 headCt  = V.fromCt;
+    int     ntpts   = V.nTpts();
 
-    if( size && !firstCtIm[ip] ) {
+    if( ntpts && !firstCtIm[ip] ) {
 
         firstCtIm[ip] = headCt;
 
@@ -1077,7 +1087,7 @@ bool TrigBase::writeDataIM( vec_i16 &data, quint64 headCt, int ip )
 
                 // need enough data to extrapolate
 
-                if( size / p.stream_nChans( jsIM, ip ) > 12-int(headCt%12) )
+                if( ntpts > 12-int(headCt%12) )
                     xtra = true;
             }
 
@@ -1085,43 +1095,43 @@ bool TrigBase::writeDataIM( vec_i16 &data, quint64 headCt, int ip )
         }
     }
 
-    if( isLF && !writeDataLF( data, headCt, ip, !isAP, xtra ) )
+    if( isLF && !writeDataLF( V, ip, xtra ) )
         return false;
 
-    if( isAP && !dfImAp[ip]->writeAndInvalSamps( data ) )
+    if( isAP && !dfImAp[ip]->writeAndInvalView( V ) )
         return false;
 
     return true;
 }
 
 
-bool TrigBase::writeDataOB( vec_i16 &data, quint64 headCt, int ip )
+bool TrigBase::writeDataOB( const AIQ::View &V, int ip )
 {
     int np = (int)firstCtOb.size();
 
     if( ip >= np || !dfOb[ip] )
         return true;
 
-    if( data.size() && !firstCtOb[ip] ) {
-        firstCtOb[ip] = headCt;
-        dfOb[ip]->setFirstSample( headCt, true );
+    if( V.nTpts() && !firstCtOb[ip] ) {
+        firstCtOb[ip] = V.fromCt;
+        dfOb[ip]->setFirstSample( V.fromCt, true );
     }
 
-    return dfOb[ip]->writeAndInvalSamps( data );
+    return dfOb[ip]->writeAndInvalView( V );
 }
 
 
-bool TrigBase::writeDataNI( vec_i16 &data, quint64 headCt )
+bool TrigBase::writeDataNI( const AIQ::View &V )
 {
     if( !dfNi )
         return true;
 
-    if( !firstCtNi && data.size() ) {
-        firstCtNi = headCt;
-        dfNi->setFirstSample( headCt, true );
+    if( !firstCtNi && V.nTpts() ) {
+        firstCtNi = V.fromCt;
+        dfNi->setFirstSample( V.fromCt, true );
     }
 
-    return dfNi->writeAndInvalSamps( data );
+    return dfNi->writeAndInvalView( V );
 }
 
 
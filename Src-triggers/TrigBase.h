@@ -39,6 +39,7 @@ private:
     const QVector<AIQ*>         &imQ;
     const QVector<AIQ*>         &obQ;
     const AIQ                   *niQ;
+    const AIQ                   *wakeQ;
     std::vector<DataFileIMAP*>  dfImAp;
     std::vector<DataFileIMLF*>  dfImLf;
     std::vector<DataFileOB*>    dfOb;
@@ -60,7 +61,8 @@ private:
     std::vector<double>         tLastProf;
     std::vector<quint64>        firstCtIm;
     std::vector<quint64>        firstCtOb;
-    quint64                     firstCtNi;
+    quint64                     firstCtNi,
+                                wakeCt;
     quint32                     offHertz,
                                 offmsec,
                                 onHertz,
@@ -153,35 +155,26 @@ protected:
     void endTrig();
     bool newTrig( int &ig, int &it, bool trigLED = true );
     void setSyncWriteMode();
-    bool nSampsFromCt(
-        vec_i16     &data,
+    bool viewFromCt(
+        AIQ::View   &V,
         quint64     fromCt,
         int         nMax,
         int         js,
         int         ip );
-    bool writeAndInvalData(
-        int         js,
-        int         ip,
-        vec_i16     &data,
-        quint64     headCt );
+    bool writeAndInvalView( int js, int ip, const AIQ::View &V );
     quint64 sampCount( int js );
     void endRun( const QString &err );
     void statusOnSince( QString &s );
     void statusWrPerf( QString &s );
     void setYieldPeriod_ms( int loopPeriod_ms );
-    void yield( double loopT );
+    void yield( double loopT, const AIQ *Qwake = 0 );
 
 private:
     bool openFile( DataFile *df, int ig, int it );
-    bool writeDataLF(
-        vec_i16     &data,
-        quint64     headCt,
-        int         ip,
-        bool        inplace,
-        bool        xtra );
-    bool writeDataIM( vec_i16 &data, quint64 headCt, int ip );
-    bool writeDataOB( vec_i16 &data, quint64 headCt, int ip );
-    bool writeDataNI( vec_i16 &data, quint64 headCt );
+    bool writeDataLF( const AIQ::View &V, int ip, bool xtra );
+    bool writeDataIM( const AIQ::View &V, int ip );
+    bool writeDataOB( const AIQ::View &V, int ip );
+    bool writeDataNI( const AIQ::View &V );
     void getErrFlags( int js, int ip );
 };
 
@@ -1,6 +1,8 @@
 
 #include "TrigImmed.h"
+#include "BenchRun.h"
 #include "Util.h"
+#include "ThreadPlace.h"
 
 #include <QThread>
 
@@ -20,6 +22,9 @@ void TrImmWorker::run()
     const int   niq = (int)viq.size();
     bool        ok  = true;
 
+    ThreadPlace::pin(
+        ThreadPlace::tpTrig, QString("trig%1").arg( niq ? viq[0] : 0 ) );
+
     for(;;) {
 
         if( !shr.wake( ok ) )
@@ -32,6 +37,8 @@ void TrImmWorker::run()
         }
     }
 
+    BenchCPU::add( BenchCPU::trig );
+
     emit finished();
 }
 
@@ -43,20 +50,20 @@ bool TrImmWorker::writeSome( int iq )
 
     const SyncStream    &S = vS[iq];
 
-    vec_i16 data;
-    quint64 headCt = shr.iqNextCt[iq];
+    AIQ::View   V;
+    quint64     headCt = shr.iqNextCt[iq];
 
-    if( !ME->nSampsFromCt( data, headCt, -LOOP_MS, S.js, S.ip ) )
+    if( !ME->viewFromCt( V, headCt, -LOOP_MS, S.js, S.ip ) )
         return false;
 
-    uint    size = (uint)data.size();
+    int     ntpts = V.nTpts();
 
-    if( !size )
+    if( !ntpts )
         return true;
 
-    shr.iqNextCt[iq] += size / S.Q->nChans();
+    shr.iqNextCt[iq] += ntpts;
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 /* ---------------------------------------------------------------- */
@@ -143,13 +150,7 @@ void TrigImmed::run()
 
 // Wait for threads to reach ready (sleep) state
 
-    shr.runMtx.lock();
-        while( shr.asleep < nThd ) {
-            shr.runMtx.unlock();
-                QThread::usleep( 10 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitAsleep( nThd );
 
 // -----
 // Start
@@ -211,6 +212,8 @@ next_loop:
 
 // Done
 
+    BenchCPU::add( BenchCPU::trig );
+
     endRun( err );
 }
 
@@ -280,15 +283,7 @@ bool TrigImmed::xferAll( TrImmShared &shr, QString &err )
 
 // Wait all threads started, and all done
 
-    shr.runMtx.lock();
-        while( shr.awake  < nThd
-            || shr.asleep < nThd ) {
-
-            shr.runMtx.unlock();
-                QThread::msleep( LOOP_MS/8 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitDone( nThd );
 
     if( maxOK && !shr.errors )
         return true;
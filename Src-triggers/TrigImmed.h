@@ -14,6 +14,7 @@ struct TrImmShared {
     std::vector<quint64>    iqNextCt;
     QMutex                  runMtx;
     QWaitCondition          condWake;
+    QWaitCondition          condDone;
     int                     awake,
                             asleep,
                             errors;
@@ -28,6 +29,7 @@ struct TrImmShared {
         runMtx.lock();
             errors += !ok;
             ++asleep;
+            condDone.wakeAll();
             condWake.wait( &runMtx );
             ++awake;
             run = !stop;
@@ -35,6 +37,22 @@ struct TrImmShared {
         return run;
     }
 
+    void waitAsleep( int nThd )
+    {
+        runMtx.lock();
+            while( asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
+    void waitDone( int nThd )
+    {
+        runMtx.lock();
+            while( awake < nThd || asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
     void kill()
     {
         runMtx.lock();
@@ -5,6 +5,7 @@
 #include "MainApp.h"
 #include "Run.h"
 #include "GraphsWindow.h"
+#include "ThreadPlace.h"
 
 #include <QTimer>
 #include <QThread>
@@ -25,6 +26,9 @@ void TrSpkWorker::run()
     const int   niq = (int)viq.size();
     bool        ok  = true;
 
+    ThreadPlace::pin(
+        ThreadPlace::tpTrig, QString("trig%1").arg( niq ? viq[0] : 0 ) );
+
     for(;;) {
 
         if( !shr.wake( ok ) )
@@ -46,29 +50,29 @@ bool TrSpkWorker::writeSome( int iq )
     const SyncStream    &S = vS[iq];
     TrigSpike::Counts   &C = ME->cnt;
 
-    vec_i16 data;
-    quint64 headCt  = C.nextCt[iq];
+    AIQ::View   V;
+    quint64     headCt  = C.nextCt[iq];
 
-    if( !ME->nSampsFromCt( data, headCt, C.remCt[iq], S.js, S.ip ) )
+    if( !ME->viewFromCt( V, headCt, C.remCt[iq], S.js, S.ip ) )
         return false;
 
-    uint    size = (uint)data.size();
+    int     ntpts = V.nTpts();
 
-    if( !size )
+    if( !ntpts )
         return true;
 
 // ---------------
 // Update tracking
 // ---------------
 
-    C.nextCt[iq]    += size / S.Q->nChans();
+    C.nextCt[iq]    += ntpts;
     C.remCt[iq]     -= C.nextCt[iq] - headCt;
 
 // -----
 // Write
 // -----
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 /* ---------------------------------------------------------------- */
@@ -308,13 +312,7 @@ void TrigSpike::run()
 
 // Wait for threads to reach ready (sleep) state
 
-    shr.runMtx.lock();
-        while( shr.asleep < nThd ) {
-            shr.runMtx.unlock();
-                QThread::usleep( 10 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitAsleep( nThd );
 
 // -----
 // Start
@@ -322,6 +320,8 @@ void TrigSpike::run()
 
     setYieldPeriod_ms( LOOP_MS );
 
+    const AIQ   *Qsrc = vS[p.stream2iq( p.trgSpike.stream )].Q;
+
     initState();
 
     QString err;
@@ -429,7 +429,9 @@ next_loop:
         // Moderate fetch rate
         // -------------------
 
-        yield( loopT );
+        // Seeking an edge: wake on each new source batch
+
+        yield( loopT, !inactive && ISSTATE_GetEdge ? Qsrc : 0 );
     }
 
 // Kill all threads
@@ -569,15 +571,7 @@ bool TrigSpike::xferAll( TrSpkShared &shr, QString &err )
 
 // Wait all threads started, and all done
 
-    shr.runMtx.lock();
-        while( shr.awake  < nThd
-            || shr.asleep < nThd ) {
-
-            shr.runMtx.unlock();
-                QThread::msleep( LOOP_MS/8 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitDone( nThd );
 
     if( maxOK && !shr.errors )
         return true;
@@ -15,6 +15,7 @@ struct TrSpkShared {
     const DAQ::Params   &p;
     QMutex              runMtx;
     QWaitCondition      condWake;
+    QWaitCondition      condDone;
     int                 awake,
                         asleep,
                         errors;
@@ -29,6 +30,7 @@ struct TrSpkShared {
         runMtx.lock();
             errors += !ok;
             ++asleep;
+            condDone.wakeAll();
             condWake.wait( &runMtx );
             ++awake;
             run = !stop;
@@ -36,6 +38,22 @@ struct TrSpkShared {
         return run;
     }
 
+    void waitAsleep( int nThd )
+    {
+        runMtx.lock();
+            while( asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
+    void waitDone( int nThd )
+    {
+        runMtx.lock();
+            while( awake < nThd || asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
     void kill()
     {
         runMtx.lock();
@@ -1,6 +1,7 @@
 
 #include "TrigTCP.h"
 #include "Util.h"
+#include "ThreadPlace.h"
 
 #include <QThread>
 
@@ -20,6 +21,9 @@ void TrTCPWorker::run()
     const int   niq = (int)viq.size();
     bool        ok  = true;
 
+    ThreadPlace::pin(
+        ThreadPlace::tpTrig, QString("trig%1").arg( niq ? viq[0] : 0 ) );
+
     for(;;) {
 
         if( !shr.wake( ok ) )
@@ -47,20 +51,20 @@ bool TrTCPWorker::writeSome( int iq )
 {
     const SyncStream    &S = vS[iq];
 
-    vec_i16 data;
-    quint64 headCt = shr.iqNextCt[iq];
+    AIQ::View   V;
+    quint64     headCt = shr.iqNextCt[iq];
 
-    if( !ME->nSampsFromCt( data, headCt, -LOOP_MS, S.js, S.ip ) )
+    if( !ME->viewFromCt( V, headCt, -LOOP_MS, S.js, S.ip ) )
         return false;
 
-    uint    size = (uint)data.size();
+    int     ntpts = V.nTpts();
 
-    if( !size )
+    if( !ntpts )
         return true;
 
-    shr.iqNextCt[iq] += size / S.Q->nChans();
+    shr.iqNextCt[iq] += ntpts;
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 
@@ -76,16 +80,16 @@ bool TrTCPWorker::writeRem( int iq, double tlo )
     if( curCt >= spnCt )
         return true;
 
-    vec_i16 data;
-    quint64 headCt = shr.iqNextCt[iq];
+    AIQ::View   V;
+    quint64     headCt = shr.iqNextCt[iq];
 
-    if( !ME->nSampsFromCt( data, headCt, spnCt - curCt, S.js, S.ip ) )
+    if( !ME->viewFromCt( V, headCt, spnCt - curCt, S.js, S.ip ) )
         return false;
 
-    if( !data.size() )
+    if( !V.nTpts() )
         return true;
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 /* ---------------------------------------------------------------- */
@@ -191,13 +195,7 @@ void TrigTCP::run()
 
 // Wait for threads to reach ready (sleep) state
 
-    shr.runMtx.lock();
-        while( shr.asleep < nThd ) {
-            shr.runMtx.unlock();
-                QThread::usleep( 10 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitAsleep( nThd );
 
 // -----
 // Start
@@ -344,15 +342,7 @@ bool TrigTCP::xferAll( TrTCPShared &shr, double tRem, QString &err )
 
 // Wait all threads started, and all done
 
-    shr.runMtx.lock();
-        while( shr.awake  < nThd
-            || shr.asleep < nThd ) {
-
-            shr.runMtx.unlock();
-                QThread::msleep( LOOP_MS/8 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitDone( nThd );
 
     if( maxOK && !shr.errors )
         return true;
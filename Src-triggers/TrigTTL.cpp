@@ -3,6 +3,7 @@
 #include "Util.h"
 #include "MainApp.h"
 #include "Run.h"
+#include "ThreadPlace.h"
 
 #include <QThread>
 
@@ -22,6 +23,9 @@ void TrTTLWorker::run()
     const int   niq = (int)viq.size();
     bool        ok  = true;
 
+    ThreadPlace::pin(
+        ThreadPlace::tpTrig, QString("trig%1").arg( niq ? viq[0] : 0 ) );
+
     for(;;) {
 
         if( !shr.wake( ok ) )
@@ -57,17 +61,17 @@ bool TrTTLWorker::writePreMargin( int iq )
     if( C.remCt[iq] <= 0 )
         return true;
 
-    vec_i16 data;
-    quint64 headCt  = C.nextCt[iq];
-    int     nMax    = (C.remCt[iq] <= C.maxFetch[iq] ?
-                        C.remCt[iq] : C.maxFetch[iq]);
+    AIQ::View   V;
+    quint64     headCt  = C.nextCt[iq];
+    int         nMax    = (C.remCt[iq] <= C.maxFetch[iq] ?
+                            C.remCt[iq] : C.maxFetch[iq]);
 
-    if( !ME->nSampsFromCt( data, headCt, nMax, S.js, S.ip ) )
+    if( !ME->viewFromCt( V, headCt, nMax, S.js, S.ip ) )
         return false;
 
-    uint    size = (uint)data.size();
+    int     ntpts = V.nTpts();
 
-    if( !size )
+    if( !ntpts )
         return true;
 
 // Status in this state should be what's done: +(margin - rem).
@@ -75,10 +79,10 @@ bool TrTTLWorker::writePreMargin( int iq )
 //
 // When rem falls to zero, (next = edge) sets us up for state H.
 
-    C.remCt[iq] -= size / S.Q->nChans();
+    C.remCt[iq] -= ntpts;
     C.nextCt[iq] = C.edgeCt[iq] - C.remCt[iq];
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 
@@ -94,27 +98,27 @@ bool TrTTLWorker::writePostMargin( int iq )
     if( C.remCt[iq] <= 0 )
         return true;
 
-    vec_i16 data;
-    quint64 headCt  = C.nextCt[iq];
-    int     nMax    = (C.remCt[iq] <= C.maxFetch[iq] ?
-                        C.remCt[iq] : C.maxFetch[iq]);
+    AIQ::View   V;
+    quint64     headCt  = C.nextCt[iq];
+    int         nMax    = (C.remCt[iq] <= C.maxFetch[iq] ?
+                            C.remCt[iq] : C.maxFetch[iq]);
 
-    if( !ME->nSampsFromCt( data, headCt, nMax, S.js, S.ip ) )
+    if( !ME->viewFromCt( V, headCt, nMax, S.js, S.ip ) )
         return false;
 
-    uint    size = (uint)data.size();
+    int     ntpts = V.nTpts();
 
-    if( !size )
+    if( !ntpts )
         return true;
 
 // Status in this state should be: +(margin + H + margin - rem).
 // With next defined as below, status = +(margin + next - edge)
 // = margin + (fall-edge) + margin - rem = correct.
 
-    C.remCt[iq] -= size / S.Q->nChans();
+    C.remCt[iq] -= ntpts;
     C.nextCt[iq] = C.fallCt[iq] + C.marginCt[iq] - C.remCt[iq];
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 
@@ -127,16 +131,16 @@ bool TrTTLWorker::doSomeH( int iq )
     const SyncStream    &S = vS[iq];
     TrigTTL::Counts     &C = ME->cnt;
 
-    vec_i16 data;
-    quint64 headCt = C.nextCt[iq];
-    bool    ok;
+    AIQ::View   V;
+    quint64     headCt = C.nextCt[iq];
+    bool        ok;
 
 // ---------------
 // Fetch a la mode
 // ---------------
 
     if( shr.p.trgTTL.mode == DAQ::TrgTTLLatch )
-        ok = ME->nSampsFromCt( data, headCt, -LOOP_MS, S.js, S.ip );
+        ok = ME->viewFromCt( V, headCt, -LOOP_MS, S.js, S.ip );
     else if( C.remCt[iq] <= 0 )
         return true;
     else {
@@ -144,25 +148,25 @@ bool TrTTLWorker::doSomeH( int iq )
         int nMax = (C.remCt[iq] <= C.maxFetch[iq] ?
                     C.remCt[iq] : C.maxFetch[iq]);
 
-        ok = ME->nSampsFromCt( data, headCt, nMax, S.js, S.ip );
+        ok = ME->viewFromCt( V, headCt, nMax, S.js, S.ip );
     }
 
     if( !ok )
         return false;
 
-    uint    size = (uint)data.size();
+    int     ntpts = V.nTpts();
 
-    if( !size )
+    if( !ntpts )
         return true;
 
 // ------------------------
 // Write/update all H cases
 // ------------------------
 
-    C.nextCt[iq]    += size / S.Q->nChans();
+    C.nextCt[iq]    += ntpts;
     C.remCt[iq]     -= C.nextCt[iq] - headCt;
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 /* ---------------------------------------------------------------- */
@@ -414,13 +418,7 @@ void TrigTTL::run()
 
 // Wait for threads to reach ready (sleep) state
 
-    shr.runMtx.lock();
-        while( shr.asleep < nThd ) {
-            shr.runMtx.unlock();
-                QThread::usleep( 10 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitAsleep( nThd );
 
 // -----
 // Start
@@ -584,7 +582,9 @@ next_loop:
         // Moderate fetch rate
         // -------------------
 
-        yield( loopT );
+        // Seeking an edge: wake on each new source batch
+
+        yield( loopT, !inactive && ISSTATE_L ? vS[cnt.iTrk].Q : 0 );
     }
 
 // Kill all threads
@@ -847,15 +847,7 @@ bool TrigTTL::xferAll( TrTTLShared &shr, int preMidPost, QString &err )
 
 // Wait all threads started, and all done
 
-    shr.runMtx.lock();
-        while( shr.awake  < nThd
-            || shr.asleep < nThd ) {
-
-            shr.runMtx.unlock();
-                QThread::msleep( LOOP_MS/8 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitDone( nThd );
 
     if( maxOK && !shr.errors )
         return true;
@@ -13,6 +13,7 @@ struct TrTTLShared {
     const DAQ::Params   &p;
     QMutex              runMtx;
     QWaitCondition      condWake;
+    QWaitCondition      condDone;
     int                 preMidPost, // {-1,0,+1}
                         awake,
                         asleep,
@@ -28,6 +29,7 @@ struct TrTTLShared {
         runMtx.lock();
             errors += !ok;
             ++asleep;
+            condDone.wakeAll();
             condWake.wait( &runMtx );
             ++awake;
             run = !stop;
@@ -35,6 +37,22 @@ struct TrTTLShared {
         return run;
     }
 
+    void waitAsleep( int nThd )
+    {
+        runMtx.lock();
+            while( asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
+    void waitDone( int nThd )
+    {
+        runMtx.lock();
+            while( awake < nThd || asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
     void kill()
     {
         runMtx.lock();
@@ -3,6 +3,7 @@
 #include "Util.h"
 #include "MainApp.h"
 #include "Run.h"
+#include "ThreadPlace.h"
 
 #include <QThread>
 
@@ -22,6 +23,9 @@ void TrTimWorker::run()
     const int   niq = (int)viq.size();
     bool        ok  = true;
 
+    ThreadPlace::pin(
+        ThreadPlace::tpTrig, QString("trig%1").arg( niq ? viq[0] : 0 ) );
+
     for(;;) {
 
         if( !shr.wake( ok ) )
@@ -45,31 +49,31 @@ bool TrTimWorker::doSomeH( int iq )
     const SyncStream    &S = vS[iq];
     TrigTimed::Counts   &C = ME->cnt;
 
-    vec_i16 data;
-    quint64 headCt  = C.nextCt[iq],
-            remCt   = C.hiCtMax[iq] - C.hiCtCur[iq];
-    uint    nMax    = (remCt <= C.maxFetch[iq] ? remCt : C.maxFetch[iq]);
+    AIQ::View   V;
+    quint64     headCt  = C.nextCt[iq],
+                remCt   = C.hiCtMax[iq] - C.hiCtCur[iq];
+    uint        nMax    = (remCt <= C.maxFetch[iq] ? remCt : C.maxFetch[iq]);
 
-    if( !ME->nSampsFromCt( data, headCt, nMax, S.js, S.ip ) )
+    if( !ME->viewFromCt( V, headCt, nMax, S.js, S.ip ) )
         return false;
 
-    uint    size = (uint)data.size();
+    int     ntpts = V.nTpts();
 
-    if( !size )
+    if( !ntpts )
         return true;
 
 // ---------------
 // Update tracking
 // ---------------
 
-    C.nextCt[iq]    += size / S.Q->nChans();
+    C.nextCt[iq]    += ntpts;
     C.hiCtCur[iq]   += C.nextCt[iq] - headCt;
 
 // -----
 // Write
 // -----
 
-    return ME->writeAndInvalData( S.js, S.ip, data, headCt );
+    return ME->writeAndInvalView( S.js, S.ip, V );
 }
 
 /* ---------------------------------------------------------------- */
@@ -233,13 +237,7 @@ void TrigTimed::run()
 
 // Wait for threads to reach ready (sleep) state
 
-    shr.runMtx.lock();
-        while( shr.asleep < nThd ) {
-            shr.runMtx.unlock();
-                QThread::usleep( 10 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitAsleep( nThd );
 
 // -----
 // Start
@@ -502,15 +500,7 @@ bool TrigTimed::xferAll( TrTimShared &shr, QString &err )
 
 // Wait all threads started, and all done
 
-    shr.runMtx.lock();
-        while( shr.awake  < nThd
-            || shr.asleep < nThd ) {
-
-            shr.runMtx.unlock();
-                QThread::msleep( LOOP_MS/8 );
-            shr.runMtx.lock();
-        }
-    shr.runMtx.unlock();
+    shr.waitDone( nThd );
 
     if( maxOK && !shr.errors )
         return true;
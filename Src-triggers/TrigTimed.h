@@ -13,6 +13,7 @@ struct TrTimShared {
     const DAQ::Params   &p;
     QMutex              runMtx;
     QWaitCondition      condWake;
+    QWaitCondition      condDone;
     int                 awake,
                         asleep,
                         errors;
@@ -27,6 +28,7 @@ struct TrTimShared {
         runMtx.lock();
             errors += !ok;
             ++asleep;
+            condDone.wakeAll();
             condWake.wait( &runMtx );
             ++awake;
             run = !stop;
@@ -34,6 +36,22 @@ struct TrTimShared {
         return run;
     }
 
+    void waitAsleep( int nThd )
+    {
+        runMtx.lock();
+            while( asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
+    void waitDone( int nThd )
+    {
+        runMtx.lock();
+            while( awake < nThd || asleep < nThd )
+                condDone.wait( &runMtx );
+        runMtx.unlock();
+    }
+
     void kill()
     {
         runMtx.lock();
@@ -0,0 +1,478 @@
+#include "FileChecksum.h"
+#include "Util.h"
+
+#include "SHA1.h"
+#undef TCHAR
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define FCK_X64
+    #include <nmmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define FCK_SSE42
+    #else
+        #define FCK_SSE42   __attribute__((target("sse4.2")))
+    #endif
+#endif
+
+
+#define RDBYTES     (4*1024*1024)   // file read size
+#define SHANBUF     4               // sha1 read-ahead buffers
+
+/* ---------------------------------------------------------------- */
+/* CRC32C kernels ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Castagnoli polynomial, reflected.
+//
+static quint32 crcTbl[256];
+
+static bool initTbl()
+{
+    for( quint32 i = 0; i < 256; ++i ) {
+
+        quint32 c = i;
+
+        for( int k = 0; k < 8; ++k )
+            c = (c & 1 ? (c >> 1) ^ 0x82F63B78 : c >> 1);
+
+        crcTbl[i] = c;
+    }
+
+    return true;
+}
+
+
+static quint32 crc32c_sw( quint32 crc, const void *src, size_t bytes )
+{
+    static const bool   tblOK = initTbl();
+    const uchar         *p    = (const uchar*)src;
+
+    Q_UNUSED( tblOK )
+
+    crc = ~crc;
+
+    while( bytes-- )
+        crc = crcTbl[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+
+#ifdef FCK_X64
+
+FCK_SSE42
+static quint32 crc32c_hw( quint32 crc, const void *src, size_t bytes )
+{
+    const uchar *p = (const uchar*)src;
+    quint64     c  = ~crc & 0xFFFFFFFF;
+
+    for( ; bytes >= 8; bytes -= 8, p += 8 ) {
+        quint64 v;
+        memcpy( &v, p, 8 );
+        c = _mm_crc32_u64( c, v );
+    }
+
+    quint32 c32 = quint32(c);
+
+    while( bytes-- )
+        c32 = _mm_crc32_u8( c32, *p++ );
+
+    return ~c32;
+}
+
+
+static bool haveSSE42()
+{
+#ifdef _MSC_VER
+    int r[4];
+    __cpuid( r, 1 );
+    return (r[2] & (1 << 20)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "sse4.2" );
+#endif
+}
+
+#endif
+
+
+quint32 FileChecksum::crc32c( quint32 crc, const void *src, size_t bytes )
+{
+    typedef quint32 (*Fn)( quint32, const void*, size_t );
+
+#ifdef FCK_X64
+    static const Fn fn = (haveSSE42() ? &crc32c_hw : &crc32c_sw);
+#else
+    static const Fn fn = &crc32c_sw;
+#endif
+
+    return fn( crc, src, bytes );
+}
+
+/* ---------------------------------------------------------------- */
+/* TreeCRC -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void TreeCRC::update( const void *src, qint64 bytes )
+{
+    const char  *s = (const char*)src;
+
+    while( bytes > 0 ) {
+
+        qint64  n = qMin( bytes, blkBytes - inBlk );
+
+        cur     = FileChecksum::crc32c( cur, s, n );
+        inBlk  += n;
+        s      += n;
+        bytes  -= n;
+
+        if( inBlk == blkBytes ) {
+            blk.push_back( cur );
+            cur     = 0;
+            inBlk   = 0;
+        }
+    }
+}
+
+
+quint32 TreeCRC::final()
+{
+    if( inBlk ) {
+        blk.push_back( cur );
+        cur     = 0;
+        inBlk   = 0;
+    }
+
+    return root( blk.size() ? &blk[0] : 0, int(blk.size()) );
+}
+
+
+quint32 TreeCRC::root( const quint32 *blk, int n )
+{
+    quint32 crc = 0;
+
+    for( int i = 0; i < n; ++i ) {
+
+        uchar   le[4] = {
+                    uchar(blk[i]),       uchar(blk[i] >> 8),
+                    uchar(blk[i] >> 16), uchar(blk[i] >> 24) };
+
+        crc = FileChecksum::crc32c( crc, le, 4 );
+    }
+
+    return crc;
+}
+
+
+QString TreeCRC::toString( quint32 crc )
+{
+    return QString("%1").arg( crc, 8, 16, QChar('0') ).toUpper();
+}
+
+/* ---------------------------------------------------------------- */
+/* sha1 ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Reader thread fills SHANBUF buffers round-robin;
+// caller hashes them in order. nb[i] states:
+// -2=free, -1=error, 0=eof, >0=bytes ready.
+//
+FileChecksum::Result FileChecksum::sha1(
+    QString         &hex,
+    QString         &err,
+    const QString   &file,
+    Tick            tick )
+{
+    QFile   f( file );
+
+    if( !f.open( QIODevice::ReadOnly ) ) {
+        err = QString("SHA1 error <%1> opening(read) '%2'.")
+                .arg( f.errorString() ).arg( file );
+        return Failure;
+    }
+
+    std::vector<std::vector<UINT_8> >   buf( SHANBUF );
+    qint64                              nb[SHANBUF];
+    QMutex                              mtx;
+    QWaitCondition                      cond;
+    qint64                              size    = f.size(),
+                                        read    = 0,
+                                        step    = qMax( 1LL, size/100 ),
+                                        lastPct = 0;
+    bool                                stop    = false;
+
+    for( int i = 0; i < SHANBUF; ++i ) {
+        buf[i].resize( RDBYTES );
+        nb[i] = -2;
+    }
+
+    std::thread reader( [&]() {
+        for( int i = 0;; i = (i + 1) % SHANBUF ) {
+
+            mtx.lock();
+            while( nb[i] != -2 && !stop )
+                cond.wait( &mtx );
+            bool    quit = stop;
+            mtx.unlock();
+
+            if( quit )
+                return;
+
+            qint64  n = f.read( (char*)&buf[i][0], RDBYTES );
+
+            mtx.lock();
+            nb[i] = (n < 0 ? -1 : n);
+            cond.wakeAll();
+            mtx.unlock();
+
+            if( n <= 0 )
+                return;
+        }
+    } );
+
+    CSHA1   sha;
+    Result  res = Success;
+
+    for( int i = 0;; i = (i + 1) % SHANBUF ) {
+
+        mtx.lock();
+        while( nb[i] == -2 )
+            cond.wait( &mtx );
+        qint64  n = nb[i];
+        mtx.unlock();
+
+        if( n < 0 ) {
+            err = QString("SHA1 error <%1> reading '%2'.")
+                    .arg( f.errorString() ).arg( file );
+            res = Failure;
+            break;
+        }
+        else if( !n )
+            break;
+
+        sha.Update( &buf[i][0], n );
+
+        qint64 pct = (read += n) / step;
+
+        if( pct >= lastPct + 5 ) {
+            lastPct = pct;
+            if( tick && !tick( int(pct) ) ) {
+                res = Canceled;
+                break;
+            }
+        }
+
+        mtx.lock();
+        nb[i] = -2;
+        cond.wakeAll();
+        mtx.unlock();
+    }
+
+    mtx.lock();
+    stop = true;
+    cond.wakeAll();
+    mtx.unlock();
+
+    reader.join();
+
+    if( res == Success ) {
+
+        sha.Final();
+
+        std::basic_string<char> hStr;
+        sha.ReportHashStl( hStr, CSHA1::REPORT_HEX_SHORT );
+        hex = QString(hStr.c_str()).trimmed();
+    }
+
+    return res;
+}
+
+/* ---------------------------------------------------------------- */
+/* treeCRC -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Threads take blocks from a shared counter, each through its own
+// file handle. Caller polls progress until all threads are done.
+//
+FileChecksum::Result FileChecksum::treeCRC(
+    quint32         &root,
+    QString         &err,
+    const QString   &file,
+    qint64          blkBytes,
+    int             nThd,
+    Tick            tick )
+{
+    QFileInfo   fi( file );
+
+    if( !fi.exists() || blkBytes <= 0 ) {
+        err = QString("Tree CRC can't read '%1'.").arg( file );
+        return Failure;
+    }
+
+    qint64                  size = fi.size(),
+                            nBlk = (size + blkBytes - 1) / blkBytes;
+    std::vector<quint32>    crc( nBlk );
+    std::atomic<qint64>     next( 0 ),
+                            done( 0 );
+    std::atomic<int>        nRunning( 0 );
+    std::atomic<bool>       stop( false );
+    QMutex                  errMtx;
+
+    nThd = int(qBound( 1LL, qint64(nThd), qMax( 1LL, nBlk ) ));
+
+    auto    work = [&]() {
+
+        QFile               f( file );
+        std::vector<char>   buf( qMin( blkBytes, qint64(RDBYTES) ) );
+
+        if( !f.open( QIODevice::ReadOnly ) ) {
+            QMutexLocker    ml( &errMtx );
+            err = QString("Tree CRC error <%1> opening(read) '%2'.")
+                    .arg( f.errorString() ).arg( file );
+            stop = true;
+        }
+
+        for( qint64 ib; !stop && (ib = next++) < nBlk; ) {
+
+            qint64  rem = qMin( blkBytes, size - ib * blkBytes );
+            quint32 c   = 0;
+
+            if( !f.seek( ib * blkBytes ) )
+                rem = -1;
+
+            while( rem > 0 && !stop ) {
+
+                qint64  n = f.read( &buf[0], qMin( rem, qint64(buf.size()) ) );
+
+                if( n <= 0 ) {
+                    rem = -1;
+                    break;
+                }
+
+                c    = crc32c( c, &buf[0], n );
+                rem -= n;
+                done += n;
+            }
+
+            if( rem < 0 ) {
+                QMutexLocker    ml( &errMtx );
+                err = QString("Tree CRC error <%1> reading '%2'.")
+                        .arg( f.errorString() ).arg( file );
+                stop = true;
+            }
+
+            crc[ib] = c;
+        }
+
+        --nRunning;
+    };
+
+    std::vector<std::thread>    vT;
+    Result                      res = Success;
+    int                         lastPct = 0;
+
+    nRunning = nThd;
+
+    for( int i = 0; i < nThd; ++i )
+        vT.push_back( std::thread( work ) );
+
+    while( nRunning > 0 ) {
+
+        QThread::msleep( 50 );
+
+        int pct = int(size ? 100 * done / size : 100);
+
+        if( pct >= lastPct + 5 ) {
+            lastPct = pct;
+            if( tick && !tick( pct ) && !stop ) {
+                res  = Canceled;
+                stop = true;
+            }
+        }
+    }
+
+    for( int i = 0; i < nThd; ++i )
+        vT[i].join();
+
+    if( res == Success ) {
+
+        QMutexLocker    ml( &errMtx );
+
+        if( !err.isEmpty() )
+            res = Failure;
+        else
+            root = TreeCRC::root( nBlk ? &crc[0] : 0, int(nBlk) );
+    }
+
+    return res;
+}
+
+/* ---------------------------------------------------------------- */
+/* verify --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+FileChecksum::Result FileChecksum::verify(
+    QString         &err,
+    QString         &how,
+    const QString   &file,
+    const KeyValMap &kvm,
+    Tick            tick )
+{
+    err.clear();
+
+    QString tree = kvm.value( "fileTreeCRC32C" ).toString().trimmed();
+
+    if( !tree.isEmpty() ) {
+
+        how = "tree CRC32C";
+
+        qint64  blkBytes = kvm.value( "fileTreeCRCBlkBytes" ).toLongLong();
+        quint32 root;
+        Result  res = treeCRC(
+                        root, err, file, blkBytes,
+                        getNAssignedThreads(), tick );
+
+        if( res == Success && tree.compare( TreeCRC::toString( root ), Qt::CaseInsensitive ) ) {
+            err =
+                "Computed tree CRC32C does not match that in metafile;"
+                " data file corrupt.";
+            res = Failure;
+        }
+
+        return res;
+    }
+
+    how = "SHA1";
+
+    QString sha1FromMeta = kvm.value( "fileSHA1" ).toString().trimmed();
+
+    if( sha1FromMeta.length() != 40 ) {
+        err = QString("Missing or bad SHA1 tag in metafile [%1].")
+                .arg( sha1FromMeta );
+        return Failure;
+    }
+
+    QString hex;
+    Result  res = sha1( hex, err, file, tick );
+
+    if( res == Success && sha1FromMeta.compare( hex, Qt::CaseInsensitive ) ) {
+        err =
+            "Computed SHA1 does not match that in metafile;"
+            " data file corrupt.";
+        res = Failure;
+    }
+
+    return res;
+}
@@ -0,0 +1,90 @@
+#ifndef FILECHECKSUM_H
+#define FILECHECKSUM_H
+
+#include "KVParams.h"
+
+#include <functional>
+#include <vector>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Tree checksum of a byte stream: the stream is cut into fixed
+// size blocks, each block gets a CRC32C, and the root is the
+// CRC32C of the little-endian array of block CRCs. Unlike SHA1,
+// blocks can be summed independently, so verification scales
+// with cores. Recorded in metadata as:
+//
+// fileTreeCRC32C=root, 8 hex digits
+// fileTreeCRCBlkBytes=block size
+//
+class TreeCRC
+{
+public:
+    enum { DEFBLKBYTES = 16*1024*1024 };
+
+private:
+    std::vector<quint32>    blk;
+    qint64                  blkBytes,
+                            inBlk;
+    quint32                 cur;
+
+public:
+    TreeCRC( qint64 blkBytes = DEFBLKBYTES )
+    :   blkBytes(blkBytes), inBlk(0), cur(0)    {}
+
+    void update( const void *src, qint64 bytes );
+    quint32 final();
+    qint64 blockBytes() const   {return blkBytes;}
+
+    static quint32 root( const quint32 *blk, int n );
+    static QString toString( quint32 crc );
+};
+
+
+// Whole-file checksums, with optional progress/cancel callback
+// (return false from tick to cancel).
+//
+// sha1: reading runs on a helper thread, overlapping disk and hash.
+// treeCRC: blocks are divided among nThd threads.
+// verify: check (file) against whichever sum its metadata carries,
+//     preferring tree CRC; (how) names the method used.
+//
+class FileChecksum
+{
+public:
+    enum Result {
+        Success,
+        Failure,
+        Canceled
+    };
+
+    typedef std::function<bool( int pct )>  Tick;
+
+public:
+    static quint32 crc32c( quint32 crc, const void *src, size_t bytes );
+
+    static Result sha1(
+        QString         &hex,
+        QString         &err,
+        const QString   &file,
+        Tick            tick = Tick() );
+
+    static Result treeCRC(
+        quint32         &root,
+        QString         &err,
+        const QString   &file,
+        qint64          blkBytes,
+        int             nThd,
+        Tick            tick = Tick() );
+
+    static Result verify(
+        QString         &err,
+        QString         &how,
+        const QString   &file,
+        const KeyValMap &kvm,
+        Tick            tick = Tick() );
+};
+
+#endif  // FILECHECKSUM_H
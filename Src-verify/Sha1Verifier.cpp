@@ -4,9 +4,7 @@
 #include "MainApp.h"
 #include "ConsoleWindow.h"
 #include "Run.h"
-
-#include "SHA1.h"
-#undef TCHAR
+#include "FileChecksum.h"
 
 #include <QThread>
 #include <QProgressDialog>
@@ -29,46 +27,17 @@ Sha1Worker::Sha1Worker(
 }
 
 
+// Uses the metafile's tree CRC if present (all cores),
+// else SHA1 (read-ahead overlapped with hashing).
+//
 void Sha1Worker::run()
 {
     extendedError.clear();
     emit progress( 0 );
 
-// Get metafile tag
-
-    QString sha1FromMeta = kvm["fileSHA1"].toString().trimmed();
-
-    if( sha1FromMeta.isEmpty() ) {
-        extendedError =
-            QString("Missing SHA1 tag in metafile '%1'.")
-            .arg( dataFileNameShort );
-        emit result( Failure );
-        return;
-    }
-
-// Open file
-
-    const int bufSize = 64*1024;
-
-    std::vector<UINT_8> buf( bufSize );
-    QFile               f( dataFileName );
-    QFileInfo           fi( dataFileName );
-    CSHA1               sha1;
-
-    if( !f.open( QIODevice::ReadOnly ) ) {
-        extendedError =
-            QString("SHA1 error <%1> opening(read) '%2'.")
-            .arg( f.errorString() ).arg( dataFileNameShort );
-        emit result( Failure );
-        return;
-    }
-
 // Check size
 
-    qint64  size    = fi.size(),
-            read    = 0,
-            step    = qMax( 1LL, size/100 ),
-            lastPct = 0;
+    qint64  size = QFileInfo( dataFileName ).size();
 
     if( size != kvm["fileSizeBytes"].toLongLong() ) {
         Warning()
@@ -83,57 +52,28 @@ void Sha1Worker::run()
 
 // Hash
 
-    while( !isStopped() && !f.atEnd() ) {
-
-//        qint64  bytes = readChunky( f, &buf[0], bufSize );
-        qint64  bytes = f.read( (char*)&buf[0], bufSize );
+    int     lastPct = 0;
+    QString how;
 
-        if( bytes < 0 ) {
-            extendedError = f.errorString();
-            break;
-        }
-        else if( bytes > 0 ) {
-
-            qint64 pct = (read += bytes) / step;
-
-            sha1.Update( &buf[0], bytes );
-
-            if( pct >= lastPct + 5 ) {
-                emit progress( pct );
-                lastPct = pct;
-                QThread::usleep( 20 );  // allow event processing
-            }
-        }
-        else {
-
-            if( !f.atEnd() )
-                extendedError = f.errorString();
-
-            break;
-        }
-    }
+    FileChecksum::Result    fr = FileChecksum::verify(
+        extendedError, how, dataFileName, kvm,
+        [this, &lastPct]( int pct ) {
+            emit progress( pct );
+            lastPct = pct;
+            QThread::usleep( 20 );  // allow event processing
+            return !isStopped();
+        } );
 
 // Report
 
     Result  r = Failure;
 
-    if( isStopped() )
+    if( fr == FileChecksum::Canceled || isStopped() )
         r = Canceled;
-    else if( f.atEnd() && extendedError.isEmpty() ) {
-
-        sha1.Final();
-
-        std::basic_string<char> hStr;
-        sha1.ReportHashStl( hStr, CSHA1::REPORT_HEX_SHORT );
-
-        if( !sha1FromMeta.compare( hStr.c_str(), Qt::CaseInsensitive ) )
-            r = Success;
-        else {
-            extendedError =
-                "Computed SHA1 does not match that in metafile;"
-                " data file corrupt.";
-            r = Failure;
-        }
+    else if( fr == FileChecksum::Success ) {
+        Log() << QString("Verified '%1' using %2.")
+                    .arg( dataFileNameShort ).arg( how );
+        r = Success;
     }
 
     if( lastPct < 100 )
@@ -1,10 +1,12 @@
 
 HEADERS += \
+    $$PWD/FileChecksum.h \
     $$PWD/Par2Window.h \
     $$PWD/SHA1.h \
     $$PWD/Sha1Verifier.h
 
 SOURCES += \
+    $$PWD/FileChecksum.cpp \
     $$PWD/Par2Window.cpp \
     $$PWD/SHA1.cpp \
     $$PWD/Sha1Verifier.cpp
@@ -0,0 +1,328 @@
+// Stand-in local client for SpikeGLX shared-memory streams.
+//
+// Usage:
+//   AIQShmReader <stream> [secs]
+//     Attach read-only to /SpikeGLX_<stream> (e.g. imQ0, niQ),
+//     follow it for secs (default 10), copying each new block
+//     out of the ring, and report throughput and any laps.
+//
+//   AIQShmReader -bench [nchans [srate [blockTpts [secs]]]]
+//     Latency benchmark. A writer thread publishes blocks into
+//     a private segment at srate using the same protocol as
+//     AIQ; a reader thread maps it read-only and measures the
+//     delay from publication to observation.
+//
+
+#include "AIQShmHdr.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+typedef std::chrono::steady_clock   Clock;
+
+static double secsSince( Clock::time_point t0 )
+{
+    return std::chrono::duration<double>( Clock::now() - t0 ).count();
+}
+
+/* ---------------------------------------------------------------- */
+/* Mapping -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+static const AIQShmHdr *attach( const std::string &name, size_t &bytes )
+{
+    int fd = shm_open( name.c_str(), O_RDONLY, 0 );
+
+    if( fd < 0 ) {
+        fprintf( stderr, "shm_open '%s': %s\n", name.c_str(), strerror( errno ) );
+        return 0;
+    }
+
+    struct stat st;
+    fstat( fd, &st );
+    bytes = st.st_size;
+
+    void    *base = mmap( 0, bytes, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+
+    if( base == MAP_FAILED ) {
+        fprintf( stderr, "mmap '%s': %s\n", name.c_str(), strerror( errno ) );
+        return 0;
+    }
+
+    const AIQShmHdr *H = (const AIQShmHdr*)base;
+
+    if( H->magic != AIQSHM_MAGIC || H->version != AIQSHM_VERSION ) {
+        fprintf( stderr, "'%s': not a SpikeGLX stream (v%u).\n",
+            name.c_str(), H->version );
+        munmap( base, bytes );
+        return 0;
+    }
+
+    std::atomic_thread_fence( std::memory_order_acquire );
+
+    return H;
+}
+
+/* ---------------------------------------------------------------- */
+/* Reader --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Copy timepoints [fromCt, endCt) into dst following the header's
+// reader protocol. Return count copied; on lap, advance fromCt to
+// oldest intact data and return -1.
+//
+static int64_t readNew(
+    const AIQShmHdr         *H,
+    std::vector<int16_t>    &dst,
+    uint64_t                &fromCt,
+    uint64_t                &endCt )
+{
+    const uint64_t  bufmax = H->bufmax;
+    const int       nC     = H->nchans;
+
+    endCt = H->endCt.load( std::memory_order_acquire );
+
+    if( endCt <= fromCt )
+        return 0;
+
+    uint64_t    headCt = (endCt > bufmax ? endCt - bufmax : 0);
+
+    if( fromCt < headCt ) {
+        fromCt = headCt;
+        return -1;
+    }
+
+    uint64_t    n = endCt - fromCt;
+
+    dst.resize( n * nC );
+
+    for( uint64_t done = 0; done < n; ) {
+
+        uint64_t    i   = (fromCt + done) % bufmax,
+                    run = std::min( n - done, bufmax - i );
+
+        memcpy( &dst[done * nC], H->ring() + i * nC,
+            run * nC * sizeof(int16_t) );
+
+        done += run;
+    }
+
+    std::atomic_thread_fence( std::memory_order_acquire );
+
+    uint64_t    w = H->wrCt.load( std::memory_order_relaxed );
+
+    if( w > bufmax && fromCt < w - bufmax ) {
+        fromCt = w - bufmax;
+        return -1;
+    }
+
+    fromCt = endCt;
+    return n;
+}
+
+
+static int follow( const char *stream, double secs )
+{
+    std::string name = std::string("/SpikeGLX_") + stream;
+    size_t      bytes;
+
+    const AIQShmHdr *H = attach( name, bytes );
+
+    if( !H )
+        return 1;
+
+    printf( "%s: srate %.3f  nchans %u  bufmax %u  tzero %.6f  endCt %llu\n",
+        name.c_str(), H->srate, H->nchans, H->bufmax, H->tzero,
+        (unsigned long long)H->endCt.load() );
+
+    std::vector<int16_t>    data;
+    uint64_t                fromCt  = H->endCt.load( std::memory_order_acquire ),
+                            endCt   = fromCt,
+                            nTpts   = 0,
+                            nLaps   = 0,
+                            nBlocks = 0;
+    Clock::time_point       t0      = Clock::now();
+
+    while( secsSince( t0 ) < secs && H->live ) {
+
+        int64_t n = readNew( H, data, fromCt, endCt );
+
+        if( n > 0 ) {
+            nTpts += n;
+            ++nBlocks;
+        }
+        else if( n < 0 )
+            ++nLaps;
+        else
+            std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+    }
+
+    double  t = secsSince( t0 );
+
+    printf( "read %llu tpts in %llu blocks (%.1f tpts/s, %.1f MB/s), laps %llu\n",
+        (unsigned long long)nTpts, (unsigned long long)nBlocks,
+        nTpts / t, nTpts * H->nchans * sizeof(int16_t) / t / 1e6,
+        (unsigned long long)nLaps );
+
+    munmap( (void*)H, bytes );
+    return 0;
+}
+
+/* ---------------------------------------------------------------- */
+/* Benchmark ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+static int bench( int nchans, double srate, int blk, double secs )
+{
+    const char  *name   = "/SpikeGLX_bench";
+    uint32_t    bufmax  = uint32_t(2 * srate);
+    size_t      bytes   = 4096 + size_t(nchans) * bufmax * sizeof(int16_t);
+
+    shm_unlink( name );
+
+    int fd = shm_open( name, O_CREAT | O_EXCL | O_RDWR, 0644 );
+
+    if( fd < 0 || ftruncate( fd, bytes ) != 0 ) {
+        fprintf( stderr, "create '%s': %s\n", name, strerror( errno ) );
+        return 1;
+    }
+
+    void    *base = mmap( 0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+
+    AIQShmHdr   *W = new (base) AIQShmHdr;
+
+    W->version  = AIQSHM_VERSION;
+    W->hdrBytes = 4096;
+    W->nchans   = nchans;
+    W->bufmax   = bufmax;
+    W->live     = 1;
+    W->srate    = srate;
+    W->tzero    = 0;
+    W->endCt.store( 0 );
+    W->wrCt.store( 0 );
+    W->magic    = AIQSHM_MAGIC;
+
+    int64_t nBlk = int64_t(secs * srate / blk);
+
+    std::vector<Clock::time_point>  tPub( nBlk );
+    std::vector<double>             lat;
+    std::vector<int16_t>            src( blk * nchans, 1 );
+
+    lat.reserve( nBlk );
+
+    // Writer: same sequence as AIQ::wrBegin/store/wrEnd.
+
+    std::thread writer( [&]() {
+        int16_t             *ring   = (int16_t*)((char*)W + W->hdrBytes);
+        Clock::time_point   t0      = Clock::now();
+        uint64_t            endCt   = 0;
+
+        for( int64_t ib = 0; ib < nBlk; ++ib ) {
+
+            std::this_thread::sleep_until(
+                t0 + std::chrono::duration<double>( (ib + 1) * blk / srate ) );
+
+            W->wrCt.store( endCt + blk, std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_release );
+
+            for( int it = 0; it < blk; ++it ) {
+                memcpy( ring + ((endCt + it) % bufmax) * nchans,
+                    &src[it * nchans], nchans * sizeof(int16_t) );
+            }
+
+            endCt += blk;
+            tPub[ib] = Clock::now();
+            W->endCt.store( endCt, std::memory_order_release );
+        }
+
+        W->live = 0;
+    } );
+
+    // Reader: independent read-only mapping, spin-polls endCt.
+
+    size_t          rbytes;
+    const AIQShmHdr *H = attach( name, rbytes );
+
+    if( H ) {
+
+        std::vector<int16_t>    data;
+        uint64_t                fromCt = 0, endCt = 0, nLaps = 0;
+
+        while( H->live || fromCt < H->endCt.load() ) {
+
+            int64_t n = readNew( H, data, fromCt, endCt );
+
+            if( n > 0 ) {
+
+                Clock::time_point   tObs = Clock::now();
+                int64_t             ib   = endCt / blk - 1;
+
+                if( ib >= 0 && ib < nBlk ) {
+                    lat.push_back( std::chrono::duration<double>(
+                                    tObs - tPub[ib] ).count() * 1e6 );
+                }
+            }
+            else if( n < 0 )
+                ++nLaps;
+        }
+
+        munmap( (void*)H, rbytes );
+
+        std::sort( lat.begin(), lat.end() );
+
+        if( !lat.empty() ) {
+            printf( "nchans %d  srate %.0f  block %d tpts  blocks %zu  laps %llu\n",
+                nchans, srate, blk, lat.size(), (unsigned long long)nLaps );
+            printf( "publish->read latency us: min %.2f  p50 %.2f  p99 %.2f  max %.2f\n",
+                lat.front(), lat[lat.size() / 2],
+                lat[size_t(lat.size() * 0.99)], lat.back() );
+        }
+    }
+
+    writer.join();
+    munmap( base, bytes );
+    shm_unlink( name );
+
+    return H ? 0 : 1;
+}
+
+/* ---------------------------------------------------------------- */
+/* main ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+int main( int argc, char *argv[] )
+{
+    if( argc < 2 ) {
+        fprintf( stderr,
+            "usage: %s <stream> [secs]\n"
+            "       %s -bench [nchans [srate [blockTpts [secs]]]]\n",
+            argv[0], argv[0] );
+        return 1;
+    }
+
+    if( !strcmp( argv[1], "-bench" ) ) {
+        return bench(
+                argc > 2 ? atoi( argv[2] ) : 385,
+                argc > 3 ? atof( argv[3] ) : 30000,
+                argc > 4 ? atoi( argv[4] ) : 12,
+                argc > 5 ? atof( argv[5] ) : 5 );
+    }
+
+    return follow( argv[1], argc > 2 ? atof( argv[2] ) : 10 );
+}
@@ -0,0 +1,21 @@
+######################################################################
+# Stand-in client for SpikeGLX shared-memory stream export.
+# Plain C++ (no Qt); POSIX only.
+######################################################################
+
+TEMPLATE = app
+TARGET   = AIQShmReader
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+INCLUDEPATH += $$PWD/../../Src-run
+
+HEADERS += \
+    $$PWD/../../Src-run/AIQShmHdr.h
+
+SOURCES += \
+    $$PWD/AIQShmReader.cpp
+
+unix:!macx {
+    LIBS += -lrt -lpthread
+}
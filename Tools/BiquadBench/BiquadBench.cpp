@@ -0,0 +1,99 @@
+// Throughput of BiquadKernel::scalar vs the runtime-selected
+// kernel, in channels x samples per second, plus a bitwise
+// equality check of their outputs.
+//
+// Usage: BiquadBench [nchans [ntpts [reps]]]
+//
+
+#include "BiquadKernel.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+
+// 300 Hz highpass at 30 kHz (as used for AP display filtering).
+//
+static BiquadKernel::Coefs highpass( double Fc )
+{
+    BiquadKernel::Coefs C;
+    double  Q    = sqrt( 0.5 ),
+            K    = tan( M_PI * Fc ),
+            KK   = K * K,
+            norm = 1 / (1 + K/Q + KK);
+
+    C.a0 = norm;
+    C.a1 = -2 * C.a0;
+    C.a2 = C.a0;
+    C.b1 = 2 * (KK - 1) * norm;
+    C.b2 = (1 - K/Q + KK) * norm;
+    return C;
+}
+
+
+static double run(
+    BiquadKernel::Fn            fn,
+    const BiquadKernel::Coefs   &C,
+    std::vector<short>          &data,
+    const std::vector<short>    &src,
+    int                         nchans,
+    int                         ntpts,
+    int                         reps )
+{
+    std::vector<double> z1( nchans, 0 ), z2( nchans, 0 );
+    double              best = 1e99;
+
+    for( int r = 0; r < reps; ++r ) {
+
+        data = src;
+        std::fill( z1.begin(), z1.end(), 0 );
+        std::fill( z2.begin(), z2.end(), 0 );
+
+        auto t0 = std::chrono::steady_clock::now();
+        fn( &data[0], C, &z1[0], &z2[0], 512, ntpts, nchans, 0, nchans - 1 );
+        double t = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0 ).count();
+
+        if( t < best )
+            best = t;
+    }
+
+    return best;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    int nchans  = argc > 1 ? atoi( argv[1] ) : 385,
+        ntpts   = argc > 2 ? atoi( argv[2] ) : 3000,
+        reps    = argc > 3 ? atoi( argv[3] ) : 50;
+
+    std::vector<short>              src( nchans * ntpts ), a, b;
+    std::mt19937                    rng( 1 );
+    std::normal_distribution<double> nd( 0, 60 );
+
+    for( size_t i = 0; i < src.size(); ++i )
+        src[i] = short(std::max( -512.0, std::min( 511.0, nd( rng ) ) ));
+
+    BiquadKernel::Coefs C = highpass( 300.0 / 30000.0 );
+
+    // Filter all but the last (sync) channel, as applyBlockwiseMem does.
+
+    double  ts  = run( &BiquadKernel::scalar, C, a, src, nchans, ntpts, reps ),
+            tv  = run( BiquadKernel::best(), C, b, src, nchans, ntpts, reps ),
+            cs  = double(nchans - 1) * ntpts;
+
+    printf( "nchans %d  ntpts %d  AVX2 %s\n",
+        nchans, ntpts, BiquadKernel::haveAVX2() ? "yes" : "no" );
+    printf( "scalar:   %8.1f Mch*samp/s\n", cs / ts / 1e6 );
+    printf( "selected: %8.1f Mch*samp/s  (x%.2f)\n", cs / tv / 1e6, ts / tv );
+    printf( "outputs %s\n",
+        memcmp( &a[0], &b[0], a.size() * sizeof(short) ) ? "DIFFER" : "identical" );
+
+    return 0;
+}
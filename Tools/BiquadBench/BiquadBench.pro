@@ -0,0 +1,18 @@
+######################################################################
+# Micro-benchmark: Biquad block kernels, scalar vs vector.
+# Plain C++ (no Qt).
+######################################################################
+
+TEMPLATE = app
+TARGET   = BiquadBench
+CONFIG  += console c++17 release
+CONFIG  -= qt app_bundle
+
+INCLUDEPATH += $$PWD/../../Src-filters
+
+HEADERS += \
+    $$PWD/../../Src-filters/BiquadKernel.h
+
+SOURCES += \
+    $$PWD/../../Src-filters/BiquadKernel.cpp \
+    $$PWD/BiquadBench.cpp
@@ -0,0 +1,729 @@
+// Round-trip latency and throughput of the SpikeGLX command
+// server, text protocol vs framed binary protocol (BINARYMODE).
+//
+// Usage:
+//   CmdProtoBench [host [port [js [ip [nchans [ntpts [iters]]]]]]]
+//     Defaults: 127.0.0.1 4142 2 0 384 3000 1000.
+//
+// SpikeGLX must be running locally with its command server
+// enabled and a run in progress that includes stream (js, ip).
+//
+// Phases (iters calls each):
+//   NOOP           empty round trip: protocol overhead only.
+//   FETCH          nchans x ntpts, channels 0..nchans-1.
+//   FETCHMULTI     4 such fetches per binary frame.
+//
+// Before timing, malformed FETCH frames (bad or oversized
+// nChan, e.g. counts whose id list would wrap 32-bit size
+// arithmetic) must each get an error reply, and the
+// connection must still answer NOOP afterward.
+//
+// All FETCHes of a phase ask for the same window, just behind
+// the stream's current end (refreshed every 200 calls), so both
+// protocols move identical data and the rate of acquisition
+// doesn't limit throughput.
+//
+
+#include "CmdBinProto.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+#define REFRESH 200
+#define NBATCH  4
+
+typedef std::chrono::steady_clock   Clock;
+
+static double usSince( Clock::time_point t0 )
+{
+    return std::chrono::duration<double>( Clock::now() - t0 ).count() * 1e6;
+}
+
+/* ---------------------------------------------------------------- */
+/* Conn ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Blocking TCP connection with a read buffer
+// shared by line and binary reads.
+//
+struct Conn {
+    std::vector<char>   buf;
+    size_t              beg,
+                        end;
+    int                 fd;
+
+    Conn() : buf( 1 << 20 ), beg(0), end(0), fd(-1)  {}
+    ~Conn() {if( fd >= 0 ) close( fd );}
+
+    bool open( const char *host, int port );
+    bool sendAll( const void *src, size_t n );
+    bool sendStr( const std::string &s )
+        {return sendAll( s.data(), s.size() );}
+    bool recvAll( void *dst, size_t n );
+    bool recvLine( std::string &line );
+
+private:
+    bool fill();
+};
+
+
+bool Conn::open( const char *host, int port )
+{
+    sockaddr_in a;
+    int         one = 1;
+
+    memset( &a, 0, sizeof(a) );
+    a.sin_family    = AF_INET;
+    a.sin_port      = htons( port );
+
+    if( inet_pton( AF_INET, host, &a.sin_addr ) != 1 ) {
+        fprintf( stderr, "Bad host address '%s'.\n", host );
+        return false;
+    }
+
+    fd = socket( AF_INET, SOCK_STREAM, 0 );
+
+    if( fd < 0 || connect( fd, (sockaddr*)&a, sizeof(a) ) < 0 ) {
+        fprintf( stderr, "connect %s:%d: %s\n", host, port, strerror( errno ) );
+        return false;
+    }
+
+    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) );
+
+    return true;
+}
+
+
+bool Conn::sendAll( const void *src, size_t n )
+{
+    const char  *s = (const char*)src;
+
+    while( n ) {
+
+        ssize_t k = send( fd, s, n, 0 );
+
+        if( k <= 0 ) {
+            fprintf( stderr, "send: %s\n", strerror( errno ) );
+            return false;
+        }
+
+        s += k;
+        n -= k;
+    }
+
+    return true;
+}
+
+
+bool Conn::fill()
+{
+    if( beg == end )
+        beg = end = 0;
+    else if( end == buf.size() ) {
+        memmove( &buf[0], &buf[beg], end - beg );
+        end -= beg;
+        beg  = 0;
+    }
+
+    ssize_t k = recv( fd, &buf[end], buf.size() - end, 0 );
+
+    if( k <= 0 ) {
+        fprintf( stderr, "recv: %s\n", k ? strerror( errno ) : "peer closed" );
+        return false;
+    }
+
+    end += k;
+    return true;
+}
+
+
+bool Conn::recvAll( void *dst, size_t n )
+{
+    char    *d = (char*)dst;
+
+    while( n ) {
+
+        if( beg == end ) {
+
+            // Large reads bypass buffer
+
+            if( n >= buf.size() / 2 ) {
+
+                ssize_t k = recv( fd, d, n, 0 );
+
+                if( k <= 0 ) {
+                    fprintf( stderr, "recv: %s\n",
+                        k ? strerror( errno ) : "peer closed" );
+                    return false;
+                }
+
+                d += k;
+                n -= k;
+                continue;
+            }
+
+            if( !fill() )
+                return false;
+        }
+
+        size_t  k = std::min( n, end - beg );
+
+        memcpy( d, &buf[beg], k );
+        beg += k;
+        d   += k;
+        n   -= k;
+    }
+
+    return true;
+}
+
+
+bool Conn::recvLine( std::string &line )
+{
+    for(;;) {
+
+        char    *b = &buf[beg],
+                *e = (char*)memchr( b, '\n', end - beg );
+
+        if( e ) {
+            line.assign( b, e );
+            beg += e - b + 1;
+            return true;
+        }
+
+        if( !fill() )
+            return false;
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* Stats ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+struct Stats {
+    std::vector<double> us;
+    double              bytes;
+
+    Stats() : bytes(0)  {}
+
+    void report( const char *name ) const;
+};
+
+
+void Stats::report( const char *name ) const
+{
+    if( us.empty() ) {
+        printf( "%-22s no calls\n", name );
+        return;
+    }
+
+    std::vector<double> s = us;
+    double              sum = 0;
+
+    std::sort( s.begin(), s.end() );
+
+    for( size_t i = 0, n = s.size(); i < n; ++i )
+        sum += s[i];
+
+    printf( "%-22s us: p50 %8.1f  p99 %8.1f  max %8.1f",
+        name, s[s.size() / 2], s[size_t(s.size() * 0.99)], s.back() );
+
+    if( bytes )
+        printf( "  MB/s %8.1f", bytes / sum );
+
+    printf( "\n" );
+}
+
+/* ---------------------------------------------------------------- */
+/* Text protocol -------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+static bool textOK( Conn &C )
+{
+    std::string line;
+
+    if( !C.recvLine( line ) )
+        return false;
+
+    if( line != "OK" ) {
+        fprintf( stderr, "server: %s\n", line.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool textCount( Conn &C, int js, int ip, uint64_t &ct )
+{
+    char        cmd[64];
+    std::string line;
+
+    snprintf( cmd, sizeof(cmd), "GETSTREAMSAMPLECOUNT %d %d\n", js, ip );
+
+    if( !C.sendStr( cmd ) || !C.recvLine( line ) )
+        return false;
+
+    if( !line.compare( 0, 5, "ERROR" ) ) {
+        fprintf( stderr, "server: %s\n", line.c_str() );
+        return false;
+    }
+
+    ct = strtoull( line.c_str(), 0, 10 );
+
+    return textOK( C );
+}
+
+
+static bool textFetch(
+    Conn                    &C,
+    std::vector<int16_t>    &data,
+    const std::string       &chans,
+    int                     js,
+    int                     ip,
+    uint64_t                fromCt,
+    int                     ntpts )
+{
+    char                cmd[128];
+    std::string         line;
+    unsigned long long  ct;
+    int                 nC, nS;
+
+    snprintf( cmd, sizeof(cmd), "FETCH %d %d %llu %d ",
+        js, ip, (unsigned long long)fromCt, ntpts );
+
+    if( !C.sendStr( cmd + chans + "\n" ) || !C.recvLine( line ) )
+        return false;
+
+    if( sscanf( line.c_str(),
+            "BINARY_DATA %d %d uint64(%llu)", &nC, &nS, &ct ) != 3 ) {
+
+        fprintf( stderr, "server: %s\n", line.c_str() );
+        return false;
+    }
+
+    data.resize( size_t(nC) * nS );
+
+    if( data.size() && !C.recvAll( &data[0], data.size() * sizeof(int16_t) ) )
+        return false;
+
+    return textOK( C );
+}
+
+/* ---------------------------------------------------------------- */
+/* Binary protocol ------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+static uint32_t seq = 0;
+
+
+static bool binEnter( Conn &C )
+{
+    std::string line;
+
+    if( !C.sendStr( "BINARYMODE\n" ) || !C.recvLine( line ) )
+        return false;
+
+    if( line.compare( 0, 11, "BINARYMODE " ) ) {
+        fprintf( stderr, "server: %s\n", line.c_str() );
+        return false;
+    }
+
+    if( atoi( line.c_str() + 11 ) != CMDBIN_VERSION ) {
+        fprintf( stderr, "Server protocol version %s, expected %d.\n",
+            line.c_str() + 11, CMDBIN_VERSION );
+        return false;
+    }
+
+    return true;
+}
+
+
+// Send request frame (op, req), read reply payload into rep.
+//
+static bool binCall(
+    Conn                        &C,
+    int                         op,
+    const std::vector<char>     &req,
+    std::vector<char>           &rep )
+{
+    CmdBinHdr   H;
+
+    H.magic     = CMDBIN_MAGIC;
+    H.op        = op;
+    H.status    = 0;
+    H.seq       = ++seq;
+    H.len       = req.size();
+
+    if( !C.sendAll( &H, sizeof(H) )
+        || (H.len && !C.sendAll( &req[0], H.len ))
+        || !C.recvAll( &H, sizeof(H) ) ) {
+
+        return false;
+    }
+
+    if( H.magic != CMDBIN_MAGIC || H.op != op || H.seq != seq ) {
+        fprintf( stderr, "Bad reply frame.\n" );
+        return false;
+    }
+
+    rep.resize( H.len );
+
+    if( H.len && !C.recvAll( &rep[0], H.len ) )
+        return false;
+
+    if( H.status != CMDBIN_OK ) {
+        fprintf( stderr, "server (status %d): %.*s\n",
+            H.status, int(rep.size()), rep.empty() ? "" : &rep[0] );
+        return false;
+    }
+
+    return true;
+}
+
+
+// Send request frame (op, req); true if server replies
+// with an error status, as it must for a malformed request.
+//
+static bool binCallRejected(
+    Conn                        &C,
+    int                         op,
+    const std::vector<char>     &req )
+{
+    CmdBinHdr           H;
+    std::vector<char>   rep;
+
+    H.magic     = CMDBIN_MAGIC;
+    H.op        = op;
+    H.status    = 0;
+    H.seq       = ++seq;
+    H.len       = req.size();
+
+    if( !C.sendAll( &H, sizeof(H) )
+        || (H.len && !C.sendAll( &req[0], H.len ))
+        || !C.recvAll( &H, sizeof(H) ) ) {
+
+        return false;
+    }
+
+    if( H.magic != CMDBIN_MAGIC || H.op != op || H.seq != seq ) {
+        fprintf( stderr, "Bad reply frame.\n" );
+        return false;
+    }
+
+    rep.resize( H.len );
+
+    if( H.len && !C.recvAll( &rep[0], H.len ) )
+        return false;
+
+    if( H.status == CMDBIN_OK ) {
+        fprintf( stderr, "Malformed request accepted.\n" );
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool binLeave( Conn &C )
+{
+    std::vector<char>   none, rep;
+
+    return binCall( C, CMDBIN_BYE, none, rep ) && textOK( C );
+}
+
+
+// Append one CmdBinFetchReq + chan ids to req.
+//
+static void binFetchReq(
+    std::vector<char>   &req,
+    int                 js,
+    int                 ip,
+    uint64_t            fromCt,
+    int                 ntpts,
+    int                 nchans )
+{
+    CmdBinFetchReq  F;
+    size_t          off = req.size();
+
+    F.js        = js;
+    F.ip        = ip;
+    F.fromCt    = fromCt;
+    F.nMax      = ntpts;
+    F.dnsmp     = 1;
+    F.nChan     = nchans;
+    F.recipe    = 0;
+
+    req.resize( off + sizeof(F) + cmdBinChanBytes( nchans ), 0 );
+    memcpy( &req[off], &F, sizeof(F) );
+
+    uint16_t    *ids = (uint16_t*)&req[off + sizeof(F)];
+
+    for( int i = 0; i < nchans; ++i )
+        ids[i] = i;
+}
+
+
+// Sum of FETCH data bytes in reply; -1 if any stream failed.
+//
+static double binFetchBytes( const std::vector<char> &rep, int nReq, bool multi )
+{
+    const char  *p      = &rep[0];
+    double      bytes   = 0;
+
+    if( multi )
+        p += sizeof(CmdBinMultiHdr);
+
+    for( int i = 0; i < nReq; ++i ) {
+
+        const CmdBinFetchRep    *R = (const CmdBinFetchRep*)p;
+
+        if( R->status != CMDBIN_OK )
+            return -1;
+
+        bytes += double(R->nChans) * R->nTpts * sizeof(int16_t);
+        p     += sizeof(CmdBinFetchRep) + cmdBinDataBytes( R->nChans, R->nTpts );
+    }
+
+    return bytes;
+}
+
+/* ---------------------------------------------------------------- */
+/* Phases --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+struct Args {
+    const char  *host;
+    int         port,
+                js,
+                ip,
+                nchans,
+                ntpts,
+                iters;
+};
+
+
+static bool textPhase( Conn &C, const Args &A, Stats &noop, Stats &fetch )
+{
+    std::vector<int16_t>    data;
+    std::string             chans;
+    uint64_t                ct = 0;
+
+    for( int i = 0; i < A.nchans; ++i )
+        chans += std::to_string( i ) + "#";
+
+    for( int i = 0; i < A.iters; ++i ) {
+
+        Clock::time_point   t0 = Clock::now();
+
+        if( !C.sendStr( "NOOP\n" ) || !textOK( C ) )
+            return false;
+
+        noop.us.push_back( usSince( t0 ) );
+    }
+
+    for( int i = 0; i < A.iters; ++i ) {
+
+        if( !(i % REFRESH) ) {
+
+            if( !textCount( C, A.js, A.ip, ct ) )
+                return false;
+
+            ct -= std::min( ct, uint64_t(2 * A.ntpts) );
+        }
+
+        Clock::time_point   t0 = Clock::now();
+
+        if( !textFetch( C, data, chans, A.js, A.ip, ct, A.ntpts ) )
+            return false;
+
+        fetch.us.push_back( usSince( t0 ) );
+        fetch.bytes += data.size() * sizeof(int16_t);
+    }
+
+    return true;
+}
+
+
+// FETCH frames whose nChan is out of range. Most carry only
+// 4 real ids, so a server that wraps the request size would
+// read ids far past the frame. The last sends all its ids,
+// which are more than any stream has channels.
+//
+static bool rejectPhase( Conn &C, const Args &A )
+{
+    static const struct {
+        int32_t nChan;
+        int     nIds;
+    } bad[] = {
+        {-3,                4},
+        {INT32_MIN,         4},
+        {0x7FFFFFF8,        4},     // 32-bit id bytes: 8-byte request
+        {0x7FFFFFFD,        4},     // 32-bit id bytes: 0
+        {0x7FFFFFFF,        4},
+        {CMDBIN_MAXIDS + 1, 4},
+        {65536,             65536}
+    };
+    const int   nBad = sizeof(bad) / sizeof(bad[0]);
+
+    std::vector<char>   req, rep;
+
+    if( !binEnter( C ) )
+        return false;
+
+    for( int i = 0; i < nBad; ++i ) {
+
+        req.clear();
+        binFetchReq( req, A.js, A.ip, 0, A.ntpts, bad[i].nIds );
+        ((CmdBinFetchReq*)&req[0])->nChan = bad[i].nChan;
+
+        if( !binCallRejected( C, CMDBIN_FETCH, req ) ) {
+            fprintf( stderr, "FETCH nChan %d not rejected.\n", bad[i].nChan );
+            return false;
+        }
+    }
+
+    req.clear();
+
+    if( !binCall( C, CMDBIN_NOOP, req, rep ) )
+        return false;
+
+    printf( "rejected %d malformed FETCH frames\n", nBad );
+
+    return binLeave( C );
+}
+
+
+static bool binPhase(
+    Conn        &C,
+    const Args  &A,
+    Stats       &noop,
+    Stats       &fetch,
+    Stats       &multi )
+{
+    std::vector<char>   req, rep;
+    uint64_t            ct = 0;
+
+    if( !binEnter( C ) )
+        return false;
+
+    for( int i = 0; i < A.iters; ++i ) {
+
+        Clock::time_point   t0 = Clock::now();
+
+        if( !binCall( C, CMDBIN_NOOP, req, rep ) )
+            return false;
+
+        noop.us.push_back( usSince( t0 ) );
+    }
+
+    for( int ph = 0; ph < 2; ++ph ) {
+
+        Stats   &S      = (ph ? multi : fetch);
+        int     nReq    = (ph ? NBATCH : 1);
+
+        for( int i = 0; i < A.iters; ++i ) {
+
+            if( !(i % REFRESH) ) {
+
+                if( !binLeave( C )
+                    || !textCount( C, A.js, A.ip, ct )
+                    || !binEnter( C ) ) {
+
+                    return false;
+                }
+
+                ct -= std::min( ct, uint64_t(2 * A.ntpts) );
+
+                req.clear();
+
+                if( ph ) {
+                    CmdBinMultiHdr  M = {nReq, 0};
+                    req.insert( req.end(), (char*)&M, (char*)(&M + 1) );
+                }
+
+                for( int k = 0; k < nReq; ++k )
+                    binFetchReq( req, A.js, A.ip, ct, A.ntpts, A.nchans );
+            }
+
+            Clock::time_point   t0 = Clock::now();
+
+            if( !binCall( C, ph ? CMDBIN_FETCHMULTI : CMDBIN_FETCH, req, rep ) )
+                return false;
+
+            S.us.push_back( usSince( t0 ) );
+
+            double  bytes = binFetchBytes( rep, nReq, ph );
+
+            if( bytes < 0 ) {
+                fprintf( stderr, "FETCHMULTI: stream failed.\n" );
+                return false;
+            }
+
+            S.bytes += bytes;
+        }
+    }
+
+    return binLeave( C );
+}
+
+/* ---------------------------------------------------------------- */
+/* main ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+int main( int argc, char *argv[] )
+{
+    Args    A;
+
+    A.host      = argc > 1 ? argv[1] : "127.0.0.1";
+    A.port      = argc > 2 ? atoi( argv[2] ) : 4142;
+    A.js        = argc > 3 ? atoi( argv[3] ) : 2;
+    A.ip        = argc > 4 ? atoi( argv[4] ) : 0;
+    A.nchans    = argc > 5 ? atoi( argv[5] ) : 384;
+    A.ntpts     = argc > 6 ? atoi( argv[6] ) : 3000;
+    A.iters     = argc > 7 ? atoi( argv[7] ) : 1000;
+
+    if( A.nchans < 1 || A.ntpts < 1 || A.iters < 1 ) {
+        fprintf( stderr,
+            "usage: %s [host [port [js [ip [nchans [ntpts [iters]]]]]]]\n",
+            argv[0] );
+        return 1;
+    }
+
+    Conn    C;
+    Stats   tNoop, tFetch, bNoop, bFetch, bMulti;
+
+    if( !C.open( A.host, A.port )
+        || !rejectPhase( C, A )
+        || !textPhase( C, A, tNoop, tFetch )
+        || !binPhase( C, A, bNoop, bFetch, bMulti ) ) {
+
+        return 1;
+    }
+
+    printf( "%s:%d  js %d ip %d  %d chans x %d tpts  %d calls\n",
+        A.host, A.port, A.js, A.ip, A.nchans, A.ntpts, A.iters );
+
+    tNoop.report( "text NOOP" );
+    bNoop.report( "binary NOOP" );
+    tFetch.report( "text FETCH" );
+    bFetch.report( "binary FETCH" );
+    bMulti.report( "binary FETCHMULTI x4" );
+
+    C.sendStr( "BYE\n" );
+
+    return 0;
+}
@@ -0,0 +1,17 @@
+######################################################################
+# Loopback benchmark: command server text vs binary protocol.
+# Plain C++ (no Qt); POSIX only.
+######################################################################
+
+TEMPLATE = app
+TARGET   = CmdProtoBench
+CONFIG  += console c++17 release
+CONFIG  -= qt app_bundle
+
+INCLUDEPATH += $$PWD/../../Src-remote
+
+HEADERS += \
+    $$PWD/../../Src-remote/CmdBinProto.h
+
+SOURCES += \
+    $$PWD/CmdProtoBench.cpp
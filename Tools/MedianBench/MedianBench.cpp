@@ -0,0 +1,113 @@
+
+// Throughput of MedianKernel::scalar (gather + nth_element, as
+// CAR always did) vs the runtime-selected kernel, single and
+// multithreaded, in timepoints per second, plus a bitwise
+// equality check of their outputs.
+//
+// Usage: MedianBench [nchans [ntpts [reps [nThd]]]]
+//
+
+#include "MedianKernel.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+static double run(
+    MedianKernel::Fn            fn,
+    int                         nThd,
+    std::vector<short>          &data,
+    const std::vector<short>    &src,
+    const std::vector<int>      &idx,
+    int                         nchans,
+    int                         ntpts,
+    int                         reps )
+{
+    int                 nU = int(idx.size());
+    std::vector<short>  work( MedianKernel::workSize( nU ) );
+    double              best = 1e99;
+
+    for( int r = 0; r < reps; ++r ) {
+
+        data = src;
+
+        auto t0 = std::chrono::steady_clock::now();
+        if( fn )
+            fn( &data[0], &work[0], &idx[0], nU, ntpts, nchans );
+        else {
+            MedianKernel::applyThd(
+                &data[0], &work[0], &idx[0], nU, ntpts, nchans, nThd );
+        }
+        double t = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0 ).count();
+
+        if( t < best )
+            best = t;
+    }
+
+    return best;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    int nchans  = argc > 1 ? atoi( argv[1] ) : 385,
+        ntpts   = argc > 2 ? atoi( argv[2] ) : 30000,
+        reps    = argc > 3 ? atoi( argv[3] ) : 10,
+        nThd    = argc > 4 ? atoi( argv[4] ) :
+                    std::max( 1, int(std::thread::hardware_concurrency()) );
+
+    std::vector<short>               src( nchans * ntpts ), a, b, c;
+    std::vector<int>                 idx;
+    std::mt19937                     rng( 1 );
+    std::normal_distribution<double> nd( 0, 60 );
+    std::uniform_int_distribution<>  ud( 0, 999 );
+
+    // Noise, a common-mode wander, and rare large spikes.
+
+    for( int it = 0; it < ntpts; ++it ) {
+
+        double  cm = 200 * sin( it * 0.001 );
+        short   *d = &src[it * nchans];
+
+        for( int ic = 0; ic < nchans; ++ic ) {
+            double v = cm + nd( rng );
+            if( !ud( rng ) )
+                v += (ud( rng ) & 1 ? 1 : -1) * 4000;
+            d[ic] = short(std::max( -32768.0, std::min( 32767.0, v ) ));
+        }
+    }
+
+    // All but the last (sync) channel, and a few excluded, as CAR does.
+
+    for( int ic = 0; ic < nchans - 1; ++ic ) {
+        if( ic % 50 != 7 )
+            idx.push_back( ic );
+    }
+
+    double  ts  = run( &MedianKernel::scalar, 1, a, src, idx, nchans, ntpts, reps ),
+            tv  = run( MedianKernel::best(), 1, b, src, idx, nchans, ntpts, reps ),
+            tt  = run( 0, nThd, c, src, idx, nchans, ntpts, reps ),
+            ns  = ntpts;
+
+    printf( "nchans %d  nU %d  ntpts %d  AVX2 %s  threads %d\n",
+        nchans, int(idx.size()), ntpts,
+        MedianKernel::haveAVX2() ? "yes" : "no", nThd );
+    printf( "nth_element: %8.3f Mtpts/s\n", ns / ts / 1e6 );
+    printf( "selected:    %8.3f Mtpts/s  (x%.2f)\n", ns / tv / 1e6, ts / tv );
+    printf( "threaded:    %8.3f Mtpts/s  (x%.2f)\n", ns / tt / 1e6, ts / tt );
+    printf( "outputs %s\n",
+        memcmp( &a[0], &b[0], a.size() * sizeof(short) )
+        || memcmp( &a[0], &c[0], a.size() * sizeof(short) ) ?
+        "DIFFER" : "identical" );
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+######################################################################
+# Micro-benchmark: CAR global median, nth_element vs MedianKernel.
+# Plain C++ (no Qt).
+######################################################################
+
+TEMPLATE = app
+TARGET   = MedianBench
+CONFIG  += console c++17 release thread
+CONFIG  -= qt app_bundle
+
+INCLUDEPATH += $$PWD/../../Src-filters
+
+HEADERS += \
+    $$PWD/../../Src-filters/MedianKernel.h
+
+SOURCES += \
+    $$PWD/../../Src-filters/MedianKernel.cpp \
+    $$PWD/MedianBench.cpp